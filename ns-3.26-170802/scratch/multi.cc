@@ -291,23 +291,25 @@ int main (int argc, char *argv[])
 	Simulator::Run ();
 	fprintf(stderr, "\n");
 
-	uint32_t total_num_acks_received[8] = {0};
-	uint32_t total_num_acks_missed[8] = {0};
+	std::vector<MrRadioStatistics::Snapshot> total_stats(num_radios);
 	for(uint32_t i=0; i<num_nodes; i++) {
         mrdevice = DynamicCast<MrWifiNetDevice>(staDevice.Get(i));
+		std::vector<MrRadioStatistics::Snapshot> stats = mrdevice->GetStatisticsSnapshot();
 		for(uint32_t j=0; j<num_radios; j++) {
-			NS_LOG_UNCOND("[" << i << ":" << j << "] number of acks received: " << mrdevice->GetNumAcksReceived(j));
-			total_num_acks_received[j] += mrdevice->GetNumAcksReceived(j);
-			NS_LOG_UNCOND("[" << i << ":" << j << "] number of acks missed: " << mrdevice->GetNumAcksMissed(j));
-			total_num_acks_missed[j] += mrdevice->GetNumAcksMissed(j);
+			NS_LOG_UNCOND("[" << i << ":" << j << "] number of acks received: " << stats[j].acksReceived);
+			NS_LOG_UNCOND("[" << i << ":" << j << "] number of acks missed: " << stats[j].acksMissed);
+			total_stats[j] += stats[j];
 		}
 	}
 
 	NS_LOG_UNCOND(" ");
 
 	for(uint32_t j=0; j<num_radios; j++) {
-		NS_LOG_UNCOND("[ " << j << " ] total number of acks received: " << total_num_acks_received[j]);
-		NS_LOG_UNCOND("[ " << j << " ] total number of acks missed  : " << total_num_acks_missed[j]);
+		NS_LOG_UNCOND("[ " << j << " ] total number of acks received: " << total_stats[j].acksReceived);
+		NS_LOG_UNCOND("[ " << j << " ] total number of acks missed  : " << total_stats[j].acksMissed);
+		NS_LOG_UNCOND("[ " << j << " ] total bytes sent             : " << total_stats[j].txBytes);
+		NS_LOG_UNCOND("[ " << j << " ] queue high-water mark        : " << total_stats[j].queueHighWater);
+		NS_LOG_UNCOND("[ " << j << " ] token hold time              : " << total_stats[j].tokenHoldTime.GetSeconds() << " s");
 	}
 
 	/*
@@ -336,7 +338,7 @@ int main (int argc, char *argv[])
     fprintf(outfile, " %d", run);
     fprintf(outfile, " %8.2f", throughput);
     for(uint32_t j=0; j<num_radios; j++) {
-        fprintf(outfile, " %5d", total_num_acks_missed[j]);
+        fprintf(outfile, " %5d", total_stats[j].acksMissed);
     }
     fprintf(outfile, "\n");
     fclose(outfile);
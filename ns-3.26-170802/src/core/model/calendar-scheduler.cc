@@ -382,4 +382,10 @@ CalendarScheduler::Resize (uint32_t newSize)
   DoResize (newSize, newWidth);
 }
 
+bool
+CalendarScheduler::IsRemoveCheap (void) const
+{
+  return true;
+}
+
 } // namespace ns3
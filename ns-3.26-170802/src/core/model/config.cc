@@ -26,6 +26,9 @@
 #include "pointer.h"
 #include "log.h"
 
+#include <algorithm>
+#include <limits>
+#include <map>
 #include <sstream>
 
 /**
@@ -153,6 +156,9 @@ MatchContainer::DisconnectWithoutContext (std::string name, const CallbackBase &
 class ArrayMatcher
 {
 public:
+  /** A range of indices, with both bounds included. */
+  typedef std::pair<uint32_t, uint32_t> Range;
+
   /**
    * Construct from a Config path specification.
    *
@@ -166,7 +172,19 @@ public:
    * \returns \c true if the index matches the Config Path.
    */
   bool Matches (uint32_t i) const;
+  /**
+   * Get the matching indices.
+   *
+   * \returns The disjoint ranges of the matching indices, in increasing order.
+   */
+  const std::vector<Range> & GetRanges (void) const;
 private:
+  /**
+   * Add the indices matching a Config path specification to m_ranges.
+   *
+   * \param [in] element The Config path specification.
+   */
+  void Parse (std::string element);
   /**
    * Convert a string to an \c uint32_t.
    *
@@ -177,6 +195,8 @@ private:
   bool StringToUint32 (std::string str, uint32_t *value) const;
   /** The Config path element. */
   std::string m_element;
+  /** The matching indices, parsed once from m_element. */
+  std::vector<Range> m_ranges;
 };
 
 
@@ -184,70 +204,84 @@ ArrayMatcher::ArrayMatcher (std::string element)
   : m_element (element)
 {
   NS_LOG_FUNCTION (this << element);
+  Parse (element);
+  // sort and merge the ranges, so that they can be walked in index order
+  std::sort (m_ranges.begin (), m_ranges.end ());
+  std::vector<Range> merged;
+  for (std::vector<Range>::const_iterator i = m_ranges.begin (); i != m_ranges.end (); ++i)
+    {
+      if (!merged.empty () && (uint64_t)i->first <= (uint64_t)merged.back ().second + 1)
+        {
+          merged.back ().second = std::max (merged.back ().second, i->second);
+        }
+      else
+        {
+          merged.push_back (*i);
+        }
+    }
+  m_ranges.swap (merged);
 }
-bool
-ArrayMatcher::Matches (uint32_t i) const
+void
+ArrayMatcher::Parse (std::string element)
 {
-  NS_LOG_FUNCTION (this << i);
-  if (m_element == "*")
+  NS_LOG_FUNCTION (this << element);
+  if (element == "*")
     {
-      NS_LOG_DEBUG ("Array "<<i<<" matches *");
-      return true;
+      m_ranges.push_back (Range (0, std::numeric_limits<uint32_t>::max ()));
+      return;
     }
   std::string::size_type tmp;
-  tmp = m_element.find ("|");
+  tmp = element.find ("|");
   if (tmp != std::string::npos)
     {
-      std::string left = m_element.substr (0, tmp-0);
-      std::string right = m_element.substr (tmp+1, m_element.size () - (tmp + 1));
-      ArrayMatcher matcher = ArrayMatcher (left);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<left);
-          return true;
-        }
-      matcher = ArrayMatcher (right);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<right);
-          return true;
-        }
-      NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
-      return false;
+      Parse (element.substr (0, tmp-0));
+      Parse (element.substr (tmp+1, element.size () - (tmp + 1)));
+      return;
     }
-  std::string::size_type leftBracket = m_element.find ("[");
-  std::string::size_type rightBracket = m_element.find ("]");
-  std::string::size_type dash = m_element.find ("-");
-  if (leftBracket == 0 && rightBracket == m_element.size () - 1 &&
+  std::string::size_type leftBracket = element.find ("[");
+  std::string::size_type rightBracket = element.find ("]");
+  std::string::size_type dash = element.find ("-");
+  if (leftBracket == 0 && rightBracket == element.size () - 1 &&
       dash > leftBracket && dash < rightBracket)
     {
-      std::string lowerBound = m_element.substr (leftBracket + 1, dash - (leftBracket + 1));
-      std::string upperBound = m_element.substr (dash + 1, rightBracket - (dash + 1));
+      std::string lowerBound = element.substr (leftBracket + 1, dash - (leftBracket + 1));
+      std::string upperBound = element.substr (dash + 1, rightBracket - (dash + 1));
       uint32_t min;
       uint32_t max;
       if (StringToUint32 (lowerBound, &min) && 
           StringToUint32 (upperBound, &max) &&
-          i >= min && i <= max)
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
-          return true;
-        }
-      else
+          min <= max)
         {
-          NS_LOG_DEBUG ("Array "<<i<<" does not "<<m_element);
-          return false;
+          m_ranges.push_back (Range (min, max));
         }
+      return;
     }
   uint32_t value;
-  if (StringToUint32 (m_element, &value) &&
-      i == value)
+  if (StringToUint32 (element, &value))
     {
-      NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
-      return true;
+      m_ranges.push_back (Range (value, value));
+    }
+}
+bool
+ArrayMatcher::Matches (uint32_t i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  for (std::vector<Range>::const_iterator j = m_ranges.begin (); j != m_ranges.end (); ++j)
+    {
+      if (i >= j->first && i <= j->second)
+        {
+          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
+          return true;
+        }
     }
   NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
   return false;
 }
+const std::vector<ArrayMatcher::Range> &
+ArrayMatcher::GetRanges (void) const
+{
+  return m_ranges;
+}
 
 bool
 ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
@@ -259,6 +293,172 @@ ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
   return !iss.bad () && !iss.fail ();
 }
 
+/**
+ * An attribute of an object leading to other objects on a Config path:
+ * a pointer or a container of objects.
+ */
+struct PathAttribute
+{
+  /** The attribute name. */
+  std::string name;
+  /** The attribute accessor. */
+  Ptr<const AttributeAccessor> accessor;
+  /** The accessor of a container of objects, or 0 for a pointer. */
+  const ObjectPtrContainerAccessor *container;
+  /** The attribute can be read with its accessor. */
+  bool gettable;
+};
+
+/**
+ * Get the attributes of a type matching an element of a Config path.
+ *
+ * The result depends only on the type, on its attributes and on the
+ * element.  It is cached by type, element and number of own and
+ * inherited attributes, so that an attribute added to the type or to
+ * one of its parents with TypeId::AddAttribute gives a new entry.  The
+ * entries are never removed, and the references returned stay valid.
+ *
+ * \param [in] tid The type of the object.
+ * \param [in] item The Config path element, an attribute name or "*".
+ * \returns The matching pointer and container attributes, in the order
+ *          of the type and then of its parents.
+ */
+static const std::vector<PathAttribute> &
+GetPathAttributes (TypeId tid, const std::string &item)
+{
+  NS_LOG_FUNCTION (tid << item);
+  const TypeId::AttributeTable &table = tid.GetAttributeTable ();
+  typedef std::pair<std::pair<uint16_t, uint32_t>, std::string> Key;
+  typedef std::map<Key, std::vector<PathAttribute> > Cache;
+  static Cache cache;
+  Key key = std::make_pair (std::make_pair (tid.GetUid (), table.size ()), item);
+  std::pair<Cache::iterator, bool> inserted =
+    cache.insert (std::make_pair (key, std::vector<PathAttribute> ()));
+  std::vector<PathAttribute> &attributes = inserted.first->second;
+  if (!inserted.second)
+    {
+      return attributes;
+    }
+  for (TypeId::AttributeTable::const_iterator i = table.begin (); i != table.end (); ++i)
+    {
+      const struct TypeId::AttributeInformation &info = *i->second;
+      if (info.name != item && item != "*")
+        {
+          continue;
+        }
+      PathAttribute attribute;
+      attribute.name = info.name;
+      attribute.accessor = info.accessor;
+      attribute.container = 0;
+      attribute.gettable = (info.flags & TypeId::ATTR_GET) && info.accessor->HasGetter ();
+      if (dynamic_cast<const PointerChecker *> (PeekPointer (info.checker)) != 0)
+        {
+          attributes.push_back (attribute);
+        }
+      else if (dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker)) != 0)
+        {
+          attribute.container = dynamic_cast<const ObjectPtrContainerAccessor *> (PeekPointer (info.accessor));
+          if (attribute.container == 0)
+            {
+              // not our accessor: read the whole container
+              attribute.gettable = false;
+            }
+          attributes.push_back (attribute);
+        }
+      // this could be anything else and we don't know what to do with it.
+      // So, we just ignore it.
+    }
+  return attributes;
+}
+
+/**
+ * A Config path, split once into its elements.
+ *
+ * The objects found on the path differ from one resolution to the next,
+ * but the parsing of the elements, the TypeId of the GetObject elements
+ * and the attributes matching each element on a given type do not, and
+ * are kept with the path.
+ */
+class CompiledPath : public SimpleRefCount<CompiledPath>
+{
+public:
+  /** An element of the path. */
+  struct Element
+  {
+    /**
+     * Constructor.
+     * \param [in] item The element.
+     */
+    Element (std::string item);
+
+    /** The element. */
+    std::string item;
+    /** The element, as an index specification. */
+    ArrayMatcher matcher;
+    /** The element is the name of the root of the name service. */
+    bool names;
+    /** The element is a GetObject call, "$" followed by a TypeId name. */
+    bool getObject;
+    /** The TypeId of a GetObject element has been looked up. */
+    bool tidResolved;
+    /** The TypeId of a GetObject element. */
+    TypeId tid;
+    /** The uid of the type of the last object seen at this element. */
+    uint16_t lastUid;
+    /** The number of own and inherited attributes of that type. */
+    uint32_t lastAttributeN;
+    /** The attributes of that type matching the element, or 0. */
+    const std::vector<PathAttribute> *lastAttributes;
+  };
+
+  /**
+   * Split a Config path.
+   *
+   * \param [in] path The Config path.
+   */
+  CompiledPath (std::string path);
+
+  /** The elements of the path. */
+  std::vector<Element> elements;
+};
+
+CompiledPath::Element::Element (std::string item)
+  : item (item),
+    matcher (item),
+    names (item.compare (0, 5, "Names") == 0),
+    getObject (item.find ("$") == 0),
+    tidResolved (false),
+    lastUid (0),
+    lastAttributeN (0),
+    lastAttributes (0)
+{
+}
+
+CompiledPath::CompiledPath (std::string path)
+{
+  NS_LOG_FUNCTION (this << path);
+  // ensure that we start and end with a '/'
+  std::string::size_type tmp = path.find ("/");
+  if (tmp != 0)
+    {
+      // no slash at start
+      path = "/" + path;
+    }
+  tmp = path.find_last_of ("/");
+  if (tmp != (path.size () - 1))
+    {
+      // no slash at end
+      path = path + "/";
+    }
+  std::string::size_type start = 1;
+  std::string::size_type next;
+  while ((next = path.find ("/", start)) != std::string::npos)
+    {
+      elements.push_back (Element (path.substr (start, next - start)));
+      start = next + 1;
+    }
+}
+
 /**
  * Abstract class to parse Config paths into object references.
  */
@@ -270,7 +470,7 @@ public:
    *
    * \param [in] path The Config path.
    */
-  Resolver (std::string path);
+  Resolver (Ptr<CompiledPath> path);
   /** Destructor. */
   virtual ~Resolver ();
 
@@ -284,23 +484,22 @@ public:
   void Resolve (Ptr<Object> root);
   
 private:
-  /** Ensure the Config path starts and ends with a '/'. */
-  void Canonicalize (void);
   /**
    * Parse the next element in the Config path.
    *
-   * \param [in] path The remaining portion of the Config path.
+   * \param [in] element The index of the next element of the Config path.
    * \param [in] root The object corresponding to the current positon
    *                  in the Config path.
    */
-  void DoResolve (std::string path, Ptr<Object> root);
+  void DoResolve (uint32_t element, Ptr<Object> root);
   /**
    * Parse an index on the Config path.
    *
-   * \param [in] path The remaining Config path.
-   * \param [in,out] vector The resulting list of matching objects.
+   * \param [in] element The index of the next element of the Config path.
+   * \param [in] root The object holding the container.
+   * \param [in] attribute The container attribute.
    */
-  void DoArrayResolve (std::string path, const ObjectPtrContainerValue &vector);
+  void DoArrayResolve (uint32_t element, Ptr<Object> root, const PathAttribute &attribute);
   /**
    * Handle one object found on the path.
    *
@@ -323,46 +522,29 @@ private:
 
   /** Current list of path tokens. */
   std::vector<std::string> m_workStack;
-  /** The Config path. */
-  std::string m_path;
+  /**
+   * The Config path, held for the whole resolution although
+   * ConfigImpl may drop it meanwhile.
+   */
+  Ptr<CompiledPath> m_path;
 };
 
-Resolver::Resolver (std::string path)
+Resolver::Resolver (Ptr<CompiledPath> path)
   : m_path (path)
 {
   NS_LOG_FUNCTION (this << path);
-  Canonicalize ();
 }
 Resolver::~Resolver ()
 {
   NS_LOG_FUNCTION (this);
 }
-void
-Resolver::Canonicalize (void)
-{
-  NS_LOG_FUNCTION (this);
-
-  // ensure that we start and end with a '/'
-  std::string::size_type tmp = m_path.find ("/");
-  if (tmp != 0)
-    {
-      // no slash at start
-      m_path = "/" + m_path;
-    }
-  tmp = m_path.find_last_of ("/");
-  if (tmp != (m_path.size () - 1))
-    {
-      // no slash at end
-      m_path = m_path + "/";
-    }
-}
 
 void 
 Resolver::Resolve (Ptr<Object> root)
 {
   NS_LOG_FUNCTION (this << root);
 
-  DoResolve (m_path, root);
+  DoResolve (0, root);
 }
 
 std::string
@@ -388,13 +570,11 @@ Resolver::DoResolveOne (Ptr<Object> object)
 }
 
 void
-Resolver::DoResolve (std::string path, Ptr<Object> root)
+Resolver::DoResolve (uint32_t element, Ptr<Object> root)
 {
-  NS_LOG_FUNCTION (this << path << root);
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
+  NS_LOG_FUNCTION (this << element << root);
 
-  if (next == std::string::npos)
+  if (element == m_path->elements.size ())
     {
       //
       // If root is zero, we're beginning to see if we can use the object name 
@@ -410,8 +590,8 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
         }
       return;
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
+  CompiledPath::Element &current = m_path->elements[element];
+  const std::string &item = current.item;
 
   //
   // If root is zero, we're beginning to see if we can use the object name 
@@ -422,11 +602,10 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   //
   if (root == 0)
     {
-      std::string::size_type offset = path.find ("/Names");
-      if (offset == 0)
+      if (current.names)
         {
           m_workStack.push_back (item);
-          DoResolve (pathLeft, root);
+          DoResolve (element + 1, root);
           m_workStack.pop_back ();
           return;
         }
@@ -443,7 +622,7 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
     {
       NS_LOG_DEBUG ("Name system resolved item = " << item << " to " << namedObject);
       m_workStack.push_back (item);
-      DoResolve (pathLeft, namedObject);
+      DoResolve (element + 1, namedObject);
       m_workStack.pop_back ();
       return;
     }
@@ -459,82 +638,73 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
     {
       return;
     }
-  std::string::size_type dollarPos = item.find ("$");
-  if (dollarPos == 0)
+  if (current.getObject)
     {
       // This is a call to GetObject
-      std::string tidString = item.substr (1, item.size () - 1);
-      NS_LOG_DEBUG ("GetObject="<<tidString<<" on path="<<GetResolvedPath ());
-      TypeId tid = TypeId::LookupByName (tidString);
-      Ptr<Object> object = root->GetObject<Object> (tid);
+      if (!current.tidResolved)
+        {
+          current.tid = TypeId::LookupByName (item.substr (1, item.size () - 1));
+          current.tidResolved = true;
+        }
+      NS_LOG_DEBUG ("GetObject="<<current.tid.GetName ()<<" on path="<<GetResolvedPath ());
+      Ptr<Object> object = root->GetObject<Object> (current.tid);
       if (object == 0)
         {
-          NS_LOG_DEBUG ("GetObject ("<<tidString<<") failed on path="<<GetResolvedPath ());
+          NS_LOG_DEBUG ("GetObject ("<<current.tid.GetName ()<<") failed on path="<<GetResolvedPath ());
           return;
         }
       m_workStack.push_back (item);
-      DoResolve (pathLeft, object);
+      DoResolve (element + 1, object);
       m_workStack.pop_back ();
     }
   else 
     {
       // this is a normal attribute.
-      TypeId tid;
-      TypeId nextTid = root->GetInstanceTypeId ();
+      TypeId tid = root->GetInstanceTypeId ();
+      uint32_t attributeN = tid.GetAttributeTable ().size ();
+      if (current.lastAttributes == 0 || current.lastUid != tid.GetUid ()
+          || current.lastAttributeN != attributeN)
+        {
+          current.lastAttributes = &GetPathAttributes (tid, item);
+          current.lastUid = tid.GetUid ();
+          current.lastAttributeN = attributeN;
+        }
+      const std::vector<PathAttribute> &attributes = *current.lastAttributes;
       bool foundMatch = false;
-      
-      do
+
+      for (std::vector<PathAttribute>::const_iterator i = attributes.begin (); i != attributes.end (); ++i)
         {
-          tid = nextTid;
-          
-          for (uint32_t i = 0; i < tid.GetAttributeN(); i++)
+          if (i->container == 0)
             {
-              struct TypeId::AttributeInformation info;
-              info = tid.GetAttribute(i);
-              if (info.name != item && item != "*")
-                {
-                  continue;
-                }
-              // attempt to cast to a pointer checker.
-              const PointerChecker *ptr = dynamic_cast<const PointerChecker *> (PeekPointer (info.checker));
-              if (ptr != 0)
+              NS_LOG_DEBUG ("GetAttribute(ptr)="<<i->name<<" on path="<<GetResolvedPath ());
+              PointerValue ptr;
+              if (!i->gettable || !i->accessor->Get (PeekPointer (root), ptr))
                 {
-                  NS_LOG_DEBUG ("GetAttribute(ptr)="<<info.name<<" on path="<<GetResolvedPath ());
-                  PointerValue ptr;
-                  root->GetAttribute (info.name, ptr);
-                  Ptr<Object> object = ptr.Get<Object> ();
-                  if (object == 0)
-                    {
-                      NS_LOG_ERROR ("Requested object name=\""<<item<<
-                                    "\" exists on path=\""<<GetResolvedPath ()<<"\""
-                                    " but is null.");
-                      continue;
-                    }
-                  foundMatch = true;
-                  m_workStack.push_back (info.name);
-                  DoResolve (pathLeft, object);
-                  m_workStack.pop_back ();
+                  root->GetAttribute (i->name, ptr);
                 }
-              // attempt to cast to an object vector.
-              const ObjectPtrContainerChecker *vectorChecker = 
-                dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker));
-              if (vectorChecker != 0)
+              Ptr<Object> object = ptr.Get<Object> ();
+              if (object == 0)
                 {
-                  NS_LOG_DEBUG ("GetAttribute(vector)="<<info.name<<" on path="<<GetResolvedPath () << pathLeft);
-                  foundMatch = true;
-                  ObjectPtrContainerValue vector;
-                  root->GetAttribute (info.name, vector);
-                  m_workStack.push_back (info.name);
-                  DoArrayResolve (pathLeft, vector);
-                  m_workStack.pop_back ();
+                  NS_LOG_ERROR ("Requested object name=\""<<item<<
+                                "\" exists on path=\""<<GetResolvedPath ()<<"\""
+                                " but is null.");
+                  continue;
                 }
-              // this could be anything else and we don't know what to do with it.
-              // So, we just ignore it.
+              foundMatch = true;
+              m_workStack.push_back (i->name);
+              DoResolve (element + 1, object);
+              m_workStack.pop_back ();
+            }
+          else
+            {
+              NS_LOG_DEBUG ("GetAttribute(vector)="<<i->name<<" on path="<<GetResolvedPath ());
+              foundMatch = true;
+              m_workStack.push_back (i->name);
+              DoArrayResolve (element + 1, root, *i);
+              m_workStack.pop_back ();
             }
+        }
 
-          nextTid = tid.GetParent ();
-        } while (nextTid != tid);
-      
       if (!foundMatch)
         {
           NS_LOG_DEBUG ("Requested item="<<item<<" does not exist on path="<<GetResolvedPath ());
@@ -544,20 +714,53 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
 }
 
 void 
-Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &container)
+Resolver::DoArrayResolve (uint32_t element, Ptr<Object> root, const PathAttribute &attribute)
 {
-  NS_LOG_FUNCTION(this << path << &container);
-  NS_ASSERT (path != "");
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
-  if (next == std::string::npos)
+  NS_LOG_FUNCTION (this << element << root << attribute.name);
+  if (element == m_path->elements.size ())
     {
       return;
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
+  const ArrayMatcher &matcher = m_path->elements[element].matcher;
+
+  //
+  // When the container is indexed by position, as the vectors are, get the
+  // matching objects by index, rather than all the objects of the container.
+  // The indices of a container are increasing, so that they are the
+  // positions if the last index is the last position.
+  //
+  uint32_t n;
+  if (attribute.gettable && attribute.container->GetN (PeekPointer (root), &n))
+    {
+      uint32_t index;
+      if (n == 0)
+        {
+          return;
+        }
+      attribute.container->GetItem (PeekPointer (root), n - 1, &index);
+      if (index == n - 1)
+        {
+          const std::vector<ArrayMatcher::Range> &ranges = matcher.GetRanges ();
+          for (std::vector<ArrayMatcher::Range>::const_iterator i = ranges.begin ();
+               i != ranges.end () && i->first < n; ++i)
+            {
+              uint32_t last = std::min (i->second, n - 1);
+              for (uint32_t j = i->first; j <= last; j++)
+                {
+                  Ptr<Object> object = attribute.container->GetItem (PeekPointer (root), j, &index);
+                  std::ostringstream oss;
+                  oss << index;
+                  m_workStack.push_back (oss.str ());
+                  DoResolve (element + 1, object);
+                  m_workStack.pop_back ();
+                }
+            }
+          return;
+        }
+    }
 
-  ArrayMatcher matcher = ArrayMatcher (item);
+  ObjectPtrContainerValue container;
+  root->GetAttribute (attribute.name, container);
   ObjectPtrContainerValue::Iterator it;
   for (it = container.Begin (); it != container.End (); ++it)
     {
@@ -566,7 +769,7 @@ Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &conta
           std::ostringstream oss;
           oss << (*it).first;
           m_workStack.push_back (oss.str ());
-          DoResolve (pathLeft, (*it).second);
+          DoResolve (element + 1, (*it).second);
           m_workStack.pop_back ();
         }
     }
@@ -609,11 +812,25 @@ private:
    */
   void ParsePath (std::string path, std::string *root, std::string *leaf) const;
 
+  /**
+   * Get the compiled form of a Config path.
+   * \param [in] path The Config path.
+   * \returns The compiled path, kept for the next calls with the same path.
+   */
+  Ptr<CompiledPath> GetCompiledPath (std::string path);
+
   /** Container type to hold the root Config path tokens. */
   typedef std::vector<Ptr<Object> > Roots;
 
   /** The list of Config path roots. */
   Roots m_roots;
+
+  /** Container type of the compiled paths, by path. */
+  typedef std::map<std::string, Ptr<CompiledPath> > CompiledPaths;
+  /** The paths compiled by the previous calls. */
+  CompiledPaths m_paths;
+  /** Largest number of compiled paths kept. */
+  static const uint32_t MAX_COMPILED_PATHS = 1024;
 };
 
 void 
@@ -684,7 +901,7 @@ ConfigImpl::LookupMatches (std::string path)
   class LookupMatchesResolver : public Resolver 
   {
   public:
-    LookupMatchesResolver (std::string path)
+    LookupMatchesResolver (Ptr<CompiledPath> path)
       : Resolver (path)
     {}
     virtual void DoOne (Ptr<Object> object, std::string path) {
@@ -693,7 +910,7 @@ ConfigImpl::LookupMatches (std::string path)
     }
     std::vector<Ptr<Object> > m_objects;
     std::vector<std::string> m_contexts;
-  } resolver = LookupMatchesResolver (path);
+  } resolver = LookupMatchesResolver (GetCompiledPath (path));
   for (Roots::const_iterator i = m_roots.begin (); i != m_roots.end (); i++)
     {
       resolver.Resolve (*i);
@@ -709,6 +926,26 @@ ConfigImpl::LookupMatches (std::string path)
   return Config::MatchContainer (resolver.m_objects, resolver.m_contexts, path);
 }
 
+Ptr<CompiledPath>
+ConfigImpl::GetCompiledPath (std::string path)
+{
+  NS_LOG_FUNCTION (this << path);
+  CompiledPaths::iterator i = m_paths.find (path);
+  if (i != m_paths.end ())
+    {
+      return i->second;
+    }
+  if (m_paths.size () >= MAX_COMPILED_PATHS)
+    {
+      // the paths built per node or per device are seldom used twice.
+      // The resolutions in progress hold their own reference.
+      m_paths.clear ();
+    }
+  Ptr<CompiledPath> compiled = Create<CompiledPath> (path);
+  m_paths.insert (std::make_pair (path, compiled));
+  return compiled;
+}
+
 void 
 ConfigImpl::RegisterRootNamespaceObject (Ptr<Object> obj)
 {
@@ -25,6 +25,8 @@
 
 #include "ptr.h"
 #include "pointer.h"
+#include "enum.h"
+#include "double.h"
 #include "assert.h"
 #include "log.h"
 
@@ -53,6 +55,25 @@ DefaultSimulatorImpl::GetTypeId (void)
     .SetParent<SimulatorImpl> ()
     .SetGroupName ("Core")
     .AddConstructor<DefaultSimulatorImpl> ()
+    .AddAttribute ("CancelPolicy",
+                   "What to do with the cancelled events: leave them in the "
+                   "event list until they expire, remove them at once, rebuild "
+                   "the event list when they exceed CompactionThreshold, or "
+                   "remove them if the scheduler removes events cheaply and "
+                   "rebuild the event list otherwise.",
+                   EnumValue (CANCEL_LAZY),
+                   MakeEnumAccessor (&DefaultSimulatorImpl::m_cancelPolicy),
+                   MakeEnumChecker (CANCEL_LAZY, "Lazy",
+                                    CANCEL_REMOVE, "Remove",
+                                    CANCEL_COMPACT, "Compact",
+                                    CANCEL_AUTO, "Auto"))
+    .AddAttribute ("CompactionThreshold",
+                   "Fraction of cancelled events in the event list above which "
+                   "it is rebuilt without them (used in conjunction with "
+                   "CancelPolicy=Compact or Auto).",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&DefaultSimulatorImpl::m_compactionThreshold),
+                   MakeDoubleChecker<double> (0.0, 1.0))
   ;
   return tid;
 }
@@ -71,6 +92,9 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
+  m_deadEvents = 0;
+  m_pendingDeadEvents = 0;
+  m_compactions = 0;
   m_eventsWithContextEmpty = true;
   m_main = SystemThread::Self();
 }
@@ -115,6 +139,7 @@ DefaultSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
 {
   NS_LOG_FUNCTION (this << schedulerFactory);
   Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+  m_schedulerFactory = schedulerFactory;
 
   if (m_events != 0)
     {
@@ -141,6 +166,10 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
 
   NS_ASSERT (next.key.m_ts >= m_currentTs);
   m_unscheduledEvents--;
+  if (m_deadEvents > 0 && next.impl->IsCancelled ())
+    {
+      m_deadEvents--;
+    }
 
   NS_LOG_LOGIC ("handle " << next.key.m_ts);
   m_currentTs = next.key.m_ts;
@@ -184,6 +213,12 @@ DefaultSimulatorImpl::ProcessEventsWithContext (void)
        ev.key.m_uid = m_uid;
        m_uid++;
        m_unscheduledEvents++;
+       if (m_pendingDeadEvents > 0 && ev.impl->IsCancelled ())
+         {
+           // cancelled before it got here, it now counts as dead
+           m_pendingDeadEvents--;
+           m_deadEvents++;
+         }
        m_events->Insert (ev);
     }
 }
@@ -360,10 +395,82 @@ DefaultSimulatorImpl::Remove (const EventId &id)
 void
 DefaultSimulatorImpl::Cancel (const EventId &id)
 {
-  if (!IsExpired (id))
+  if (IsExpired (id))
+    {
+      return;
+    }
+  if (id.GetUid () == 2)
     {
+      // destroy events are not in the event list
       id.PeekEventImpl ()->Cancel ();
+      return;
+    }
+  enum CancelPolicy policy = m_cancelPolicy;
+  if (policy == CANCEL_AUTO)
+    {
+      policy = m_events->IsRemoveCheap () ? CANCEL_REMOVE : CANCEL_COMPACT;
+    }
+  if (IsPendingWithContext (id))
+    {
+      // an event scheduled from another thread is not in the event list
+      // yet, and counts as dead once ProcessEventsWithContext moves it in.
+      id.PeekEventImpl ()->Cancel ();
+      m_pendingDeadEvents++;
+      return;
+    }
+  if (policy == CANCEL_REMOVE)
+    {
+      Remove (id);
+      return;
+    }
+  id.PeekEventImpl ()->Cancel ();
+  m_deadEvents++;
+  if (policy == CANCEL_COMPACT
+      && m_deadEvents > m_compactionThreshold * m_unscheduledEvents)
+    {
+      Compact ();
+    }
+}
+
+void
+DefaultSimulatorImpl::Compact (void)
+{
+  NS_LOG_FUNCTION (this << m_deadEvents << m_unscheduledEvents);
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  while (!m_events->IsEmpty ())
+    {
+      Scheduler::Event next = m_events->RemoveNext ();
+      if (next.impl->IsCancelled ())
+        {
+          next.impl->Unref ();
+          m_unscheduledEvents--;
+        }
+      else
+        {
+          scheduler->Insert (next);
+        }
     }
+  m_events = scheduler;
+  m_deadEvents = 0;
+  m_compactions++;
+}
+
+bool
+DefaultSimulatorImpl::IsPendingWithContext (const EventId &id)
+{
+  if (m_eventsWithContextEmpty)
+    {
+      return false;
+    }
+  CriticalSection cs (m_eventsWithContextMutex);
+  for (EventsWithContext::const_iterator i = m_eventsWithContext.begin (); i != m_eventsWithContext.end (); i++)
+    {
+      if (i->event == id.PeekEventImpl ())
+        {
+          return true;
+        }
+    }
+  return false;
 }
 
 bool
@@ -414,4 +521,22 @@ DefaultSimulatorImpl::GetContext (void) const
   return m_currentContext;
 }
 
+uint32_t
+DefaultSimulatorImpl::GetLiveEventCount (void) const
+{
+  return m_unscheduledEvents - m_deadEvents;
+}
+
+uint32_t
+DefaultSimulatorImpl::GetDeadEventCount (void) const
+{
+  return m_deadEvents;
+}
+
+uint32_t
+DefaultSimulatorImpl::GetCompactionCount (void) const
+{
+  return m_compactions;
+}
+
 } // namespace ns3
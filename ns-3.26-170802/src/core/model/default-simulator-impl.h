@@ -53,6 +53,29 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  /** What to do with the cancelled events. */
+  enum CancelPolicy
+  {
+    /**
+     * Leave the cancelled events in the event list until they expire
+     * (the default).
+     */
+    CANCEL_LAZY,
+    /** Remove the cancelled events from the event list at once. */
+    CANCEL_REMOVE,
+    /**
+     * Leave the cancelled events in the event list, and rebuild the event
+     * list without them when they exceed the CompactionThreshold fraction
+     * of the events.
+     */
+    CANCEL_COMPACT,
+    /**
+     * CANCEL_REMOVE if the Scheduler::Remove() of the scheduler is cheap,
+     * CANCEL_COMPACT otherwise.
+     */
+    CANCEL_AUTO
+  };
+
   /** Constructor. */
   DefaultSimulatorImpl ();
   /** Destructor. */
@@ -78,6 +101,20 @@ public:
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
 
+  /**
+   * \returns The number of events in the event list not cancelled.
+   */
+  uint32_t GetLiveEventCount (void) const;
+  /**
+   * \returns The number of cancelled events still in the event list.
+   */
+  uint32_t GetDeadEventCount (void) const;
+  /**
+   * \returns The number of times the event list was rebuilt without its
+   * cancelled events.
+   */
+  uint32_t GetCompactionCount (void) const;
+
 private:
   virtual void DoDispose (void);
 
@@ -85,6 +122,14 @@ private:
   void ProcessOneEvent (void);
   /** Move events from a different context into the main event queue. */
   void ProcessEventsWithContext (void);
+  /** Rebuild the event list without the cancelled events. */
+  void Compact (void);
+  /**
+   * \param [in] id The event to look for.
+   * \returns \c true if the event was scheduled from another thread, and
+   * not yet moved into the event list.
+   */
+  bool IsPendingWithContext (const EventId &id);
  
   /** Wrap an event with its execution context. */
   struct EventWithContext {
@@ -115,6 +160,24 @@ private:
   bool m_stop;
   /** The event priority queue. */
   Ptr<Scheduler> m_events;
+  /** The factory of m_events, to rebuild it in Compact(). */
+  ObjectFactory m_schedulerFactory;
+  /** What to do with the cancelled events. */
+  enum CancelPolicy m_cancelPolicy;
+  /**
+   * Fraction of cancelled events in the event list above which it is
+   * rebuilt, with CANCEL_COMPACT.
+   */
+  double m_compactionThreshold;
+  /** Number of cancelled events in the event list. */
+  uint32_t m_deadEvents;
+  /**
+   * Number of cancelled events scheduled from another thread, and not
+   * yet moved into the event list.
+   */
+  uint32_t m_pendingDeadEvents;
+  /** Number of times the event list was rebuilt. */
+  uint32_t m_compactions;
 
   /** Next event unique id. */
   uint32_t m_uid;
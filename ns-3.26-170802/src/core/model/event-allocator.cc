@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "event-allocator.h"
+#include "size-class-allocator.h"
+#include "global-value.h"
+#include "boolean.h"
+#include "uinteger.h"
+#include "log.h"
+
+/**
+ * \file
+ * \ingroup events
+ * ns3::EventAllocator implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EventAllocator");
+
+/**
+ * \ingroup events
+ * Whether the events are allocated from per-thread pools.
+ */
+static GlobalValue g_eventPoolEnabled = GlobalValue ("EventPoolEnabled",
+                                                     "Allocate the simulation events from per-thread pools "
+                                                     "instead of calling malloc for each event",
+                                                     BooleanValue (true),
+                                                     MakeBooleanChecker ());
+
+/**
+ * \ingroup events
+ * The bytes kept in the free lists of the event pools.
+ */
+static GlobalValue g_eventPoolMaxFreeBytes = GlobalValue ("EventPoolMaxFreeBytes",
+                                                          "Largest number of bytes kept in the free lists "
+                                                          "of the event pools of a thread",
+                                                          UintegerValue (16 * 1024 * 1024),
+                                                          MakeUintegerChecker<uint64_t> ());
+
+namespace {
+
+/**
+ * \returns The pools of the events.  Never destroyed, so that the events
+ *          freed by the static destructors find them.
+ */
+SizeClassAllocator &
+GetAllocator (void)
+{
+  static const SizeClassAllocator::Layout layout = {
+    32, 4, SizeClassAllocator::HEADER_SIZE + EventAllocator::MAX_POOLED_SIZE
+  };
+  static SizeClassAllocator *allocator =
+    new SizeClassAllocator (layout, "EventPoolEnabled", "EventPoolMaxFreeBytes", "");
+  return *allocator;
+}
+
+} // unnamed namespace
+
+void *
+EventAllocator::Allocate (std::size_t size)
+{
+  return GetAllocator ().Allocate (size);
+}
+
+void
+EventAllocator::Deallocate (void *p)
+{
+  GetAllocator ().Deallocate (p);
+}
+
+bool
+EventAllocator::IsEnabled (void)
+{
+  return GetAllocator ().IsEnabled ();
+}
+
+void
+EventAllocator::Reconfigure (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  GetAllocator ().Reconfigure ();
+}
+
+EventAllocator::Statistics
+EventAllocator::GetStatistics (void)
+{
+  return GetAllocator ().GetStatistics ();
+}
+
+void
+EventAllocator::ResetStatistics (void)
+{
+  GetAllocator ().ResetStatistics ();
+}
+
+void
+EventAllocator::Trim (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  GetAllocator ().Trim ();
+}
+
+} // namespace ns3
@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef EVENT_ALLOCATOR_H
+#define EVENT_ALLOCATOR_H
+
+#include <stdint.h>
+#include <cstddef>
+#include "size-class-allocator.h"
+
+/**
+ * \file
+ * \ingroup events
+ * ns3::EventAllocator declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup events
+ * \brief Memory allocator of the EventImpl objects.
+ *
+ * The events of up to MAX_POOLED_SIZE bytes are allocated by a
+ * SizeClassAllocator, in size classes from 32 bytes, header included,
+ * four between two powers of two.  Each thread keeps a free list per size class, so
+ * that once a simulation has reached its largest number of pending
+ * events, scheduling an event no longer calls malloc.  Larger events are
+ * allocated with malloc.
+ *
+ * The behavior is set by GlobalValues, read when the first event is
+ * allocated and again after each Simulator::Destroy:
+ *  - "EventPoolEnabled" enables the pools (default true);
+ *  - "EventPoolMaxFreeBytes" bounds the bytes kept in the free lists of
+ *    a thread (default 16 MiB); the events freed beyond it are given back
+ *    to the system.  An event freed by another thread than the one which
+ *    allocated it (as with ScheduleWithContext from another thread) joins
+ *    the free list of the freeing thread, so this bound also keeps such
+ *    one-way traffic from growing the free lists without limit.
+ *
+ * The free events of a thread are given back to the system when it
+ * exits.  Events allocated before a change of the GlobalValues are freed
+ * correctly afterwards.
+ */
+class EventAllocator
+{
+public:
+  /** Largest event size served from the pools, in bytes, without the header. */
+  static const std::size_t MAX_POOLED_SIZE = 256;
+
+  /** Allocation statistics of a thread. */
+  typedef SizeClassAllocator::Statistics Statistics;
+
+  /**
+   * \param [in] size The size of the event.
+   * \returns The memory of the event.
+   */
+  static void * Allocate (std::size_t size);
+  /**
+   * \param [in] p The memory of an event returned by Allocate().
+   */
+  static void Deallocate (void *p);
+  /**
+   * \returns \c true if the events are allocated from the pools.
+   */
+  static bool IsEnabled (void);
+  /**
+   * Read the GlobalValues again before the next allocation.  Called by
+   * Simulator::Destroy().
+   */
+  static void Reconfigure (void);
+  /**
+   * \returns The allocation statistics of the calling thread.
+   */
+  static Statistics GetStatistics (void);
+  /** Reset the allocation statistics of the calling thread. */
+  static void ResetStatistics (void);
+  /**
+   * Give back to the system the free events of the calling thread.
+   */
+  static void Trim (void);
+};
+
+} // namespace ns3
+
+#endif /* EVENT_ALLOCATOR_H */
@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 /**
@@ -66,6 +67,18 @@ public:
    */
   bool IsCancelled (void);
 
+  /**
+   * Allocate an event with EventAllocator.
+   * \param [in] size The size of the event.
+   * \returns The memory of the event.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Free an event allocated with EventAllocator.
+   * \param [in] p The memory of the event.
+   */
+  static void operator delete (void *p);
+
 protected:
   /**
    * Implementation for Invoke().
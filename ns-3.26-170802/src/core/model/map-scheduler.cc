@@ -109,4 +109,10 @@ MapScheduler::Remove (const Event &ev)
   m_list.erase (i);
 }
 
+bool
+MapScheduler::IsRemoveCheap (void) const
+{
+  return true;
+}
+
 } // namespace ns3
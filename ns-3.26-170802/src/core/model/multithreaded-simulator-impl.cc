@@ -0,0 +1,719 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+#include "simulator.h"
+#include "uinteger.h"
+#include "config.h"
+#include "assert.h"
+#include "log.h"
+
+#include <algorithm>
+#include <thread>
+
+/**
+ * \file
+ * \ingroup simulator
+ * Implementation of class ns3::MultithreadedSimulatorImpl.
+ */
+
+namespace ns3 {
+
+// Note:  Logging in this file is largely avoided due to the
+// number of calls that are made to these functions and the possibility
+// of causing recursions leading to stack overflow
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+thread_local MultithreadedSimulatorImpl::Partition *MultithreadedSimulatorImpl::m_threadPartition = 0;
+
+const uint32_t MultithreadedSimulatorImpl::NO_PARTITION;
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Core")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("ThreadCount",
+                   "Number of threads running the events, including the main "
+                   "thread, or 0 for one per core.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_threadCount),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("PartitionCount",
+                   "Number of partitions the contexts are spread over, or 0 "
+                   "for four per thread.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_partitionCount),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Lookahead",
+                   "Smallest delay of the events scheduled in the contexts of "
+                   "another partition, usually the smallest propagation delay "
+                   "of the channels between the nodes, or a negative value to "
+                   "derive it at Run from the Delay or MinimumDelay attribute of "
+                   "the channels.",
+                   TimeValue (Seconds (-1)),
+                   MakeTimeAccessor (&MultithreadedSimulatorImpl::m_lookahead),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::Barrier::Barrier (uint32_t count)
+  : m_count (count),
+    m_waiting (0),
+    m_generation (0)
+{
+}
+
+void
+MultithreadedSimulatorImpl::Barrier::Wait (void)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  uint64_t generation = m_generation;
+  m_waiting++;
+  if (m_waiting == m_count)
+    {
+      m_waiting = 0;
+      m_generation++;
+      m_cond.notify_all ();
+      return;
+    }
+  while (generation == m_generation)
+    {
+      m_cond.wait (lock);
+    }
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_global (0),
+    m_threadCount (0),
+    m_partitionCount (0),
+    m_barrier (0),
+    m_nextPartition (0),
+    m_exit (false),
+    m_windowStart (0),
+    m_windowEnd (0),
+    m_windows (0),
+    m_runLookahead (Seconds (0)),
+    m_stop (false)
+{
+  NS_LOG_FUNCTION (this);
+  m_main = SystemThread::Self ();
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  MergeOutboxes ();
+  m_partitions.push_back (m_global);
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      while (!(*i)->events->IsEmpty ())
+        {
+          Scheduler::Event next = (*i)->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      delete *i;
+    }
+  m_partitions.clear ();
+  m_global = 0;
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::CreatePartitions (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t threads = m_threadCount != 0 ? m_threadCount : std::max (1U, std::thread::hardware_concurrency ());
+  uint32_t n = m_partitionCount != 0 ? m_partitionCount : 4 * threads;
+  for (uint32_t i = 0; i <= n; i++)
+    {
+      Partition *partition = new Partition;
+      partition->events = m_schedulerFactory.Create<Scheduler> ();
+      // uids are allocated from 4, as in the DefaultSimulatorImpl
+      partition->uid = 4;
+      partition->currentUid = 0;
+      partition->currentTs = 0;
+      partition->currentContext = Simulator::NO_CONTEXT;
+      partition->unscheduledEvents = 0;
+      partition->index = i < n ? i : NO_PARTITION;
+      if (i < n)
+        {
+          m_partitions.push_back (partition);
+        }
+      else
+        {
+          m_global = partition;
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  m_schedulerFactory = schedulerFactory;
+  if (m_global == 0)
+    {
+      CreatePartitions ();
+      return;
+    }
+  m_partitions.push_back (m_global);
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      while (!(*i)->events->IsEmpty ())
+        {
+          scheduler->Insert ((*i)->events->RemoveNext ());
+        }
+      (*i)->events = scheduler;
+    }
+  m_partitions.pop_back ();
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (uint32_t context)
+{
+  if (context == Simulator::NO_CONTEXT)
+    {
+      return m_global;
+    }
+  return m_partitions[context % m_partitions.size ()];
+}
+
+const MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (uint32_t context) const
+{
+  if (context == Simulator::NO_CONTEXT)
+    {
+      return m_global;
+    }
+  return m_partitions[context % m_partitions.size ()];
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetCurrentPartition (void) const
+{
+  return m_threadPartition != 0 ? m_threadPartition : m_global;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return 0;
+}
+
+EventId
+MultithreadedSimulatorImpl::Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = partition->uid;
+  partition->uid++;
+  partition->unscheduledEvents++;
+  partition->events->Insert (ev);
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (Partition *partition)
+{
+  Scheduler::Event next = partition->events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= partition->currentTs);
+  partition->unscheduledEvents--;
+
+  NS_LOG_LOGIC ("handle " << next.key.m_ts);
+  partition->currentTs = next.key.m_ts;
+  partition->currentContext = next.key.m_context;
+  partition->currentUid = next.key.m_uid;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::MergeOutboxes (void)
+{
+  // in partition order, for the runs to be reproducible
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      std::vector<Scheduler::Event> &outbox = (*i)->outbox;
+      for (std::vector<Scheduler::Event>::const_iterator j = outbox.begin (); j != outbox.end (); ++j)
+        {
+          Insert (GetPartition (j->key.m_context), j->key.m_ts, j->key.m_context, j->impl);
+        }
+      outbox.clear ();
+    }
+  std::list<Scheduler::Event> foreignEvents;
+  {
+    CriticalSection cs (m_mutex);
+    m_foreignEvents.swap (foreignEvents);
+  }
+  for (std::list<Scheduler::Event>::const_iterator i = foreignEvents.begin (); i != foreignEvents.end (); ++i)
+    {
+      // the delay is added to the current time here
+      Insert (GetPartition (i->key.m_context), m_global->currentTs + i->key.m_ts, i->key.m_context, i->impl);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::RunWindow (void)
+{
+  while (true)
+    {
+      uint32_t index = m_nextPartition++;
+      if (index >= m_partitions.size ())
+        {
+          break;
+        }
+      Partition *partition = m_partitions[index];
+      m_threadPartition = partition;
+      while (!partition->events->IsEmpty () && !m_stop
+             && partition->events->PeekNext ().key.m_ts < m_windowEnd)
+        {
+          ProcessOneEvent (partition);
+        }
+    }
+  m_threadPartition = 0;
+}
+
+void
+MultithreadedSimulatorImpl::Worker (void)
+{
+  while (true)
+    {
+      m_barrier->Wait ();
+      if (m_exit)
+        {
+          return;
+        }
+      RunWindow ();
+      m_barrier->Wait ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_stop)
+    {
+      return true;
+    }
+  if (!m_global->events->IsEmpty ())
+    {
+      return false;
+    }
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      if (!(*i)->events->IsEmpty () || !(*i)->outbox.empty ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_main = SystemThread::Self ();
+  m_stop = false;
+
+  uint32_t threads = m_threadCount != 0 ? m_threadCount : std::max (1U, std::thread::hardware_concurrency ());
+  m_barrier = new Barrier (threads);
+  m_exit = false;
+  for (uint32_t i = 1; i < threads; i++)
+    {
+      Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&MultithreadedSimulatorImpl::Worker, this));
+      thread->Start ();
+      m_threads.push_back (thread);
+    }
+
+  m_runLookahead = m_lookahead.IsNegative () ? CalculateLookahead () : m_lookahead;
+  uint64_t lookahead = m_runLookahead.GetTimeStep ();
+  while (true)
+    {
+      MergeOutboxes ();
+      if (m_stop)
+        {
+          break;
+        }
+      bool found = false;
+      uint64_t start = 0;
+      for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+        {
+          if (!(*i)->events->IsEmpty ())
+            {
+              uint64_t ts = (*i)->events->PeekNext ().key.m_ts;
+              start = found ? std::min (start, ts) : ts;
+              found = true;
+            }
+        }
+      bool global = !m_global->events->IsEmpty ();
+      uint64_t globalTs = global ? m_global->events->PeekNext ().key.m_ts : 0;
+      if (global && (!found || globalTs <= start))
+        {
+          // the events without context run alone, before the events of
+          // the contexts at the same time
+          m_threadPartition = m_global;
+          while (!m_global->events->IsEmpty () && !m_stop
+                 && m_global->events->PeekNext ().key.m_ts == globalTs)
+            {
+              ProcessOneEvent (m_global);
+            }
+          m_threadPartition = 0;
+          continue;
+        }
+      if (!found)
+        {
+          break;
+        }
+      if (start > m_global->currentTs)
+        {
+          m_global->currentTs = start;
+          m_global->currentUid = 0;
+        }
+      m_windowStart = start;
+      m_windowEnd = start + std::max (lookahead, (uint64_t)1);
+      if (global)
+        {
+          m_windowEnd = std::min (m_windowEnd, globalTs);
+        }
+      m_windows++;
+      m_nextPartition = 0;
+      m_barrier->Wait ();
+      RunWindow ();
+      m_barrier->Wait ();
+    }
+
+  m_exit = true;
+  m_barrier->Wait ();
+  for (std::vector<Ptr<SystemThread> >::iterator i = m_threads.begin (); i != m_threads.end (); ++i)
+    {
+      (*i)->Join ();
+    }
+  m_threads.clear ();
+  delete m_barrier;
+  m_barrier = 0;
+
+  // outside of the windows, the time is the time of the last event run
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      if ((*i)->currentTs > m_global->currentTs)
+        {
+          m_global->currentTs = (*i)->currentTs;
+          m_global->currentUid = 0;
+        }
+    }
+
+  // If the simulator stopped naturally by lack of events, make a
+  // consistency test to check that we didn't lose any events along the way.
+  if (!m_stop)
+    {
+      NS_ASSERT (m_global->unscheduledEvents == 0);
+      for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+        {
+          NS_ASSERT ((*i)->unscheduledEvents == 0);
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  Simulator::Schedule (delay, &Simulator::Stop);
+}
+
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep () << event);
+  NS_ASSERT_MSG (m_threadPartition != 0 || SystemThread::Equals (m_main), "Simulator::Schedule Thread-unsafe invocation!");
+
+  Partition *partition = GetCurrentPartition ();
+  Time tAbsolute = delay + TimeStep (partition->currentTs);
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (partition->currentTs));
+  return Insert (partition, tAbsolute.GetTimeStep (), partition->currentContext, event);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << delay.GetTimeStep () << event);
+
+  Partition *current = m_threadPartition;
+  if (current == 0 && !SystemThread::Equals (m_main))
+    {
+      Scheduler::Event ev;
+      ev.impl = event;
+      // Current time added in MergeOutboxes()
+      ev.key.m_ts = delay.GetTimeStep ();
+      ev.key.m_context = context;
+      ev.key.m_uid = 0;
+      CriticalSection cs (m_mutex);
+      m_foreignEvents.push_back (ev);
+      return;
+    }
+  if (current == 0)
+    {
+      current = m_global;
+    }
+  uint64_t ts = (delay + TimeStep (current->currentTs)).GetTimeStep ();
+  Partition *partition = GetPartition (context);
+  if (partition == current || current == m_global)
+    {
+      // the events without context run alone
+      Insert (partition, ts, context, event);
+      return;
+    }
+  if (ts < m_windowStart + m_runLookahead.GetTimeStep ())
+    {
+      NS_FATAL_ERROR ("Event scheduled in context " << context << " from context "
+                      << current->currentContext << " with a delay of " << delay
+                      << ", less than the Lookahead of " << m_runLookahead);
+    }
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = 0;
+  current->outbox.push_back (ev);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return Schedule (Time (0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  EventId id (Ptr<EventImpl> (event, false), GetCurrentPartition ()->currentTs, 0xffffffff, 2);
+  CriticalSection cs (m_mutex);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  return TimeStep (GetCurrentPartition ()->currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetCurrentPartition ()->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_mutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *partition = GetPartition (id.GetContext ());
+  NS_ASSERT_MSG (m_threadPartition == 0 || m_threadPartition == m_global || m_threadPartition == partition,
+                 "Simulator::Remove of an event of another partition");
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  partition->events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  partition->unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0 ||
+          id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (const_cast<SystemMutex &> (m_mutex));
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  const Partition *partition = GetPartition (id.GetContext ());
+  if (id.PeekEventImpl () == 0 ||
+      id.GetTs () < partition->currentTs ||
+      (id.GetTs () == partition->currentTs &&
+       id.GetUid () <= partition->currentUid) ||
+      id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return GetCurrentPartition ()->currentContext;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetWindowCount (void) const
+{
+  return m_windows;
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookahead (void) const
+{
+  return m_runLookahead;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionCount (void) const
+{
+  return m_partitions.size ();
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionIndex (uint32_t context) const
+{
+  return GetPartition (context)->index;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetThreadPartition (void)
+{
+  return m_threadPartition != 0 ? m_threadPartition->index : NO_PARTITION;
+}
+
+Time
+MultithreadedSimulatorImpl::CalculateLookahead (void) const
+{
+  NS_LOG_FUNCTION (this);
+  Config::MatchContainer channels = Config::LookupMatches ("/ChannelList/*");
+  if (channels.GetN () == 0)
+    {
+      return Seconds (0);
+    }
+  Time lookahead = Time::Max ();
+  for (uint32_t i = 0; i < channels.GetN (); i++)
+    {
+      TimeValue delay;
+      if (!channels.Get (i)->GetAttributeFailSafe ("Delay", delay)
+          && !channels.Get (i)->GetAttributeFailSafe ("MinimumDelay", delay))
+        {
+          NS_LOG_WARN ("Channel " << channels.GetMatchedPath (i) << " has no Delay attribute, "
+                       "running one timestamp per window");
+          return Seconds (0);
+        }
+      lookahead = std::min (lookahead, delay.Get ());
+    }
+  NS_LOG_LOGIC ("Lookahead " << lookahead);
+  return lookahead;
+}
+
+} // namespace ns3
@@ -0,0 +1,295 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "simulator-impl.h"
+#include "scheduler.h"
+#include "event-impl.h"
+#include "system-thread.h"
+#include "system-mutex.h"
+#include "nstime.h"
+#include "ptr.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup simulator
+ * Declaration of class ns3::MultithreadedSimulatorImpl.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ *
+ * A simulator implementation running the event contexts on a pool of
+ * threads within one process.
+ *
+ * The contexts (the node ids given to Simulator::ScheduleWithContext) are
+ * spread over partitions, context modulo the number of partitions, each
+ * with its own event list.  The simulation advances in windows: a window
+ * starts at the earliest pending event and lasts the Lookahead, and the
+ * threads run the events of the window partition by partition in
+ * parallel.  An event scheduled in another partition must be at least
+ * the Lookahead after the start of the window, which holds when the
+ * Lookahead is the smallest delay of the channels between the nodes; it
+ * is moved to its partition, by pointer, at the end of the window.  A
+ * Lookahead of zero runs one timestamp per window.  By default, the
+ * Lookahead is derived at Run from the Delay attribute of the channels
+ * of the ChannelList, or from their MinimumDelay attribute, the smallest
+ * propagation delay of the channels whose delay depends on the positions
+ * of the nodes, as the YansWifiChannel, and is zero if a channel has
+ * neither.
+ *
+ * The events without a context (Simulator::NO_CONTEXT), such as those
+ * scheduled by the main program, are run by the main thread between
+ * windows, while the other threads wait, and can reach any object.
+ *
+ * With more than one thread, the events of a partition must only reach
+ * the objects of its contexts, or objects safe to use from several
+ * threads, and an event scheduled in another partition must not carry
+ * a reference-counted object that the sending partition still uses: the
+ * reference counts of ns-3 objects, and of the buffers shared by the
+ * copies of a packet, are not atomic.  Packet::DeepCopy gives a packet
+ * sharing nothing with the original.  The YansWifiChannel meets this
+ * condition, with the help of GetThreadPartition and GetPartitionIndex.
+ * The point-to-point and csma channels do not, since they schedule the
+ * reception with a pointer to the receiving device and a copy of the
+ * packet sharing its buffer with the packet of the sender: their
+ * topologies must be run with a single thread, or with all the nodes
+ * attached to a channel in the same partition.  Each
+ * thread allocates the packets it creates from pools of its own.  Simulator::Cancel,
+ * Simulator::Remove and Simulator::IsExpired must only be given the
+ * events of the partition of
+ * the caller.  Simulator::Stop called from a context stops the simulation
+ * at the end of the window.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  MultithreadedSimulatorImpl ();
+  /** Destructor. */
+  ~MultithreadedSimulatorImpl ();
+
+  // Inherited
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (const Time &delay);
+  virtual EventId Schedule (const Time &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, const Time &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * \returns The number of windows run.
+   */
+  uint64_t GetWindowCount (void) const;
+  /**
+   * \returns The lookahead of the last run, set by the Lookahead
+   *          attribute or derived from the channels.
+   */
+  Time GetLookahead (void) const;
+  /**
+   * \returns The number of partitions of the contexts.
+   */
+  uint32_t GetPartitionCount (void) const;
+  /**
+   * \param [in] context A context.
+   * \returns The index of the partition of the context, or NO_PARTITION
+   *          for Simulator::NO_CONTEXT.
+   */
+  uint32_t GetPartitionIndex (uint32_t context) const;
+  /**
+   * \returns The index of the partition whose events the calling thread
+   *          is running, or NO_PARTITION outside of these events, when
+   *          the thread is the only one running.
+   */
+  static uint32_t GetThreadPartition (void);
+
+  /** Partition index of the events without context. */
+  static const uint32_t NO_PARTITION = 0xffffffff;
+
+private:
+  virtual void DoDispose (void);
+
+  /** The events of a set of contexts. */
+  struct Partition
+  {
+    /** The event list. */
+    Ptr<Scheduler> events;
+    /** Events scheduled in other partitions during the window. */
+    std::vector<Scheduler::Event> outbox;
+    /** Next event unique id. */
+    uint32_t uid;
+    /** Unique id of the current event. */
+    uint32_t currentUid;
+    /** Timestamp of the current event. */
+    uint64_t currentTs;
+    /** Execution context of the current event. */
+    uint32_t currentContext;
+    /** Number of events in the event list, for the consistency check. */
+    uint64_t unscheduledEvents;
+    /** Index in the partitions, or NO_PARTITION. */
+    uint32_t index;
+  };
+
+  /** Synchronization of the threads at the start and end of a window. */
+  class Barrier
+  {
+  public:
+    /**
+     * Constructor.
+     * \param [in] count The number of threads.
+     */
+    Barrier (uint32_t count);
+    /** Wait for all the threads. */
+    void Wait (void);
+
+  private:
+    std::mutex m_mutex;                 //!< Protects the state
+    std::condition_variable m_cond;     //!< Wakes the waiting threads
+    uint32_t m_count;                   //!< Number of threads
+    uint32_t m_waiting;                 //!< Number of threads waiting
+    uint64_t m_generation;              //!< Number of barriers passed
+  };
+
+  /**
+   * Derive the lookahead from the channels.
+   * \returns The smallest Delay or MinimumDelay attribute of the
+   *          channels, or zero if there is no channel or a channel has
+   *          neither attribute.
+   */
+  Time CalculateLookahead (void) const;
+  /** Create the partitions, once the attributes are set. */
+  void CreatePartitions (void);
+  /**
+   * Get the partition of a context.
+   * \param [in] context The context.
+   * \returns The partition.
+   */
+  Partition * GetPartition (uint32_t context);
+  /**
+   * Get the partition of a context.
+   * \param [in] context The context.
+   * \returns The partition.
+   */
+  const Partition * GetPartition (uint32_t context) const;
+  /**
+   * Get the partition of the calling thread.
+   * \returns The partition of the event being run by the calling thread,
+   *          or the partition of the events without context.
+   */
+  Partition * GetCurrentPartition (void) const;
+  /**
+   * Insert an event in a partition.
+   * \param [in] partition The partition.
+   * \param [in] ts The timestamp.
+   * \param [in] context The context.
+   * \param [in] event The event.
+   * \returns The event id.
+   */
+  EventId Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event);
+  /**
+   * Run an event of a partition.
+   * \param [in] partition The partition.
+   */
+  void ProcessOneEvent (Partition *partition);
+  /** Move the events scheduled in other partitions to their partition. */
+  void MergeOutboxes (void);
+  /**
+   * Run the partitions of the current window, until none is left.
+   */
+  void RunWindow (void);
+  /** Body of the worker threads. */
+  void Worker (void);
+
+  /**
+   * The partition of the event being run by the calling thread, or 0
+   * outside of the events.
+   */
+  static thread_local Partition *m_threadPartition;
+  /** The partitions of the contexts. */
+  std::vector<Partition *> m_partitions;
+  /** The partition of the events without context. */
+  Partition *m_global;
+  /** The factory of the event lists. */
+  ObjectFactory m_schedulerFactory;
+  /** Number of threads, including the main one, or 0 for one per core. */
+  uint32_t m_threadCount;
+  /** Number of partitions, or 0 for four per thread. */
+  uint32_t m_partitionCount;
+  /** Smallest delay of the events scheduled in other partitions, or negative to derive it. */
+  Time m_lookahead;
+
+  /** Events scheduled from threads not running the simulation. */
+  std::list<Scheduler::Event> m_foreignEvents;
+  /** Mutex of m_foreignEvents and m_destroyEvents. */
+  SystemMutex m_mutex;
+  /** Container type for the events to run at Simulator::Destroy() */
+  typedef std::list<EventId> DestroyEvents;
+  /** The container of events to run at Destroy. */
+  DestroyEvents m_destroyEvents;
+
+  /** The worker threads. */
+  std::vector<Ptr<SystemThread> > m_threads;
+  /** Synchronization of the threads. */
+  Barrier *m_barrier;
+  /** Next partition to run in the window. */
+  std::atomic<uint32_t> m_nextPartition;
+  /** The worker threads must exit. */
+  bool m_exit;
+  /** Start of the window. */
+  uint64_t m_windowStart;
+  /** End of the window, excluded. */
+  uint64_t m_windowEnd;
+  /** Number of windows run. */
+  uint64_t m_windows;
+  /** Lookahead of the last run. */
+  Time m_runLookahead;
+  /** Flag calling for the end of the simulation. */
+  std::atomic<bool> m_stop;
+  /** Main execution thread. */
+  SystemThread::ThreadId m_main;
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
@@ -79,96 +79,97 @@ ObjectBase::NotifyConstructionCompleted (void)
 void
 ObjectBase::ConstructSelf (const AttributeConstructionList &attributes)
 {
-  // loop over the inheritance tree back to the Object base class.
+  // loop over the attributes of the type and of its parents, back to the
+  // Object base class.
   NS_LOG_FUNCTION (this << &attributes);
-  TypeId tid = GetInstanceTypeId ();
-  do {
-      // loop over all attributes in object type
-      NS_LOG_DEBUG ("construct tid="<<tid.GetName ()<<", params="<<tid.GetAttributeN ());
-      for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
+  TypeId instanceTid = GetInstanceTypeId ();
+  const TypeId::AttributeTable &table = instanceTid.GetAttributeTable ();
+  NS_LOG_DEBUG ("construct tid="<<instanceTid.GetName ()<<", params="<<table.size ());
+#ifdef HAVE_GETENV
+  char *envVar = getenv ("NS_ATTRIBUTE_DEFAULT");
+#endif /* HAVE_GETENV */
+  for (TypeId::AttributeTable::const_iterator i = table.begin (); i != table.end (); ++i)
+    {
+      TypeId tid = i->first;
+      const struct TypeId::AttributeInformation &info = *i->second;
+      NS_LOG_DEBUG ("try to construct \""<< tid.GetName ()<<"::"<<
+                    info.name <<"\"");
+      // is this attribute stored in this AttributeConstructionList instance ?
+      Ptr<AttributeValue> value = attributes.Find(info.checker);
+      // See if this attribute should not be set here in the
+      // constructor.
+      if (!(info.flags & TypeId::ATTR_CONSTRUCT))
         {
-          struct TypeId::AttributeInformation info = tid.GetAttribute(i);
-          NS_LOG_DEBUG ("try to construct \""<< tid.GetName ()<<"::"<<
-                        info.name <<"\"");
-          // is this attribute stored in this AttributeConstructionList instance ?
-          Ptr<AttributeValue> value = attributes.Find(info.checker);
-          // See if this attribute should not be set here in the
-          // constructor.
-          if (!(info.flags & TypeId::ATTR_CONSTRUCT))
+          // Handle this attribute if it should not be 
+          // set here.
+          if (value == 0)
             {
-              // Handle this attribute if it should not be 
-              // set here.
-              if (value == 0)
-                {
-                  // Skip this attribute if it's not in the
-                  // AttributeConstructionList.
-                  continue;
-                }              
-              else
-                {
-                  // This is an error because this attribute is not
-                  // settable in its constructor but is present in
-                  // the AttributeConstructionList.
-                  NS_FATAL_ERROR ("Attribute name="<<info.name<<" tid="<<tid.GetName () << ": initial value cannot be set using attributes");
-                }
-            }
-          bool found = false;
-          if (value != 0)
-            {
-              // We have a matching attribute value.
-              if (DoSet (info.accessor, info.checker, *value))
-                {
-                  NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                                info.name<<"\"");
-                  found = true;
-                  continue;
-                }
+              // Skip this attribute if it's not in the
+              // AttributeConstructionList.
+              continue;
             }              
-          if (!found)
+          else
+            {
+              // This is an error because this attribute is not
+              // settable in its constructor but is present in
+              // the AttributeConstructionList.
+              NS_FATAL_ERROR ("Attribute name="<<info.name<<" tid="<<tid.GetName () << ": initial value cannot be set using attributes");
+            }
+        }
+      bool found = false;
+      if (value != 0)
+        {
+          // We have a matching attribute value.
+          if (DoSet (info.accessor, info.checker, *value))
             {
-              // No matching attribute value so we try to look at the env var.
+              NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
+                            info.name<<"\"");
+              found = true;
+              continue;
+            }
+        }              
+      if (!found)
+        {
+          // No matching attribute value so we try to look at the env var.
 #ifdef HAVE_GETENV
-              char *envVar = getenv ("NS_ATTRIBUTE_DEFAULT");
-              if (envVar != 0)
+          if (envVar != 0)
+            {
+              std::string env = std::string (envVar);
+              std::string::size_type cur = 0;
+              std::string::size_type next = 0;
+              while (next != std::string::npos)
                 {
-                  std::string env = std::string (envVar);
-                  std::string::size_type cur = 0;
-                  std::string::size_type next = 0;
-                  while (next != std::string::npos)
+                  next = env.find (";", cur);
+                  std::string tmp = std::string (env, cur, next-cur);
+                  std::string::size_type equal = tmp.find ("=");
+                  if (equal != std::string::npos)
                     {
-                      next = env.find (";", cur);
-                      std::string tmp = std::string (env, cur, next-cur);
-                      std::string::size_type equal = tmp.find ("=");
-                      if (equal != std::string::npos)
+                      std::string name = tmp.substr (0, equal);
+                      std::string value = tmp.substr (equal+1, tmp.size () - equal - 1);
+                      if (name == tid.GetName () + "::" + info.name)
                         {
-                          std::string name = tmp.substr (0, equal);
-                          std::string value = tmp.substr (equal+1, tmp.size () - equal - 1);
-                          if (name == tid.GetAttributeFullName (i))
+                          if (DoSet (info.accessor, info.checker, StringValue (value)))
                             {
-                              if (DoSet (info.accessor, info.checker, StringValue (value)))
-                                {
-                                  NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                                                info.name <<"\" from env var");
-                                  found = true;
-                                  break;
-                                }
+                              NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
+                                            info.name <<"\" from env var");
+                              found = true;
+                              break;
                             }
                         }
-                      cur = next + 1;
                     }
+                  cur = next + 1;
                 }
-#endif /* HAVE_GETENV */
-            }
-          if (!found)
-            {
-              // No matching attribute value so we try to set the default value.
-              DoSet (info.accessor, info.checker, *info.initialValue);
-              NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                            info.name <<"\" from initial value.");
             }
+#endif /* HAVE_GETENV */
+        }
+      if (!found)
+        {
+          // No matching attribute value so we try to set the default value.
+          DoSet (info.accessor, info.checker, *info.initialValue);
+          NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
+                        info.name <<"\" from initial value.");
         }
-      tid = tid.GetParent ();
-    } while (tid != ObjectBase::GetTypeId ());
+    }
   NotifyConstructionCompleted ();
 }
 
@@ -178,6 +179,11 @@ ObjectBase::DoSet (Ptr<const AttributeAccessor> accessor,
                    const AttributeValue &value)
 {
   NS_LOG_FUNCTION (this << accessor << checker << &value);
+  if (checker->Check (value))
+    {
+      // no need for the copy made by CreateValidValue
+      return accessor->Set (this, value);
+    }
   Ptr<AttributeValue> v = checker->CreateValidValue (value);
   if (v == 0)
     {
@@ -191,18 +197,18 @@ void
 ObjectBase::SetAttribute (std::string name, const AttributeValue &value)
 {
   NS_LOG_FUNCTION (this << name << &value);
-  struct TypeId::AttributeInformation info;
   TypeId tid = GetInstanceTypeId ();
-  if (!tid.LookupAttributeByName (name, &info))
+  const struct TypeId::AttributeInformation *info = tid.LookupAttributeByName (name);
+  if (info == 0)
     {
       NS_FATAL_ERROR ("Attribute name="<<name<<" does not exist for this object: tid="<<tid.GetName ());
     }
-  if (!(info.flags & TypeId::ATTR_SET) ||
-      !info.accessor->HasSetter ())
+  if (!(info->flags & TypeId::ATTR_SET) ||
+      !info->accessor->HasSetter ())
     {
       NS_FATAL_ERROR ("Attribute name="<<name<<" is not settable for this object: tid="<<tid.GetName ());
     }
-  if (!DoSet (info.accessor, info.checker, value))
+  if (!DoSet (info->accessor, info->checker, value))
     {
       NS_FATAL_ERROR ("Attribute name="<<name<<" could not be set for this object: tid="<<tid.GetName ());
     }
@@ -211,36 +217,36 @@ bool
 ObjectBase::SetAttributeFailSafe (std::string name, const AttributeValue &value)
 {
   NS_LOG_FUNCTION (this << name << &value);
-  struct TypeId::AttributeInformation info;
   TypeId tid = GetInstanceTypeId ();
-  if (!tid.LookupAttributeByName (name, &info))
+  const struct TypeId::AttributeInformation *info = tid.LookupAttributeByName (name);
+  if (info == 0)
     {
       return false;
     }
-  if (!(info.flags & TypeId::ATTR_SET) ||
-      !info.accessor->HasSetter ())
+  if (!(info->flags & TypeId::ATTR_SET) ||
+      !info->accessor->HasSetter ())
     {
       return false;
     }
-  return DoSet (info.accessor, info.checker, value);
+  return DoSet (info->accessor, info->checker, value);
 }
 
 void
 ObjectBase::GetAttribute (std::string name, AttributeValue &value) const
 {
   NS_LOG_FUNCTION (this << name << &value);
-  struct TypeId::AttributeInformation info;
   TypeId tid = GetInstanceTypeId ();
-  if (!tid.LookupAttributeByName (name, &info))
+  const struct TypeId::AttributeInformation *info = tid.LookupAttributeByName (name);
+  if (info == 0)
     {
       NS_FATAL_ERROR ("Attribute name="<<name<<" does not exist for this object: tid="<<tid.GetName ());
     }
-  if (!(info.flags & TypeId::ATTR_GET) || 
-      !info.accessor->HasGetter ())
+  if (!(info->flags & TypeId::ATTR_GET) || 
+      !info->accessor->HasGetter ())
     {
       NS_FATAL_ERROR ("Attribute name="<<name<<" is not gettable for this object: tid="<<tid.GetName ());
     }
-  bool ok = info.accessor->Get (this, value);
+  bool ok = info->accessor->Get (this, value);
   if (ok)
     {
       return;
@@ -250,13 +256,13 @@ ObjectBase::GetAttribute (std::string name, AttributeValue &value) const
     {
       NS_FATAL_ERROR ("Attribute name="<<name<<" tid="<<tid.GetName () << ": input value is not a string");
     }
-  Ptr<AttributeValue> v = info.checker->Create ();
-  ok = info.accessor->Get (this, *PeekPointer (v));
+  Ptr<AttributeValue> v = info->checker->Create ();
+  ok = info->accessor->Get (this, *PeekPointer (v));
   if (!ok)
     {
       NS_FATAL_ERROR ("Attribute name="<<name<<" tid="<<tid.GetName () << ": could not get value");
     }
-  str->Set (v->SerializeToString (info.checker));
+  str->Set (v->SerializeToString (info->checker));
 }
 
 
@@ -264,18 +270,18 @@ bool
 ObjectBase::GetAttributeFailSafe (std::string name, AttributeValue &value) const
 {
   NS_LOG_FUNCTION (this << name << &value);
-  struct TypeId::AttributeInformation info;
   TypeId tid = GetInstanceTypeId ();
-  if (!tid.LookupAttributeByName (name, &info))
+  const struct TypeId::AttributeInformation *info = tid.LookupAttributeByName (name);
+  if (info == 0)
     {
       return false;
     }
-  if (!(info.flags & TypeId::ATTR_GET) ||
-      !info.accessor->HasGetter ())
+  if (!(info->flags & TypeId::ATTR_GET) ||
+      !info->accessor->HasGetter ())
     {
       return false;
     }
-  bool ok = info.accessor->Get (this, value);
+  bool ok = info->accessor->Get (this, value);
   if (ok)
     {
       return true;
@@ -285,13 +291,13 @@ ObjectBase::GetAttributeFailSafe (std::string name, AttributeValue &value) const
     {
       return false;
     }
-  Ptr<AttributeValue> v = info.checker->Create ();
-  ok = info.accessor->Get (this, *PeekPointer (v));
+  Ptr<AttributeValue> v = info->checker->Create ();
+  ok = info->accessor->Get (this, *PeekPointer (v));
   if (!ok)
     {
       return false;
     }
-  str->Set (v->SerializeToString (info.checker));
+  str->Set (v->SerializeToString (info->checker));
   return true;
 }
 
@@ -135,6 +135,15 @@ public:
    * \param [in] ev The event to remove
    */
   virtual void Remove (const Event &ev) = 0;
+  /**
+   * Test if Remove() costs about as much as RemoveNext().
+   *
+   * The simulator then removes the cancelled events at once, instead of
+   * leaving them in the event list until they expire.
+   *
+   * \returns \c true if Remove() does not scan the event list.
+   */
+  virtual bool IsRemoveCheap (void) const;
 };
 
 /**
@@ -23,6 +23,7 @@
 #include "scheduler.h"
 #include "map-scheduler.h"
 #include "event-impl.h"
+#include "event-allocator.h"
 #include "des-metrics.h"
 
 #include "ptr.h"
@@ -167,6 +168,7 @@ Simulator::Destroy (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
+  EventAllocator::Reconfigure ();
   SimulatorImpl **pimpl = PeekImpl (); 
   if (*pimpl == 0)
     {
@@ -0,0 +1,434 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "size-class-allocator.h"
+#include "global-value.h"
+#include "boolean.h"
+#include "uinteger.h"
+#include "fatal-error.h"
+#include "log.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::SizeClassAllocator implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SizeClassAllocator");
+
+namespace {
+
+/** Size class recorded for the blocks allocated with malloc. */
+const uint32_t UNPOOLED = 0xffffffff;
+/** Default bound of the bytes in the free lists. */
+const uint64_t DEFAULT_MAX_FREE_BYTES = 16 * 1024 * 1024;
+
+/** A free block of a pool. */
+struct FreeBlock
+{
+  FreeBlock *next;      //!< Next free block of the same size class
+};
+
+/** The per-thread free lists of all the allocators of a thread. */
+struct ThreadPools
+{
+  SizeClassAllocator::Pool pools[SizeClassAllocator::MAX_ALLOCATORS]; //!< Free lists of each allocator
+};
+
+/**
+ * The free lists of the calling thread, allocated on first use.  A
+ * single pointer, so that it fits in the static TLS of a library loaded
+ * with dlopen.  With GCC and clang, the initial-exec TLS model makes an
+ * access a single load from the thread pointer instead of a call to
+ * __tls_get_addr from the shared library.
+ */
+#if defined (__GNUC__)
+thread_local ThreadPools *t_pools __attribute__ ((tls_model ("initial-exec"))) = 0;
+/** The calling thread has given back its free lists. */
+thread_local bool t_exited __attribute__ ((tls_model ("initial-exec"))) = false;
+#else
+thread_local ThreadPools *t_pools = 0;
+thread_local bool t_exited = false;
+#endif
+
+/** Number of allocators constructed. */
+std::atomic<uint32_t> g_allocators (0);
+
+/**
+ * Give back to the system the free blocks of a pool.
+ *
+ * \param [in] pool The pool.
+ */
+void
+Release (SizeClassAllocator::Pool &pool)
+{
+  for (uint32_t i = 0; i < SizeClassAllocator::MAX_CLASSES; i++)
+    {
+      while (pool.free[i] != 0)
+        {
+          FreeBlock *block = static_cast<FreeBlock *> (pool.free[i]);
+          pool.free[i] = block->next;
+          std::free (block);
+          pool.stats.heapDeallocations++;
+        }
+    }
+  pool.stats.freeBytes = 0;
+}
+
+/**
+ * Gives back the free blocks of a thread when it exits.  Touched only
+ * when the free lists of the thread are created, to keep the per-access
+ * initialization check out of the usual paths.
+ */
+struct ThreadPoolsReleaser
+{
+  bool active;          //!< The free lists of the thread have been created
+  ~ThreadPoolsReleaser ()
+  {
+    t_exited = true;
+    if (t_pools != 0)
+      {
+        for (uint32_t i = 0; i < SizeClassAllocator::MAX_ALLOCATORS; i++)
+          {
+            Release (t_pools->pools[i]);
+          }
+        std::free (t_pools);
+        t_pools = 0;
+      }
+  }
+};
+
+/** The releaser of the free lists of the calling thread. */
+thread_local ThreadPoolsReleaser t_releaser;
+
+/**
+ * \param [in] x A positive number.
+ * \returns The base 2 logarithm of \p x, rounded down.
+ */
+inline uint32_t
+Log2 (std::size_t x)
+{
+#if defined (__GNUC__)
+  return sizeof (unsigned long) * 8 - 1 - __builtin_clzl (x);
+#else
+  uint32_t log2 = 0;
+  while ((x >> (log2 + 1)) != 0)
+    {
+      log2++;
+    }
+  return log2;
+#endif
+}
+
+} // unnamed namespace
+
+/**
+ * The free lists used by the calling thread, with the lock of the
+ * shared free lists held when they are used.
+ */
+class SizeClassAllocator::PoolLock
+{
+public:
+  /**
+   * \param [in] allocator The allocator.
+   */
+  PoolLock (SizeClassAllocator &allocator)
+    : m_allocator (allocator),
+      m_locked (!allocator.m_threadLocal.load (std::memory_order_relaxed))
+  {
+    if (m_locked)
+      {
+        m_allocator.m_mutex.lock ();
+      }
+  }
+  ~PoolLock ()
+  {
+    if (m_locked)
+      {
+        m_allocator.m_mutex.unlock ();
+      }
+  }
+  /**
+   * \returns The free lists used by the calling thread, or 0 when the
+   *          thread is exiting.
+   */
+  Pool * GetPool (void)
+  {
+    return m_locked ? &m_allocator.m_shared : m_allocator.GetThreadPool ();
+  }
+
+private:
+  SizeClassAllocator &m_allocator;      //!< The allocator
+  bool m_locked;                        //!< The shared free lists are used, and their mutex held
+};
+
+SizeClassAllocator::SizeClassAllocator (Layout layout,
+                                        std::string enabledName,
+                                        std::string maxFreeBytesName,
+                                        std::string threadLocalName)
+  : m_layout (layout),
+    m_minClassShift (Log2 (layout.minClassSize)),
+    m_subClassShift (Log2 (layout.subClasses)),
+    m_index (g_allocators++),
+    m_enabledName (enabledName),
+    m_maxFreeBytesName (maxFreeBytesName),
+    m_threadLocalName (threadLocalName),
+    m_configured (false),
+    m_enabled (true),
+    m_threadLocal (true),
+    m_maxFreeBytes (DEFAULT_MAX_FREE_BYTES)
+{
+  NS_LOG_FUNCTION (this << layout.minClassSize << layout.subClasses << layout.maxPooledSize
+                   << enabledName << maxFreeBytesName << threadLocalName);
+  if (m_index >= MAX_ALLOCATORS)
+    {
+      NS_FATAL_ERROR ("Too many size class allocators, at most " << MAX_ALLOCATORS);
+    }
+  if ((std::size_t (1) << m_minClassShift) != layout.minClassSize
+      || (1U << m_subClassShift) != layout.subClasses
+      || m_subClassShift > m_minClassShift
+      || layout.minClassSize < HEADER_SIZE + sizeof (FreeBlock)
+      || layout.maxPooledSize < layout.minClassSize
+      || SizeClass (layout.maxPooledSize) >= MAX_CLASSES)
+    {
+      NS_FATAL_ERROR ("Invalid size class layout " << layout.minClassSize << " "
+                      << layout.subClasses << " " << layout.maxPooledSize);
+    }
+  std::memset (&m_shared, 0, sizeof (m_shared));
+}
+
+void
+SizeClassAllocator::Configure (void)
+{
+  BooleanValue enabled (true);
+  UintegerValue maxFreeBytes (DEFAULT_MAX_FREE_BYTES);
+  BooleanValue threadLocal (true);
+  if ((m_enabledName.empty () || GlobalValue::GetValueByNameFailSafe (m_enabledName, enabled))
+      && (m_maxFreeBytesName.empty () || GlobalValue::GetValueByNameFailSafe (m_maxFreeBytesName, maxFreeBytes))
+      && (m_threadLocalName.empty () || GlobalValue::GetValueByNameFailSafe (m_threadLocalName, threadLocal)))
+    {
+      m_enabled.store (enabled.Get (), std::memory_order_relaxed);
+      m_maxFreeBytes.store (maxFreeBytes.Get (), std::memory_order_relaxed);
+      m_threadLocal.store (threadLocal.Get (), std::memory_order_relaxed);
+      m_configured.store (true, std::memory_order_release);
+    }
+  // before the GlobalValues are constructed, use the default values and
+  // read them again at the next allocation
+}
+
+inline std::size_t
+SizeClassAllocator::ClassSize (uint32_t sizeClass) const
+{
+  if (sizeClass == 0)
+    {
+      return m_layout.minClassSize;
+    }
+  uint32_t log2 = m_minClassShift + ((sizeClass - 1) >> m_subClassShift);
+  uint32_t sub = (sizeClass - 1) & (m_layout.subClasses - 1);
+  return static_cast<std::size_t> (m_layout.subClasses + 1 + sub) << (log2 - m_subClassShift);
+}
+
+inline uint32_t
+SizeClassAllocator::SizeClass (std::size_t total) const
+{
+  if (total <= m_layout.minClassSize)
+    {
+      return 0;
+    }
+  std::size_t x = total - 1;
+  uint32_t log2 = Log2 (x);
+  uint32_t sub = (x >> (log2 - m_subClassShift)) & (m_layout.subClasses - 1);
+  return ((log2 - m_minClassShift) << m_subClassShift) + sub + 1;
+}
+
+inline SizeClassAllocator::Pool *
+SizeClassAllocator::GetThreadPool (void)
+{
+  ThreadPools *pools = t_pools;
+  if (pools == 0)
+    {
+      if (t_exited)
+        {
+          return 0;
+        }
+      pools = static_cast<ThreadPools *> (std::calloc (1, sizeof (ThreadPools)));
+      if (pools == 0)
+        {
+          throw std::bad_alloc ();
+        }
+      t_pools = pools;
+      t_releaser.active = true;
+    }
+  return &pools->pools[m_index];
+}
+
+void *
+SizeClassAllocator::Allocate (std::size_t size, std::size_t &usable)
+{
+  if (!m_configured.load (std::memory_order_acquire))
+    {
+      Configure ();
+    }
+  std::size_t total = HEADER_SIZE + size;
+  PoolLock lock (*this);
+  Pool *pool = lock.GetPool ();
+  char *block;
+  uint32_t sizeClass;
+  if (pool == 0 || !m_enabled.load (std::memory_order_relaxed) || total > m_layout.maxPooledSize)
+    {
+      block = static_cast<char *> (std::malloc (total));
+      sizeClass = UNPOOLED;
+      usable = size;
+      if (pool != 0)
+        {
+          pool->stats.heapAllocations++;
+        }
+    }
+  else
+    {
+      sizeClass = SizeClass (total);
+      std::size_t classSize = ClassSize (sizeClass);
+      usable = classSize - HEADER_SIZE;
+      FreeBlock *free = static_cast<FreeBlock *> (pool->free[sizeClass]);
+      if (free != 0)
+        {
+          pool->free[sizeClass] = free->next;
+          pool->stats.freeBytes -= classSize;
+          pool->stats.pooled++;
+          block = reinterpret_cast<char *> (free);
+        }
+      else
+        {
+          block = static_cast<char *> (std::malloc (classSize));
+          pool->stats.heapAllocations++;
+        }
+    }
+  if (block == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  if (pool != 0)
+    {
+      pool->stats.allocations++;
+      pool->stats.inUse++;
+      if (pool->stats.inUse > pool->stats.maxInUse)
+        {
+          pool->stats.maxInUse = pool->stats.inUse;
+        }
+    }
+  *reinterpret_cast<uint32_t *> (block) = sizeClass;
+  return block + HEADER_SIZE;
+}
+
+void *
+SizeClassAllocator::Allocate (std::size_t size)
+{
+  std::size_t usable;
+  return Allocate (size, usable);
+}
+
+void
+SizeClassAllocator::Deallocate (void *p)
+{
+  if (p == 0)
+    {
+      return;
+    }
+  char *block = static_cast<char *> (p) - HEADER_SIZE;
+  uint32_t sizeClass = *reinterpret_cast<uint32_t *> (block);
+  PoolLock lock (*this);
+  Pool *pool = lock.GetPool ();
+  if (pool == 0)
+    {
+      std::free (block);
+      return;
+    }
+  pool->stats.deallocations++;
+  pool->stats.inUse--;
+  if (sizeClass == UNPOOLED
+      || pool->stats.freeBytes + ClassSize (sizeClass) > m_maxFreeBytes.load (std::memory_order_relaxed))
+    {
+      std::free (block);
+      pool->stats.heapDeallocations++;
+      return;
+    }
+  FreeBlock *free = reinterpret_cast<FreeBlock *> (block);
+  free->next = static_cast<FreeBlock *> (pool->free[sizeClass]);
+  pool->free[sizeClass] = free;
+  pool->stats.freeBytes += ClassSize (sizeClass);
+}
+
+bool
+SizeClassAllocator::IsEnabled (void)
+{
+  if (!m_configured.load (std::memory_order_acquire))
+    {
+      Configure ();
+    }
+  return m_enabled.load (std::memory_order_relaxed);
+}
+
+void
+SizeClassAllocator::Reconfigure (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_configured.store (false, std::memory_order_release);
+}
+
+SizeClassAllocator::Statistics
+SizeClassAllocator::GetStatistics (void)
+{
+  PoolLock lock (*this);
+  Pool *pool = lock.GetPool ();
+  return pool != 0 ? pool->stats : Statistics ();
+}
+
+void
+SizeClassAllocator::ResetStatistics (void)
+{
+  PoolLock lock (*this);
+  Pool *pool = lock.GetPool ();
+  if (pool == 0)
+    {
+      return;
+    }
+  Statistics stats = Statistics ();
+  // the levels are kept, and the number of blocks in use becomes the
+  // high-water mark
+  stats.inUse = pool->stats.inUse;
+  stats.maxInUse = pool->stats.inUse;
+  stats.freeBytes = pool->stats.freeBytes;
+  pool->stats = stats;
+}
+
+void
+SizeClassAllocator::Trim (void)
+{
+  NS_LOG_FUNCTION (this);
+  PoolLock lock (*this);
+  Pool *pool = lock.GetPool ();
+  if (pool != 0)
+    {
+      Release (*pool);
+    }
+}
+
+} // namespace ns3
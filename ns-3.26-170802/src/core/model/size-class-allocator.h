@@ -0,0 +1,203 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef SIZE_CLASS_ALLOCATOR_H
+#define SIZE_CLASS_ALLOCATOR_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <string>
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::SizeClassAllocator declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup core
+ * \brief Memory allocator keeping the freed blocks in a free list per
+ * size class, for the next allocations.
+ *
+ * The size classes start at Layout::minClassSize, then Layout::subClasses
+ * evenly spaced sizes up to each next power of two, so that with four
+ * sub-classes a block wastes at most a fifth of its size.  Each block has
+ * a header of HEADER_SIZE bytes recording its class, which keeps the
+ * blocks aligned as malloc does.  The blocks larger than
+ * Layout::maxPooledSize, header included, are allocated with malloc.
+ * Allocate() returns the usable size of the block, which may be larger
+ * than the requested size.
+ *
+ * By default each thread has its own free lists, without any lock.  A
+ * block freed by another thread than the one which allocated it joins
+ * the free lists of the freeing thread, and the free blocks of a thread
+ * are given back to the system when it exits.  The free lists may
+ * instead be shared by all the threads, protected by a mutex.
+ *
+ * The behavior of an allocator is set by up to three GlobalValues, whose
+ * names are given to the constructor, and read when the first block is
+ * allocated and again after each call to Reconfigure():
+ *  - a boolean enabling the free lists, true if not named;
+ *  - an unsigned integer bounding the bytes kept in the free lists of a
+ *    thread, or in the shared free lists; the blocks freed beyond it are
+ *    given back to the system.  16 MiB if not named;
+ *  - a boolean giving each thread its own free lists, true if not named.
+ *
+ * Blocks allocated before a change of the GlobalValues are freed
+ * correctly afterwards.
+ *
+ * The allocators are meant to live until the end of the program, as
+ * those of EventAllocator and PacketAllocator, which are never destroyed
+ * so that the blocks freed by the static destructors find them.  There
+ * are at most MAX_ALLOCATORS of them.
+ */
+class SizeClassAllocator
+{
+public:
+  /** Size of the header in front of each block. */
+  static const std::size_t HEADER_SIZE = 16;
+  /** Largest number of size classes of an allocator. */
+  static const uint32_t MAX_CLASSES = 40;
+  /** Largest number of allocators. */
+  static const uint32_t MAX_ALLOCATORS = 8;
+
+  /** The size classes of an allocator. */
+  struct Layout
+  {
+    /** Smallest class, header included, a power of two. */
+    std::size_t minClassSize;
+    /** Number of classes between two powers of two, a power of two. */
+    uint32_t subClasses;
+    /** Largest pooled block, header included. */
+    std::size_t maxPooledSize;
+  };
+
+  /** Allocation statistics of the free lists of a thread, or shared. */
+  struct Statistics
+  {
+    uint64_t allocations;       //!< Number of blocks allocated
+    uint64_t deallocations;     //!< Number of blocks freed
+    uint64_t pooled;            //!< Number of blocks allocated from a free list
+    uint64_t heapAllocations;   //!< Number of calls to malloc
+    uint64_t heapDeallocations; //!< Number of calls to free
+    int64_t inUse;              //!< Blocks allocated minus blocks freed
+    int64_t maxInUse;           //!< High-water mark of inUse
+    uint64_t freeBytes;         //!< Bytes held in the free lists
+  };
+
+  /**
+   * \param [in] layout The size classes.
+   * \param [in] enabledName The name of the GlobalValue enabling the
+   *                         free lists, or empty.
+   * \param [in] maxFreeBytesName The name of the GlobalValue bounding the
+   *                              bytes in the free lists, or empty.
+   * \param [in] threadLocalName The name of the GlobalValue giving each
+   *                             thread its own free lists, or empty.
+   */
+  SizeClassAllocator (Layout layout,
+                      std::string enabledName,
+                      std::string maxFreeBytesName,
+                      std::string threadLocalName);
+
+  /**
+   * \param [in] size The requested size, in bytes.
+   * \param [out] usable The usable size of the block, at least \p size.
+   * \returns The memory of the block.
+   */
+  void * Allocate (std::size_t size, std::size_t &usable);
+  /**
+   * \param [in] size The requested size, in bytes.
+   * \returns The memory of the block.
+   */
+  void * Allocate (std::size_t size);
+  /**
+   * \param [in] p The memory of a block returned by Allocate(), or 0.
+   */
+  void Deallocate (void *p);
+  /**
+   * \returns \c true if the blocks are allocated from the free lists.
+   */
+  bool IsEnabled (void);
+  /**
+   * Read the GlobalValues again before the next allocation.
+   */
+  void Reconfigure (void);
+  /**
+   * \returns The statistics of the free lists used by the calling thread.
+   */
+  Statistics GetStatistics (void);
+  /** Reset the statistics of the free lists used by the calling thread. */
+  void ResetStatistics (void);
+  /**
+   * Give back to the system the free blocks of the free lists used by
+   * the calling thread.
+   */
+  void Trim (void);
+
+  /**
+   * The free lists of an allocator, for a thread or shared.  Plain data,
+   * so that the per-thread instances need no construction.
+   */
+  struct Pool
+  {
+    void *free[MAX_CLASSES];    //!< Free list of each size class
+    Statistics stats;           //!< Statistics of the free lists
+  };
+
+private:
+  /** Read the GlobalValues. */
+  void Configure (void);
+  /**
+   * \param [in] sizeClass A size class.
+   * \returns The size of the blocks of the class, header included.
+   */
+  std::size_t ClassSize (uint32_t sizeClass) const;
+  /**
+   * \param [in] total The size of a block, header included, at most
+   *                   Layout::maxPooledSize.
+   * \returns The smallest size class holding the block.
+   */
+  uint32_t SizeClass (std::size_t total) const;
+  /**
+   * \returns The free lists of the calling thread, or 0 when the thread
+   *          is exiting.
+   */
+  Pool * GetThreadPool (void);
+
+  /** The free lists used by the calling thread, locked if shared. */
+  class PoolLock;
+
+  Layout m_layout;                      //!< The size classes
+  uint32_t m_minClassShift;             //!< Base 2 logarithm of Layout::minClassSize
+  uint32_t m_subClassShift;             //!< Base 2 logarithm of Layout::subClasses
+  uint32_t m_index;                     //!< Index of the per-thread free lists
+  std::string m_enabledName;            //!< Name of the GlobalValue enabling the free lists
+  std::string m_maxFreeBytesName;       //!< Name of the GlobalValue bounding the free bytes
+  std::string m_threadLocalName;        //!< Name of the GlobalValue giving per-thread free lists
+  std::atomic<bool> m_configured;       //!< The GlobalValues have been read
+  std::atomic<bool> m_enabled;          //!< The free lists are used
+  std::atomic<bool> m_threadLocal;      //!< Each thread has its own free lists
+  std::atomic<uint64_t> m_maxFreeBytes; //!< Bound of the bytes in the free lists
+  Pool m_shared;                        //!< The free lists shared by the threads
+  std::mutex m_mutex;                   //!< Mutex of m_shared
+};
+
+} // namespace ns3
+
+#endif /* SIZE_CLASS_ALLOCATOR_H */
@@ -0,0 +1,293 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "timing-wheel-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+#include <cstring>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::TimingWheelScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TimingWheelScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (TimingWheelScheduler);
+
+namespace {
+
+/**
+ * Compare the uids of two events of the same slot of wheel 0.
+ *
+ * \param [in] a The first event.
+ * \param [in] b The second event.
+ * \returns \c true if \p a was inserted before \p b.
+ */
+bool
+UidLess (const Scheduler::Event &a, const Scheduler::Event &b)
+{
+  return a.key.m_uid < b.key.m_uid;
+}
+
+} // unnamed namespace
+
+TypeId
+TimingWheelScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TimingWheelScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<TimingWheelScheduler> ()
+  ;
+  return tid;
+}
+
+TimingWheelScheduler::TimingWheelScheduler ()
+  : m_current (0),
+    m_size (0)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t wheel = 0; wheel < N_WHEELS; wheel++)
+    {
+      for (uint32_t slot = 0; slot < N_SLOTS; slot++)
+        {
+          m_slots[wheel][slot].m_head = 0;
+        }
+    }
+  std::memset (m_occupied, 0, sizeof (m_occupied));
+}
+
+TimingWheelScheduler::~TimingWheelScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TimingWheelScheduler::Locate (uint64_t ts, uint32_t &wheel, uint32_t &slot) const
+{
+  NS_ASSERT (ts >= m_current);
+  uint64_t diff = ts ^ m_current;
+  wheel = diff == 0 ? 0 : (63 - __builtin_clzll (diff)) / 8;
+  slot = (ts >> (8 * wheel)) & (N_SLOTS - 1);
+}
+
+void
+TimingWheelScheduler::DoInsert (const Event &ev)
+{
+  uint32_t wheel;
+  uint32_t slot;
+  Locate (ev.key.m_ts, wheel, slot);
+  NS_LOG_LOGIC ("insert ts=" << ev.key.m_ts << " in wheel=" << wheel << ", slot=" << slot);
+  std::vector<Event> &events = m_slots[wheel][slot].m_events;
+  if (wheel == 0 && !events.empty () && ev.key.m_uid < events.back ().key.m_uid)
+    {
+      // cascaded events may come after events inserted directly
+      std::vector<Event>::iterator begin = events.begin () + m_slots[wheel][slot].m_head;
+      events.insert (std::upper_bound (begin, events.end (), ev, UidLess), ev);
+    }
+  else
+    {
+      events.push_back (ev);
+    }
+  m_occupied[wheel][slot / 64] |= (uint64_t)1 << (slot % 64);
+}
+
+uint32_t
+TimingWheelScheduler::FirstSlot (uint32_t wheel) const
+{
+  for (uint32_t word = 0; word < N_WORDS; word++)
+    {
+      if (m_occupied[wheel][word] != 0)
+        {
+          return word * 64 + __builtin_ctzll (m_occupied[wheel][word]);
+        }
+    }
+  return N_SLOTS;
+}
+
+void
+TimingWheelScheduler::ClearSlot (uint32_t wheel, uint32_t slot)
+{
+  m_slots[wheel][slot].m_events.clear ();
+  m_slots[wheel][slot].m_head = 0;
+  m_occupied[wheel][slot / 64] &= ~((uint64_t)1 << (slot % 64));
+}
+
+void
+TimingWheelScheduler::Advance (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_size == 0 || !m_early.empty ())
+    {
+      return;
+    }
+  while (FirstSlot (0) == N_SLOTS)
+    {
+      uint32_t wheel = 1;
+      uint32_t slot = FirstSlot (wheel);
+      while (slot == N_SLOTS)
+        {
+          wheel++;
+          NS_ASSERT (wheel < N_WHEELS);
+          slot = FirstSlot (wheel);
+        }
+      // the lower wheels are empty: move to the start of the slot, in
+      // which the next event is, and spread its events over them
+      uint32_t shift = 8 * wheel;
+      uint64_t above = shift + 8 < 64 ? (m_current >> (shift + 8)) << (shift + 8) : 0;
+      m_current = above | ((uint64_t)slot << shift);
+      NS_LOG_LOGIC ("cascade wheel=" << wheel << ", slot=" << slot << ", current=" << m_current);
+      std::vector<Event> events;
+      events.swap (m_slots[wheel][slot].m_events);
+      ClearSlot (wheel, slot);
+      for (std::vector<Event>::const_iterator i = events.begin (); i != events.end (); ++i)
+        {
+          DoInsert (*i);
+        }
+      // give the storage back to the slot for its next events
+      events.clear ();
+      m_slots[wheel][slot].m_events.swap (events);
+    }
+}
+
+void
+TimingWheelScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  if (ev.key.m_ts < m_current)
+    {
+      m_early.insert (std::make_pair (ev.key, ev.impl));
+    }
+  else
+    {
+      DoInsert (ev);
+    }
+  m_size++;
+  Advance ();
+}
+
+bool
+TimingWheelScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_size == 0;
+}
+
+Scheduler::Event
+TimingWheelScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (!m_early.empty ())
+    {
+      Event ev;
+      ev.impl = m_early.begin ()->second;
+      ev.key = m_early.begin ()->first;
+      return ev;
+    }
+  uint32_t slot = FirstSlot (0);
+  NS_ASSERT (slot != N_SLOTS);
+  const Slot &s = m_slots[0][slot];
+  return s.m_events[s.m_head];
+}
+
+Scheduler::Event
+TimingWheelScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Event ev;
+  if (!m_early.empty ())
+    {
+      ev.impl = m_early.begin ()->second;
+      ev.key = m_early.begin ()->first;
+      m_early.erase (m_early.begin ());
+    }
+  else
+    {
+      uint32_t slot = FirstSlot (0);
+      NS_ASSERT (slot != N_SLOTS);
+      Slot &s = m_slots[0][slot];
+      ev = s.m_events[s.m_head];
+      s.m_head++;
+      if (s.m_head == s.m_events.size ())
+        {
+          ClearSlot (0, slot);
+        }
+      m_current = ev.key.m_ts;
+    }
+  m_size--;
+  Advance ();
+  return ev;
+}
+
+void
+TimingWheelScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  if (ev.key.m_ts < m_current)
+    {
+      std::map<EventKey, EventImpl *>::iterator i = m_early.find (ev.key);
+      NS_ASSERT (i != m_early.end () && i->second == ev.impl);
+      m_early.erase (i);
+    }
+  else
+    {
+      uint32_t wheel;
+      uint32_t slot;
+      Locate (ev.key.m_ts, wheel, slot);
+      Slot &s = m_slots[wheel][slot];
+      std::vector<Event>::iterator begin = s.m_events.begin () + s.m_head;
+      if (wheel == 0)
+        {
+          std::vector<Event>::iterator i = std::lower_bound (begin, s.m_events.end (), ev, UidLess);
+          NS_ASSERT (i != s.m_events.end () && i->key.m_uid == ev.key.m_uid && i->impl == ev.impl);
+          s.m_events.erase (i);
+        }
+      else
+        {
+          std::vector<Event>::iterator i = begin;
+          while (i != s.m_events.end () && i->key.m_uid != ev.key.m_uid)
+            {
+              ++i;
+            }
+          NS_ASSERT (i != s.m_events.end () && i->impl == ev.impl);
+          *i = s.m_events.back ();
+          s.m_events.pop_back ();
+        }
+      if (s.m_head == s.m_events.size ())
+        {
+          ClearSlot (wheel, slot);
+        }
+    }
+  m_size--;
+  Advance ();
+}
+
+bool
+TimingWheelScheduler::IsRemoveCheap (void) const
+{
+  return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TIMING_WHEEL_SCHEDULER_H
+#define TIMING_WHEEL_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+#include <map>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::TimingWheelScheduler class.
+ */
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup scheduler
+ * \brief a hierarchical timing wheel event scheduler
+ *
+ * The 64-bit timestamps are split in eight bytes, one per wheel, and each
+ * wheel has one slot per value of its byte.  An event is stored in the
+ * wheel of the most significant byte in which its timestamp differs from
+ * the current time, in the slot of the value of that byte, so that wheel 0
+ * holds the events of the next 256 time steps, one timestamp per slot,
+ * wheel 1 those of the next 65536 time steps, 256 per slot, and so on.
+ *
+ * When wheel 0 runs empty, the first slot of the lowest non-empty wheel
+ * is cascaded: the current time moves to the start of that slot, and its
+ * events are spread over the lower wheels.  Each event is therefore moved
+ * at most seven times, and insertion and removal are O(1) amortized
+ * whatever the mix of timescales, without any resizing heuristic.  A
+ * bitmap of the non-empty slots of each wheel finds the next slot in a
+ * few instructions.
+ *
+ * Within a slot of wheel 0, the events are kept in increasing order of
+ * uid, to be run in insertion order.  The events scheduled before the
+ * current time of the wheels, which happens only if the simulator is
+ * asked for its next event time and then schedules an earlier one, are
+ * kept in a std::map.
+ */
+class TimingWheelScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  TimingWheelScheduler ();
+  /** Destructor. */
+  virtual ~TimingWheelScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+  virtual bool IsRemoveCheap (void) const;
+
+private:
+  /** Number of wheels, one per byte of the timestamps. */
+  static const uint32_t N_WHEELS = 8;
+  /** Number of slots of a wheel. */
+  static const uint32_t N_SLOTS = 256;
+  /** Number of 64-bit words of the bitmap of a wheel. */
+  static const uint32_t N_WORDS = N_SLOTS / 64;
+
+  /** A slot of a wheel. */
+  struct Slot
+  {
+    /**
+     * The events of the slot, from index m_head.  In wheel 0 they are
+     * sorted by uid; in the other wheels they are unsorted.
+     */
+    std::vector<Scheduler::Event> m_events;
+    /** Index of the first event of wheel 0 slots not yet removed. */
+    uint32_t m_head;
+  };
+
+  /**
+   * Get the wheel and slot of an event in the wheels.
+   *
+   * \param [in] ts The timestamp of the event, not before m_current.
+   * \param [out] wheel The wheel index.
+   * \param [out] slot The slot index.
+   */
+  void Locate (uint64_t ts, uint32_t &wheel, uint32_t &slot) const;
+  /**
+   * Insert an event in the wheels.
+   *
+   * \param [in] ev The event, not before m_current.
+   */
+  void DoInsert (const Scheduler::Event &ev);
+  /**
+   * Get the first non-empty slot of a wheel.
+   *
+   * \param [in] wheel The wheel index.
+   * \returns The slot index, or N_SLOTS if the wheel is empty.
+   */
+  uint32_t FirstSlot (uint32_t wheel) const;
+  /**
+   * Mark a slot empty and release its events.
+   *
+   * \param [in] wheel The wheel index.
+   * \param [in] slot The slot index.
+   */
+  void ClearSlot (uint32_t wheel, uint32_t slot);
+  /**
+   * Cascade the higher wheels until wheel 0 or the early events hold the
+   * next event, if there is one.
+   */
+  void Advance (void);
+
+  /** The slots, wheel after wheel. */
+  Slot m_slots[N_WHEELS][N_SLOTS];
+  /** The non-empty slots of each wheel. */
+  uint64_t m_occupied[N_WHEELS][N_WORDS];
+  /**
+   * The current time of the wheels: every event in the wheels is at or
+   * after it.
+   */
+  uint64_t m_current;
+  /** Events scheduled before m_current. */
+  std::map<Scheduler::EventKey, EventImpl *> m_early;
+  /** Number of events in the scheduler. */
+  uint32_t m_size;
+};
+
+} // namespace ns3
+
+#endif /* TIMING_WHEEL_SCHEDULER_H */
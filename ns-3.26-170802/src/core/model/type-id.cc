@@ -23,7 +23,9 @@
 #include "singleton.h"
 #include "trace-source-accessor.h"
 
+#include <deque>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <sstream>
 #include <iomanip>
@@ -270,6 +272,26 @@ public:
    * \returns \c true if this TypeId should be hidden from the user.
    */
   bool MustHideFromDocumentation (uint16_t uid) const;
+  /**
+   * Get the attributes of a type id and of its parents.
+   * \param [in] uid The id.
+   * \returns The attributes, see TypeId::GetAttributeTable().
+   */
+  const TypeId::AttributeTable & GetAttributeTable (uint16_t uid) const;
+  /**
+   * Find an Attribute of a type id or of its parents.
+   * \param [in] uid The id.
+   * \param [in] name The Attribute name.
+   * \returns The Attribute information, or 0 if not found.
+   */
+  const struct TypeId::AttributeInformation * LookupAttribute (uint16_t uid, const std::string &name) const;
+  /**
+   * Find a TraceSource of a type id or of its parents.
+   * \param [in] uid The id.
+   * \param [in] name The TraceSource name.
+   * \returns The TraceSource information, or 0 if not found.
+   */
+  const struct TypeId::TraceSourceInformation * LookupTraceSource (uint16_t uid, const std::string &name) const;
 
 private:
   /**
@@ -293,6 +315,21 @@ private:
    */
   static TypeId::hash_t Hasher (const std::string name);
 
+  /**
+   * The attributes and trace sources of a type id and of its parents,
+   * indexed by name.
+   */
+  struct Tables {
+    /** \c true once the tables have been filled. */
+    bool built;
+    /** The attributes, in the order of TypeId::GetAttributeTable(). */
+    TypeId::AttributeTable attributes;
+    /** The attributes by name. */
+    std::unordered_map<std::string, const TypeId::AttributeInformation *> attributesByName;
+    /** The trace sources by name. */
+    std::unordered_map<std::string, const TypeId::TraceSourceInformation *> traceSourcesByName;
+  };
+
   /** The information record about a single type id. */
   struct IidInformation {
     /** The type id name. */
@@ -319,9 +356,11 @@ private:
     TypeId::SupportLevel supportLevel;
     /** Support message. */
     std::string supportMsg;
+    /** Own and inherited attributes and trace sources, built on first use. */
+    Tables tables;
   };
   /** Iterator type. */
-  typedef std::vector<struct IidInformation>::const_iterator Iterator;
+  typedef std::deque<struct IidInformation>::const_iterator Iterator;
 
   /**
    * Retrieve the information record for a type.
@@ -329,9 +368,25 @@ private:
    * \returns The information record.
    */
   struct IidManager::IidInformation *LookupInformation (uint16_t uid) const;
+  /**
+   * Retrieve the tables of a type, building them if needed.
+   * \param [in] uid The id.
+   * \returns The tables.
+   */
+  const Tables & GetTables (uint16_t uid) const;
+  /**
+   * Clear the tables of a type and of all the types derived from it,
+   * when it changes.
+   * \param [in] uid The id.
+   */
+  void InvalidateTables (uint16_t uid);
 
-  /** The container of all type id records. */
-  std::vector<struct IidInformation> m_information;
+  /**
+   * The container of all type id records.  The records do not move
+   * when types are added, so that the tables of a type can refer to the
+   * attributes and trace sources of its parents.
+   */
+  std::deque<struct IidInformation> m_information;
 
   /** Type of the by-name index. */
   typedef std::map<std::string, uint16_t> namemap_t;
@@ -429,6 +484,7 @@ IidManager::AllocateUid (std::string name)
   information.size = (std::size_t)(-1);
   information.hasConstructor = false;
   information.mustHideFromDocumentation = false;
+  information.tables.built = false;
   m_information.push_back (information);
   uint32_t uid = m_information.size ();
   NS_ASSERT (uid <= 0xffff);
@@ -456,6 +512,7 @@ IidManager::SetParent (uint16_t uid, uint16_t parent)
   NS_ASSERT (parent <= m_information.size ());
   struct IidInformation *information = LookupInformation (uid);
   information->parent = parent;
+  InvalidateTables (uid);
 }
 void 
 IidManager::SetGroupName (uint16_t uid, std::string groupName)
@@ -665,6 +722,7 @@ IidManager::AddAttribute (uint16_t uid,
   info.supportLevel = supportLevel;
   info.supportMsg = supportMsg;
   information->attributes.push_back (info);
+  InvalidateTables (uid);
   NS_LOG_LOGIC (IIDL << information->attributes.size () - 1);
 }
 void 
@@ -756,6 +814,7 @@ IidManager::AddTraceSource (uint16_t uid,
   source.supportLevel = supportLevel;
   source.supportMsg = supportMsg;
   information->traceSources.push_back (source);
+  InvalidateTables (uid);
   NS_LOG_LOGIC (IIDL << information->traceSources.size () - 1);
 }
 uint32_t 
@@ -786,6 +845,107 @@ IidManager::MustHideFromDocumentation (uint16_t uid) const
   return hide;
 }
 
+const IidManager::Tables &
+IidManager::GetTables (uint16_t uid) const
+{
+  NS_LOG_FUNCTION (IID << uid);
+  struct IidInformation *information = LookupInformation (uid);
+  Tables &tables = information->tables;
+  if (tables.built)
+    {
+      return tables;
+    }
+  uint16_t tid = uid;
+  while (true)
+    {
+      struct IidInformation *current = LookupInformation (tid);
+      for (uint32_t i = 0; i < current->attributes.size (); i++)
+        {
+          const struct TypeId::AttributeInformation *attribute = &current->attributes[i];
+          tables.attributes.push_back (std::make_pair (TypeId (tid), attribute));
+          // the attributes of the derived types hide those of their parents
+          tables.attributesByName.insert (std::make_pair (attribute->name, attribute));
+        }
+      for (uint32_t i = 0; i < current->traceSources.size (); i++)
+        {
+          const struct TypeId::TraceSourceInformation *source = &current->traceSources[i];
+          tables.traceSourcesByName.insert (std::make_pair (source->name, source));
+        }
+      if (current->parent == tid || current->parent == 0)
+        {
+          // top of inheritance tree
+          break;
+        }
+      tid = current->parent;
+    }
+  tables.built = true;
+  NS_LOG_LOGIC (IIDL << tables.attributes.size () << " attributes, "
+                << tables.traceSourcesByName.size () << " trace sources");
+  return tables;
+}
+
+void
+IidManager::InvalidateTables (uint16_t uid)
+{
+  NS_LOG_FUNCTION (IID << uid);
+  for (uint32_t i = 0; i < m_information.size (); i++)
+    {
+      Tables &tables = m_information[i].tables;
+      if (!tables.built)
+        {
+          continue;
+        }
+      // is uid the type itself or one of its parents ?
+      uint16_t tid = i + 1;
+      while (tid != uid && m_information[tid - 1].parent != tid && m_information[tid - 1].parent != 0)
+        {
+          tid = m_information[tid - 1].parent;
+        }
+      if (tid == uid)
+        {
+          tables.built = false;
+          tables.attributes.clear ();
+          tables.attributesByName.clear ();
+          tables.traceSourcesByName.clear ();
+        }
+    }
+}
+
+const TypeId::AttributeTable &
+IidManager::GetAttributeTable (uint16_t uid) const
+{
+  NS_LOG_FUNCTION (IID << uid);
+  return GetTables (uid).attributes;
+}
+
+const struct TypeId::AttributeInformation *
+IidManager::LookupAttribute (uint16_t uid, const std::string &name) const
+{
+  NS_LOG_FUNCTION (IID << uid << name);
+  const Tables &tables = GetTables (uid);
+  std::unordered_map<std::string, const TypeId::AttributeInformation *>::const_iterator i =
+    tables.attributesByName.find (name);
+  if (i == tables.attributesByName.end ())
+    {
+      return 0;
+    }
+  return i->second;
+}
+
+const struct TypeId::TraceSourceInformation *
+IidManager::LookupTraceSource (uint16_t uid, const std::string &name) const
+{
+  NS_LOG_FUNCTION (IID << uid << name);
+  const Tables &tables = GetTables (uid);
+  std::unordered_map<std::string, const TypeId::TraceSourceInformation *>::const_iterator i =
+    tables.traceSourcesByName.find (name);
+  if (i == tables.traceSourcesByName.end ())
+    {
+      return 0;
+    }
+  return i->second;
+}
+
 } // namespace ns3
 
 namespace ns3 {
@@ -866,38 +1026,43 @@ bool
 TypeId::LookupAttributeByName (std::string name, struct TypeId::AttributeInformation *info) const
 {
   NS_LOG_FUNCTION (this << name << info);
-  TypeId tid;
-  TypeId nextTid = *this;
-  do {
-      tid = nextTid;
-      for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
-        {
-          struct TypeId::AttributeInformation tmp = tid.GetAttribute(i);
-          if (tmp.name == name)
-            {
-              if (tmp.supportLevel == TypeId::SUPPORTED)
-                {
-                  *info = tmp;
-                  return true;
-                }
-              else if (tmp.supportLevel == TypeId::DEPRECATED)
-                {
-                  std::cerr << "Attribute '" << name << "' is deprecated: "
-                                 << tmp.supportMsg << std::endl;
-                  *info = tmp;
-                  return true;
-                }
-              else if (tmp.supportLevel == TypeId::OBSOLETE)
-                {
-                  NS_FATAL_ERROR ("Attribute '" << name
-                                  << "' is obsolete, with no fallback: "
-                                  << tmp.supportMsg);
-                }
-            }
-        }
-      nextTid = tid.GetParent ();
-    } while (nextTid != tid);
-  return false;
+  const struct TypeId::AttributeInformation *tmp = LookupAttributeByName (name);
+  if (tmp == 0)
+    {
+      return false;
+    }
+  *info = *tmp;
+  return true;
+}
+
+const struct TypeId::AttributeInformation *
+TypeId::LookupAttributeByName (std::string name) const
+{
+  NS_LOG_FUNCTION (this << name);
+  const struct TypeId::AttributeInformation *info = IidManager::Get ()->LookupAttribute (m_tid, name);
+  if (info == 0)
+    {
+      return 0;
+    }
+  if (info->supportLevel == TypeId::DEPRECATED)
+    {
+      std::cerr << "Attribute '" << name << "' is deprecated: "
+                << info->supportMsg << std::endl;
+    }
+  else if (info->supportLevel == TypeId::OBSOLETE)
+    {
+      NS_FATAL_ERROR ("Attribute '" << name
+                      << "' is obsolete, with no fallback: "
+                      << info->supportMsg);
+    }
+  return info;
+}
+
+const TypeId::AttributeTable &
+TypeId::GetAttributeTable (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return IidManager::Get ()->GetAttributeTable (m_tid);
 }
 
 TypeId 
@@ -1121,51 +1286,59 @@ TypeId::HideFromDocumentation (void)
   return *this;
 }
 
+/**
+ * Find a TraceSource of a type or of its parents, and check its support
+ * level.
+ * \param [in] uid The id of the type.
+ * \param [in] name The name of the TraceSource.
+ * \returns The TraceSource information, or 0 if not found.
+ */
+static const struct TypeId::TraceSourceInformation *
+LookupSupportedTraceSource (uint16_t uid, const std::string &name)
+{
+  const struct TypeId::TraceSourceInformation *info = IidManager::Get ()->LookupTraceSource (uid, name);
+  if (info == 0)
+    {
+      return 0;
+    }
+  if (info->supportLevel == TypeId::DEPRECATED)
+    {
+      std::cerr << "TraceSource '" << name << "' is deprecated: "
+                << info->supportMsg << std::endl;
+    }
+  else if (info->supportLevel == TypeId::OBSOLETE)
+    {
+      NS_FATAL_ERROR ("TraceSource '" << name
+                      << "' is obsolete, with no fallback: "
+                      << info->supportMsg);
+    }
+  return info;
+}
+
 Ptr<const TraceSourceAccessor>
 TypeId::LookupTraceSourceByName (std::string name,
                                  struct TraceSourceInformation *info) const
 {
   NS_LOG_FUNCTION (this << name);
-  TypeId tid;
-  TypeId nextTid = *this;
-  struct TypeId::TraceSourceInformation tmp;
-  do {
-      tid = nextTid;
-      for (uint32_t i = 0; i < tid.GetTraceSourceN (); i++)
-        {
-          tmp = tid.GetTraceSource (i);
-          if (tmp.name == name)
-            {
-              if (tmp.supportLevel == TypeId::SUPPORTED)
-                {
-                  *info = tmp;
-                   return tmp.accessor;
-                }
-              else if (tmp.supportLevel == TypeId::DEPRECATED)
-                {
-                  std::cerr << "TraceSource '" << name << "' is deprecated: "
-                                 << tmp.supportMsg << std::endl;
-                  *info = tmp;
-                  return tmp.accessor;
-                }
-              else  if (tmp.supportLevel == TypeId::OBSOLETE)
-                {
-                  NS_FATAL_ERROR ("TraceSource '" << name
-                                  << "' is obsolete, with no fallback: "
-                                  << tmp.supportMsg);
-                }
-            }
-        }
-      nextTid = tid.GetParent ();
-    } while (nextTid != tid);
-  return 0;
+  const struct TypeId::TraceSourceInformation *tmp = LookupSupportedTraceSource (m_tid, name);
+  if (tmp == 0)
+    {
+      return 0;
+    }
+  *info = *tmp;
+  return tmp->accessor;
 }
 
 Ptr<const TraceSourceAccessor> 
 TypeId::LookupTraceSourceByName (std::string name) const
 {
-  struct TraceSourceInformation info;
-  return LookupTraceSourceByName (name, &info);
+  NS_LOG_FUNCTION (this << name);
+  const struct TypeId::TraceSourceInformation *info = LookupSupportedTraceSource (m_tid, name);
+  if (info == 0)
+    {
+      return 0;
+    }
+  return info->accessor;
 }
 
 uint16_t 
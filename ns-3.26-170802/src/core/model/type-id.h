@@ -28,6 +28,8 @@
 #include "deprecated.h"
 #include "hash.h"
 #include <string>
+#include <utility>
+#include <vector>
 #include <stdint.h>
 
 /**
@@ -485,6 +487,34 @@ public:
    * \returns \c true if the requested attribute could be found.
    */
   bool LookupAttributeByName (std::string name, struct AttributeInformation *info) const;
+  /**
+   * Find an Attribute by name, without copying its AttributeInformation.
+   *
+   * The attributes of this TypeId and of its parents are indexed by
+   * name on the first lookup.
+   *
+   * \param [in] name The name of the requested attribute
+   * \returns The information of the attribute, or 0 if it could not be
+   *          found.  It is valid until an attribute is added to this
+   *          TypeId or to one of its parents.
+   */
+  const struct AttributeInformation * LookupAttributeByName (std::string name) const;
+
+  /**
+   * The attributes of a TypeId and of its parents, each with the TypeId
+   * which declares it.
+   */
+  typedef std::vector<std::pair<TypeId, const struct AttributeInformation *> > AttributeTable;
+  /**
+   * Get the attributes of this TypeId and of its parents.
+   *
+   * The table lists the attributes of this TypeId, then those of its
+   * parent, and so on.  It is built on first use, and is valid until an
+   * attribute is added to one of these TypeIds.
+   *
+   * \returns The attributes.
+   */
+  const AttributeTable & GetAttributeTable (void) const;
   /**
    * Find a TraceSource by name.
    *
@@ -559,6 +589,9 @@ private:
   friend  bool operator <  (TypeId a, TypeId b);
   /**@}*/
 
+  /** IidManager fills the attribute tables. */
+  friend class IidManager;
+
   /**
    * Construct from an integer value.
    * \param [in] tid The TypeId value as an integer.
@@ -27,6 +27,7 @@
 #include "ns3/singleton.h"
 #include "ns3/object.h"
 #include "ns3/object-vector.h"
+#include "ns3/object-map.h"
 #include "ns3/names.h"
 #include "ns3/pointer.h"
 #include "ns3/log.h"
@@ -46,6 +47,7 @@ public:
 
   void AddNodeA (Ptr<ConfigTestObject> a);
   void AddNodeB (Ptr<ConfigTestObject> b);
+  void AddNodeC (uint32_t index, Ptr<ConfigTestObject> c);
 
   void SetNodeA (Ptr<ConfigTestObject> a);
   void SetNodeB (Ptr<ConfigTestObject> b);
@@ -56,6 +58,7 @@ public:
 private:
   std::vector<Ptr<ConfigTestObject> > m_nodesA;
   std::vector<Ptr<ConfigTestObject> > m_nodesB;
+  std::map<uint32_t, Ptr<ConfigTestObject> > m_nodesC;
   Ptr<ConfigTestObject> m_nodeA;
   Ptr<ConfigTestObject> m_nodeB;
   int8_t m_a;
@@ -76,6 +79,10 @@ ConfigTestObject::GetTypeId (void)
                    ObjectVectorValue (),
                    MakeObjectVectorAccessor (&ConfigTestObject::m_nodesB),
                    MakeObjectVectorChecker<ConfigTestObject> ())
+    .AddAttribute ("NodesC", "",
+                   ObjectMapValue (),
+                   MakeObjectMapAccessor (&ConfigTestObject::m_nodesC),
+                   MakeObjectMapChecker<ConfigTestObject> ())
     .AddAttribute ("NodeA", "",
                    PointerValue (),
                    MakePointerAccessor (&ConfigTestObject::m_nodeA),
@@ -127,6 +134,12 @@ ConfigTestObject::AddNodeB (Ptr<ConfigTestObject> b)
   m_nodesB.push_back (b);
 }
 
+void 
+ConfigTestObject::AddNodeC (uint32_t index, Ptr<ConfigTestObject> c)
+{
+  m_nodesC[index] = c;
+}
+
 int8_t 
 ConfigTestObject::GetA (void) const
 {
@@ -721,6 +734,184 @@ SearchAttributesOfParentObjectsTestCase::DoRun (void)
 
 }
 
+// ===========================================================================
+// Test that the paths are resolved again at each call, although the parsing
+// of a path is kept from one call to the next, and that the indices of the
+// vectors and of the maps are matched in increasing order.
+// ===========================================================================
+class RepeatedPathConfigTestCase : public TestCase
+{
+public:
+  RepeatedPathConfigTestCase ();
+  virtual ~RepeatedPathConfigTestCase () {}
+
+private:
+  virtual void DoRun (void);
+};
+
+RepeatedPathConfigTestCase::RepeatedPathConfigTestCase ()
+  : TestCase ("Check that repeated paths see the changes of the vectors and maps of Object")
+{
+}
+
+void
+RepeatedPathConfigTestCase::DoRun (void)
+{
+  Ptr<ConfigTestObject> root = CreateObject<ConfigTestObject> ();
+  Config::RegisterRootNamespaceObject (root);
+  Ptr<ConfigTestObject> a = CreateObject<ConfigTestObject> ();
+  root->SetNodeA (a);
+
+  //
+  // Three objects in a vector: the indices are matched in increasing
+  // order, whatever the order of the path.
+  //
+  std::vector<Ptr<ConfigTestObject> > nodes;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      nodes.push_back (CreateObject<ConfigTestObject> ());
+      a->AddNodeA (nodes.back ());
+    }
+  Config::MatchContainer matches = Config::LookupMatches ("/NodeA/NodesA/2|0");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 2, "unexpected number of vector matches");
+  NS_TEST_EXPECT_MSG_EQ (matches.Get (0), nodes[0], "unexpected first vector match");
+  NS_TEST_EXPECT_MSG_EQ (matches.Get (1), nodes[2], "unexpected second vector match");
+  NS_TEST_EXPECT_MSG_EQ (matches.GetMatchedPath (1), "/NodeA/NodesA/2/", "unexpected matched path");
+
+  //
+  // The same paths again, once objects are added.
+  //
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches ("/NodeA/NodesA/[1-4]").GetN (), 2, "unexpected number of vector matches");
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches ("/NodeA/NodesA/*").GetN (), 3, "unexpected number of vector matches");
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      nodes.push_back (CreateObject<ConfigTestObject> ());
+      a->AddNodeA (nodes.back ());
+    }
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches ("/NodeA/NodesA/[1-4]").GetN (), 4, "added objects not matched");
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches ("/NodeA/NodesA/*").GetN (), 6, "added objects not matched");
+  Config::Set ("/NodeA/NodesA/[4-9]|1/A", IntegerValue (3));
+  IntegerValue iv;
+  for (uint32_t i = 0; i < nodes.size (); i++)
+    {
+      nodes[i]->GetAttribute ("A", iv);
+      NS_TEST_EXPECT_MSG_EQ (iv.Get (), ((i == 1 || i >= 4) ? 3 : 10), "Object Attribute \"A\" of vector item " << i);
+    }
+
+  //
+  // Objects in a map, whose indices are not their positions.
+  //
+  Ptr<ConfigTestObject> c2 = CreateObject<ConfigTestObject> ();
+  Ptr<ConfigTestObject> c5 = CreateObject<ConfigTestObject> ();
+  Ptr<ConfigTestObject> c9 = CreateObject<ConfigTestObject> ();
+  a->AddNodeC (9, c9);
+  a->AddNodeC (2, c2);
+  a->AddNodeC (5, c5);
+  matches = Config::LookupMatches ("/NodeA/NodesC/2");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 1, "unexpected number of map matches");
+  NS_TEST_EXPECT_MSG_EQ (matches.Get (0), c2, "unexpected map match");
+  matches = Config::LookupMatches ("/NodeA/NodesC/9|[0-4]");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 2, "unexpected number of map matches");
+  NS_TEST_EXPECT_MSG_EQ (matches.Get (0), c2, "unexpected first map match");
+  NS_TEST_EXPECT_MSG_EQ (matches.Get (1), c9, "unexpected second map match");
+  NS_TEST_EXPECT_MSG_EQ (matches.GetMatchedPath (1), "/NodeA/NodesC/9/", "unexpected matched path");
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches ("/NodeA/NodesC/1").GetN (), 0, "unexpected map match");
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches ("/NodeA/NodesC/*").GetN (), 3, "unexpected number of map matches");
+
+  Config::UnregisterRootNamespaceObject (root);
+}
+
+// ===========================================================================
+// An object whose pointer attributes are added once paths through its type
+// have been resolved, and whose getter resolves many other paths.
+// ===========================================================================
+class ConfigAddedAttributeObject : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  Ptr<ConfigTestObject> GetBusy (void) const;
+
+  Ptr<ConfigTestObject> m_added;
+  Ptr<ConfigTestObject> m_busy;
+};
+
+TypeId
+ConfigAddedAttributeObject::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ConfigAddedAttributeObject")
+    .SetParent<Object> ()
+  ;
+  return tid;
+}
+
+Ptr<ConfigTestObject>
+ConfigAddedAttributeObject::GetBusy (void) const
+{
+  // enough distinct paths to have the compiled paths dropped
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      std::ostringstream oss;
+      oss << "/NodesA/" << i;
+      Config::LookupMatches (oss.str ());
+    }
+  return m_busy;
+}
+
+// ===========================================================================
+// Test that the paths see the attributes added to a type after they were
+// first resolved, and that the compiled paths may be dropped while a path
+// is being resolved.
+// ===========================================================================
+class AddedAttributeConfigTestCase : public TestCase
+{
+public:
+  AddedAttributeConfigTestCase ();
+  virtual ~AddedAttributeConfigTestCase () {}
+
+private:
+  virtual void DoRun (void);
+};
+
+AddedAttributeConfigTestCase::AddedAttributeConfigTestCase ()
+  : TestCase ("Check that paths see the added attributes and survive the drop of the compiled paths")
+{
+}
+
+void
+AddedAttributeConfigTestCase::DoRun (void)
+{
+  Ptr<ConfigAddedAttributeObject> root = CreateObject<ConfigAddedAttributeObject> ();
+  Config::RegisterRootNamespaceObject (root);
+  root->m_added = CreateObject<ConfigTestObject> ();
+  root->m_busy = CreateObject<ConfigTestObject> ();
+
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches ("/Added").GetN (), 0, "unexpected match before the attribute is added");
+  // the other tests may have left roots with pointer attributes
+  uint32_t others = Config::LookupMatches ("/*").GetN ();
+
+  TypeId tid = ConfigAddedAttributeObject::GetTypeId ();
+  tid.AddAttribute ("Added", "",
+                    PointerValue (),
+                    MakePointerAccessor (&ConfigAddedAttributeObject::m_added),
+                    MakePointerChecker<ConfigTestObject> ());
+  Config::MatchContainer matches = Config::LookupMatches ("/Added");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 1, "added attribute not matched");
+  NS_TEST_EXPECT_MSG_EQ (matches.Get (0), root->m_added, "unexpected match of the added attribute");
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches ("/*").GetN (), others + 1, "added attribute not matched by a wildcard");
+
+  tid.AddAttribute ("Busy", "",
+                    PointerValue (),
+                    MakePointerAccessor (&ConfigAddedAttributeObject::GetBusy),
+                    MakePointerChecker<ConfigTestObject> ());
+  matches = Config::LookupMatches ("/Busy");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 1, "path not resolved past the busy getter");
+  NS_TEST_EXPECT_MSG_EQ (matches.Get (0), root->m_busy, "unexpected match past the busy getter");
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches ("/*").GetN (), others + 2, "unexpected number of wildcard matches");
+
+  Config::UnregisterRootNamespaceObject (root);
+}
+
 // ===========================================================================
 // The Test Suite that glues all of the Test Cases together.
 // ===========================================================================
@@ -737,6 +928,8 @@ ConfigTestSuite::ConfigTestSuite ()
   AddTestCase (new UnderRootNamespaceConfigTestCase, TestCase::QUICK);
   AddTestCase (new ObjectVectorConfigTestCase, TestCase::QUICK);
   AddTestCase (new SearchAttributesOfParentObjectsTestCase, TestCase::QUICK);
+  AddTestCase (new RepeatedPathConfigTestCase, TestCase::QUICK);
+  AddTestCase (new AddedAttributeConfigTestCase, TestCase::QUICK);
 }
 
 static ConfigTestSuite configTestSuite;
@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/event-allocator.h"
+#include "ns3/config.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup core-tests
+ * Check that EventAllocator recycles the events of a simulation.
+ */
+class EventAllocatorTestCase : public TestCase
+{
+public:
+  EventAllocatorTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /** Schedule a burst of events, with and without arguments. */
+  void ScheduleBurst (void);
+  /** Event without arguments. */
+  void Event0 (void);
+  /**
+   * Event with arguments.
+   * \param [in] a First argument.
+   * \param [in] b Second argument.
+   */
+  void Event2 (uint64_t a, double b);
+
+  uint32_t m_count;     //!< Number of events run
+};
+
+EventAllocatorTestCase::EventAllocatorTestCase ()
+  : TestCase ("Check that the events are allocated from the pools"),
+    m_count (0)
+{
+}
+
+void
+EventAllocatorTestCase::Event0 (void)
+{
+  m_count++;
+}
+
+void
+EventAllocatorTestCase::Event2 (uint64_t a, double b)
+{
+  m_count++;
+}
+
+void
+EventAllocatorTestCase::ScheduleBurst (void)
+{
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i), &EventAllocatorTestCase::Event0, this);
+      EventId id = Simulator::Schedule (MicroSeconds (i), &EventAllocatorTestCase::Event2, this, i, 1.5);
+      if (i % 2 == 0)
+        {
+          id.Cancel ();
+        }
+    }
+}
+
+void
+EventAllocatorTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (EventAllocator::IsEnabled (), true, "pools should be enabled by default");
+
+  // the first burst fills the pools
+  Simulator::Schedule (Seconds (0), &EventAllocatorTestCase::ScheduleBurst, this);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_count, 1500, "unexpected number of events run");
+
+  // the second one is served from them
+  EventAllocator::ResetStatistics ();
+  Simulator::Schedule (Seconds (1), &EventAllocatorTestCase::ScheduleBurst, this);
+  Simulator::Run ();
+  EventAllocator::Statistics stats = EventAllocator::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (m_count, 3000, "unexpected number of events run");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (stats.allocations, 2001, "each event should be allocated");
+  NS_TEST_EXPECT_MSG_EQ (stats.pooled, stats.allocations, "each event should come from the pools");
+  NS_TEST_EXPECT_MSG_EQ (stats.heapAllocations, 0, "no event should be allocated by malloc");
+  NS_TEST_EXPECT_MSG_EQ (stats.deallocations, stats.allocations, "each event should be freed");
+  Simulator::Destroy ();
+
+  // disabled, the events are allocated by malloc; the setting is read
+  // again after Simulator::Destroy
+  Config::SetGlobal ("EventPoolEnabled", BooleanValue (false));
+  NS_TEST_EXPECT_MSG_EQ (EventAllocator::IsEnabled (), false, "pools should be disabled");
+  EventAllocator::ResetStatistics ();
+  ScheduleBurst ();
+  Simulator::Run ();
+  stats = EventAllocator::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.pooled, 0, "no event should come from the pools");
+  NS_TEST_EXPECT_MSG_EQ (stats.heapAllocations, stats.allocations, "each event should be allocated by malloc");
+  Simulator::Destroy ();
+
+  Config::SetGlobal ("EventPoolEnabled", BooleanValue (true));
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (EventAllocator::IsEnabled (), true, "pools should be enabled again");
+
+  // the free lists keep at most EventPoolMaxFreeBytes, the events freed
+  // beyond it are given back to the system
+  Config::SetGlobal ("EventPoolMaxFreeBytes", UintegerValue (4096));
+  Simulator::Destroy ();
+  EventAllocator::Trim ();
+  EventAllocator::ResetStatistics ();
+  ScheduleBurst ();
+  Simulator::Run ();
+  stats = EventAllocator::GetStatistics ();
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (stats.freeBytes, 4096, "the free lists should be bounded");
+  NS_TEST_EXPECT_MSG_GT (stats.heapDeallocations, 0, "the events beyond the bound should be freed");
+  EventAllocator::Trim ();
+  stats = EventAllocator::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.freeBytes, 0, "the free lists should be empty");
+  Config::SetGlobal ("EventPoolMaxFreeBytes", UintegerValue (16 * 1024 * 1024));
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup core-tests
+ * EventAllocator test suite.
+ */
+class EventAllocatorTestSuite : public TestSuite
+{
+public:
+  EventAllocatorTestSuite ()
+    : TestSuite ("event-allocator", UNIT)
+  {
+    AddTestCase (new EventAllocatorTestCase (), TestCase::QUICK);
+  }
+};
+
+static EventAllocatorTestSuite g_eventAllocatorTestSuite;
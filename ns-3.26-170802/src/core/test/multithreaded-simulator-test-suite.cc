@@ -0,0 +1,244 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup core-tests
+ * Run contexts which send each other messages with the
+ * MultithreadedSimulatorImpl, and check that they see the same events
+ * as with the DefaultSimulatorImpl.
+ */
+class MultithreadedSimulatorTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] threads The number of threads.
+   * \param [in] lookahead The lookahead, which is also the smallest delay
+   *             of the messages.
+   * \param [in] scheduler The scheduler type.
+   */
+  MultithreadedSimulatorTestCase (uint32_t threads, Time lookahead, std::string scheduler);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+private:
+  /** State of a context, only changed by its own events. */
+  struct Context
+  {
+    uint32_t ticks;             //!< Number of ticks run
+    uint32_t messages;          //!< Number of messages received
+    uint64_t checksum;          //!< Sum of the message times and senders
+    uint32_t errors;            //!< Number of unexpected times or contexts
+  };
+
+  /**
+   * Run the model.
+   * \param [in] simulatorType The simulator implementation type.
+   * \returns The context states.
+   */
+  std::vector<Context> RunModel (std::string simulatorType);
+  /**
+   * Periodic event of a context, which sends a message.
+   * \param [in] context The context.
+   * \param [in] ts The expected time.
+   */
+  void Tick (uint32_t context, uint64_t ts);
+  /**
+   * Message reception.
+   * \param [in] context The receiving context.
+   * \param [in] from The sending context.
+   * \param [in] ts The expected time.
+   */
+  void Receive (uint32_t context, uint32_t from, uint64_t ts);
+  /**
+   * Event without context, which can read all the contexts.
+   * \param [in] ts The expected time.
+   */
+  void Check (uint64_t ts);
+
+  uint32_t m_threads;                   //!< Number of threads
+  Time m_lookahead;                     //!< Lookahead
+  std::string m_scheduler;              //!< Scheduler type
+  std::vector<Context> m_contexts;      //!< The context states
+  uint32_t m_checks;                    //!< Number of Check events run
+  uint32_t m_checkErrors;               //!< Errors of the Check events
+};
+
+/**
+ * Build the name of a test case.
+ * \param [in] threads The number of threads.
+ * \param [in] lookahead The lookahead.
+ * \param [in] scheduler The scheduler type.
+ * \returns The name.
+ */
+static std::string
+Name (uint32_t threads, Time lookahead, std::string scheduler)
+{
+  std::ostringstream oss;
+  oss << "Check the multithreaded simulator with " << threads << " threads, a lookahead of "
+      << lookahead.GetNanoSeconds () << " ns and " << scheduler;
+  return oss.str ();
+}
+
+MultithreadedSimulatorTestCase::MultithreadedSimulatorTestCase (uint32_t threads, Time lookahead, std::string scheduler)
+  : TestCase (Name (threads, lookahead, scheduler)),
+    m_threads (threads),
+    m_lookahead (lookahead),
+    m_scheduler (scheduler)
+{
+}
+
+void
+MultithreadedSimulatorTestCase::Tick (uint32_t context, uint64_t ts)
+{
+  Context &state = m_contexts[context];
+  if (Simulator::GetContext () != context || Simulator::Now ().GetTimeStep () != (int64_t)ts)
+    {
+      state.errors++;
+    }
+  state.ticks++;
+  uint32_t n = m_contexts.size ();
+  uint32_t to = (context + 1 + state.ticks % (n - 1)) % n;
+  Time delay = m_lookahead + NanoSeconds (state.ticks % 3);
+  Simulator::ScheduleWithContext (to, delay, &MultithreadedSimulatorTestCase::Receive, this,
+                                  to, context, (Simulator::Now () + delay).GetTimeStep ());
+  Time next = MicroSeconds (1) + NanoSeconds ((context * 13 + state.ticks * 7) % 50);
+  Simulator::Schedule (next, &MultithreadedSimulatorTestCase::Tick, this,
+                       context, (Simulator::Now () + next).GetTimeStep ());
+}
+
+void
+MultithreadedSimulatorTestCase::Receive (uint32_t context, uint32_t from, uint64_t ts)
+{
+  Context &state = m_contexts[context];
+  if (Simulator::GetContext () != context || Simulator::Now ().GetTimeStep () != (int64_t)ts)
+    {
+      state.errors++;
+    }
+  state.messages++;
+  state.checksum += ts * (from + 1);
+}
+
+void
+MultithreadedSimulatorTestCase::Check (uint64_t ts)
+{
+  if (Simulator::GetContext () != Simulator::NO_CONTEXT || Simulator::Now ().GetTimeStep () != (int64_t)ts)
+    {
+      m_checkErrors++;
+    }
+  // every context ticks at least once per 1.05 microsecond
+  for (std::vector<Context>::const_iterator i = m_contexts.begin (); i != m_contexts.end (); ++i)
+    {
+      if (i->ticks < Simulator::Now ().GetMicroSeconds () * 100 / 105)
+        {
+          m_checkErrors++;
+        }
+    }
+  m_checks++;
+}
+
+std::vector<MultithreadedSimulatorTestCase::Context>
+MultithreadedSimulatorTestCase::RunModel (std::string simulatorType)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (simulatorType));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (m_threads));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Lookahead", TimeValue (m_lookahead));
+  ObjectFactory factory;
+  factory.SetTypeId (m_scheduler);
+  Simulator::SetScheduler (factory);
+
+  Context initial = { 0, 0, 0, 0 };
+  m_contexts.assign (37, initial);
+  m_checks = 0;
+  m_checkErrors = 0;
+  for (uint32_t i = 0; i < m_contexts.size (); i++)
+    {
+      Simulator::ScheduleWithContext (i, NanoSeconds (i), &MultithreadedSimulatorTestCase::Tick, this,
+                                      i, NanoSeconds (i).GetTimeStep ());
+    }
+  for (uint32_t i = 1; i <= 10; i++)
+    {
+      Simulator::Schedule (MicroSeconds (20 * i), &MultithreadedSimulatorTestCase::Check, this,
+                           MicroSeconds (20 * i).GetTimeStep ());
+    }
+  Simulator::Stop (MicroSeconds (500));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), MicroSeconds (500), "unexpected stop time");
+  Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  if (impl != 0)
+    {
+      NS_TEST_EXPECT_MSG_GT (impl->GetWindowCount (), 0, "no window run");
+    }
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (m_checks, 10, "unexpected number of events without context");
+  NS_TEST_EXPECT_MSG_EQ (m_checkErrors, 0, "unexpected state in the events without context");
+  return m_contexts;
+}
+
+void
+MultithreadedSimulatorTestCase::DoRun (void)
+{
+  std::vector<Context> expected = RunModel ("ns3::DefaultSimulatorImpl");
+  std::vector<Context> contexts = RunModel ("ns3::MultithreadedSimulatorImpl");
+  for (uint32_t i = 0; i < contexts.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (contexts[i].errors, 0, "unexpected time or context in context " << i);
+      NS_TEST_EXPECT_MSG_GT (contexts[i].ticks, 400, "too few ticks in context " << i);
+      NS_TEST_EXPECT_MSG_EQ (contexts[i].ticks, expected[i].ticks, "unexpected ticks in context " << i);
+      NS_TEST_EXPECT_MSG_EQ (contexts[i].messages, expected[i].messages, "unexpected messages in context " << i);
+      NS_TEST_EXPECT_MSG_EQ (contexts[i].checksum, expected[i].checksum, "unexpected messages in context " << i);
+    }
+}
+
+void
+MultithreadedSimulatorTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (0));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Lookahead", TimeValue (Seconds (-1)));
+}
+
+/**
+ * \ingroup core-tests
+ * MultithreadedSimulatorImpl test suite.
+ */
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorTestSuite ()
+    : TestSuite ("multithreaded-simulator")
+  {
+    AddTestCase (new MultithreadedSimulatorTestCase (1, NanoSeconds (100), "ns3::MapScheduler"), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorTestCase (4, NanoSeconds (100), "ns3::MapScheduler"), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorTestCase (4, NanoSeconds (0), "ns3::MapScheduler"), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorTestCase (8, MicroSeconds (2), "ns3::TimingWheelScheduler"), TestCase::QUICK);
+  }
+};
+
+static MultithreadedSimulatorTestSuite g_multithreadedSimulatorTestSuite;
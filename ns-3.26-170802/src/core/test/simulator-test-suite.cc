@@ -23,6 +23,12 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/timing-wheel-scheduler.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/enum.h"
+#include "ns3/double.h"
+#include <set>
 
 using namespace ns3;
 
@@ -459,6 +465,168 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * Check a scheduler against a sorted set of event keys, with random
+ * insertions, removals and peeks over timescales from nanoseconds to
+ * hours.
+ */
+class SchedulerRandomTestCase : public TestCase
+{
+public:
+  SchedulerRandomTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  ObjectFactory m_schedulerFactory;
+};
+
+SchedulerRandomTestCase::SchedulerRandomTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check random operations on " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SchedulerRandomTestCase::DoRun (void)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  std::set<Scheduler::EventKey> expected;
+  // the events are never run: their implementation is their uid
+  Scheduler::Event ev;
+  ev.key.m_context = 0;
+  uint32_t uid = 0;
+  uint64_t now = 0;
+  uint64_t scales[] = { 1, 1000, 1000000, 1000000000, 3600000000000ULL };
+  uint32_t seed = RngSeedManager::GetSeed ();
+  for (uint32_t i = 0; i < 20000; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      uint32_t op = (seed >> 16) % 8;
+      if (op < 4 || expected.empty ())
+        {
+          uint64_t scale = scales[(seed >> 8) % 5];
+          // same timestamps are frequent at the smallest scale
+          ev.key.m_ts = now + scale * ((seed >> 20) % 4);
+          ev.key.m_uid = uid++;
+          ev.impl = reinterpret_cast<EventImpl *> (ev.key.m_uid + 1);
+          scheduler->Insert (ev);
+          expected.insert (ev.key);
+        }
+      else if (op < 6)
+        {
+          Scheduler::Event next = scheduler->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (next.key.m_uid, expected.begin ()->m_uid, "unexpected next event");
+          NS_TEST_ASSERT_MSG_EQ (next.key.m_ts, expected.begin ()->m_ts, "unexpected next event time");
+          NS_TEST_ASSERT_MSG_EQ (next.impl, reinterpret_cast<EventImpl *> (next.key.m_uid + 1), "unexpected event");
+          now = next.key.m_ts;
+          expected.erase (expected.begin ());
+        }
+      else if (op < 7)
+        {
+          std::set<Scheduler::EventKey>::iterator j = expected.begin ();
+          std::advance (j, (seed >> 4) % expected.size ());
+          ev.key = *j;
+          ev.impl = reinterpret_cast<EventImpl *> (ev.key.m_uid + 1);
+          scheduler->Remove (ev);
+          expected.erase (j);
+        }
+      else
+        {
+          NS_TEST_ASSERT_MSG_EQ (scheduler->PeekNext ().key.m_uid, expected.begin ()->m_uid, "unexpected peeked event");
+        }
+      NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), expected.empty (), "unexpected emptiness");
+    }
+  while (!expected.empty ())
+    {
+      NS_TEST_ASSERT_MSG_EQ (scheduler->RemoveNext ().key.m_uid, expected.begin ()->m_uid, "unexpected next event");
+      expected.erase (expected.begin ());
+    }
+  NS_TEST_EXPECT_MSG_EQ (scheduler->IsEmpty (), true, "scheduler should be empty");
+}
+
+/**
+ * Check the live and dead event counts, and that the cancelled events
+ * are not run, with each CancelPolicy of DefaultSimulatorImpl.
+ */
+class CancelPolicyTestCase : public TestCase
+{
+public:
+  CancelPolicyTestCase (ObjectFactory schedulerFactory,
+                        DefaultSimulatorImpl::CancelPolicy policy, std::string name);
+  virtual void DoRun (void);
+  /** Count the events run. */
+  void Count (void);
+  ObjectFactory m_schedulerFactory;
+  DefaultSimulatorImpl::CancelPolicy m_policy;
+  uint32_t m_count;
+};
+
+CancelPolicyTestCase::CancelPolicyTestCase (ObjectFactory schedulerFactory,
+                                            DefaultSimulatorImpl::CancelPolicy policy, std::string name)
+  : TestCase ("Check the cancelled events with CancelPolicy=" + name + " and " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory),
+    m_policy (policy),
+    m_count (0)
+{
+}
+
+void
+CancelPolicyTestCase::Count (void)
+{
+  m_count++;
+}
+
+void
+CancelPolicyTestCase::DoRun (void)
+{
+  Simulator::SetScheduler (m_schedulerFactory);
+  Ptr<DefaultSimulatorImpl> impl = DynamicCast<DefaultSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (impl, 0, "unexpected simulator implementation");
+  impl->SetAttribute ("CancelPolicy", EnumValue (m_policy));
+  impl->SetAttribute ("CompactionThreshold", DoubleValue (0.25));
+
+  std::vector<EventId> events;
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      events.push_back (Simulator::Schedule (MicroSeconds (i), &CancelPolicyTestCase::Count, this));
+    }
+  for (uint32_t i = 0; i < 400; i++)
+    {
+      events[i * 2 + 1].Cancel ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (impl->GetLiveEventCount (), 600, "unexpected number of live events");
+  bool removing = m_policy == DefaultSimulatorImpl::CANCEL_REMOVE
+    || (m_policy == DefaultSimulatorImpl::CANCEL_AUTO && m_schedulerFactory.Create<Scheduler> ()->IsRemoveCheap ());
+  if (removing)
+    {
+      NS_TEST_EXPECT_MSG_EQ (impl->GetDeadEventCount (), 0, "the cancelled events should be removed");
+    }
+  else if (m_policy == DefaultSimulatorImpl::CANCEL_LAZY)
+    {
+      NS_TEST_EXPECT_MSG_EQ (impl->GetDeadEventCount (), 400, "the cancelled events should stay");
+    }
+  else
+    {
+      // rebuilt when the dead events exceed a quarter of the events
+      NS_TEST_EXPECT_MSG_LT (impl->GetDeadEventCount (), 400, "the event list should be rebuilt");
+      NS_TEST_EXPECT_MSG_GT (impl->GetCompactionCount (), 0, "the event list should be rebuilt");
+    }
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (events[i].IsExpired (), (i % 2 == 1 && i < 800), "unexpected event state");
+    }
+
+  Simulator::Stop (MicroSeconds (500));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_count, 251, "unexpected number of events run");
+  NS_TEST_EXPECT_MSG_EQ (impl->GetLiveEventCount (), 349, "unexpected number of live events");
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_count, 600, "the cancelled events should not run");
+  NS_TEST_EXPECT_MSG_EQ (impl->GetLiveEventCount (), 0, "no event should be left");
+  NS_TEST_EXPECT_MSG_EQ (impl->GetDeadEventCount (), 0, "no event should be left");
+  Simulator::Destroy ();
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +643,29 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (TimingWheelScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    TypeId schedulers[] = {
+      ListScheduler::GetTypeId (),
+      MapScheduler::GetTypeId (),
+      HeapScheduler::GetTypeId (),
+      CalendarScheduler::GetTypeId (),
+      TimingWheelScheduler::GetTypeId ()
+    };
+    for (uint32_t i = 0; i < sizeof (schedulers) / sizeof (schedulers[0]); i++)
+      {
+        factory.SetTypeId (schedulers[i]);
+        AddTestCase (new SchedulerRandomTestCase (factory), TestCase::QUICK);
+      }
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new CancelPolicyTestCase (factory, DefaultSimulatorImpl::CANCEL_LAZY, "Lazy"), TestCase::QUICK);
+    AddTestCase (new CancelPolicyTestCase (factory, DefaultSimulatorImpl::CANCEL_REMOVE, "Remove"), TestCase::QUICK);
+    AddTestCase (new CancelPolicyTestCase (factory, DefaultSimulatorImpl::CANCEL_AUTO, "Auto"), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new CancelPolicyTestCase (factory, DefaultSimulatorImpl::CANCEL_COMPACT, "Compact"), TestCase::QUICK);
+    AddTestCase (new CancelPolicyTestCase (factory, DefaultSimulatorImpl::CANCEL_AUTO, "Auto"), TestCase::QUICK);
+    factory.SetTypeId (TimingWheelScheduler::GetTypeId ());
+    AddTestCase (new CancelPolicyTestCase (factory, DefaultSimulatorImpl::CANCEL_AUTO, "Auto"), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/size-class-allocator.h"
+#include "ns3/event-allocator.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup core-tests
+ * Check the size classes and the free lists of a SizeClassAllocator.
+ */
+class SizeClassAllocatorTestCase : public TestCase
+{
+public:
+  SizeClassAllocatorTestCase ();
+  virtual void DoRun (void);
+};
+
+SizeClassAllocatorTestCase::SizeClassAllocatorTestCase ()
+  : TestCase ("Check the size classes and the free lists")
+{
+}
+
+void
+SizeClassAllocatorTestCase::DoRun (void)
+{
+  SizeClassAllocator::Layout layout = { 64, 4, 1024 };
+  // not named GlobalValues: enabled, with the default bound
+  static SizeClassAllocator *allocator = new SizeClassAllocator (layout, "", "", "");
+  allocator->Trim ();
+  allocator->ResetStatistics ();
+  EventAllocator::Statistics events = EventAllocator::GetStatistics ();
+
+  const std::size_t h = SizeClassAllocator::HEADER_SIZE;
+  std::size_t usable;
+  void *p = allocator->Allocate (1, usable);
+  NS_TEST_EXPECT_MSG_EQ (usable, 64 - h, "smallest class");
+  allocator->Deallocate (p);
+  p = allocator->Allocate (80 - h, usable);
+  NS_TEST_EXPECT_MSG_EQ (usable, 80 - h, "exact class");
+  allocator->Deallocate (p);
+  p = allocator->Allocate (81 - h, usable);
+  NS_TEST_EXPECT_MSG_EQ (usable, 96 - h, "next class");
+  allocator->Deallocate (p);
+  p = allocator->Allocate (129 - h, usable);
+  NS_TEST_EXPECT_MSG_EQ (usable, 160 - h, "class after a power of two");
+  allocator->Deallocate (p);
+  p = allocator->Allocate (1024 - h, usable);
+  NS_TEST_EXPECT_MSG_EQ (usable, 1024 - h, "largest class");
+  allocator->Deallocate (p);
+  p = allocator->Allocate (1025 - h, usable);
+  NS_TEST_EXPECT_MSG_EQ (usable, 1025 - h, "malloc beyond the largest class");
+  allocator->Deallocate (p);
+
+  SizeClassAllocator::Statistics stats = allocator->GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.allocations, 6, "unexpected number of allocations");
+  NS_TEST_EXPECT_MSG_EQ (stats.heapAllocations, 6, "each class should be allocated by malloc once");
+  NS_TEST_EXPECT_MSG_EQ (stats.heapDeallocations, 1, "only the largest block should be freed");
+  NS_TEST_EXPECT_MSG_EQ (stats.freeBytes, 64 + 80 + 96 + 160 + 1024, "unexpected bytes in the free lists");
+  NS_TEST_EXPECT_MSG_EQ (stats.inUse, 0, "no block should be in use");
+  NS_TEST_EXPECT_MSG_EQ (stats.maxInUse, 1, "unexpected high-water mark");
+
+  // the freed blocks are reused
+  p = allocator->Allocate (90 - h);
+  void *q = allocator->Allocate (2);
+  stats = allocator->GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.pooled, 2, "the blocks should come from the free lists");
+  NS_TEST_EXPECT_MSG_EQ (stats.heapAllocations, 6, "no block should be allocated by malloc");
+  allocator->Deallocate (p);
+  allocator->Deallocate (q);
+
+  // the allocators have their own free lists and statistics
+  NS_TEST_EXPECT_MSG_EQ (EventAllocator::GetStatistics ().allocations, events.allocations,
+                         "the events should not be counted");
+  allocator->Trim ();
+  NS_TEST_EXPECT_MSG_EQ (allocator->GetStatistics ().freeBytes, 0, "the free lists should be empty");
+}
+
+/**
+ * \ingroup core-tests
+ * SizeClassAllocator test suite.
+ */
+class SizeClassAllocatorTestSuite : public TestSuite
+{
+public:
+  SizeClassAllocatorTestSuite ()
+    : TestSuite ("size-class-allocator", UNIT)
+  {
+    AddTestCase (new SizeClassAllocatorTestCase (), TestCase::QUICK);
+  }
+};
+
+static SizeClassAllocatorTestSuite g_sizeClassAllocatorTestSuite;
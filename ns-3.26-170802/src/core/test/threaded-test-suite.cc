@@ -26,6 +26,9 @@
 #include "ns3/config.h"
 #include "ns3/string.h"
 #include "ns3/system-thread.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/make-event.h"
+#include "ns3/enum.h"
 
 #include <ctime>
 #include <list>
@@ -225,6 +228,90 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_a, m_d, "Bad scheduling");
 }
 
+/**
+ * Check that an event scheduled from another thread, and cancelled
+ * before it is moved into the event list, is not run with
+ * CancelPolicy=Remove.
+ */
+class ThreadedCancelTestCase : public TestCase
+{
+public:
+  ThreadedCancelTestCase ();
+  /** Schedule m_event from a thread other than the main one. */
+  static void SchedulingThread (ThreadedCancelTestCase *me);
+  /** Count the events run. */
+  void Count (void);
+  /**
+   * Record the dead and live event counts.
+   * \param impl The simulator implementation.
+   */
+  void CheckCounts (Ptr<DefaultSimulatorImpl> impl);
+  EventImpl *m_event;
+  uint32_t m_count;
+  uint32_t m_dead;
+  uint32_t m_live;
+
+private:
+  virtual void DoRun (void);
+};
+
+ThreadedCancelTestCase::ThreadedCancelTestCase ()
+  : TestCase ("Check the cancel of an event scheduled from another thread with CancelPolicy=Remove"),
+    m_event (0),
+    m_count (0),
+    m_dead (0),
+    m_live (0)
+{
+}
+
+void
+ThreadedCancelTestCase::SchedulingThread (ThreadedCancelTestCase *me)
+{
+  Simulator::ScheduleWithContext (1, MicroSeconds (10), me->m_event);
+}
+
+void
+ThreadedCancelTestCase::Count (void)
+{
+  m_count++;
+}
+
+void
+ThreadedCancelTestCase::CheckCounts (Ptr<DefaultSimulatorImpl> impl)
+{
+  m_dead = impl->GetDeadEventCount ();
+  m_live = impl->GetLiveEventCount ();
+}
+
+void
+ThreadedCancelTestCase::DoRun (void)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (MapScheduler::GetTypeId ());
+  Simulator::SetScheduler (factory);
+  Ptr<DefaultSimulatorImpl> impl = DynamicCast<DefaultSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (impl, 0, "unexpected simulator implementation");
+  impl->SetAttribute ("CancelPolicy", EnumValue (DefaultSimulatorImpl::CANCEL_REMOVE));
+
+  m_event = MakeEvent (&ThreadedCancelTestCase::Count, this);
+  EventId id (Ptr<EventImpl> (m_event), MicroSeconds (10).GetTimeStep (), 1, 0xffffffff);
+  Ptr<SystemThread> thread = Create<SystemThread> (MakeBoundCallback (&ThreadedCancelTestCase::SchedulingThread, this));
+  thread->Start ();
+  thread->Join ();
+
+  Simulator::Cancel (id);
+  NS_TEST_EXPECT_MSG_EQ (id.IsExpired (), true, "the event should be cancelled");
+  NS_TEST_EXPECT_MSG_EQ (impl->GetDeadEventCount (), 0, "the event should not count as dead before it is in the list");
+  NS_TEST_EXPECT_MSG_EQ (impl->GetLiveEventCount (), 0, "the cancelled event should not count as live");
+  Simulator::Schedule (MicroSeconds (1), &ThreadedCancelTestCase::CheckCounts, this, impl);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_dead, 1, "the event should be dead once in the list");
+  NS_TEST_EXPECT_MSG_EQ (m_live, 0, "the event should not be live once in the list");
+  NS_TEST_EXPECT_MSG_EQ (m_count, 0, "the cancelled event should not run");
+  NS_TEST_EXPECT_MSG_EQ (impl->GetDeadEventCount (), 0, "no event should be left");
+  Simulator::Destroy ();
+}
+
 class ThreadedSimulatorTestSuite : public TestSuite
 {
 public:
@@ -241,7 +328,8 @@ public:
       "ns3::ListScheduler",
       "ns3::HeapScheduler",
       "ns3::MapScheduler",
-      "ns3::CalendarScheduler"
+      "ns3::CalendarScheduler",
+      "ns3::TimingWheelScheduler"
     };
     unsigned int threadcounts[] = {
       0,
@@ -262,5 +350,6 @@ public:
               }
           }
       }
+    AddTestCase (new ThreadedCancelTestCase (), TestCase::QUICK);
   }
 } g_threadedSimulatorTestSuite;
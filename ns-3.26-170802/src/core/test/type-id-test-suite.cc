@@ -325,6 +325,125 @@ DeprecatedAttributeTestCase::DoRun (void)
        << endl;
 }
 
+//----------------------------
+//
+// Attribute table test
+
+class AttributeTableBase : public Object
+{
+public:
+  AttributeTableBase () : m_base (0), m_added (0) { };
+  virtual ~AttributeTableBase () { };
+
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("AttributeTableBase")
+      .SetParent<Object> ()
+      .AddConstructor<AttributeTableBase> ()
+      .AddAttribute ("base",
+                     "the Attribute of the base class",
+                     IntegerValue (1),
+                     MakeIntegerAccessor (&AttributeTableBase::m_base),
+                     MakeIntegerChecker<int> ())
+      .AddTraceSource ("baseTrace",
+                       "the TraceSource of the base class",
+                       MakeTraceSourceAccessor (&AttributeTableBase::m_trace),
+                       "ns3::TracedValueCallback::Double");
+    return tid;
+  }
+
+  int m_base;                   //!< Registered with the type
+  int m_added;                  //!< Registered by the test
+  TracedValue<double> m_trace;  //!< Trace source
+};
+
+class AttributeTableDerived : public AttributeTableBase
+{
+public:
+  AttributeTableDerived () : m_derived (0) { };
+  virtual ~AttributeTableDerived () { };
+
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("AttributeTableDerived")
+      .SetParent<AttributeTableBase> ()
+      .AddConstructor<AttributeTableDerived> ()
+      .AddAttribute ("derived",
+                     "the Attribute of the derived class",
+                     IntegerValue (2),
+                     MakeIntegerAccessor (&AttributeTableDerived::m_derived),
+                     MakeIntegerChecker<int> ());
+    return tid;
+  }
+
+  int m_derived;                //!< Registered with the type
+};
+
+
+class AttributeTableTestCase : public TestCase
+{
+public:
+  AttributeTableTestCase ();
+  virtual ~AttributeTableTestCase ();
+private:
+  virtual void DoRun (void);
+
+};
+
+AttributeTableTestCase::AttributeTableTestCase ()
+  : TestCase ("Check the tables of the own and inherited Attributes and TraceSources")
+{
+}
+
+AttributeTableTestCase::~AttributeTableTestCase ()
+{
+}
+
+void
+AttributeTableTestCase::DoRun (void)
+{
+  TypeId base = AttributeTableBase::GetTypeId ();
+  TypeId derived = AttributeTableDerived::GetTypeId ();
+
+  // own attributes first, then those of the parents
+  const TypeId::AttributeTable &table = derived.GetAttributeTable ();
+  NS_TEST_ASSERT_MSG_EQ (table.size (), 2, "unexpected number of attributes");
+  NS_TEST_EXPECT_MSG_EQ (table[0].first, derived, "unexpected type of the first attribute");
+  NS_TEST_EXPECT_MSG_EQ (table[0].second->name, "derived", "unexpected first attribute");
+  NS_TEST_EXPECT_MSG_EQ (table[1].first, base, "unexpected type of the second attribute");
+  NS_TEST_EXPECT_MSG_EQ (table[1].second->name, "base", "unexpected second attribute");
+
+  NS_TEST_EXPECT_MSG_EQ (derived.LookupAttributeByName ("base"), table[1].second,
+                         "lookup inherited attribute");
+  NS_TEST_EXPECT_MSG_EQ (derived.LookupAttributeByName ("derived"), table[0].second,
+                         "lookup own attribute");
+  NS_TEST_EXPECT_MSG_EQ ((base.LookupAttributeByName ("derived") == 0), true,
+                         "lookup attribute of a derived class");
+  NS_TEST_EXPECT_MSG_EQ ((derived.LookupAttributeByName ("missing") == 0), true,
+                         "lookup missing attribute");
+  NS_TEST_EXPECT_MSG_NE (derived.LookupTraceSourceByName ("baseTrace"), 0,
+                         "lookup inherited trace source");
+  NS_TEST_EXPECT_MSG_EQ (derived.LookupTraceSourceByName ("missing"), 0,
+                         "lookup missing trace source");
+
+  Ptr<AttributeTableDerived> object = CreateObject<AttributeTableDerived> ();
+  NS_TEST_EXPECT_MSG_EQ (object->m_base, 1, "inherited attribute not constructed");
+  NS_TEST_EXPECT_MSG_EQ (object->m_derived, 2, "own attribute not constructed");
+
+  // an attribute added to the parent is seen by the derived type
+  base.AddAttribute ("added",
+                     "the Attribute added to the base class",
+                     IntegerValue (3),
+                     MakeIntegerAccessor (&AttributeTableBase::m_added),
+                     MakeIntegerChecker<int> ());
+  NS_TEST_EXPECT_MSG_EQ (derived.GetAttributeTable ().size (), 3, "added attribute not in the table");
+  NS_TEST_EXPECT_MSG_NE (derived.LookupAttributeByName ("added"), 0, "lookup added attribute");
+  object = CreateObject<AttributeTableDerived> ();
+  NS_TEST_EXPECT_MSG_EQ (object->m_added, 3, "added attribute not constructed");
+  object->SetAttribute ("added", IntegerValue (4));
+  NS_TEST_EXPECT_MSG_EQ (object->m_added, 4, "added attribute not set");
+}
+
   
 //----------------------------
 //
@@ -437,6 +556,7 @@ TypeIdTestSuite::TypeIdTestSuite ()
   AddTestCase (new UniqueTypeIdTestCase, QUICK);
   AddTestCase (new CollisionTestCase, QUICK);
   AddTestCase (new DeprecatedAttributeTestCase, QUICK);
+  AddTestCase (new AttributeTableTestCase, QUICK);
 }
 
 static TypeIdTestSuite g_TypeIdTestSuite;  
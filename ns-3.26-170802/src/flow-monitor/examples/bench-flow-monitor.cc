@@ -0,0 +1,139 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Measure the cost of classifying and tracking packets in FlowMonitor.
+//
+// --packets packets of --flows UDP flows are classified by an
+// Ipv4FlowClassifier, then reported to a FlowMonitor as transmitted,
+// forwarded twice and received --inflight packets later, so that
+// --inflight packets are tracked at once.  The monitor checks for lost
+// packets every --check packets, as its periodic check would.  The time
+// per packet of the classifier and of the monitor is printed in
+// nanoseconds.
+//
+//   ./waf --run "bench-flow-monitor --inflight=1000"
+//   ./waf --run "bench-flow-monitor --inflight=1000000 --maxTracked=100000"
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-probe.h"
+#include "ns3/ipv4-flow-classifier.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * A probe which only reports the packets given by the benchmark.
+ */
+class BenchProbe : public FlowProbe
+{
+public:
+  /**
+   * \param monitor the monitor of the probe
+   */
+  BenchProbe (Ptr<FlowMonitor> monitor)
+    : FlowProbe (monitor)
+  {
+  }
+};
+
+int main (int argc, char *argv[])
+{
+  uint32_t flows = 1000;
+  uint32_t packets = 2000000;
+  uint32_t inflight = 100000;
+  uint32_t check = 10000;
+  uint32_t maxTracked = 0;
+  uint32_t sampling = 1;
+
+  CommandLine cmd;
+  cmd.Usage ("Measure the cost of classifying and tracking packets in FlowMonitor");
+  cmd.AddValue ("flows", "number of flows", flows);
+  cmd.AddValue ("packets", "number of packets", packets);
+  cmd.AddValue ("inflight", "number of packets in flight", inflight);
+  cmd.AddValue ("check", "number of packets between checks for lost packets", check);
+  cmd.AddValue ("maxTracked", "FlowMonitor::MaxTrackedPackets", maxTracked);
+  cmd.AddValue ("sampling", "FlowMonitor::HistogramSampling", sampling);
+  cmd.Parse (argc, argv);
+
+  // Stop recording the Time objects, as a simulation does when it starts
+  Simulator::Run ();
+
+  Ptr<Ipv4FlowClassifier> classifier = Create<Ipv4FlowClassifier> ();
+  std::vector<std::pair<FlowId, FlowPacketId> > ids (packets);
+  Ptr<Packet> payload = Create<Packet> (100);
+  SystemWallClockMs clock;
+  clock.Start ();
+  for (uint32_t i = 0; i < packets; i++)
+    {
+      uint32_t flow = (i * 7919) % flows;
+      Ipv4Header header;
+      header.SetSource (Ipv4Address (0x0a000000 + flow / 16));
+      header.SetDestination (Ipv4Address (0x0a800000 + flow % 16));
+      header.SetProtocol (17);
+      classifier->Classify (header, payload, &ids[i].first, &ids[i].second);
+    }
+  int64_t classifyMs = clock.End ();
+
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  monitor->SetAttribute ("MaxTrackedPackets", UintegerValue (maxTracked));
+  monitor->SetAttribute ("HistogramSampling", UintegerValue (sampling));
+  monitor->StartRightNow ();
+  Ptr<FlowProbe> probe = Create<BenchProbe> (monitor);
+  clock.Start ();
+  for (uint32_t i = 0; i < packets + inflight; i++)
+    {
+      if (i < packets)
+        {
+          monitor->ReportFirstTx (probe, ids[i].first, ids[i].second, 100);
+          monitor->ReportForwarding (probe, ids[i].first, ids[i].second, 100);
+        }
+      if (i >= inflight / 2 && i - inflight / 2 < packets)
+        {
+          uint32_t j = i - inflight / 2;
+          monitor->ReportForwarding (probe, ids[j].first, ids[j].second, 100);
+        }
+      if (i >= inflight)
+        {
+          uint32_t j = i - inflight;
+          monitor->ReportLastRx (probe, ids[j].first, ids[j].second, 100);
+        }
+      if (i % check == 0)
+        {
+          monitor->CheckForLostPackets ();
+        }
+    }
+  int64_t monitorMs = clock.End ();
+
+  uint64_t rxPackets = 0;
+  const FlowMonitor::FlowStatsContainer &stats = monitor->GetFlowStats ();
+  for (FlowMonitor::FlowStatsContainerCI i = stats.begin (); i != stats.end (); i++)
+    {
+      rxPackets += i->second.rxPackets;
+    }
+  std::cout << "classify ns/packet " << classifyMs * 1e6 / packets
+            << " monitor ns/packet " << monitorMs * 1e6 / packets
+            << " received " << rxPackets << std::endl;
+
+  monitor->Dispose ();
+  Simulator::Destroy ();
+  return 0;
+}
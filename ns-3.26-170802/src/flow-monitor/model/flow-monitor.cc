@@ -22,8 +22,11 @@
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 #define INDENT(level) for (int __xpto = 0; __xpto < level; __xpto++) os << ' ';
 
@@ -35,6 +38,8 @@ NS_LOG_COMPONENT_DEFINE ("FlowMonitor");
 
 NS_OBJECT_ENSURE_REGISTERED (FlowMonitor);
 
+const uint32_t FlowMonitor::NO_SLOT;
+const FlowId FlowMonitor::NO_FLOW;
 
 TypeId 
 FlowMonitor::GetTypeId (void)
@@ -48,6 +53,25 @@ FlowMonitor::GetTypeId (void)
                    TimeValue (Seconds (10.0)),
                    MakeTimeAccessor (&FlowMonitor::m_maxPerHopDelay),
                    MakeTimeChecker ())
+    .AddAttribute ("MaxTrackedPackets", ("The maximum number of packets tracked at once, or 0 for no limit.  "
+                                         "Beyond it, a packet stops being tracked as set by TrackedPacketEviction, "
+                                         "and it is considered lost once it was last seen MaxPerHopDelay ago, "
+                                         "its last sighting being rounded up to the next second."),
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&FlowMonitor::m_maxTrackedPackets),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("TrackedPacketEviction", ("The packet which stops being tracked when a new packet is "
+                                             "transmitted while MaxTrackedPackets packets are tracked."),
+                   EnumValue (FlowMonitor::EVICT_LEAST_RECENT),
+                   MakeEnumAccessor (&FlowMonitor::m_eviction),
+                   MakeEnumChecker (FlowMonitor::EVICT_LEAST_RECENT, "LeastRecent",
+                                    FlowMonitor::EVICT_NEW, "New"))
+    .AddAttribute ("HistogramSampling", ("Add the delay and jitter of 1 received packet in N of each flow "
+                                         "to the delay and jitter histograms.  The other statistics "
+                                         "account for all the packets."),
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&FlowMonitor::m_histogramSampling),
+                   MakeUintegerChecker<uint32_t> (1))
     .AddAttribute ("StartTime", ("The time when the monitoring starts."),
                    TimeValue (Seconds (0.0)),
                    MakeTimeAccessor (&FlowMonitor::Start),
@@ -83,7 +107,10 @@ FlowMonitor::GetInstanceTypeId (void) const
 }
 
 FlowMonitor::FlowMonitor ()
-  : m_enabled (false)
+  : m_nTrackedPackets (0),
+    m_leastRecentSlot (NO_SLOT),
+    m_mostRecentSlot (NO_SLOT),
+    m_enabled (false)
 {
   // m_histogramBinWidth=DEFAULT_BIN_WIDTH;
 }
@@ -105,32 +132,272 @@ FlowMonitor::DoDispose (void)
   Object::DoDispose ();
 }
 
+/**
+ * \param index a hash index of flow stats
+ * \param flowId a flow
+ * \param stats the stats of the flow, to add to the index
+ */
+static void
+AddToFlowStatsIndex (std::vector<std::pair<FlowId, FlowMonitor::FlowStats *> > &index,
+                     FlowId flowId, FlowMonitor::FlowStats *stats)
+{
+  uint32_t mask = index.size () - 1;
+  uint32_t i = (flowId * 2654435761U) & mask;
+  while (index[i].second != 0)
+    {
+      i = (i + 1) & mask;
+    }
+  index[i] = std::make_pair (flowId, stats);
+}
+
 inline FlowMonitor::FlowStats&
 FlowMonitor::GetStatsForFlow (FlowId flowId)
 {
-  FlowStatsContainerI iter;
-  iter = m_flowStats.find (flowId);
-  if (iter == m_flowStats.end ())
-    {
-      FlowMonitor::FlowStats &ref = m_flowStats[flowId];
-      ref.delaySum = Seconds (0);
-      ref.jitterSum = Seconds (0);
-      ref.lastDelay = Seconds (0);
-      ref.txBytes = 0;
-      ref.rxBytes = 0;
-      ref.txPackets = 0;
-      ref.rxPackets = 0;
-      ref.lostPackets = 0;
-      ref.timesForwarded = 0;
-      ref.delayHistogram.SetDefaultBinWidth (m_delayBinWidth);
-      ref.jitterHistogram.SetDefaultBinWidth (m_jitterBinWidth);
-      ref.packetSizeHistogram.SetDefaultBinWidth (m_packetSizeBinWidth);
-      ref.flowInterruptionsHistogram.SetDefaultBinWidth (m_flowInterruptionsBinWidth);
-      return ref;
+  if (!m_flowStatsIndex.empty ())
+    {
+      uint32_t mask = m_flowStatsIndex.size () - 1;
+      for (uint32_t i = (flowId * 2654435761U) & mask; m_flowStatsIndex[i].second != 0; i = (i + 1) & mask)
+        {
+          if (m_flowStatsIndex[i].first == flowId)
+            {
+              return *m_flowStatsIndex[i].second;
+            }
+        }
+    }
+
+  FlowMonitor::FlowStats &ref = m_flowStats[flowId];
+  ref.delaySum = Seconds (0);
+  ref.jitterSum = Seconds (0);
+  ref.lastDelay = Seconds (0);
+  ref.txBytes = 0;
+  ref.rxBytes = 0;
+  ref.txPackets = 0;
+  ref.rxPackets = 0;
+  ref.lostPackets = 0;
+  ref.timesForwarded = 0;
+  ref.delayHistogram.SetDefaultBinWidth (m_delayBinWidth);
+  ref.jitterHistogram.SetDefaultBinWidth (m_jitterBinWidth);
+  ref.packetSizeHistogram.SetDefaultBinWidth (m_packetSizeBinWidth);
+  ref.flowInterruptionsHistogram.SetDefaultBinWidth (m_flowInterruptionsBinWidth);
+
+  // Keep the index at most half full
+  if (2 * m_flowStats.size () > m_flowStatsIndex.size ())
+    {
+      m_flowStatsIndex.assign (std::max<uint32_t> (16, 2 * m_flowStatsIndex.size ()),
+                               std::make_pair (0, static_cast<FlowStats *> (0)));
+      for (FlowStatsContainerI iter = m_flowStats.begin (); iter != m_flowStats.end (); iter++)
+        {
+          AddToFlowStatsIndex (m_flowStatsIndex, iter->first, &iter->second);
+        }
     }
   else
     {
-      return iter->second;
+      AddToFlowStatsIndex (m_flowStatsIndex, flowId, &ref);
+    }
+  return ref;
+}
+
+uint32_t
+FlowMonitor::GetTrackedPacketHome (FlowId flowId, FlowPacketId packetId) const
+{
+  uint64_t key = (static_cast<uint64_t> (flowId) << 32) | packetId;
+  return static_cast<uint32_t> ((key * 0x9e3779b97f4a7c15ULL) >> 32) & (m_trackedPackets.size () - 1);
+}
+
+uint32_t
+FlowMonitor::FindTrackedPacket (FlowId flowId, FlowPacketId packetId)
+{
+  if (m_nTrackedPackets == 0)
+    {
+      return NO_SLOT;
+    }
+  uint32_t mask = m_trackedPackets.size () - 1;
+  for (uint32_t i = GetTrackedPacketHome (flowId, packetId); m_trackedPackets[i].flowId != NO_FLOW; i = (i + 1) & mask)
+    {
+      if (m_trackedPackets[i].flowId == flowId && m_trackedPackets[i].packetId == packetId)
+        {
+          return i;
+        }
+    }
+  return NO_SLOT;
+}
+
+uint32_t
+FlowMonitor::AddTrackedPacket (FlowId flowId, FlowPacketId packetId)
+{
+  NS_ASSERT_MSG (flowId != NO_FLOW, "The flow ID " << NO_FLOW << " is reserved");
+  uint32_t slot = FindTrackedPacket (flowId, packetId);
+  if (slot != NO_SLOT)
+    {
+      TouchTrackedPacket (slot);
+      return slot;
+    }
+  while (m_maxTrackedPackets != 0 && m_nTrackedPackets >= m_maxTrackedPackets)
+    {
+      if (m_eviction == EVICT_NEW)
+        {
+          NS_LOG_DEBUG ("AddTrackedPacket: not tracking packet (flowId=" << flowId
+                        << ", packetId=" << packetId << ").");
+          AddEvictedPacket (flowId, Simulator::Now ());
+          return NO_SLOT;
+        }
+      const TrackedPacket &evicted = m_trackedPackets[m_leastRecentSlot];
+      NS_LOG_DEBUG ("AddTrackedPacket: evicting tracked packet (flowId=" << evicted.flowId
+                    << ", packetId=" << evicted.packetId << ").");
+      AddEvictedPacket (evicted.flowId, evicted.lastSeenTime);
+      RemoveTrackedPacket (m_leastRecentSlot);
+    }
+
+  // Keep the table at most three quarters full
+  if (4 * static_cast<uint64_t> (m_nTrackedPackets + 1) > 3 * static_cast<uint64_t> (m_trackedPackets.size ()))
+    {
+      ResizeTrackedPackets (std::max<uint32_t> (16, 2 * m_trackedPackets.size ()));
+    }
+  uint32_t mask = m_trackedPackets.size () - 1;
+  slot = GetTrackedPacketHome (flowId, packetId);
+  while (m_trackedPackets[slot].flowId != NO_FLOW)
+    {
+      slot = (slot + 1) & mask;
+    }
+  m_trackedPackets[slot].flowId = flowId;
+  m_trackedPackets[slot].packetId = packetId;
+  LinkTrackedPacket (slot);
+  m_nTrackedPackets++;
+  return slot;
+}
+
+void
+FlowMonitor::TouchTrackedPacket (uint32_t slot)
+{
+  if (slot != m_mostRecentSlot)
+    {
+      UnlinkTrackedPacket (slot);
+      LinkTrackedPacket (slot);
+    }
+}
+
+void
+FlowMonitor::RemoveTrackedPacket (uint32_t slot)
+{
+  UnlinkTrackedPacket (slot);
+
+  // Move back the packets which follow the removed one in their probe
+  // sequence, so that no lookup runs into an empty slot too early
+  uint32_t mask = m_trackedPackets.size () - 1;
+  uint32_t hole = slot;
+  for (uint32_t i = (hole + 1) & mask; m_trackedPackets[i].flowId != NO_FLOW; i = (i + 1) & mask)
+    {
+      uint32_t home = GetTrackedPacketHome (m_trackedPackets[i].flowId, m_trackedPackets[i].packetId);
+      bool stays = hole < i ? (hole < home && home <= i) : (hole < home || home <= i);
+      if (stays)
+        {
+          continue;
+        }
+      TrackedPacket &moved = m_trackedPackets[hole];
+      moved = m_trackedPackets[i];
+      m_timesForwarded[hole] = m_timesForwarded[i];
+      if (moved.previous != NO_SLOT)
+        {
+          m_trackedPackets[moved.previous].next = hole;
+        }
+      else
+        {
+          m_leastRecentSlot = hole;
+        }
+      if (moved.next != NO_SLOT)
+        {
+          m_trackedPackets[moved.next].previous = hole;
+        }
+      else
+        {
+          m_mostRecentSlot = hole;
+        }
+      hole = i;
+    }
+  m_trackedPackets[hole].flowId = NO_FLOW;
+  m_nTrackedPackets--;
+}
+
+void
+FlowMonitor::LinkTrackedPacket (uint32_t slot)
+{
+  TrackedPacket &linked = m_trackedPackets[slot];
+  linked.previous = m_mostRecentSlot;
+  linked.next = NO_SLOT;
+  if (m_mostRecentSlot != NO_SLOT)
+    {
+      m_trackedPackets[m_mostRecentSlot].next = slot;
+    }
+  else
+    {
+      m_leastRecentSlot = slot;
+    }
+  m_mostRecentSlot = slot;
+}
+
+void
+FlowMonitor::UnlinkTrackedPacket (uint32_t slot)
+{
+  const TrackedPacket &unlinked = m_trackedPackets[slot];
+  if (unlinked.previous != NO_SLOT)
+    {
+      m_trackedPackets[unlinked.previous].next = unlinked.next;
+    }
+  else
+    {
+      m_leastRecentSlot = unlinked.next;
+    }
+  if (unlinked.next != NO_SLOT)
+    {
+      m_trackedPackets[unlinked.next].previous = unlinked.previous;
+    }
+  else
+    {
+      m_mostRecentSlot = unlinked.previous;
+    }
+}
+
+void
+FlowMonitor::AddEvictedPacket (FlowId flowId, Time lastSeenTime)
+{
+  // The packets are evicted in order of last sighting, so that a
+  // packet goes to the last period, or to a new one
+  int64_t period = Time (PERIODIC_CHECK_INTERVAL).GetInteger ();
+  Time end = TimeStep ((lastSeenTime.GetInteger () / period + 1) * period);
+  if (m_evictedPackets.empty () || m_evictedPackets.back ().lastSeenTime < end)
+    {
+      m_evictedPackets.push_back (EvictedPackets ());
+      m_evictedPackets.back ().lastSeenTime = end;
+    }
+  m_evictedPackets.back ().packets[flowId]++;
+}
+
+void
+FlowMonitor::ResizeTrackedPackets (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  TrackedPacket empty;
+  empty.flowId = NO_FLOW;
+  std::vector<TrackedPacket> old (size, empty);
+  old.swap (m_trackedPackets);
+  std::vector<uint32_t> oldTimesForwarded (size);
+  oldTimesForwarded.swap (m_timesForwarded);
+  uint32_t mask = size - 1;
+  uint32_t slot = m_leastRecentSlot;
+  m_leastRecentSlot = NO_SLOT;
+  m_mostRecentSlot = NO_SLOT;
+  while (slot != NO_SLOT)
+    {
+      const TrackedPacket &packet = old[slot];
+      uint32_t i = GetTrackedPacketHome (packet.flowId, packet.packetId);
+      while (m_trackedPackets[i].flowId != NO_FLOW)
+        {
+          i = (i + 1) & mask;
+        }
+      m_trackedPackets[i] = packet;
+      m_timesForwarded[i] = oldTimesForwarded[slot];
+      LinkTrackedPacket (i);
+      slot = packet.next;
     }
 }
 
@@ -143,12 +410,16 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
       return;
     }
   Time now = Simulator::Now ();
-  TrackedPacket &tracked = m_trackedPackets[std::make_pair (flowId, packetId)];
-  tracked.firstSeenTime = now;
-  tracked.lastSeenTime = tracked.firstSeenTime;
-  tracked.timesForwarded = 0;
-  NS_LOG_DEBUG ("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId=" << packetId
-                                                                << ").");
+  uint32_t slot = AddTrackedPacket (flowId, packetId);
+  if (slot != NO_SLOT)
+    {
+      TrackedPacket &tracked = m_trackedPackets[slot];
+      tracked.firstSeenTime = now;
+      tracked.lastSeenTime = tracked.firstSeenTime;
+      m_timesForwarded[slot] = 0;
+      NS_LOG_DEBUG ("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId=" << packetId
+                                                                    << ").");
+    }
 
   probe->AddPacketStats (flowId, packetSize, Seconds (0));
 
@@ -170,19 +441,20 @@ FlowMonitor::ReportForwarding (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t p
     {
       return;
     }
-  std::pair<FlowId, FlowPacketId> key (flowId, packetId);
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (key);
-  if (tracked == m_trackedPackets.end ())
+  uint32_t slot = FindTrackedPacket (flowId, packetId);
+  if (slot == NO_SLOT)
     {
       NS_LOG_WARN ("Received packet forward report (flowId=" << flowId << ", packetId=" << packetId
                                                              << ") but not known to be transmitted.");
       return;
     }
 
-  tracked->second.timesForwarded++;
-  tracked->second.lastSeenTime = Simulator::Now ();
+  TrackedPacket &tracked = m_trackedPackets[slot];
+  m_timesForwarded[slot]++;
+  tracked.lastSeenTime = Simulator::Now ();
+  TouchTrackedPacket (slot);
 
-  Time delay = (Simulator::Now () - tracked->second.firstSeenTime);
+  Time delay = (Simulator::Now () - tracked.firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 }
 
@@ -194,33 +466,44 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
     {
       return;
     }
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked == m_trackedPackets.end ())
+  uint32_t slot = FindTrackedPacket (flowId, packetId);
+  if (slot == NO_SLOT)
     {
       NS_LOG_WARN ("Received packet last-tx report (flowId=" << flowId << ", packetId=" << packetId
                                                              << ") but not known to be transmitted.");
       return;
     }
 
+  const TrackedPacket &tracked = m_trackedPackets[slot];
   Time now = Simulator::Now ();
-  Time delay = (now - tracked->second.firstSeenTime);
+  Time delay = (now - tracked.firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 
   FlowStats &stats = GetStatsForFlow (flowId);
+  bool sampled = packetId % m_histogramSampling == 0;
   stats.delaySum += delay;
-  stats.delayHistogram.AddValue (delay.GetSeconds ());
+  if (sampled)
+    {
+      stats.delayHistogram.AddValue (delay.GetSeconds ());
+    }
   if (stats.rxPackets > 0 )
     {
       Time jitter = stats.lastDelay - delay;
       if (jitter > Seconds (0))
         {
           stats.jitterSum += jitter;
-          stats.jitterHistogram.AddValue (jitter.GetSeconds ());
+          if (sampled)
+            {
+              stats.jitterHistogram.AddValue (jitter.GetSeconds ());
+            }
         }
       else 
         {
           stats.jitterSum -= jitter;
-          stats.jitterHistogram.AddValue (-jitter.GetSeconds ());
+          if (sampled)
+            {
+              stats.jitterHistogram.AddValue (-jitter.GetSeconds ());
+            }
         }
     }
   stats.lastDelay = delay;
@@ -242,12 +525,12 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
         }
     }
   stats.timeLastRxPacket = now;
-  stats.timesForwarded += tracked->second.timesForwarded;
+  stats.timesForwarded += m_timesForwarded[slot];
 
   NS_LOG_DEBUG ("ReportLastTx: removing tracked packet (flowId="
                 << flowId << ", packetId=" << packetId << ").");
 
-  m_trackedPackets.erase (tracked); // we don't need to track this packet anymore
+  RemoveTrackedPacket (slot); // we don't need to track this packet anymore
 }
 
 void
@@ -272,14 +555,14 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
   stats.bytesDropped[reasonCode] += packetSize;
   NS_LOG_DEBUG ("++stats.packetsDropped[" << reasonCode<< "]; // becomes: " << stats.packetsDropped[reasonCode]);
 
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked != m_trackedPackets.end ())
+  uint32_t slot = FindTrackedPacket (flowId, packetId);
+  if (slot != NO_SLOT)
     {
       // we don't need to track this packet anymore
       // FIXME: this will not necessarily be true with broadcast/multicast
       NS_LOG_DEBUG ("ReportDrop: removing tracked packet (flowId="
                     << flowId << ", packetId=" << packetId << ").");
-      m_trackedPackets.erase (tracked);
+      RemoveTrackedPacket (slot);
     }
 }
 
@@ -295,23 +578,26 @@ FlowMonitor::CheckForLostPackets (Time maxDelay)
 {
   Time now = Simulator::Now ();
 
-  for (TrackedPacketMap::iterator iter = m_trackedPackets.begin ();
-       iter != m_trackedPackets.end (); )
+  // the packets no longer tracked are lost once they would have been
+  while (!m_evictedPackets.empty () && now - m_evictedPackets.front ().lastSeenTime >= maxDelay)
     {
-      if (now - iter->second.lastSeenTime >= maxDelay)
-        {
-          // packet is considered lost, add it to the loss statistics
-          FlowStatsContainerI flow = m_flowStats.find (iter->first.first);
-          NS_ASSERT (flow != m_flowStats.end ());
-          flow->second.lostPackets++;
-
-          // we won't track it anymore
-          m_trackedPackets.erase (iter++);
-        }
-      else
+      const std::map<FlowId, uint32_t> &packets = m_evictedPackets.front ().packets;
+      for (std::map<FlowId, uint32_t>::const_iterator i = packets.begin (); i != packets.end (); i++)
         {
-          iter++;
+          GetStatsForFlow (i->first).lostPackets += i->second;
         }
+      m_evictedPackets.pop_front ();
+    }
+
+  // the tracked packets are in order of last sighting
+  while (m_leastRecentSlot != NO_SLOT
+         && now - m_trackedPackets[m_leastRecentSlot].lastSeenTime >= maxDelay)
+    {
+      // packet is considered lost, add it to the loss statistics
+      GetStatsForFlow (m_trackedPackets[m_leastRecentSlot].flowId).lostPackets++;
+
+      // we won't track it anymore
+      RemoveTrackedPacket (m_leastRecentSlot);
     }
 }
 
@@ -23,6 +23,7 @@
 
 #include <vector>
 #include <map>
+#include <deque>
 
 #include "ns3/ptr.h"
 #include "ns3/object.h"
@@ -46,6 +47,12 @@ namespace ns3 {
  * The FlowMonitor class is responsible for coordinating efforts
  * regarding probes, and collects end-to-end flow statistics.
  *
+ * The packets in flight are tracked in a hash table, in order of their
+ * last sighting, so that the check for lost packets only visits the
+ * packets it finds lost.  The MaxTrackedPackets attribute bounds the
+ * memory used by the tracked packets.  The flow ID 0xffffffff, never
+ * handed out by the flow classifiers, marks the empty slots of the table.
+ *
  */
 class FlowMonitor : public Object
 {
@@ -137,6 +144,16 @@ public:
     Histogram flowInterruptionsHistogram; //!< histogram of durations of flow interruptions
   };
 
+  /// \brief What to do when a new packet is transmitted while the
+  /// maximum number of tracked packets is reached.  The packet which is
+  /// no longer tracked is counted as lost once it was last seen more
+  /// than MaxPerHopDelay ago.
+  enum TrackedPacketEviction
+  {
+    EVICT_LEAST_RECENT, //!< Stop tracking the packet seen least recently
+    EVICT_NEW,          //!< Do not track the new packet
+  };
+
   // --- basic methods ---
   /**
    * \brief Get the type ID.
@@ -264,20 +281,56 @@ protected:
 
 private:
 
-  /// Structure to represent a single tracked packet data
+  /// Structure to represent a single tracked packet data, in a slot of
+  /// the table of tracked packets.  The slots in use are linked from the
+  /// packet seen least recently to the packet seen most recently.  The
+  /// number of times the packet was forwarded is kept apart, in
+  /// m_timesForwarded, so that a slot takes 32 bytes.
   struct TrackedPacket
   {
     Time firstSeenTime; //!< absolute time when the packet was first seen by a probe
     Time lastSeenTime; //!< absolute time when the packet was last seen by a probe
-    uint32_t timesForwarded; //!< number of times the packet was reportedly forwarded
+    FlowId flowId; //!< flow of the packet, or NO_FLOW if the slot is empty
+    FlowPacketId packetId; //!< packet ID in the flow
+    uint32_t previous; //!< slot of the packet seen before, or NO_SLOT
+    uint32_t next; //!< slot of the packet seen after, or NO_SLOT
   };
 
+  /// The index of no slot
+  static const uint32_t NO_SLOT = 0xffffffff;
+  /// The flow of the empty slots of m_trackedPackets
+  static const FlowId NO_FLOW = 0xffffffff;
+
   /// FlowId --> FlowStats
   FlowStatsContainer m_flowStats;
 
-  /// (FlowId,PacketId) --> TrackedPacket
-  typedef std::map< std::pair<FlowId, FlowPacketId>, TrackedPacket> TrackedPacketMap;
-  TrackedPacketMap m_trackedPackets; //!< Tracked packets
+  /// Hash index of m_flowStats by FlowId, with open addressing and
+  /// linear probing; empty slots point to no stats.
+  std::vector<std::pair<FlowId, FlowStats *> > m_flowStatsIndex;
+
+  /// (FlowId,PacketId) --> TrackedPacket, with open addressing and
+  /// linear probing; the table size is a power of two, and the table is
+  /// at most three quarters full.
+  std::vector<TrackedPacket> m_trackedPackets;
+  /// Number of times the packet of each slot of m_trackedPackets was
+  /// reportedly forwarded
+  std::vector<uint32_t> m_timesForwarded;
+  uint32_t m_nTrackedPackets;   //!< number of tracked packets
+  uint32_t m_leastRecentSlot;   //!< slot of the packet seen least recently
+  uint32_t m_mostRecentSlot;    //!< slot of the packet seen most recently
+  uint32_t m_maxTrackedPackets; //!< maximum number of tracked packets, or 0
+  TrackedPacketEviction m_eviction; //!< eviction when m_maxTrackedPackets is reached
+  /// The packets no longer tracked, last seen in the same period of
+  /// time, and counted per flow
+  struct EvictedPackets
+  {
+    Time lastSeenTime; //!< end of the period, when all the packets are considered seen last
+    std::map<FlowId, uint32_t> packets; //!< number of packets of each flow
+  };
+  /// The packets no longer tracked, to be counted as lost, in order of
+  /// last sighting
+  std::deque<EvictedPackets> m_evictedPackets;
+  uint32_t m_histogramSampling; //!< 1 in m_histogramSampling packets go to the delay histograms
   Time m_maxPerHopDelay; //!< Minimum per-hop delay
   FlowProbeContainer m_flowProbes; //!< all the FlowProbes
 
@@ -298,6 +351,53 @@ private:
   /// \returns the stats of the flow
   FlowStats& GetStatsForFlow (FlowId flowId);
 
+  /// \param flowId the flow of a packet
+  /// \param packetId the ID of the packet in its flow
+  /// \returns the home slot of the packet in m_trackedPackets
+  uint32_t GetTrackedPacketHome (FlowId flowId, FlowPacketId packetId) const;
+
+  /// \param flowId the flow of a packet
+  /// \param packetId the ID of the packet in its flow
+  /// \returns the slot of the tracked packet, or NO_SLOT
+  uint32_t FindTrackedPacket (FlowId flowId, FlowPacketId packetId);
+
+  /// Start tracking a packet, or restart if it is tracked already.  The
+  /// packet is tracked as seen most recently.
+  /// \param flowId the flow of the packet
+  /// \param packetId the ID of the packet in its flow
+  /// \returns the slot of the tracked packet, or NO_SLOT if the table
+  /// is full and the eviction policy is EVICT_NEW
+  uint32_t AddTrackedPacket (FlowId flowId, FlowPacketId packetId);
+
+  /// Mark a tracked packet as seen most recently
+  /// \param slot the slot of the tracked packet
+  void TouchTrackedPacket (uint32_t slot);
+
+  /// Stop tracking a packet
+  /// \param slot the slot of the tracked packet
+  void RemoveTrackedPacket (uint32_t slot);
+
+  /// Link a slot as the packet seen most recently
+  /// \param slot the slot
+  void LinkTrackedPacket (uint32_t slot);
+
+  /// Unlink a slot from the packets in order of last sighting
+  /// \param slot the slot
+  void UnlinkTrackedPacket (uint32_t slot);
+
+  /// Remember a packet no longer tracked, to count it as lost later.
+  /// The packets are counted in periods of one second, the interval of
+  /// the periodic check for lost packets, and considered seen last at
+  /// the end of their period.
+  /// \param flowId the flow of the packet
+  /// \param lastSeenTime the last time the packet was seen
+  void AddEvictedPacket (FlowId flowId, Time lastSeenTime);
+
+  /// Rebuild m_trackedPackets with another size, keeping the packets
+  /// and their order
+  /// \param size the new size, a power of two
+  void ResizeTrackedPackets (uint32_t size);
+
   /// Periodic function to check for lost packets and prune statistics
   void PeriodicCheckForLostPackets ();
 };
@@ -23,6 +23,7 @@
 #include "ipv4-flow-classifier.h"
 #include "ns3/udp-header.h"
 #include "ns3/tcp-header.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -95,6 +96,38 @@ bool operator == (const Ipv4FlowClassifier::FiveTuple &t1,
 
 
 
+/**
+ * \param tuple a five-tuple
+ * \returns the hash of the five-tuple
+ */
+static uint32_t
+HashFiveTuple (const Ipv4FlowClassifier::FiveTuple &tuple)
+{
+  uint64_t h = (static_cast<uint64_t> (tuple.sourceAddress.Get ()) << 32) | tuple.destinationAddress.Get ();
+  h = (h ^ (h >> 33)) * 0xff51afd7ed558ccdULL;
+  h ^= (static_cast<uint64_t> (tuple.sourcePort) << 24) | (static_cast<uint64_t> (tuple.destinationPort) << 8)
+    | tuple.protocol;
+  h = (h ^ (h >> 33)) * 0xc4ceb9fe1a85ec53ULL;
+  return static_cast<uint32_t> (h >> 32);
+}
+
+/**
+ * \param index a hash index of flows
+ * \param hash the hash of the five-tuple of a flow
+ * \param position the position of the flow in the flows
+ */
+static void
+AddToFlowIndex (std::vector<uint32_t> &index, uint32_t hash, uint32_t position)
+{
+  uint32_t mask = index.size () - 1;
+  uint32_t i = hash & mask;
+  while (index[i] != 0)
+    {
+      i = (i + 1) & mask;
+    }
+  index[i] = 1 + position;
+}
+
 Ipv4FlowClassifier::Ipv4FlowClassifier ()
 {
 }
@@ -146,24 +179,46 @@ Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPa
   tuple.sourcePort = srcPort;
   tuple.destinationPort = dstPort;
 
-  // try to insert the tuple, but check if it already exists
-  std::pair<std::map<FiveTuple, FlowId>::iterator, bool> insert
-    = m_flowMap.insert (std::pair<FiveTuple, FlowId> (tuple, 0));
+  // look for the tuple among the known flows
+  uint32_t hash = HashFiveTuple (tuple);
+  if (!m_flowIndex.empty ())
+    {
+      uint32_t mask = m_flowIndex.size () - 1;
+      for (uint32_t i = hash & mask; m_flowIndex[i] != 0; i = (i + 1) & mask)
+        {
+          Flow &flow = m_flows[m_flowIndex[i] - 1];
+          if (flow.tuple == tuple)
+            {
+              *out_flowId = flow.flowId;
+              *out_packetId = ++flow.lastPacketId;
+              return true;
+            }
+        }
+    }
+
+  // otherwise, we need to assign this tuple a new flow identifier
+  Flow flow;
+  flow.tuple = tuple;
+  flow.flowId = GetNewFlowId ();
+  flow.lastPacketId = 0;
+  m_flows.push_back (flow);
 
-  // if the insertion succeeded, we need to assign this tuple a new flow identifier
-  if (insert.second)
+  // keep the index at most half full
+  if (2 * m_flows.size () > m_flowIndex.size ())
     {
-      FlowId newFlowId = GetNewFlowId ();
-      insert.first->second = newFlowId;
-      m_flowPktIdMap[newFlowId] = 0;
+      m_flowIndex.assign (std::max<uint32_t> (16, 2 * m_flowIndex.size ()), 0);
+      for (uint32_t i = 0; i < m_flows.size (); i++)
+        {
+          AddToFlowIndex (m_flowIndex, HashFiveTuple (m_flows[i].tuple), i);
+        }
     }
   else
     {
-      m_flowPktIdMap[insert.first->second] ++;
+      AddToFlowIndex (m_flowIndex, hash, m_flows.size () - 1);
     }
 
-  *out_flowId = insert.first->second;
-  *out_packetId = m_flowPktIdMap[*out_flowId];
+  *out_flowId = flow.flowId;
+  *out_packetId = flow.lastPacketId;
 
   return true;
 }
@@ -172,14 +227,25 @@ Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPa
 Ipv4FlowClassifier::FiveTuple
 Ipv4FlowClassifier::FindFlow (FlowId flowId) const
 {
-  for (std::map<FiveTuple, FlowId>::const_iterator
-       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+  // the flows are in order of FlowId
+  uint32_t low = 0;
+  uint32_t high = m_flows.size ();
+  while (low < high)
     {
-      if (iter->second == flowId)
+      uint32_t middle = low + (high - low) / 2;
+      if (m_flows[middle].flowId < flowId)
+        {
+          low = middle + 1;
+        }
+      else
         {
-          return iter->first;
+          high = middle;
         }
     }
+  if (low < m_flows.size () && m_flows[low].flowId == flowId)
+    {
+      return m_flows[low].tuple;
+    }
   NS_FATAL_ERROR ("Could not find the flow with ID " << flowId);
   FiveTuple retval = { Ipv4Address::GetZero (), Ipv4Address::GetZero (), 0, 0, 0 };
   return retval;
@@ -192,9 +258,17 @@ Ipv4FlowClassifier::SerializeToXmlStream (std::ostream &os, int indent) const
 
   INDENT (indent); os << "<Ipv4FlowClassifier>\n";
 
+  // the flows are listed in order of five-tuple
+  std::vector<std::pair<FiveTuple, FlowId> > flows;
+  for (std::vector<Flow>::const_iterator iter = m_flows.begin (); iter != m_flows.end (); iter++)
+    {
+      flows.push_back (std::make_pair (iter->tuple, iter->flowId));
+    }
+  std::sort (flows.begin (), flows.end ());
+
   indent += 2;
-  for (std::map<FiveTuple, FlowId>::const_iterator
-       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+  for (std::vector<std::pair<FiveTuple, FlowId> >::const_iterator
+       iter = flows.begin (); iter != flows.end (); iter++)
     {
       INDENT (indent);
       os << "<Flow flowId=\"" << iter->second << "\""
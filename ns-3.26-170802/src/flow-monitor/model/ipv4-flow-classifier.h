@@ -22,7 +22,7 @@
 #define IPV4_FLOW_CLASSIFIER_H
 
 #include <stdint.h>
-#include <map>
+#include <vector>
 
 #include "ns3/ipv4-header.h"
 #include "ns3/flow-classifier.h"
@@ -34,7 +34,8 @@ class Packet;
 /// Classifies packets by looking at their IP and TCP/UDP headers.
 /// From these packet headers, a tuple (source-ip, destination-ip,
 /// protocol, source-port, destination-port) is created, and a unique
-/// flow identifier is assigned for each different tuple combination
+/// flow identifier is assigned for each different tuple combination.
+/// The flows are found with a hash table of their tuples.
 class Ipv4FlowClassifier : public FlowClassifier
 {
 public:
@@ -73,10 +74,19 @@ public:
 
 private:
 
-  /// Map to Flows Identifiers to FlowIds
-  std::map<FiveTuple, FlowId> m_flowMap;
-  /// Map to FlowIds to FlowPacketId
-  std::map<FlowId, FlowPacketId> m_flowPktIdMap;
+  /// Structure to represent a flow
+  struct Flow
+  {
+    FiveTuple tuple;            //!< Flow five-tuple
+    FlowId flowId;              //!< Flow identifier
+    FlowPacketId lastPacketId;  //!< Identifier of the last packet of the flow
+  };
+
+  /// The flows, in order of FlowId
+  std::vector<Flow> m_flows;
+  /// Hash index of m_flows by FiveTuple, with open addressing and linear
+  /// probing: 1 + the position of a flow in m_flows, or 0 for an empty slot
+  std::vector<uint32_t> m_flowIndex;
 
 };
 
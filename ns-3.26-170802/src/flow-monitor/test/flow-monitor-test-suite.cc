@@ -0,0 +1,426 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-probe.h"
+#include "ns3/ipv4-flow-classifier.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/test.h"
+#include <map>
+#include <list>
+#include <deque>
+#include <vector>
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * A probe which only reports the packets given by the test.
+ */
+class FlowMonitorTestProbe : public FlowProbe
+{
+public:
+  /**
+   * \param monitor the monitor of the probe
+   */
+  FlowMonitorTestProbe (Ptr<FlowMonitor> monitor)
+    : FlowProbe (monitor)
+  {
+  }
+};
+
+/**
+ * Report random packet events to a FlowMonitor, and check its
+ * statistics against a reference model of the tracked packets built on
+ * a std::map, as the FlowMonitor kept them.
+ */
+class FlowMonitorTrackingTestCase : public TestCase
+{
+public:
+  /**
+   * \param maxTracked the maximum number of tracked packets, or 0
+   * \param eviction the eviction policy
+   */
+  FlowMonitorTrackingTestCase (uint32_t maxTracked, FlowMonitor::TrackedPacketEviction eviction);
+  virtual void DoRun (void);
+
+private:
+  /// A flow and a packet ID
+  typedef std::pair<FlowId, FlowPacketId> Key;
+  /// A tracked packet of the model
+  struct Packet
+  {
+    Time firstSeen;               //!< First seen time
+    Time lastSeen;                //!< Last seen time
+    uint32_t forwarded;           //!< Number of forwards
+    std::list<Key>::iterator order; //!< Position in m_order
+  };
+  /// The statistics of a flow of the model
+  struct Flow
+  {
+    uint32_t txPackets;       //!< Transmitted packets
+    uint32_t rxPackets;       //!< Received packets
+    uint32_t lostPackets;     //!< Lost packets
+    uint32_t timesForwarded;  //!< Forwards of the received packets
+    Time delaySum;            //!< Sum of the delays
+  };
+
+  /// Report a random event, and update the model
+  void Step (void);
+  /// \returns a packet transmitted recently
+  Key PickPacket (void);
+  /// Stop tracking a packet of the model
+  /// \param i the packet
+  void Remove (std::map<Key, Packet>::iterator i);
+  /// Find the lost packets of the model
+  /// \param now the time of the check
+  void CheckForLostPackets (Time now);
+
+  uint32_t m_maxTracked;                          //!< Maximum number of tracked packets
+  FlowMonitor::TrackedPacketEviction m_eviction;  //!< Eviction policy
+  Time m_maxDelay;                                //!< Maximum per-hop delay
+  Ptr<FlowMonitor> m_monitor;                     //!< The monitor
+  Ptr<FlowProbe> m_probe;                         //!< The probe
+  Ptr<UniformRandomVariable> m_random;            //!< Random events
+  std::map<Key, Packet> m_packets;                //!< Tracked packets
+  std::list<Key> m_order;                         //!< Tracked packets, least recently seen first
+  std::deque<std::pair<Time, FlowId> > m_evicted; //!< Packets no longer tracked, seen last at the end of their second
+  std::map<FlowId, Flow> m_flows;                 //!< Flow statistics
+  std::map<FlowId, FlowPacketId> m_nextPacketId;  //!< Next packet ID of each flow
+  std::vector<Key> m_sent;                        //!< Transmitted packets
+  Time m_nextCheck;                               //!< Time of the next periodic check
+};
+
+/**
+ * \param maxTracked the maximum number of tracked packets, or 0
+ * \param eviction the eviction policy
+ * \returns the name of the test case
+ */
+static std::string
+GetTrackingTestName (uint32_t maxTracked, FlowMonitor::TrackedPacketEviction eviction)
+{
+  std::ostringstream oss;
+  oss << "FlowMonitor tracks packets like a sorted map, with at most " << maxTracked
+      << " packets, evicting " << (eviction == FlowMonitor::EVICT_NEW ? "new" : "least recent") << " packets";
+  return oss.str ();
+}
+
+FlowMonitorTrackingTestCase::FlowMonitorTrackingTestCase (uint32_t maxTracked,
+                                                          FlowMonitor::TrackedPacketEviction eviction)
+  : TestCase (GetTrackingTestName (maxTracked, eviction)),
+    m_maxTracked (maxTracked),
+    m_eviction (eviction),
+    m_maxDelay (MilliSeconds (500))
+{
+}
+
+void
+FlowMonitorTrackingTestCase::Remove (std::map<Key, Packet>::iterator i)
+{
+  m_order.erase (i->second.order);
+  m_packets.erase (i);
+}
+
+/**
+ * \param lastSeen the last time a packet no longer tracked was seen
+ * \return the time when FlowMonitor considers it seen last: the end of
+ * its period of one second
+ */
+static Time
+GetEvictedLastSeen (Time lastSeen)
+{
+  int64_t second = Seconds (1).GetInteger ();
+  return TimeStep ((lastSeen.GetInteger () / second + 1) * second);
+}
+
+void
+FlowMonitorTrackingTestCase::CheckForLostPackets (Time now)
+{
+  while (!m_evicted.empty () && now - m_evicted.front ().first >= m_maxDelay)
+    {
+      m_flows[m_evicted.front ().second].lostPackets++;
+      m_evicted.pop_front ();
+    }
+  for (std::map<Key, Packet>::iterator i = m_packets.begin (); i != m_packets.end (); )
+    {
+      if (now - i->second.lastSeen >= m_maxDelay)
+        {
+          m_flows[i->first.first].lostPackets++;
+          Remove (i++);
+        }
+      else
+        {
+          i++;
+        }
+    }
+}
+
+FlowMonitorTrackingTestCase::Key
+FlowMonitorTrackingTestCase::PickPacket (void)
+{
+  uint32_t recent = std::min<uint32_t> (m_sent.size (), 200);
+  return m_sent[m_sent.size () - 1 - m_random->GetInteger (0, recent - 1)];
+}
+
+void
+FlowMonitorTrackingTestCase::Step (void)
+{
+  Time now = Simulator::Now ();
+  while (m_nextCheck <= now)
+    {
+      CheckForLostPackets (m_nextCheck);
+      m_nextCheck += Seconds (1);
+    }
+
+  uint32_t event = m_random->GetInteger (0, 9);
+  if (event < 4 || m_sent.empty ())
+    {
+      FlowId flowId = m_random->GetInteger (1, 8);
+      FlowPacketId packetId = m_nextPacketId[flowId]++;
+      m_monitor->ReportFirstTx (m_probe, flowId, packetId, 100 + flowId);
+      m_sent.push_back (Key (flowId, packetId));
+      m_flows[flowId].txPackets++;
+      if (m_maxTracked != 0 && m_packets.size () >= m_maxTracked)
+        {
+          if (m_eviction == FlowMonitor::EVICT_NEW)
+            {
+              m_evicted.push_back (std::make_pair (GetEvictedLastSeen (now), flowId));
+              return;
+            }
+          std::map<Key, Packet>::iterator evicted = m_packets.find (m_order.front ());
+          m_evicted.push_back (std::make_pair (GetEvictedLastSeen (evicted->second.lastSeen), evicted->first.first));
+          Remove (evicted);
+        }
+      Packet &packet = m_packets[Key (flowId, packetId)];
+      packet.firstSeen = now;
+      packet.lastSeen = now;
+      packet.forwarded = 0;
+      packet.order = m_order.insert (m_order.end (), Key (flowId, packetId));
+      return;
+    }
+
+  Key key = PickPacket ();
+  std::map<Key, Packet>::iterator i = m_packets.find (key);
+  if (event < 7)
+    {
+      m_monitor->ReportForwarding (m_probe, key.first, key.second, 100 + key.first);
+      if (i != m_packets.end ())
+        {
+          i->second.forwarded++;
+          i->second.lastSeen = now;
+          m_order.erase (i->second.order);
+          i->second.order = m_order.insert (m_order.end (), key);
+        }
+    }
+  else if (event < 9)
+    {
+      m_monitor->ReportLastRx (m_probe, key.first, key.second, 100 + key.first);
+      if (i != m_packets.end ())
+        {
+          Flow &flow = m_flows[key.first];
+          flow.rxPackets++;
+          flow.delaySum += now - i->second.firstSeen;
+          flow.timesForwarded += i->second.forwarded;
+          Remove (i);
+        }
+    }
+  else
+    {
+      m_monitor->ReportDrop (m_probe, key.first, key.second, 100 + key.first, 0);
+      m_flows[key.first].lostPackets++;
+      if (i != m_packets.end ())
+        {
+          Remove (i);
+        }
+    }
+}
+
+void
+FlowMonitorTrackingTestCase::DoRun (void)
+{
+  m_monitor = CreateObject<FlowMonitor> ();
+  m_monitor->SetAttribute ("MaxPerHopDelay", TimeValue (m_maxDelay));
+  m_monitor->SetAttribute ("MaxTrackedPackets", UintegerValue (m_maxTracked));
+  m_monitor->SetAttribute ("TrackedPacketEviction", EnumValue (m_eviction));
+  m_monitor->StartRightNow ();
+  m_probe = Create<FlowMonitorTestProbe> (m_monitor);
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (1);
+  m_nextCheck = Seconds (1);
+
+  // The steps fall between the periodic checks of the monitor
+  uint32_t steps = 20000;
+  for (uint32_t i = 0; i < steps; i++)
+    {
+      Simulator::Schedule (MicroSeconds (500 + 1000 * i), &FlowMonitorTrackingTestCase::Step, this);
+    }
+  Simulator::Stop (MilliSeconds (steps));
+  Simulator::Run ();
+  m_monitor->CheckForLostPackets ();
+  CheckForLostPackets (Simulator::Now ());
+
+  const FlowMonitor::FlowStatsContainer &stats = m_monitor->GetFlowStats ();
+  NS_TEST_ASSERT_MSG_EQ (stats.size (), m_flows.size (), "wrong number of flows");
+  uint32_t lost = 0;
+  for (std::map<FlowId, Flow>::const_iterator i = m_flows.begin (); i != m_flows.end (); i++)
+    {
+      FlowMonitor::FlowStatsContainerCI flow = stats.find (i->first);
+      NS_TEST_ASSERT_MSG_EQ ((flow != stats.end ()), true, "flow " << i->first << " not found");
+      NS_TEST_EXPECT_MSG_EQ (flow->second.txPackets, i->second.txPackets, "flow " << i->first);
+      NS_TEST_EXPECT_MSG_EQ (flow->second.rxPackets, i->second.rxPackets, "flow " << i->first);
+      NS_TEST_EXPECT_MSG_EQ (flow->second.lostPackets, i->second.lostPackets, "flow " << i->first);
+      NS_TEST_EXPECT_MSG_EQ (flow->second.timesForwarded, i->second.timesForwarded, "flow " << i->first);
+      NS_TEST_EXPECT_MSG_EQ (flow->second.delaySum, i->second.delaySum, "flow " << i->first);
+      lost += flow->second.lostPackets;
+    }
+  NS_TEST_EXPECT_MSG_GT (lost, 0, "no packet was lost");
+
+  m_monitor->Dispose ();
+  m_monitor = 0;
+  m_probe = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * Check that 1 packet in HistogramSampling goes to the delay and jitter
+ * histograms, and that all the packets are counted.
+ */
+class FlowMonitorSamplingTestCase : public TestCase
+{
+public:
+  FlowMonitorSamplingTestCase ();
+  virtual void DoRun (void);
+};
+
+FlowMonitorSamplingTestCase::FlowMonitorSamplingTestCase ()
+  : TestCase ("FlowMonitor samples the delay histograms")
+{
+}
+
+/**
+ * \param histogram a histogram
+ * \returns the number of values in the histogram
+ */
+static uint32_t
+CountValues (Histogram &histogram)
+{
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < histogram.GetNBins (); i++)
+    {
+      count += histogram.GetBinCount (i);
+    }
+  return count;
+}
+
+void
+FlowMonitorSamplingTestCase::DoRun (void)
+{
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  monitor->SetAttribute ("HistogramSampling", UintegerValue (4));
+  monitor->StartRightNow ();
+  Ptr<FlowProbe> probe = Create<FlowMonitorTestProbe> (monitor);
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      monitor->ReportFirstTx (probe, 1, i, 1000);
+      monitor->ReportLastRx (probe, 1, i, 1000);
+    }
+
+  FlowMonitor::FlowStats stats = monitor->GetFlowStats ().find (1)->second;
+  NS_TEST_EXPECT_MSG_EQ (stats.rxPackets, 100, "all the packets are counted");
+  NS_TEST_EXPECT_MSG_EQ (stats.rxBytes, 100000, "all the bytes are counted");
+  NS_TEST_EXPECT_MSG_EQ (CountValues (stats.packetSizeHistogram), 100, "all the sizes are counted");
+  NS_TEST_EXPECT_MSG_EQ (CountValues (stats.delayHistogram), 25, "packets 0, 4, ..., 96 are sampled");
+  NS_TEST_EXPECT_MSG_EQ (CountValues (stats.jitterHistogram), 24, "packet 0 has no jitter");
+
+  monitor->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * Check that Ipv4FlowClassifier assigns one flow to each five-tuple, and
+ * consecutive packet IDs to the packets of a flow.
+ */
+class Ipv4FlowClassifierTestCase : public TestCase
+{
+public:
+  Ipv4FlowClassifierTestCase ();
+  virtual void DoRun (void);
+};
+
+Ipv4FlowClassifierTestCase::Ipv4FlowClassifierTestCase ()
+  : TestCase ("Ipv4FlowClassifier finds the flows of the five-tuples")
+{
+}
+
+void
+Ipv4FlowClassifierTestCase::DoRun (void)
+{
+  Ptr<Ipv4FlowClassifier> classifier = Create<Ipv4FlowClassifier> ();
+  std::map<FlowId, uint32_t> tuples;
+  for (uint32_t round = 0; round < 3; round++)
+    {
+      for (uint32_t i = 0; i < 1000; i++)
+        {
+          Ipv4Header header;
+          header.SetSource (Ipv4Address (0x0a000000 + i % 10));
+          header.SetDestination (Ipv4Address (0x0a010000 + i % 7));
+          header.SetProtocol (i % 2 == 0 ? 6 : 17);
+          uint8_t ports[4] = { 0, static_cast<uint8_t> (i / 10), 0, static_cast<uint8_t> (i % 10) };
+          Ptr<Packet> payload = Create<Packet> (ports, 4);
+
+          FlowId flowId;
+          FlowPacketId packetId;
+          NS_TEST_ASSERT_MSG_EQ (classifier->Classify (header, payload, &flowId, &packetId), true,
+                                 "tuple " << i << " not classified");
+          NS_TEST_EXPECT_MSG_EQ (packetId, round, "wrong packet ID for tuple " << i);
+          if (round == 0)
+            {
+              NS_TEST_EXPECT_MSG_EQ (tuples.count (flowId), 0, "flow " << flowId << " assigned twice");
+              tuples[flowId] = i;
+            }
+          else
+            {
+              NS_TEST_EXPECT_MSG_EQ (tuples[flowId], i, "wrong flow for tuple " << i);
+            }
+
+          Ipv4FlowClassifier::FiveTuple tuple = classifier->FindFlow (flowId);
+          NS_TEST_EXPECT_MSG_EQ (tuple.sourceAddress, header.GetSource (), "wrong tuple of flow " << flowId);
+          NS_TEST_EXPECT_MSG_EQ (tuple.destinationAddress, header.GetDestination (), "wrong tuple of flow " << flowId);
+          NS_TEST_EXPECT_MSG_EQ (tuple.destinationPort, i % 10, "wrong tuple of flow " << flowId);
+        }
+    }
+}
+
+/**
+ * FlowMonitor TestSuite
+ */
+static class FlowMonitorTestSuite : public TestSuite
+{
+public:
+  FlowMonitorTestSuite ()
+    : TestSuite ("flow-monitor", UNIT)
+  {
+    AddTestCase (new FlowMonitorTrackingTestCase (0, FlowMonitor::EVICT_LEAST_RECENT), TestCase::QUICK);
+    AddTestCase (new FlowMonitorTrackingTestCase (50, FlowMonitor::EVICT_LEAST_RECENT), TestCase::QUICK);
+    AddTestCase (new FlowMonitorTrackingTestCase (50, FlowMonitor::EVICT_NEW), TestCase::QUICK);
+    AddTestCase (new FlowMonitorSamplingTestCase (), TestCase::QUICK);
+    AddTestCase (new Ipv4FlowClassifierTestCase (), TestCase::QUICK);
+  }
+} g_flowMonitorTestSuite;
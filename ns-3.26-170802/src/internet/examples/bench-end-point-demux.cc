@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Measure the cost of demultiplexing a received segment to its endpoint.
+//
+// A server node listens on port 80 and holds --connections connections,
+// one per client, plus --listeners other listening endpoints on other
+// ports.  Each lookup is the one of a segment received on one of the
+// connections, picked at random; one lookup out of --syn is the one of a
+// new connection, which goes to the listening endpoint.  The time per
+// lookup is printed in nanoseconds, for IPv4 and IPv6.
+//
+//   ./waf --run "bench-end-point-demux --connections=10000"
+//   ./waf --run "bench-end-point-demux --connections=100 --lookups=10000000"
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv4-interface-address.h"
+#include "ns3/ipv6-interface.h"
+#include "../model/ipv4-end-point.h"
+#include "../model/ipv4-end-point-demux.h"
+#include "../model/ipv6-end-point.h"
+#include "../model/ipv6-end-point-demux.h"
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+using namespace ns3;
+
+/**
+ * \param connections number of connections
+ * \param listeners number of other listening endpoints
+ * \param lookups number of lookups
+ * \param syn one lookup out of syn is for a new connection
+ * \returns the time per lookup, in nanoseconds
+ */
+static double
+RunIpv4 (uint32_t connections, uint32_t listeners, uint32_t lookups, uint32_t syn)
+{
+  Ipv4EndPointDemux demux;
+  Ptr<Ipv4Interface> interface = CreateObject<Ipv4Interface> ();
+  Ipv4Address server ("10.0.0.1");
+  interface->AddAddress (Ipv4InterfaceAddress (server, Ipv4Mask ("255.0.0.0")));
+  for (uint32_t i = 0; i < listeners; i++)
+    {
+      demux.Allocate (server, 1000 + i);
+    }
+  Ipv4EndPoint *listener = demux.Allocate (server, 80);
+  std::vector<Ipv4EndPoint *> endPoints;
+  for (uint32_t i = 0; i < connections; i++)
+    {
+      endPoints.push_back (demux.Allocate (server, 80, Ipv4Address (0x0b000000 + i), 49152 + i % 1000));
+    }
+
+  srand (1);
+  uint32_t errors = 0;
+  SystemWallClockMs clock;
+  clock.Start ();
+  for (uint32_t i = 0; i < lookups; i++)
+    {
+      if (syn != 0 && i % syn == 0)
+        {
+          Ipv4EndPointDemux::EndPoints ret = demux.Lookup (server, 80, Ipv4Address ("12.0.0.1"), 1,
+                                                          interface);
+          errors += ret.size () != 1 || ret.front () != listener;
+          continue;
+        }
+      uint32_t j = rand () % connections;
+      Ipv4EndPointDemux::EndPoints ret = demux.Lookup (server, 80, Ipv4Address (0x0b000000 + j),
+                                                      49152 + j % 1000, interface);
+      errors += ret.size () != 1 || ret.front () != endPoints[j];
+    }
+  int64_t ms = clock.End ();
+  if (errors != 0)
+    {
+      std::cout << "ipv4: " << errors << " lookups found the wrong endpoint" << std::endl;
+    }
+  return ms * 1e6 / lookups;
+}
+
+/**
+ * \param i a number
+ * \returns an IPv6 address made of \p i
+ */
+static Ipv6Address
+MakeIpv6Address (uint32_t i)
+{
+  uint8_t bytes[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+  bytes[12] = i >> 24;
+  bytes[13] = i >> 16;
+  bytes[14] = i >> 8;
+  bytes[15] = i;
+  return Ipv6Address (bytes);
+}
+
+/**
+ * \param connections number of connections
+ * \param listeners number of other listening endpoints
+ * \param lookups number of lookups
+ * \param syn one lookup out of syn is for a new connection
+ * \returns the time per lookup, in nanoseconds
+ */
+static double
+RunIpv6 (uint32_t connections, uint32_t listeners, uint32_t lookups, uint32_t syn)
+{
+  Ipv6EndPointDemux demux;
+  Ptr<Ipv6Interface> interface = CreateObject<Ipv6Interface> ();
+  Ipv6Address server ("2001:db9::1");
+  for (uint32_t i = 0; i < listeners; i++)
+    {
+      demux.Allocate (server, 1000 + i);
+    }
+  Ipv6EndPoint *listener = demux.Allocate (server, 80);
+  std::vector<Ipv6EndPoint *> endPoints;
+  for (uint32_t i = 0; i < connections; i++)
+    {
+      endPoints.push_back (demux.Allocate (server, 80, MakeIpv6Address (i), 49152 + i % 1000));
+    }
+
+  srand (1);
+  uint32_t errors = 0;
+  SystemWallClockMs clock;
+  clock.Start ();
+  for (uint32_t i = 0; i < lookups; i++)
+    {
+      if (syn != 0 && i % syn == 0)
+        {
+          Ipv6EndPointDemux::EndPoints ret = demux.Lookup (server, 80, Ipv6Address ("2001:dba::1"), 1,
+                                                          interface);
+          errors += ret.size () != 1 || ret.front () != listener;
+          continue;
+        }
+      uint32_t j = rand () % connections;
+      Ipv6EndPointDemux::EndPoints ret = demux.Lookup (server, 80, MakeIpv6Address (j),
+                                                      49152 + j % 1000, interface);
+      errors += ret.size () != 1 || ret.front () != endPoints[j];
+    }
+  int64_t ms = clock.End ();
+  if (errors != 0)
+    {
+      std::cout << "ipv6: " << errors << " lookups found the wrong endpoint" << std::endl;
+    }
+  return ms * 1e6 / lookups;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t connections = 10000;
+  uint32_t listeners = 10;
+  uint32_t lookups = 1000000;
+  uint32_t syn = 100;
+
+  CommandLine cmd;
+  cmd.Usage ("Measure the cost of demultiplexing a received segment to its endpoint");
+  cmd.AddValue ("connections", "number of connections to the listening port", connections);
+  cmd.AddValue ("listeners", "number of other listening endpoints", listeners);
+  cmd.AddValue ("lookups", "number of lookups", lookups);
+  cmd.AddValue ("syn", "one lookup out of syn is for a new connection (0 for none)", syn);
+  cmd.Parse (argc, argv);
+
+  if (connections == 0)
+    {
+      syn = 1;
+    }
+  std::cout << "ipv4 ns/lookup " << RunIpv4 (connections, listeners, lookups, syn) << std::endl;
+  std::cout << "ipv6 ns/lookup " << RunIpv6 (connections, listeners, lookups, syn) << std::endl;
+  return 0;
+}
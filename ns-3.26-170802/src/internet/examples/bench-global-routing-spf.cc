@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Measure the cost of computing the global routes of a large network.
+//
+// A backbone of --rows by --cols routers, each connected to its neighbors
+// in a grid by point-to-point links, with --stubs stub routers attached to
+// it, gets its routes from global routing.  The time to populate the
+// routing tables is printed in milliseconds, then the time to recompute
+// them after a link of the backbone goes down, and after the link of a
+// stub router goes down.  The SPF computations run in --threads threads
+// (0 for one per processor), and are only run again for the routers they
+// may change with --incremental.
+//
+//   ./waf --run "bench-global-routing-spf --rows=30 --cols=30"
+//   ./waf --run "bench-global-routing-spf --rows=30 --cols=30 --stubs=1000 --threads=0 --incremental=1"
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4.h"
+#include "ns3/simulator.h"
+#include <iostream>
+#include <utility>
+
+using namespace ns3;
+
+/**
+ * \param a a node
+ * \param b another node
+ * \param addresses the addresses of the links
+ * \returns node a and its interface on a new point-to-point link to node b
+ */
+static std::pair<Ptr<Ipv4>, uint32_t>
+Connect (Ptr<Node> a, Ptr<Node> b, Ipv4AddressHelper &addresses)
+{
+  SimpleNetDeviceHelper simpleHelper;
+  simpleHelper.SetNetDevicePointToPointMode (true);
+  NetDeviceContainer net = simpleHelper.Install (NodeContainer (a, b), CreateObject<SimpleChannel> ());
+  Ipv4InterfaceContainer interfaces = addresses.Assign (net);
+  addresses.NewNetwork ();
+  return interfaces.Get (0);
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t rows = 30;
+  uint32_t cols = 30;
+  uint32_t stubs = 100;
+  uint32_t threads = 1;
+  bool incremental = false;
+
+  CommandLine cmd;
+  cmd.Usage ("Measure the cost of computing the global routes of a large network");
+  cmd.AddValue ("rows", "number of rows of the backbone", rows);
+  cmd.AddValue ("cols", "number of columns of the backbone", cols);
+  cmd.AddValue ("stubs", "number of stub routers", stubs);
+  cmd.AddValue ("threads", "number of threads running the SPF computations (0 for one per processor)", threads);
+  cmd.AddValue ("incremental", "only run again the SPF computations which may change", incremental);
+  cmd.Parse (argc, argv);
+
+  GlobalValue::Bind ("GlobalRoutingSpfThreads", UintegerValue (threads));
+  GlobalValue::Bind ("GlobalRoutingIncrementalSpf", BooleanValue (incremental));
+
+  NodeContainer backbone;
+  backbone.Create (rows * cols);
+  NodeContainer stubNodes;
+  stubNodes.Create (stubs);
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper globalRouting;
+  internet.SetRoutingHelper (globalRouting);
+  internet.Install (backbone);
+  internet.Install (stubNodes);
+
+  Ipv4AddressHelper addresses;
+  addresses.SetBase ("10.0.0.0", "255.255.255.252");
+  std::pair<Ptr<Ipv4>, uint32_t> backboneLink;
+  for (uint32_t r = 0; r < rows; r++)
+    {
+      for (uint32_t c = 0; c < cols; c++)
+        {
+          Ptr<Node> node = backbone.Get (r * cols + c);
+          if (c + 1 < cols)
+            {
+              std::pair<Ptr<Ipv4>, uint32_t> link = Connect (node, backbone.Get (r * cols + c + 1), addresses);
+              if (r == rows / 2 && c == cols / 2)
+                {
+                  backboneLink = link;
+                }
+            }
+          if (r + 1 < rows)
+            {
+              Connect (node, backbone.Get ((r + 1) * cols + c), addresses);
+            }
+        }
+    }
+  std::pair<Ptr<Ipv4>, uint32_t> stubLink;
+  for (uint32_t i = 0; i < stubs; i++)
+    {
+      stubLink = Connect (stubNodes.Get (i), backbone.Get (i * 7919 % backbone.GetN ()), addresses);
+    }
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  int64_t populateMs = clock.End ();
+  std::cout << "populate ms " << populateMs << std::endl;
+
+  if (backboneLink.first != 0)
+    {
+      backboneLink.first->SetDown (backboneLink.second);
+      clock.Start ();
+      Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+      std::cout << "backbone link down ms " << clock.End () << std::endl;
+    }
+  if (stubLink.first != 0)
+    {
+      stubLink.first->SetDown (stubLink.second);
+      clock.Start ();
+      Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+      std::cout << "stub link down ms " << clock.End () << std::endl;
+    }
+
+  Simulator::Destroy ();
+  return 0;
+}
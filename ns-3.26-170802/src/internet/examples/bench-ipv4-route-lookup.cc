@@ -0,0 +1,183 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Measure the cost of forwarding lookups in large routing tables.
+//
+// A router with --interfaces interfaces holds --routes network routes,
+// with prefix lengths from 16 to 24 in 1.0.0.0/8 to 126.0.0.0/8, and as
+// many host routes in 11.0.0.0/8, installed with AddNetworkRouteTo and
+// AddHostRouteTo in Ipv4StaticRouting and in Ipv4GlobalRouting.  Each lookup is the RouteOutput of a destination
+// picked at random, in one of the networks or one of the hosts.  The time
+// to add a route and the time per lookup are printed in nanoseconds.
+//
+//   ./waf --run "bench-ipv4-route-lookup --routes=1000"
+//   ./waf --run "bench-ipv4-route-lookup --routes=100000 --lookups=1000000"
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-interface-address.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simulator.h"
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+using namespace ns3;
+
+/**
+ * The destinations of the routes: a network or host address, and its
+ * prefix length.
+ */
+typedef std::vector<std::pair<uint32_t, uint8_t> > Destinations;
+
+/**
+ * \param routes number of network routes
+ * \returns the networks of the routes, then as many hosts
+ */
+static Destinations
+CreateDestinations (uint32_t routes)
+{
+  Destinations destinations;
+  srand (1);
+  for (uint32_t i = 0; i < routes; i++)
+    {
+      uint8_t length = 16 + rand () % 9;
+      uint32_t mask = 0xffffffffU << (32 - length);
+      uint32_t network = ((1 + rand () % 126) << 24) | (rand () & 0xffffff);
+      destinations.push_back (std::make_pair (network & mask, length));
+    }
+  for (uint32_t i = 0; i < routes; i++)
+    {
+      destinations.push_back (std::make_pair (0x0b000000 | (rand () & 0xffffff), 32));
+    }
+  return destinations;
+}
+
+/**
+ * \param routing the routing protocol
+ * \param destinations the destinations of the routes
+ * \param lookups number of lookups
+ * \returns the time per lookup, in nanoseconds
+ */
+static double
+RunLookups (Ptr<Ipv4RoutingProtocol> routing, const Destinations &destinations, uint32_t lookups)
+{
+  Ptr<Packet> p = Create<Packet> ();
+  Ipv4Header header;
+  Socket::SocketErrno err;
+  uint32_t errors = 0;
+  srand (2);
+  SystemWallClockMs clock;
+  clock.Start ();
+  for (uint32_t i = 0; i < lookups; i++)
+    {
+      const std::pair<uint32_t, uint8_t> &d = destinations[rand () % destinations.size ()];
+      header.SetDestination (Ipv4Address (d.first | (rand () & ~(0xffffffffU << (32 - d.second)))));
+      errors += routing->RouteOutput (p, header, 0, err) == 0;
+    }
+  int64_t ms = clock.End ();
+  if (errors != 0)
+    {
+      std::cout << errors << " lookups found no route" << std::endl;
+    }
+  return ms * 1e6 / lookups;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t routes = 10000;
+  uint32_t interfaces = 8;
+  uint32_t lookups = 1000000;
+
+  CommandLine cmd;
+  cmd.Usage ("Measure the cost of forwarding lookups in large routing tables");
+  cmd.AddValue ("routes", "number of network routes, and of host routes", routes);
+  cmd.AddValue ("interfaces", "number of interfaces of the router", interfaces);
+  cmd.AddValue ("lookups", "number of lookups", lookups);
+  cmd.Parse (argc, argv);
+
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  for (uint32_t i = 0; i < interfaces; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      node->AddDevice (device);
+      uint32_t interface = ipv4->AddInterface (device);
+      ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address (0xc0a80001 + (i << 8)),
+                                                         Ipv4Mask ("/24")));
+      ipv4->SetUp (interface);
+    }
+  Destinations destinations = CreateDestinations (routes);
+
+  Ipv4StaticRoutingHelper helper;
+  Ptr<Ipv4StaticRouting> staticRouting = helper.GetStaticRouting (ipv4);
+  Ptr<Ipv4GlobalRouting> globalRouting = CreateObject<Ipv4GlobalRouting> ();
+  globalRouting->SetIpv4 (ipv4);
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  for (uint32_t i = 0; i < destinations.size (); i++)
+    {
+      uint32_t interface = 1 + i % interfaces;
+      Ipv4Address nextHop (0xc0a80002 + ((interface - 1) << 8));
+      if (destinations[i].second == 32)
+        {
+          staticRouting->AddHostRouteTo (Ipv4Address (destinations[i].first), nextHop, interface);
+        }
+      else
+        {
+          Ipv4Mask mask (0xffffffffU << (32 - destinations[i].second));
+          staticRouting->AddNetworkRouteTo (Ipv4Address (destinations[i].first), mask, nextHop, interface);
+        }
+    }
+  int64_t staticMs = clock.End ();
+  clock.Start ();
+  for (uint32_t i = 0; i < destinations.size (); i++)
+    {
+      uint32_t interface = 1 + i % interfaces;
+      Ipv4Address nextHop (0xc0a80002 + ((interface - 1) << 8));
+      if (destinations[i].second == 32)
+        {
+          globalRouting->AddHostRouteTo (Ipv4Address (destinations[i].first), nextHop, interface);
+        }
+      else
+        {
+          Ipv4Mask mask (0xffffffffU << (32 - destinations[i].second));
+          globalRouting->AddNetworkRouteTo (Ipv4Address (destinations[i].first), mask, nextHop, interface);
+        }
+    }
+  int64_t globalMs = clock.End ();
+
+  std::cout << "static ns/add " << staticMs * 1e6 / destinations.size ()
+            << " ns/lookup " << RunLookups (staticRouting, destinations, lookups) << std::endl;
+  std::cout << "global ns/add " << globalMs * 1e6 / destinations.size ()
+            << " ns/lookup " << RunLookups (globalRouting, destinations, lookups) << std::endl;
+
+  globalRouting->Dispose ();
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,190 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Measure the throughput of the TCP send and receive buffers.
+//
+// The send side mimics a bulk transfer: the application fills the
+// TcpTxBuffer with writes of --write bytes, the socket takes segments of
+// --mss bytes with CopyFromSequence up to a window of --window
+// segments, and each round acknowledges half of the bytes in flight.
+// One segment out of --loss is sent again from the head of the buffer,
+// as a retransmission.
+//
+// The receive side feeds a TcpRxBuffer with the segments in order,
+// except one out of --loss which arrives --reorder segments late, and
+// the application extracts the data as soon as it is available.
+//
+// The payload is made of zeros which are not stored, as with
+// BulkSendApplication, unless --real is given.  The time per segment is
+// printed in nanoseconds for each side.
+//
+//   ./waf --run "bench-tcp-buffers --n=1000000"
+//   ./waf --run "bench-tcp-buffers --write=512 --mss=536 --loss=20"
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-tx-buffer.h"
+#include "ns3/tcp-rx-buffer.h"
+#include "ns3/tcp-header.h"
+#include <iostream>
+#include <vector>
+#include <deque>
+
+using namespace ns3;
+
+/**
+ * \param [in] size The size of the packet.
+ * \param [in] real Whether the payload is stored.
+ * \returns A packet.
+ */
+static Ptr<Packet>
+CreatePayload (uint32_t size, bool real)
+{
+  if (!real)
+    {
+      return Create<Packet> (size);
+    }
+  static std::vector<uint8_t> bytes;
+  if (bytes.size () < size)
+    {
+      bytes.resize (size);
+      for (uint32_t i = 0; i < size; i++)
+        {
+          bytes[i] = i;
+        }
+    }
+  return Create<Packet> (&bytes[0], size);
+}
+
+/**
+ * Send n segments through a TcpTxBuffer.
+ * \returns The number of bytes of the segments.
+ */
+static uint64_t
+RunTx (uint32_t n, uint32_t write, uint32_t mss, uint32_t window, uint32_t loss, bool real)
+{
+  Ptr<TcpTxBuffer> tx = CreateObject<TcpTxBuffer> ();
+  tx->SetMaxBufferSize (2 * window * mss + write);
+  tx->SetHeadSequence (SequenceNumber32 (1));
+  SequenceNumber32 next = tx->HeadSequence ();
+  uint64_t bytes = 0;
+  uint32_t sent = 0;
+  while (sent < n)
+    {
+      while (tx->Available () >= write)
+        {
+          tx->Add (CreatePayload (write, real));
+        }
+      while (next - tx->HeadSequence () < static_cast<int32_t> (window * mss)
+             && tx->SizeFromSequence (next) >= mss && sent < n)
+        {
+          Ptr<Packet> p = tx->CopyFromSequence (mss, next);
+          next += p->GetSize ();
+          bytes += p->GetSize ();
+          sent++;
+          if (loss != 0 && sent % loss == 0)
+            {
+              bytes += tx->CopyFromSequence (mss, tx->HeadSequence ())->GetSize ();
+            }
+        }
+      uint32_t inFlight = next - tx->HeadSequence ();
+      uint32_t acked = inFlight < 2 * mss ? inFlight : inFlight / 2 / mss * mss;
+      tx->DiscardUpTo (tx->HeadSequence () + SequenceNumber32 (acked));
+    }
+  return bytes;
+}
+
+/**
+ * Receive n segments through a TcpRxBuffer.
+ * \returns The number of bytes extracted.
+ */
+static uint64_t
+RunRx (uint32_t n, uint32_t mss, uint32_t window, uint32_t loss, uint32_t reorder, bool real)
+{
+  Ptr<TcpRxBuffer> rx = CreateObject<TcpRxBuffer> ();
+  rx->SetMaxBufferSize (window * mss);
+  rx->SetNextRxSequence (SequenceNumber32 (1));
+  std::deque<std::pair<uint32_t, SequenceNumber32> > late;
+  SequenceNumber32 seq (1);
+  uint64_t bytes = 0;
+  TcpHeader header;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      if (loss != 0 && i % loss == loss - 1)
+        {
+          late.push_back (std::make_pair (i + reorder, seq));
+        }
+      else
+        {
+          header.SetSequenceNumber (seq);
+          rx->Add (CreatePayload (mss, real), header);
+        }
+      seq += mss;
+      while (!late.empty () && (late.front ().first <= i || i == n - 1))
+        {
+          header.SetSequenceNumber (late.front ().second);
+          rx->Add (CreatePayload (mss, real), header);
+          late.pop_front ();
+        }
+      if (rx->Available () > 0)
+        {
+          bytes += rx->Extract (rx->Available ())->GetSize ();
+        }
+    }
+  return bytes;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 1000000;
+  uint32_t write = 1448;
+  uint32_t mss = 1448;
+  uint32_t window = 64;
+  uint32_t loss = 0;
+  uint32_t reorder = 8;
+  bool real = false;
+
+  CommandLine cmd;
+  cmd.Usage ("Measure the throughput of the TCP send and receive buffers");
+  cmd.AddValue ("n", "number of segments", n);
+  cmd.AddValue ("write", "size of the application writes", write);
+  cmd.AddValue ("mss", "segment size", mss);
+  cmd.AddValue ("window", "window, in segments", window);
+  cmd.AddValue ("loss", "one segment out of loss is retransmitted or late (0 for none)", loss);
+  cmd.AddValue ("reorder", "number of segments a late segment is late by", reorder);
+  cmd.AddValue ("real", "store the payload bytes", real);
+  cmd.Parse (argc, argv);
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  uint64_t txBytes = RunTx (n, write, mss, window, loss, real);
+  int64_t txMs = clock.End ();
+  clock.Start ();
+  uint64_t rxBytes = RunRx (n, mss, window, loss, reorder, real);
+  int64_t rxMs = clock.End ();
+
+  std::cout << "tx ns/segment " << txMs * 1e6 / n
+            << " (" << txBytes * 8 / (txMs * 1e-3) / 1e9 << " Gbit/s)" << std::endl;
+  std::cout << "rx ns/segment " << rxMs * 1e6 / n
+            << " (" << rxBytes * 8 / (rxMs * 1e-3) / 1e9 << " Gbit/s)" << std::endl;
+  if (rxBytes != static_cast<uint64_t> (n) * mss)
+    {
+      std::cout << "unexpected number of bytes received: " << rxBytes << std::endl;
+      return 1;
+    }
+  return 0;
+}
@@ -82,6 +82,9 @@ public:
    * Users must first call PopulateRoutingTables() and then may subsequently
    * call RecomputeRoutingTables() at any later time in the simulation.
    *
+   * If the global value GlobalRoutingIncrementalSpf is true, only the
+   * routes of the routers whose shortest path computations depend on the
+   * changed parts of the topology are removed and recomputed.
    */
   static void RecomputeRoutingTables (void);
 private:
@@ -49,24 +49,28 @@ operator<< (std::ostream& os, const SPFVertex::VertexType& t)
 std::ostream& 
 operator<< (std::ostream& os, const CandidateQueue& q)
 {
-  typedef CandidateQueue::CandidateList_t List_t;
+  typedef std::vector<CandidateQueue::Candidate> List_t;
   typedef List_t::const_iterator CIter_t;
-  const CandidateQueue::CandidateList_t& list = q.m_candidates;
+  List_t list = q.m_candidates;
+  std::sort (list.begin (), list.end (), &CandidateQueue::IsBefore);
 
   os << "*** CandidateQueue Begin (<id, distance, LSA-type>) ***" << std::endl;
   for (CIter_t iter = list.begin (); iter != list.end (); iter++)
     {
       os << "<" 
-      << (*iter)->GetVertexId () << ", "
-      << (*iter)->GetDistanceFromRoot () << ", "
-      << (*iter)->GetVertexType () << ">" << std::endl;
+      << iter->vertex->GetVertexId () << ", "
+      << iter->vertex->GetDistanceFromRoot () << ", "
+      << iter->vertex->GetVertexType () << ">" << std::endl;
     }
   os << "*** CandidateQueue End ***";
   return os;
 }
 
 CandidateQueue::CandidateQueue()
-  : m_candidates ()
+  : m_candidates (),
+    m_positions (),
+    m_ids (),
+    m_order (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -81,12 +85,13 @@ void
 CandidateQueue::Clear (void)
 {
   NS_LOG_FUNCTION (this);
-  while (!m_candidates.empty ())
+  for (uint32_t i = 0; i < m_candidates.size (); i++)
     {
-      SPFVertex *p = Pop ();
-      delete p;
-      p = 0;
+      delete m_candidates[i].vertex;
     }
+  m_candidates.clear ();
+  m_positions.clear ();
+  m_ids.clear ();
 }
 
 void
@@ -94,11 +99,12 @@ CandidateQueue::Push (SPFVertex *vNew)
 {
   NS_LOG_FUNCTION (this << vNew);
 
-  CandidateList_t::iterator i = std::upper_bound (
-      m_candidates.begin (), m_candidates.end (), vNew,
-      &CandidateQueue::CompareSPFVertex
-      );
-  m_candidates.insert (i, vNew);
+  Candidate c;
+  c.vertex = vNew;
+  SetPriority (c);
+  m_candidates.push_back (c);
+  m_ids.insert (std::make_pair (vNew->GetVertexId (), vNew));
+  SiftUp (m_candidates.size () - 1);
 }
 
 SPFVertex *
@@ -110,8 +116,8 @@ CandidateQueue::Pop (void)
       return 0;
     }
 
-  SPFVertex *v = m_candidates.front ();
-  m_candidates.pop_front ();
+  SPFVertex *v = m_candidates.front ().vertex;
+  Remove (0);
   return v;
 }
 
@@ -124,7 +130,7 @@ CandidateQueue::Top (void) const
       return 0;
     }
 
-  return m_candidates.front ();
+  return m_candidates.front ().vertex;
 }
 
 bool
@@ -145,18 +151,21 @@ SPFVertex *
 CandidateQueue::Find (const Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this);
-  CandidateList_t::const_iterator i = m_candidates.begin ();
+  typedef std::unordered_multimap<Ipv4Address, SPFVertex*, Ipv4AddressHash>::const_iterator CIter_t;
+  std::pair<CIter_t, CIter_t> range = m_ids.equal_range (addr);
 
-  for (; i != m_candidates.end (); i++)
+  // Several vertices may have the same ID; return the first one popped
+  const Candidate *first = 0;
+  for (CIter_t i = range.first; i != range.second; i++)
     {
-      SPFVertex *v = *i;
-      if (v->GetVertexId () == addr)
+      const Candidate &c = m_candidates[m_positions.find (i->second)->second];
+      if (first == 0 || IsBefore (c, *first))
         {
-          return v;
+          first = &c;
         }
     }
 
-  return 0;
+  return first != 0 ? first->vertex : 0;
 }
 
 void
@@ -164,11 +173,123 @@ CandidateQueue::Reorder (void)
 {
   NS_LOG_FUNCTION (this);
 
-  m_candidates.sort (&CandidateQueue::CompareSPFVertex);
+  // Sort the candidates by their former priorities, then stably by their
+  // current ones, and renumber them: a sorted array is a heap
+  std::vector<Candidate> candidates = m_candidates;
+  std::sort (candidates.begin (), candidates.end (), &CandidateQueue::IsBefore);
+  for (uint32_t i = 0; i < candidates.size (); i++)
+    {
+      SetPriority (candidates[i]);
+    }
+  std::stable_sort (candidates.begin (), candidates.end (), &CandidateQueue::IsBefore);
+  m_candidates.clear ();
+  for (uint32_t i = 0; i < candidates.size (); i++)
+    {
+      SetPriority (candidates[i]);
+      m_candidates.push_back (candidates[i]);
+      m_positions[candidates[i].vertex] = i;
+    }
   NS_LOG_LOGIC ("After reordering the CandidateQueue");
   NS_LOG_LOGIC (*this);
 }
 
+void
+CandidateQueue::Reorder (SPFVertex *v)
+{
+  NS_LOG_FUNCTION (this << v);
+
+  std::unordered_map<SPFVertex*, uint32_t>::const_iterator i = m_positions.find (v);
+  NS_ASSERT_MSG (i != m_positions.end (), "CandidateQueue::Reorder (): vertex not in the queue");
+  uint32_t position = i->second;
+  SetPriority (m_candidates[position]);
+  SiftUp (position);
+  SiftDown (m_positions[v]);
+}
+
+void
+CandidateQueue::SetPriority (Candidate &c)
+{
+  c.distance = c.vertex->GetDistanceFromRoot ();
+  c.rank = c.vertex->GetVertexType () == SPFVertex::VertexNetwork ? 0 : 1;
+  c.order = m_order++;
+}
+
+void
+CandidateQueue::Place (uint32_t i, const Candidate &c)
+{
+  m_candidates[i] = c;
+  m_positions[c.vertex] = i;
+}
+
+void
+CandidateQueue::SiftUp (uint32_t i)
+{
+  Candidate c = m_candidates[i];
+  while (i > 0)
+    {
+      uint32_t parent = (i - 1) / 2;
+      if (!IsBefore (c, m_candidates[parent]))
+        {
+          break;
+        }
+      Place (i, m_candidates[parent]);
+      i = parent;
+    }
+  Place (i, c);
+}
+
+void
+CandidateQueue::SiftDown (uint32_t i)
+{
+  Candidate c = m_candidates[i];
+  uint32_t n = m_candidates.size ();
+  for (;;)
+    {
+      uint32_t child = 2 * i + 1;
+      if (child >= n)
+        {
+          break;
+        }
+      if (child + 1 < n && IsBefore (m_candidates[child + 1], m_candidates[child]))
+        {
+          child++;
+        }
+      if (!IsBefore (m_candidates[child], c))
+        {
+          break;
+        }
+      Place (i, m_candidates[child]);
+      i = child;
+    }
+  Place (i, c);
+}
+
+void
+CandidateQueue::Remove (uint32_t i)
+{
+  SPFVertex *v = m_candidates[i].vertex;
+  typedef std::unordered_multimap<Ipv4Address, SPFVertex*, Ipv4AddressHash>::iterator Iter_t;
+  std::pair<Iter_t, Iter_t> range = m_ids.equal_range (v->GetVertexId ());
+  for (Iter_t j = range.first; j != range.second; j++)
+    {
+      if (j->second == v)
+        {
+          m_ids.erase (j);
+          break;
+        }
+    }
+  m_positions.erase (v);
+
+  Candidate last = m_candidates.back ();
+  m_candidates.pop_back ();
+  if (i < m_candidates.size ())
+    {
+      Place (i, last);
+      SiftUp (i);
+      SiftDown (m_positions[last.vertex]);
+    }
+}
+
 /*
  * In this implementation, SPFVertex follows the ordering where
  * a vertex is ranked first if its GetDistanceFromRoot () is smaller;
@@ -197,4 +318,18 @@ CandidateQueue::CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2)
   return result;
 }
 
+bool
+CandidateQueue::IsBefore (const Candidate &c1, const Candidate &c2)
+{
+  if (c1.distance != c2.distance)
+    {
+      return c1.distance < c2.distance;
+    }
+  if (c1.rank != c2.rank)
+    {
+      return c1.rank < c2.rank;
+    }
+  return c1.order < c2.order;
+}
+
 } // namespace ns3
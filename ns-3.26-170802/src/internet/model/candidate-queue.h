@@ -22,7 +22,8 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <vector>
+#include <unordered_map>
 #include "ns3/ipv4-address.h"
 
 namespace ns3 {
@@ -47,6 +48,11 @@ class SPFVertex;
  * for a Find () operation, the dynamic nature of the data and the derived
  * requirement for a Reorder () operation led us to implement this simple 
  * enhanced priority queue.
+ *
+ * The queue is a binary heap, indexed by vertex and by vertex ID, so that
+ * Push (), Pop () and the Reorder () of a single vertex take a logarithmic
+ * time and Find () a constant time.  Vertices of equal priority are popped
+ * in the order they were pushed or last reordered.
  */
 class CandidateQueue
 {
@@ -154,6 +160,19 @@ public:
  */
   void Reorder (void);
 
+/**
+ * @brief Moves a Shortest Path First Vertex pointer to its place in the
+ * Candidate Queue, after the value of its field m_distanceFromRoot changed.
+ *
+ * The vertex goes after the vertices of equal priority.  The other
+ * vertices keep their places, so that this is equivalent to Reorder ()
+ * when the distance of the vertex decreased, and much faster.
+ *
+ * @see SPFVertex
+ * @param v The vertex, which must be in the queue.
+ */
+  void Reorder (SPFVertex *v);
+
 private:
 /**
  * Candidate Queue copy construction is disallowed (not implemented) to 
@@ -184,8 +203,64 @@ private:
  */
   static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
 
-  typedef std::list<SPFVertex*> CandidateList_t; //!< container of SPFVertex pointers
-  CandidateList_t m_candidates;  //!< SPFVertex candidates
+  /**
+   * \brief A vertex in the heap, with the priority it is ordered by.
+   */
+  struct Candidate
+  {
+    uint32_t distance; //!< The distance of the vertex from the root
+    uint32_t rank;     //!< 0 for a network vertex, 1 for a router vertex
+    uint64_t order;    //!< The order of the push or last reorder of the vertex
+    SPFVertex *vertex; //!< The vertex
+  };
+
+  /**
+   * \brief return true if c1 is popped before c2
+   *
+   * The same ordering as CompareSPFVertex, on the priorities of the
+   * candidates, with ties broken by their order.
+   *
+   * \param c1 first operand
+   * \param c2 second operand
+   * \return True if c1 should be popped before c2; false otherwise
+   */
+  static bool IsBefore (const Candidate &c1, const Candidate &c2);
+
+  /**
+   * \brief Read the priority of a vertex, and give it the next order.
+   * \param c the candidate of the vertex
+   */
+  void SetPriority (Candidate &c);
+
+  /**
+   * \brief Store a candidate at a place of the heap.
+   * \param i the index of the place
+   * \param c the candidate
+   */
+  void Place (uint32_t i, const Candidate &c);
+
+  /**
+   * \brief Move a candidate up the heap to its place.
+   * \param i the index of the candidate
+   */
+  void SiftUp (uint32_t i);
+
+  /**
+   * \brief Move a candidate down the heap to its place.
+   * \param i the index of the candidate
+   */
+  void SiftDown (uint32_t i);
+
+  /**
+   * \brief Remove a candidate from the heap.
+   * \param i the index of the candidate
+   */
+  void Remove (uint32_t i);
+
+  std::vector<Candidate> m_candidates;  //!< SPFVertex candidates, as a binary heap
+  std::unordered_map<SPFVertex*, uint32_t> m_positions; //!< Index of each candidate in the heap
+  std::unordered_multimap<Ipv4Address, SPFVertex*, Ipv4AddressHash> m_ids; //!< Candidates by vertex ID
+  uint64_t m_order;  //!< Order of the next push or reorder
 
   /**
    * \brief Stream insertion operator.
@@ -27,9 +27,13 @@
 #include <queue>
 #include <algorithm>
 #include <iostream>
+#include <atomic>
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
 #include "ns3/node-list.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
@@ -40,10 +44,48 @@
 #include "candidate-queue.h"
 #include "ipv4-global-routing.h"
 
+#ifdef NS3_GLOBAL_ROUTING_THREADS
+#include <thread>
+#include "ns3/system-thread.h"
+#endif
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GlobalRouteManagerImpl");
 
+/**
+ * \ingroup globalrouting
+ * The number of threads computing the routes of the routers.
+ */
+static GlobalValue g_globalRoutingSpfThreads = GlobalValue ("GlobalRoutingSpfThreads",
+                                                            "Number of threads running the SPF computations "
+                                                            "of the routers, 0 for one per processor; "
+                                                            "needs threading support",
+                                                            UintegerValue (1),
+                                                            MakeUintegerChecker<uint32_t> ());
+
+/**
+ * \ingroup globalrouting
+ * Whether RecomputeRoutes only recomputes the routes which may change.
+ */
+static GlobalValue g_globalRoutingIncrementalSpf = GlobalValue ("GlobalRoutingIncrementalSpf",
+                                                                "Only run again the SPF computations which read "
+                                                                "a changed Link State Advertisement when the "
+                                                                "routes are recomputed",
+                                                                BooleanValue (false),
+                                                                MakeBooleanChecker ());
+
+/**
+ * \brief The SPF computations shared by the threads: each thread takes the
+ * next root until there is none left.
+ */
+struct GlobalRouteManagerImpl::SPFWork
+{
+  std::vector<Ipv4Address> roots; //!< The roots of the computations
+  std::vector<uint8_t> stubs;     //!< Whether each computation was truncated at a stub node
+  std::atomic<uint32_t> next;     //!< The index of the next root
+};
+
 /**
  * \brief Stream insertion operator.
  *
@@ -468,9 +510,27 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
     {
       m_extdatabase.push_back (lsa);
     } 
-  else
+  else if (m_database.insert (LSDBPair_t (addr, lsa)).second)
     {
-      m_database.insert (LSDBPair_t (addr, lsa));
+//
+// Index the LSA by the LinkData of its TransitNetwork link records.  Of
+// several LSAs with the same LinkData, GetLSAByLinkData returns the one
+// with the lowest address.
+//
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              continue;
+            }
+          std::pair<LSDBIndex_t::iterator, bool> ret =
+            m_linkDataIndex.insert (std::make_pair (lr->GetLinkData (), lsa));
+          if (!ret.second && addr < ret.first->second->GetLinkStateId ())
+            {
+              ret.first->second = lsa;
+            }
+        }
     }
 }
 
@@ -495,13 +555,10 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
   return 0;
 }
@@ -511,24 +568,190 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this << addr);
 //
-// Look up an LSA by its address.
+// Look up an LSA by the LinkData of one of its TransitNetwork link records.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBIndex_t::const_iterator i = m_linkDataIndex.find (addr);
+  if (i != m_linkDataIndex.end ())
     {
-      GlobalRoutingLSA* temp = i->second;
-// Iterate among temp's Link Records
-      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
+      return i->second;
+    }
+  return 0;
+}
+
+GlobalRouteManagerLSDB*
+GlobalRouteManagerLSDB::Copy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  GlobalRouteManagerLSDB *lsdb = new GlobalRouteManagerLSDB ();
+  for (LSDBMap_t::const_iterator i = m_database.begin (); i != m_database.end (); i++)
+    {
+      lsdb->Insert (i->first, new GlobalRoutingLSA (*i->second));
+    }
+  for (uint32_t j = 0; j < m_extdatabase.size (); j++)
+    {
+      lsdb->Insert (m_extdatabase[j]->GetLinkStateId (), new GlobalRoutingLSA (*m_extdatabase[j]));
+    }
+  return lsdb;
+}
+
+/**
+ * \brief Compare two Link State Advertisements, except for their SPF status.
+ *
+ * \param a an LSA
+ * \param b another LSA
+ * \returns true if the LSAs advertise the same links
+ */
+static bool
+IsSameLSA (const GlobalRoutingLSA *a, const GlobalRoutingLSA *b)
+{
+  if (a->GetLSType () != b->GetLSType ()
+      || a->GetLinkStateId () != b->GetLinkStateId ()
+      || a->GetAdvertisingRouter () != b->GetAdvertisingRouter ()
+      || a->GetNetworkLSANetworkMask () != b->GetNetworkLSANetworkMask ()
+      || a->GetNode () != b->GetNode ()
+      || a->GetNLinkRecords () != b->GetNLinkRecords ()
+      || a->GetNAttachedRouters () != b->GetNAttachedRouters ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < a->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *la = a->GetLinkRecord (i);
+      GlobalRoutingLinkRecord *lb = b->GetLinkRecord (i);
+      if (la->GetLinkType () != lb->GetLinkType ()
+          || la->GetLinkId () != lb->GetLinkId ()
+          || la->GetLinkData () != lb->GetLinkData ()
+          || la->GetMetric () != lb->GetMetric ())
         {
-          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
-          if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
-               lr->GetLinkData () == addr)
+          return false;
+        }
+    }
+  for (uint32_t i = 0; i < a->GetNAttachedRouters (); i++)
+    {
+      if (a->GetAttachedRouter (i) != b->GetAttachedRouter (i))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+bool
+GlobalRouteManagerLSDB::FindChangedLSAs (const GlobalRouteManagerLSDB* other, LSAIdSet_t& changed) const
+{
+  NS_LOG_FUNCTION (this << other);
+//
+// The LSAs added or modified, then the LSAs removed.  Keep the LinkData of
+// their TransitNetwork link records: the attached routers of a network LSA
+// with one of these addresses may now be found in another router LSA.
+//
+  LSAIdSet_t linkData;
+  const GlobalRouteManagerLSDB *lsdbs[2] = { this, other };
+  for (uint32_t k = 0; k < 2; k++)
+    {
+      const GlobalRouteManagerLSDB *lsdb = lsdbs[k];
+      const GlobalRouteManagerLSDB *otherLsdb = lsdbs[1 - k];
+      for (LSDBMap_t::const_iterator i = lsdb->m_database.begin (); i != lsdb->m_database.end (); i++)
+        {
+          GlobalRoutingLSA *otherLsa = otherLsdb->GetLSA (i->first);
+          if (otherLsa != 0 && IsSameLSA (i->second, otherLsa))
             {
-              return temp;
+              continue;
+            }
+          changed.insert (i->first);
+          for (uint32_t j = 0; j < i->second->GetNLinkRecords (); j++)
+            {
+              GlobalRoutingLinkRecord *lr = i->second->GetLinkRecord (j);
+              if (lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+                {
+                  linkData.insert (lr->GetLinkData ());
+                }
+            }
+        }
+    }
+  if (!linkData.empty ())
+    {
+      for (uint32_t k = 0; k < 2; k++)
+        {
+          const GlobalRouteManagerLSDB *lsdb = lsdbs[k];
+          for (LSDBMap_t::const_iterator i = lsdb->m_database.begin (); i != lsdb->m_database.end (); i++)
+            {
+              for (uint32_t j = 0; j < i->second->GetNAttachedRouters (); j++)
+                {
+                  if (linkData.count (i->second->GetAttachedRouter (j)))
+                    {
+                      changed.insert (i->first);
+                      break;
+                    }
+                }
+            }
+        }
+    }
+
+  if (m_extdatabase.size () != other->m_extdatabase.size ())
+    {
+      return true;
+    }
+  for (uint32_t j = 0; j < m_extdatabase.size (); j++)
+    {
+      if (!IsSameLSA (m_extdatabase[j], other->m_extdatabase[j]))
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+GlobalRouteManagerLSDB::AddUpstreamLSAs (LSAIdSet_t& ids) const
+{
+  NS_LOG_FUNCTION (this);
+//
+// Build the links of the SPF graph backwards, the way SPFNext follows them:
+// the point-to-point and transit link records of the router LSAs, and the
+// attached routers of the network LSAs.
+//
+  typedef std::unordered_map<Ipv4Address, std::vector<Ipv4Address>, Ipv4AddressHash> Upstream_t;
+  Upstream_t upstream;
+  for (LSDBMap_t::const_iterator i = m_database.begin (); i != m_database.end (); i++)
+    {
+      GlobalRoutingLSA *lsa = i->second;
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+              || lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              upstream[lr->GetLinkId ()].push_back (i->first);
+            }
+        }
+      for (uint32_t j = 0; j < lsa->GetNAttachedRouters (); j++)
+        {
+          GlobalRoutingLSA *w = GetLSAByLinkData (lsa->GetAttachedRouter (j));
+          if (w != 0)
+            {
+              upstream[w->GetLinkStateId ()].push_back (i->first);
+            }
+        }
+    }
+
+  std::vector<Ipv4Address> pending (ids.begin (), ids.end ());
+  while (!pending.empty ())
+    {
+      Upstream_t::const_iterator i = upstream.find (pending.back ());
+      pending.pop_back ();
+      if (i == upstream.end ())
+        {
+          continue;
+        }
+      for (uint32_t j = 0; j < i->second.size (); j++)
+        {
+          if (ids.insert (i->second[j]).second)
+            {
+              pending.push_back (i->second[j]);
             }
         }
     }
-  return 0;
 }
 
 // ---------------------------------------------------------------------------
@@ -539,7 +762,10 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_spfroot (0),
+    m_spfrouter (0),
+    m_truncateStubs (false),
+    m_work (0)
 {
   NS_LOG_FUNCTION (this);
   m_lsdb = new GlobalRouteManagerLSDB ();
@@ -592,6 +818,7 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
         }
       NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
     }
+  m_routers.clear ();
   if (m_lsdb)
     {
       NS_LOG_LOGIC ("Deleting LSDB, creating new one");
@@ -696,38 +923,238 @@ void
 GlobalRouteManagerImpl::InitializeRoutes ()
 {
   NS_LOG_FUNCTION (this);
+  NS_LOG_INFO ("About to start SPF calculation");
+  SPFCalculateRoots (0);
+  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+void
+GlobalRouteManagerImpl::RecomputeRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+  BooleanValue incremental;
+  GlobalValue::GetValueByName ("GlobalRoutingIncrementalSpf", incremental);
+  if (!incremental.Get () || m_routers.empty ())
+    {
+      DeleteGlobalRoutes ();
+      BuildGlobalRoutingDatabase ();
+      InitializeRoutes ();
+      return;
+    }
 //
-// Walk the list of nodes in the system.
+// Keep the routes and the LSDB they were computed from, to find out which
+// routes may change.
 //
-  NS_LOG_INFO ("About to start SPF calculation");
+  GlobalRouteManagerLSDB *previous = m_lsdb;
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  BuildGlobalRoutingDatabase ();
+  NS_LOG_INFO ("About to start incremental SPF calculation");
+  SPFCalculateRoots (previous);
+  NS_LOG_INFO ("Finished SPF calculation");
+  delete previous;
+}
+
+/**
+ * \brief Delete all the routes of a global routing protocol.
+ *
+ * \param gr the routing protocol
+ */
+static void
+DeleteRoutes (Ptr<Ipv4GlobalRouting> gr)
+{
+  for (uint32_t j = gr->GetNRoutes (); j > 0; j--)
+    {
+      gr->RemoveRoute (0);
+    }
+}
+
+//
+// Walk the list of nodes in the system, looking for the GlobalRouter
+// interface that indicates that the node is participating in routing.  The
+// SPF computations add the routes of a router to its own node only, through
+// the interfaces holding its addresses, so note these once for all.
+//
+void
+GlobalRouteManagerImpl::FindRouters (SPFRouterMap_t& routers, std::vector<Ipv4Address>& roots) const
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t systemId = MpiInterface::GetSystemId ();
   NodeList::Iterator listEnd = NodeList::End ();
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
       Ptr<Node> node = *i;
-//
-// Look for the GlobalRouter interface that indicates that the node is
-// participating in routing.
-//
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      uint32_t systemId = MpiInterface::GetSystemId ();
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+      if (rtr == 0)
+        {
+          continue;
+        }
+      std::pair<SPFRouterMap_t::iterator, bool> ret =
+        routers.insert (std::make_pair (rtr->GetRouterId (), SPFRouter ()));
+      SPFRouter &router = ret.first->second;
+      if (ret.second)
+        {
+          router.routing = rtr->GetRoutingProtocol ();
+          router.nodeId = node->GetId ();
+          router.root = false;
+          router.stub = false;
+          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+          for (uint32_t j = 0; ipv4 != 0 && j < ipv4->GetNInterfaces (); j++)
+            {
+              for (uint32_t k = 0; k < ipv4->GetNAddresses (j); k++)
+                {
+                  router.addresses.push_back (std::make_pair (j, ipv4->GetAddress (j, k).GetLocal ()));
+                }
+            }
+        }
       // Ignore nodes that are not assigned to our systemId (distributed sim)
       if (node->GetSystemId () != systemId) 
         {
           continue;
         }
-
 //
 // if the node has a global router interface, then run the global routing
 // algorithms.
 //
-      if (rtr && rtr->GetNumLSAs () )
+      if (rtr->GetNumLSAs ())
         {
-          SPFCalculate (rtr->GetRouterId ());
+          router.root = true;
+          roots.push_back (rtr->GetRouterId ());
         }
     }
-  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+void
+GlobalRouteManagerImpl::SPFCalculateRoots (const GlobalRouteManagerLSDB* previous)
+{
+  NS_LOG_FUNCTION (this << previous);
+  SPFWork work;
+  SPFRouterMap_t routers;
+  FindRouters (routers, work.roots);
+
+  if (previous != 0)
+    {
+//
+// An SPF computation reads the LSAs it reaches from its root, and all the
+// External LSAs; if it is truncated at a stub router, it only reads the
+// LSAs of the router and of its neighbor.  The routes of the other roots
+// do not change.
+//
+      GlobalRouteManagerLSDB::LSAIdSet_t changed;
+      bool externalsChanged = m_lsdb->FindChangedLSAs (previous, changed);
+      GlobalRouteManagerLSDB::LSAIdSet_t upstream = changed;
+      previous->AddUpstreamLSAs (upstream);
+      NS_LOG_LOGIC (changed.size () << " LSAs changed, read from " << upstream.size () << " LSAs");
+
+      std::vector<Ipv4Address> roots;
+      for (uint32_t i = 0; i < work.roots.size (); i++)
+        {
+          Ipv4Address root = work.roots[i];
+          SPFRouter &router = routers[root];
+          SPFRouterMap_t::const_iterator p = m_routers.find (root);
+          bool recompute = true;
+          if (p != m_routers.end () && p->second.root && p->second.routing == router.routing
+              && p->second.addresses == router.addresses)
+            {
+              if (p->second.stub)
+                {
+                  recompute = changed.count (root) > 0;
+                  GlobalRoutingLSA *rlsa = previous->GetLSA (root);
+                  for (uint32_t j = 0; !recompute && rlsa != 0 && j < rlsa->GetNLinkRecords (); j++)
+                    {
+                      recompute = rlsa->GetLinkRecord (j)->GetLinkType () != GlobalRoutingLinkRecord::StubNetwork
+                        && changed.count (rlsa->GetLinkRecord (j)->GetLinkId ()) > 0;
+                    }
+                }
+              else
+                {
+                  recompute = externalsChanged || upstream.count (root) > 0;
+                }
+              router.stub = p->second.stub;
+            }
+          if (recompute)
+            {
+              DeleteRoutes (router.routing);
+              roots.push_back (root);
+            }
+        }
+//
+// The routers whose routes are no longer computed lose them.
+//
+      for (SPFRouterMap_t::const_iterator p = m_routers.begin (); p != m_routers.end (); p++)
+        {
+          SPFRouterMap_t::const_iterator r = routers.find (p->first);
+          if (p->second.root && r != routers.end () && !r->second.root)
+            {
+              DeleteRoutes (r->second.routing);
+            }
+        }
+      NS_LOG_INFO ("Recomputing the routes of " << roots.size () << " routers out of " << work.roots.size ());
+      work.roots.swap (roots);
+    }
+  m_routers.swap (routers);
+  m_truncateStubs = NodeList::GetNNodes () > 0;
+
+  UintegerValue threadsValue;
+  GlobalValue::GetValueByName ("GlobalRoutingSpfThreads", threadsValue);
+  uint32_t threads = threadsValue.Get ();
+#ifdef NS3_GLOBAL_ROUTING_THREADS
+  if (threads == 0)
+    {
+      threads = std::max (std::thread::hardware_concurrency (), 1U);
+    }
+#else
+  threads = 1;
+#endif
+  threads = std::min<uint32_t> (threads, work.roots.size ());
+
+  work.stubs.resize (work.roots.size (), 0);
+  work.next = 0;
+  m_work = &work;
+#ifdef NS3_GLOBAL_ROUTING_THREADS
+//
+// Each thread but this one runs its SPF computations in its own copy of
+// the LSDB, since they mark the LSAs they explore.  The threads only add
+// routes to the routing protocols of their roots, without touching the
+// reference counts of the objects.
+//
+  std::vector<GlobalRouteManagerImpl *> workers;
+  std::vector<Ptr<SystemThread> > workerThreads;
+  for (uint32_t i = 1; i < threads; i++)
+    {
+      GlobalRouteManagerImpl *worker = new GlobalRouteManagerImpl ();
+      worker->DebugUseLsdb (m_lsdb->Copy ());
+      worker->m_routers = m_routers;
+      worker->m_truncateStubs = m_truncateStubs;
+      worker->m_work = &work;
+      workers.push_back (worker);
+      workerThreads.push_back (Create<SystemThread> (MakeCallback (&GlobalRouteManagerImpl::SPFWorker, worker)));
+      workerThreads.back ()->Start ();
+    }
+  SPFWorker ();
+  for (uint32_t i = 0; i < workerThreads.size (); i++)
+    {
+      workerThreads[i]->Join ();
+      delete workers[i];
+    }
+#else
+  SPFWorker ();
+#endif
+  m_work = 0;
+
+  for (uint32_t i = 0; i < work.roots.size (); i++)
+    {
+      m_routers[work.roots[i]].stub = work.stubs[i];
+    }
+}
+
+void
+GlobalRouteManagerImpl::SPFWorker (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = m_work->next++; i < m_work->roots.size (); i = m_work->next++)
+    {
+      m_work->stubs[i] = SPFCalculate (m_work->roots[i]);
+    }
 }
 
 //
@@ -960,7 +1387,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // If we've changed the cost to get to the vertex represented by <w>, we 
 // must reorder the priority queue keyed to that cost.
 //
-                  candidate.Reorder ();
+                  candidate.Reorder (cw);
                 }
             } // new lower cost path found
         } // end W is already on the candidate list
@@ -1247,6 +1674,10 @@ void
 GlobalRouteManagerImpl::DebugSPFCalculate (Ipv4Address root)
 {
   NS_LOG_FUNCTION (this << root);
+  std::vector<Ipv4Address> roots;
+  m_routers.clear ();
+  FindRouters (m_routers, roots);
+  m_truncateStubs = NodeList::GetNNodes () > 0;
   SPFCalculate (root);
 }
 
@@ -1320,9 +1751,8 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
               if (lr->GetLinkId () == myRouterId)
                 {
                   // Next hop is stored in the LinkID field of lr
-                  Ptr<GlobalRouter> router = rlsa->GetNode ()->GetObject<GlobalRouter> ();
-                  NS_ASSERT (router);
-                  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+                  NS_ASSERT (m_spfrouter);
+                  const Ptr<Ipv4GlobalRouting> &gr = m_spfrouter->routing;
                   NS_ASSERT (gr);
                   gr->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
                                          FindOutgoingInterfaceId (transitLink->GetLinkData ()));
@@ -1338,13 +1768,19 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
 }
 
 // quagga ospf_spf_calculate
-void
+bool
 GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 {
   NS_LOG_FUNCTION (this << root);
 
   SPFVertex *v;
 //
+// Find the router we are adding the routes to: the node whose GlobalRouter
+// has the router ID of the root.
+//
+  SPFRouterMap_t::const_iterator router = m_routers.find (root);
+  m_spfrouter = router != m_routers.end () ? &router->second : 0;
+//
 // Initialize the Link State Database.
 //
   m_lsdb->Initialize ();
@@ -1377,11 +1813,13 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // reached.  Instead, short-circuit this computation and just install
 // a default route in the CheckForStubNode() method.
 //
-  if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
+  if (m_truncateStubs && CheckForStubNode (root))
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
       delete m_spfroot;
-      return;
+      m_spfroot = 0;
+      m_spfrouter = 0;
+      return true;
     }
 
   for (;;)
@@ -1502,6 +1940,8 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   delete m_spfroot;
   m_spfroot = 0;
+  m_spfrouter = 0;
+  return false;
 }
 
 void
@@ -1556,109 +1996,56 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
   NS_LOG_LOGIC ("External is on remote host: " 
                 << extlsa->GetAdvertisingRouter () << "; installing");
 
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
+  NS_LOG_LOGIC ("Vertex ID = " << m_spfroot->GetVertexId ());
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The router we write the routing information to is the one whose router ID
+// is the one of the root vertex.  If there is none, there is nothing to do.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfrouter == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
+      NS_LOG_LOGIC ("No router with the router ID of the root");
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << m_spfrouter->nodeId);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFAddASExternal (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = extlsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+
+//
+// The vertex <v> (corresponding to the router advertising the external
+// route) has an m_nextHop address precalculated for us that is the address
+// to which the root node should send packets to be forwarded to the external
+// network.  Similarly, the vertex <v> has an m_rootOif (outbound interface
+// index) to which the packets should be send for forwarding.
+//
+  const Ptr<Ipv4GlobalRouting> &gr = m_spfrouter->routing;
+  NS_ASSERT (gr);
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
         {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
+          gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrouter->nodeId <<
+                        " add external network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
+      else
         {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
-//
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
-//
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-
-//
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
-// an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
-// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-// which the packets should be send for forwarding.
-//
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrouter->nodeId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 
@@ -1721,121 +2108,63 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 //
 // The root of the Shortest Path First tree is the router to which we are 
 // going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
+// to this router has a vertex ID which is the router ID of that node, and
+// SPFCalculate () found the router with this ID.  If there is none, there is
+// nothing to do.
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  NS_LOG_LOGIC ("Vertex ID = " << m_spfroot->GetVertexId ());
+  if (m_spfrouter == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
+      NS_LOG_LOGIC ("No router with the router ID of the root");
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << m_spfrouter->nodeId);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddStub (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask (l->GetLinkData ().Get ());
+  Ipv4Address tempip = l->GetLinkId ();
+  tempip = tempip.CombineMask (tempmask);
+//
+// We're going to add a network route to the stub network found in the
+// m_linkId field of the stub link record, with the mask found in its
+// m_linkData field.  The vertex <v> (corresponding to the node that has
+// this stub network) has an m_nextHop address precalculated for us that is
+// the address to which the root node should send packets to be forwarded to
+// this network.  Similarly, the vertex <v> has an m_rootOif (outbound
+// interface index) to which the packets should be send for forwarding.
+//
+  const Ptr<Ipv4GlobalRouting> &gr = m_spfrouter->routing;
+  NS_ASSERT (gr);
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
         {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrouter->nodeId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
+      else
         {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
-//
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
-//
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
-//
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
-// an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
-// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-// which the packets should be send for forwarding.
-//
-
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrouter->nodeId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 //
 // Return the interface number corresponding to a given IP address and mask
-// This is a wrapper around GetInterfaceForPrefix(), but we first
-// have to find the right node pointer to pass to that function.
+// This does what GetInterfaceForPrefix() does on the node of the root
+// router, from the local addresses noted by FindRouters().
 // If no such interface is found, return -1 (note:  unit test framework
 // for routing assumes -1 to be a legal return value)
 //
@@ -1844,69 +2173,24 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 {
   NS_LOG_FUNCTION (this << a << amask);
 //
-// We have an IP address <a> and a vertex ID of the root of the SPF tree.
-// The question is what interface index does this address correspond to.
-// The answer is a little complicated since we have to find a pointer to
-// the node corresponding to the vertex ID, find the Ipv4 interface on that
-// node in order to iterate the interfaces and find the one corresponding to
-// the address in question.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-//
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
+// We have an IP address <a> and the router at the root of the SPF tree.
+// Look through the interfaces of its node for one that has an address in the
+// same network as <a>.  If we find one, return the corresponding interface
+// index, or -1 if not found.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfrouter == 0)
     {
-      Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-//
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
-//
-      if (rtr == 0)
+      NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << m_spfroot->GetVertexId ());
+      return -1;
+    }
+  const std::vector<std::pair<int32_t, Ipv4Address> > &addresses = m_spfrouter->addresses;
+  for (uint32_t i = 0; i < addresses.size (); i++)
+    {
+      if (addresses[i].second.CombineMask (amask) == a.CombineMask (amask))
         {
-          continue;
-        }
-
-      if (rtr->GetRouterId () == routerId)
-        {
-//
-// This is the node we're building the routing table for.  We're going to need
-// the Ipv4 interface to look for the ipv4 interface index.  Since this node
-// is participating in routing IP version 4 packets, it certainly must have 
-// an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
-//
-// Look through the interfaces on this node for one that has the IP address
-// we're looking for.  If we find one, return the corresponding interface
-// index, or -1 if not found.
-//
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
-
-#if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif 
-          return interface;
+          return addresses[i].first;
         }
     }
-//
-// Couldn't find it.
-//
-  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
   return -1;
 }
 
@@ -1936,68 +2220,31 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 //
 // The root of the Shortest Path First tree is the router to which we are 
 // going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
+// to this router has a vertex ID which is the router ID of that node, and
+// SPFCalculate () found the router with this ID.  If there is none, there is
+// nothing to do.
 //
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  NS_LOG_LOGIC ("Vertex ID = " << m_spfroot->GetVertexId ());
+  if (m_spfrouter == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No router with the router ID of the root");
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << m_spfrouter->nodeId);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  const Ptr<Ipv4GlobalRouting> &gr = m_spfrouter->routing;
+  NS_ASSERT (gr);
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -2006,18 +2253,18 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+  NS_LOG_LOGIC (" Node " << m_spfrouter->nodeId <<
+                " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+  for (uint32_t j = 0; j < nLinkRecords; ++j)
+    {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+        {
+          continue;
+        }
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -2031,46 +2278,34 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-                {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
+      // walk through all available exit directions due to ECMP,
+      // and add host route for each of the exit direction toward
+      // the vertex 'v'
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
+            {
+              gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
+                                  outIf);
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrouter->nodeId <<
+                            " adding host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " and outgoing interface " << outIf);
             }
-//
-// Done adding the routes for the selected node.
-//
-          return;
-        }
+          else
+            {
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrouter->nodeId <<
+                            " NOT able to add host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
+            }
+        } // for all routes from the root the vertex 'v'
     }
 }
+
 void
 GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 {
@@ -2081,103 +2316,56 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 //
 // The root of the Shortest Path First tree is the router to which we are 
 // going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// to this router has a vertex ID which is the router ID of that node, and
+// SPFCalculate () found the router with this ID.  If there is none, there is
+// nothing to do.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  NS_LOG_LOGIC ("Vertex ID = " << m_spfroot->GetVertexId ());
+  if (m_spfrouter == 0)
     {
-      Ptr<Node> node = *i;
+      NS_LOG_LOGIC ("No router with the router ID of the root");
+      return;
+    }
+  NS_LOG_LOGIC ("setting routes for node " << m_spfrouter->nodeId);
 //
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
+// Get the Global Router Link State Advertisement from the vertex we're
+// adding the routes to.  The LSA is the network LSA of the transit network,
+// to which we add a network route.
+//
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = lsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+  const Ptr<Ipv4GlobalRouting> &gr = m_spfrouter->routing;
+  NS_ASSERT (gr);
+  // walk through all available exit directions due to ECMP,
+  // and add host route for each of the exit direction toward
+  // the vertex 'v'
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
 
-      if (rtr == 0)
+      if (outIf >= 0)
         {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrouter->nodeId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
+      else
         {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
-//
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
-//
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
-            }
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_spfrouter->nodeId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative " << outIf);
         }
-    } 
+    }
 }
 
 // Derived from quagga ospf_vertex_add_parents ()
@@ -27,6 +27,8 @@
 #include <queue>
 #include <map>
 #include <vector>
+#include <unordered_map>
+#include <unordered_set>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
@@ -674,12 +676,50 @@ public:
    */
   uint32_t GetNumExtLSAs () const;
 
+  typedef std::unordered_set<Ipv4Address, Ipv4AddressHash> LSAIdSet_t; //!< set of link state IDs
+
+/**
+ * @brief Copy the database, with copies of the Link State Advertisements.
+ *
+ * The SPF computations mark the LSAs they explore, so that concurrent
+ * computations need copies of the database.
+ *
+ * @returns A new database, to be deleted by the caller.
+ */
+  GlobalRouteManagerLSDB* Copy (void) const;
+
+/**
+ * @brief Find the Link State Advertisements which differ from those of
+ * another database.
+ *
+ * The LSAs are matched by link state ID.  The network LSAs whose attached
+ * routers may be found in other router LSAs by GetLSAByLinkData are
+ * deemed to have changed as well.
+ *
+ * @param other The other database, typically the previous one.
+ * @param changed The IDs of the LSAs added, removed or modified.
+ * @returns True if the External Link State Advertisements differ.
+ */
+  bool FindChangedLSAs (const GlobalRouteManagerLSDB* other, LSAIdSet_t& changed) const;
+
+/**
+ * @brief Add to a set of LSAs all the LSAs an SPF computation may reach
+ * them from.
+ *
+ * These are the LSAs whose SPF computation explores an LSA of the set, by
+ * following the point-to-point and transit links backwards.
+ *
+ * @param ids The IDs of the LSAs, to which the others are added.
+ */
+  void AddUpstreamLSAs (LSAIdSet_t& ids) const;
 
 private:
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t; //!< container of IPv4 addresses / Link State Advertisements
   typedef std::pair<Ipv4Address, GlobalRoutingLSA*> LSDBPair_t; //!< pair of IPv4 addresses / Link State Advertisements
+  typedef std::unordered_map<Ipv4Address, GlobalRoutingLSA*, Ipv4AddressHash> LSDBIndex_t; //!< index of Link State Advertisements by IPv4 address
 
   LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
+  LSDBIndex_t m_linkDataIndex; //!< LSAs by the LinkData of their TransitNetwork link records
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
 
 /**
@@ -735,6 +775,17 @@ public:
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Recompute the routes after a change of the topology.
+ *
+ * Equivalent to DeleteGlobalRoutes (), BuildGlobalRoutingDatabase () and
+ * InitializeRoutes ().  If the global value GlobalRoutingIncrementalSpf is
+ * true, the new Link State Advertisements are compared with the previous
+ * ones, and only the routers whose SPF computations read a changed LSA
+ * lose their routes and compute them again.
+ */
+  virtual void RecomputeRoutes ();
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  */
@@ -766,8 +817,49 @@ private:
  */
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
+  /**
+   * \brief A router, as seen by the SPF computations rooted at it: where
+   * its routes go, and through which interfaces.
+   */
+  struct SPFRouter
+  {
+    Ptr<Ipv4GlobalRouting> routing; //!< the routing protocol of the router
+    uint32_t nodeId;                //!< the ID of the node of the router
+    std::vector<std::pair<int32_t, Ipv4Address> > addresses; //!< the local addresses of the node, with their interface
+    bool root;                      //!< true if the routes of the router are computed
+    bool stub;                      //!< true if the last SPF computation was truncated at this stub router
+  };
+  typedef std::map<Ipv4Address, SPFRouter> SPFRouterMap_t; //!< container of routers, by router ID
+
+  struct SPFWork;
+
   SPFVertex* m_spfroot; //!< the root node
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
+  SPFRouterMap_t m_routers; //!< the routers, as of the last SPF computations
+  const SPFRouter* m_spfrouter; //!< the router of the root node, or 0 if there is none
+  bool m_truncateStubs; //!< true if the SPF computations of stub routers are truncated
+  SPFWork* m_work; //!< the SPF computations shared by the threads
+
+  /**
+   * \brief Find the routers, and those whose routes are computed here.
+   *
+   * \param routers the routers, by router ID
+   * \param roots the router IDs of the routers whose routes are computed
+   */
+  void FindRouters (SPFRouterMap_t& routers, std::vector<Ipv4Address>& roots) const;
+
+  /**
+   * \brief Compute the routes of the routers, possibly in several threads.
+   *
+   * \param previous the previous LSDB, to only compute the routes which
+   * depend on the changed LSAs; 0 to compute all the routes
+   */
+  void SPFCalculateRoots (const GlobalRouteManagerLSDB* previous);
+
+  /**
+   * \brief Run the SPF computations of m_work until there is none left.
+   */
+  void SPFWorker (void);
 
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
@@ -786,8 +878,9 @@ private:
    *
    * Equivalent to quagga ospf_spf_calculate
    * \param root the root node
+   * \returns true if the computation was truncated at a stub node
    */
-  void SPFCalculate (Ipv4Address root);
+  bool SPFCalculate (Ipv4Address root);
 
   /**
    * \brief Process Stub nodes
@@ -935,8 +1028,8 @@ private:
   /**
    * \brief Return the interface number corresponding to a given IP address and mask
    *
-   * This is a wrapper around GetInterfaceForPrefix(), but we first
-   * have to find the right node pointer to pass to that function.
+   * This does what GetInterfaceForPrefix() does on the node of the root
+   * router, from the local addresses found when the computations started.
    * If no such interface is found, return -1 (note:  unit test framework
    * for routing assumes -1 to be a legal return value)
    *
@@ -18,6 +18,9 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 
+#include <algorithm>
+#include <iterator>
+#include <vector>
 #include "ipv4-end-point-demux.h"
 #include "ipv4-end-point.h"
 #include "ipv4-interface-address.h"
@@ -28,8 +31,40 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux");
 
+Ipv4EndPointDemux::FourTuple::FourTuple (Ipv4Address localAddress, uint16_t localPort,
+                                         Ipv4Address peerAddress, uint16_t peerPort)
+  : localAddress (localAddress),
+    localPort (localPort),
+    peerAddress (peerAddress),
+    peerPort (peerPort)
+{
+}
+
+bool
+Ipv4EndPointDemux::FourTuple::operator == (const FourTuple &other) const
+{
+  return localPort == other.localPort && peerPort == other.peerPort
+         && localAddress == other.localAddress && peerAddress == other.peerAddress;
+}
+
+size_t
+Ipv4EndPointDemux::FourTupleHash::operator () (const FourTuple &tuple) const
+{
+  uint64_t h = (static_cast<uint64_t> (tuple.localAddress.Get ()) << 32) | tuple.peerAddress.Get ();
+  h ^= ((static_cast<uint64_t> (tuple.localPort) << 16) | tuple.peerPort) * 0x9e3779b97f4a7c15ULL;
+  h ^= h >> 29;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 32;
+  return static_cast<size_t> (h);
+}
+
+Ipv4EndPointDemux::PortEntry::PortEntry ()
+  : connected (0)
+{
+}
+
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
-  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
+  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152), m_nextOrder (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -37,40 +72,155 @@ Ipv4EndPointDemux::Ipv4EndPointDemux ()
 Ipv4EndPointDemux::~Ipv4EndPointDemux ()
 {
   NS_LOG_FUNCTION (this);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (EndPointMap::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
     {
-      Ipv4EndPoint *endPoint = *i;
+      Ipv4EndPoint *endPoint = i->second;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_ports.clear ();
+  m_connected.clear ();
 }
 
 bool
-Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+Ipv4EndPointDemux::IsConnected (Ipv4Address localAddress, Ipv4Address peerAddress, uint16_t peerPort)
+{
+  return localAddress != Ipv4Address::GetAny () && peerAddress != Ipv4Address::GetAny ()
+         && peerPort != 0;
+}
+
+bool
+Ipv4EndPointDemux::IsConnected (Ipv4EndPoint *endPoint)
+{
+  return IsConnected (endPoint->m_localAddr, endPoint->m_peerAddr, endPoint->m_peerPort);
+}
+
+bool
+Ipv4EndPointDemux::IsAllocatedBefore (Ipv4EndPoint *a, Ipv4EndPoint *b)
+{
+  return a->m_order < b->m_order;
+}
+
+void
+Ipv4EndPointDemux::InsertSorted (EndPoints &endPoints, Ipv4EndPoint *endPoint)
+{
+  // The endpoints are most often indexed right after their allocation
+  EndPoints::reverse_iterator i = endPoints.rbegin ();
+  while (i != endPoints.rend () && IsAllocatedBefore (endPoint, *i))
+    {
+      i++;
+    }
+  endPoints.insert (i.base (), endPoint);
+}
+
+void
+Ipv4EndPointDemux::Add (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  endPoint->m_demux = this;
+  endPoint->m_order = m_nextOrder++;
+  m_endPoints.insert (m_endPoints.end (), std::make_pair (endPoint->m_order, endPoint));
+  Index (endPoint);
+}
+
+void
+Ipv4EndPointDemux::Index (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  PortEntry &entry = m_ports[endPoint->m_localPort];
+  if (IsConnected (endPoint))
+    {
+      FourTuple tuple (endPoint->m_localAddr, endPoint->m_localPort,
+                       endPoint->m_peerAddr, endPoint->m_peerPort);
+      InsertSorted (m_connected[tuple], endPoint);
+      entry.connected++;
+    }
+  else
+    {
+      InsertSorted (entry.wildcard, endPoint);
+    }
+}
+
+void
+Ipv4EndPointDemux::Unindex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  std::unordered_map<uint16_t, PortEntry>::iterator entry = m_ports.find (endPoint->m_localPort);
+  NS_ASSERT (entry != m_ports.end ());
+  if (IsConnected (endPoint))
+    {
+      FourTuple tuple (endPoint->m_localAddr, endPoint->m_localPort,
+                       endPoint->m_peerAddr, endPoint->m_peerPort);
+      std::unordered_map<FourTuple, EndPoints, FourTupleHash>::iterator i = m_connected.find (tuple);
+      NS_ASSERT (i != m_connected.end ());
+      i->second.remove (endPoint);
+      if (i->second.empty ())
+        {
+          m_connected.erase (i);
+        }
+      entry->second.connected--;
+    }
+  else
+    {
+      entry->second.wildcard.remove (endPoint);
+    }
+  if (entry->second.wildcard.empty () && entry->second.connected == 0)
+    {
+      m_ports.erase (entry);
+    }
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemux::FindFirstConnected (uint16_t port)
 {
   NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (EndPointMap::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
-      if ((*i)->GetLocalPort  () == port) 
+      if (i->second->m_localPort == port && IsConnected (i->second))
         {
-          return true;
+          return i->second;
         }
     }
-  return false;
+  return 0;
+}
+
+bool
+Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::unordered_map<uint16_t, PortEntry>::iterator entry = m_ports.find (port);
+  if (entry == m_ports.end ())
     {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr) 
+      return false;
+    }
+  for (EndPointsI i = entry->second.wildcard.begin (); i != entry->second.wildcard.end (); i++) 
+    {
+      if ((*i)->GetLocalAddress () == addr) 
         {
           return true;
         }
     }
+  if (entry->second.connected > 0 && addr != Ipv4Address::GetAny ())
+    {
+      // Binding to a port which has connections is rare enough to walk
+      // all the endpoints
+      for (EndPointMap::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+        {
+          if (i->second->GetLocalPort () == port
+              && i->second->GetLocalAddress () == addr) 
+            {
+              return true;
+            }
+        }
+    }
   return false;
 }
 
@@ -85,7 +235,7 @@ Ipv4EndPointDemux::Allocate (void)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Add (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -101,7 +251,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Add (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -124,7 +274,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Add (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -134,21 +284,38 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  bool duplicate = false;
+  if (IsConnected (localAddress, peerAddress, peerPort))
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress) 
+      FourTuple tuple (localAddress, localPort, peerAddress, peerPort);
+      duplicate = m_connected.find (tuple) != m_connected.end ();
+    }
+  else
+    {
+      std::unordered_map<uint16_t, PortEntry>::iterator entry = m_ports.find (localPort);
+      if (entry != m_ports.end ())
         {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
+          for (EndPointsI i = entry->second.wildcard.begin (); i != entry->second.wildcard.end (); i++) 
+            {
+              if ((*i)->GetLocalAddress () == localAddress &&
+                  (*i)->GetPeerPort () == peerPort &&
+                  (*i)->GetPeerAddress () == peerAddress) 
+                {
+                  duplicate = true;
+                  break;
+                }
+            }
         }
     }
+  if (duplicate)
+    {
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
+    }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Add (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -159,14 +326,13 @@ void
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this << endPoint);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  EndPointMap::iterator i = m_endPoints.find (endPoint->m_order);
+  if (i != m_endPoints.end () && i->second == endPoint)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      Unindex (endPoint);
+      m_endPoints.erase (i);
+      endPoint->m_demux = 0;
+      delete endPoint;
     }
 }
 
@@ -179,9 +345,9 @@ Ipv4EndPointDemux::GetAllEndPoints (void)
   NS_LOG_FUNCTION (this);
   EndPoints ret;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (EndPointMap::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
-      Ipv4EndPoint* endP = *i;
+      Ipv4EndPoint* endP = i->second;
       ret.push_back (endP);
     }
   return ret;
@@ -206,7 +372,50 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval4; // Exact match on all 4
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::unordered_map<uint16_t, PortEntry>::iterator entry = m_ports.find (dport);
+  if (entry == m_ports.end ())
+    {
+      NS_LOG_LOGIC ("No endpoint bound to port " << dport);
+      return retval1;
+    }
+
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
+    {
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+      if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+          daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+        {
+          subnetDirected = true;
+          incomingInterfaceAddr = addr.GetLocal ();
+        }
+    }
+  bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+  NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
+
+  // The endpoints to look at are the ones bound to the port which are not
+  // connected, and the connected ones whose local address is the one the
+  // packet is destined to, with the four-tuple of the packet.  They are
+  // merged in allocation order.
+  std::vector<Ipv4EndPoint *> candidates;
+  std::unordered_map<FourTuple, EndPoints, FourTupleHash>::iterator connected = m_connected.end ();
+  if (entry->second.connected > 0)
+    {
+      connected = m_connected.find (FourTuple (incomingInterfaceAddr, dport, saddr, sport));
+    }
+  if (connected == m_connected.end ())
+    {
+      candidates.assign (entry->second.wildcard.begin (), entry->second.wildcard.end ());
+    }
+  else
+    {
+      std::merge (entry->second.wildcard.begin (), entry->second.wildcard.end (),
+                  connected->second.begin (), connected->second.end (),
+                  std::back_inserter (candidates), IsAllocatedBefore);
+    }
+
+  for (std::vector<Ipv4EndPoint *>::iterator i = candidates.begin (); i != candidates.end (); i++) 
     {
       Ipv4EndPoint* endP = *i;
 
@@ -241,20 +450,6 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
               continue;
             }
         }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
-        {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
-            {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
-            }
-        }
-      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
-      NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
       bool localAddressMatchesWildCard = 
         endP->GetLocalAddress () == Ipv4Address::GetAny ();
       bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
@@ -328,13 +523,28 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 
   // this code is a copy/paste version of an old BSD ip stack lookup
   // function.
+  std::unordered_map<uint16_t, PortEntry>::iterator entry = m_ports.find (dport);
+  if (entry == m_ports.end ())
+    {
+      return 0;
+    }
+  Ipv4EndPoint *exact = 0;
+  if (entry->second.connected > 0)
+    {
+      std::unordered_map<FourTuple, EndPoints, FourTupleHash>::iterator connected =
+        m_connected.find (FourTuple (daddr, dport, saddr, sport));
+      if (connected != m_connected.end ())
+        {
+          exact = connected->second.front ();
+        }
+    }
   uint32_t genericity = 3;
   Ipv4EndPoint *generic = 0;
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (EndPointsI i = entry->second.wildcard.begin (); i != entry->second.wildcard.end (); i++) 
     {
-      if ((*i)->GetLocalPort () != dport) 
+      if (exact != 0 && IsAllocatedBefore (exact, *i))
         {
-          continue;
+          break;
         }
       if ((*i)->GetLocalAddress () == daddr &&
           (*i)->GetPeerPort () == sport &&
@@ -358,6 +568,20 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
           genericity = tmp;
         }
     }
+  if (exact != 0)
+    {
+      return exact;
+    }
+  if (entry->second.connected > 0)
+    {
+      // The connected endpoints are not generic at all: the first one is
+      // returned, unless an endpoint as specific was allocated before it
+      Ipv4EndPoint *first = FindFirstConnected (dport);
+      if (genericity > 0 || IsAllocatedBefore (first, generic))
+        {
+          return first;
+        }
+    }
   return generic;
 }
 uint16_t
@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <unordered_map>
 #include "ns3/ipv4-address.h"
 #include "ipv4-interface.h"
 
@@ -40,6 +42,17 @@ class Ipv4EndPoint;
  * of endpoints, and has APIs to add and find endpoints in this demux.  This
  * code is shared in common to TCP and UDP protocols in ns3.  This demux
  * sits between ns3's layer four and the socket layer
+ *
+ * The endpoints are indexed in two levels.  The connected endpoints, whose
+ * local address, peer address and peer port are all set, are kept in a
+ * hash table keyed by their four-tuple; the other ones, such as listening
+ * or unconnected sockets, are kept in a table keyed by their local port.
+ * A lookup thus only visits the endpoints bound to the destination port
+ * which are not connected, plus the connected endpoints with the exact
+ * four-tuple of the packet, however many connections the node holds.  The
+ * endpoints tell the demux when their address or peer changes, and the
+ * matches are returned in the order in which the endpoints were allocated,
+ * as when the endpoints were kept in a single list.
  */
 
 class Ipv4EndPointDemux {
@@ -163,6 +176,123 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
+
+  /**
+   * \brief The four-tuple of a connected endpoint.
+   */
+  struct FourTuple
+  {
+    /**
+     * \brief Constructor.
+     * \param localAddress local address
+     * \param localPort local port
+     * \param peerAddress peer address
+     * \param peerPort peer port
+     */
+    FourTuple (Ipv4Address localAddress, uint16_t localPort,
+               Ipv4Address peerAddress, uint16_t peerPort);
+    /**
+     * \param other the four-tuple to compare with
+     * \returns true if both four-tuples are equal
+     */
+    bool operator == (const FourTuple &other) const;
+
+    Ipv4Address localAddress; //!< the local address
+    uint16_t localPort;       //!< the local port
+    Ipv4Address peerAddress;  //!< the peer address
+    uint16_t peerPort;        //!< the peer port
+  };
+
+  /**
+   * \brief Hash function of the four-tuples.
+   */
+  struct FourTupleHash
+  {
+    /**
+     * \param tuple the four-tuple
+     * \returns the hash of the four-tuple
+     */
+    size_t operator () (const FourTuple &tuple) const;
+  };
+
+  /**
+   * \brief The endpoints bound to a local port.
+   */
+  struct PortEntry
+  {
+    /**
+     * \brief Constructor.
+     */
+    PortEntry ();
+
+    EndPoints wildcard; //!< the endpoints which are not connected, in allocation order
+    uint32_t connected; //!< the number of connected endpoints
+  };
+
+  /**
+   * \brief Container of the IPv4 endpoints, by allocation order.
+   */
+  typedef std::map<uint64_t, Ipv4EndPoint *> EndPointMap;
+
+  /**
+   * \brief Check whether an endpoint with the given addresses and peer port
+   * is connected, and thus indexed by its four-tuple.
+   * \param localAddress local address
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \return true if neither of them is a wildcard
+   */
+  static bool IsConnected (Ipv4Address localAddress, Ipv4Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Check whether an endpoint is connected.
+   * \param endPoint the endpoint
+   * \return true if the endpoint is indexed by its four-tuple
+   */
+  static bool IsConnected (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Compare two endpoints by allocation order.
+   * \param a an endpoint
+   * \param b another endpoint
+   * \return true if \p a was allocated before \p b
+   */
+  static bool IsAllocatedBefore (Ipv4EndPoint *a, Ipv4EndPoint *b);
+
+  /**
+   * \brief Insert an endpoint in a list sorted by allocation order.
+   * \param endPoints the list
+   * \param endPoint the endpoint
+   */
+  static void InsertSorted (EndPoints &endPoints, Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Find the first connected endpoint bound to a local port.
+   * \param port the local port
+   * \return the endpoint (0 if not found)
+   */
+  Ipv4EndPoint *FindFirstConnected (uint16_t port);
+
+  /**
+   * \brief Add a new endpoint to the demux.
+   * \param endPoint the endpoint
+   */
+  void Add (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Index an endpoint by its current addresses and ports.
+   * \param endPoint the endpoint
+   */
+  void Index (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Remove an endpoint from the index, before its addresses or ports
+   * change or before it is deallocated.
+   * \param endPoint the endpoint
+   */
+  void Unindex (Ipv4EndPoint *endPoint);
+
 
   /**
    * \brief Allocate an ephemeral port.
@@ -186,9 +316,24 @@ private:
   uint16_t m_portFirst;
 
   /**
-   * \brief A list of IPv4 end points.
+   * \brief The allocation order of the next endpoint.
+   */
+  uint64_t m_nextOrder;
+
+  /**
+   * \brief All the IPv4 end points, by allocation order.
+   */
+  EndPointMap m_endPoints;
+
+  /**
+   * \brief The IPv4 end points by local port.
+   */
+  std::unordered_map<uint16_t, PortEntry> m_ports;
+
+  /**
+   * \brief The connected IPv4 end points by four-tuple.
    */
-  EndPoints m_endPoints;
+  std::unordered_map<FourTuple, EndPoints, FourTupleHash> m_connected;
 };
 
 } // namespace ns3
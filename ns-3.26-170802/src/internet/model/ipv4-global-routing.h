@@ -21,6 +21,8 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <vector>
+#include <unordered_map>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -28,6 +30,7 @@
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-prefix-trie.h"
 
 namespace ns3 {
 
@@ -65,6 +68,11 @@ class Node;
  *
  * This class deals with Ipv4 unicast routes only.
  *
+ * The host routes are indexed by destination, and the network and
+ * external routes by prefix in an Ipv4PrefixTrie, so that a lookup does
+ * not depend on the size of the tables.  As the routes are built once,
+ * the indexes are updated as routes are added and removed.
+ *
  * \see Ipv4RoutingProtocol
  * \see GlobalRouteManager
  */
@@ -260,6 +268,13 @@ private:
   /// iterator of container of Ipv4RoutingTableEntry (routes to external AS)
   typedef std::list<Ipv4RoutingTableEntry *>::iterator ASExternalRoutesI;
 
+  /// container of the routes to a host, in insertion order
+  typedef std::vector<Ipv4RoutingTableEntry *> RouteVec;
+  /// routes to hosts, by destination
+  typedef std::unordered_map<Ipv4Address, RouteVec, Ipv4AddressHash> HostRouteIndex;
+  /// routes to networks, by prefix
+  typedef Ipv4PrefixTrie<Ipv4RoutingTableEntry *> NetworkRouteTrie;
+
   /**
    * \brief Lookup in the forwarding table for destination.
    * \param dest destination address
@@ -268,10 +283,45 @@ private:
    */
   Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
 
+  /**
+   * \brief Find the network routes which match a destination.
+   * \param routes the routes
+   * \param trie the routes with a contiguous mask, by prefix
+   * \param nonPrefixRoutes the number of routes with a non-contiguous mask
+   * \param dest destination address
+   * \param [out] matches the matching routes, in the order of \p routes
+   */
+  static void MatchNetworkRoutes (const NetworkRoutes &routes, const NetworkRouteTrie &trie,
+                                  uint32_t nonPrefixRoutes, Ipv4Address dest, RouteVec &matches);
+
+  /**
+   * \brief Index a network route by prefix.
+   * \param route the route
+   * \param trie the index
+   * \param nonPrefixRoutes the number of routes with a non-contiguous mask
+   */
+  static void IndexNetworkRoute (Ipv4RoutingTableEntry *route, NetworkRouteTrie &trie,
+                                 uint32_t &nonPrefixRoutes);
+
+  /**
+   * \brief Remove a network route from its index.
+   * \param route the route
+   * \param trie the index
+   * \param nonPrefixRoutes the number of routes with a non-contiguous mask
+   */
+  static void UnindexNetworkRoute (Ipv4RoutingTableEntry *route, NetworkRouteTrie &trie,
+                                   uint32_t &nonPrefixRoutes);
+
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  HostRouteIndex m_hostRouteIndex;           //!< Routes to hosts, by destination
+  NetworkRouteTrie m_networkRouteTrie;       //!< Routes to networks, by prefix
+  NetworkRouteTrie m_ASexternalRouteTrie;    //!< External routes, by prefix
+  uint32_t m_nonPrefixNetworkRoutes;         //!< Network routes with a non-contiguous mask
+  uint32_t m_nonPrefixASexternalRoutes;      //!< External routes with a non-contiguous mask
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
@@ -0,0 +1,413 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_PREFIX_TRIE_H
+#define IPV4_PREFIX_TRIE_H
+
+#include <stdint.h>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "ns3/ipv4-address.h"
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4Routing
+ *
+ * \brief Path-compressed binary trie of IPv4 prefixes, for longest prefix
+ * matching in the routing tables.
+ *
+ * Each prefix holds the values inserted for it, such as routing table
+ * entries, in insertion order.  Each node of the trie is a prefix with
+ * values or a branching point, so that a lookup visits at most one node
+ * per bit which differs among the prefixes, and at most 33 nodes.
+ *
+ * Only prefixes, i.e., contiguous masks, can be stored; the routing
+ * protocols keep the routes with other masks aside.
+ *
+ * \tparam T The type of the values, compared with operator==.
+ */
+template <typename T>
+class Ipv4PrefixTrie
+{
+public:
+  /** A value and its insertion order in the trie. */
+  typedef std::pair<uint64_t, T> Value;
+  /** The values of a prefix, in insertion order. */
+  typedef std::vector<Value> Values;
+
+  Ipv4PrefixTrie ();
+  ~Ipv4PrefixTrie ();
+
+  /**
+   * \param mask a mask
+   * \param [out] length the prefix length of \p mask, if it is contiguous
+   * \return true if \p mask is made of leading ones only
+   */
+  static bool IsPrefix (Ipv4Mask mask, uint8_t &length);
+
+  /**
+   * \brief Add a value after the values already stored for a prefix.
+   * \param prefix the prefix; the bits beyond \p length are ignored
+   * \param length the prefix length, from 0 to 32
+   * \param value the value
+   */
+  void Insert (Ipv4Address prefix, uint8_t length, T value);
+
+  /**
+   * \brief Remove the first occurrence of a value of a prefix.
+   * \param prefix the prefix; the bits beyond \p length are ignored
+   * \param length the prefix length, from 0 to 32
+   * \param value the value
+   * \return true if the value was found
+   */
+  bool Remove (Ipv4Address prefix, uint8_t length, T value);
+
+  /**
+   * \brief Remove all the values.
+   */
+  void Clear (void);
+
+  /**
+   * \return the number of values stored
+   */
+  uint32_t GetSize (void) const;
+
+  /**
+   * \brief Find the prefixes which match an address.
+   * \param address the address
+   * \param [out] matches the values of the matching prefixes, from the
+   * shortest to the longest prefix
+   * \param [out] lengths the lengths of the matching prefixes
+   * \return the number of matching prefixes
+   */
+  uint32_t Match (Ipv4Address address, const Values *matches[33], uint8_t lengths[33]) const;
+
+  /**
+   * \brief Find all the values whose prefix matches an address.
+   * \param address the address
+   * \param [out] values the values, in insertion order
+   */
+  void MatchAll (Ipv4Address address, std::vector<T> &values) const;
+
+private:
+  /** A node of the trie. */
+  struct Node
+  {
+    uint32_t prefix;   //!< The prefix, with zeros beyond length
+    uint8_t length;    //!< The prefix length
+    Values values;     //!< The values of the prefix
+    Node *child[2];    //!< The children, by the bit after the prefix
+  };
+
+  /**
+   * \param length a prefix length
+   * \return the mask of the prefix length
+   */
+  static uint32_t GetMask (uint8_t length);
+
+  /**
+   * \param address an address
+   * \param index the index of a bit, from 0 for the most significant one
+   * \return the bit of \p address
+   */
+  static uint32_t GetBit (uint32_t address, uint8_t index);
+
+  /**
+   * \param a a value
+   * \param b another value
+   * \return true if \p a was inserted before \p b
+   */
+  static bool IsInsertedBefore (const Value &a, const Value &b);
+
+  /**
+   * \param prefix a prefix
+   * \param length its length
+   * \return a new node without values or children
+   */
+  static Node * CreateNode (uint32_t prefix, uint8_t length);
+
+  /**
+   * \param node a node to delete with its descendants
+   */
+  static void Delete (Node *node);
+
+  /**
+   * \brief Copy constructor, not implemented.
+   * \param o the object to copy
+   */
+  Ipv4PrefixTrie (const Ipv4PrefixTrie &o);
+  /**
+   * \brief Assignment operator, not implemented.
+   * \param o the object to copy
+   * \return this object
+   */
+  Ipv4PrefixTrie &operator = (const Ipv4PrefixTrie &o);
+
+  Node *m_root;        //!< The node of the empty prefix
+  uint32_t m_size;     //!< The number of values
+  uint64_t m_order;    //!< The insertion order of the next value
+};
+
+} // namespace ns3
+
+/***************************************************************
+ *  Implementation of the templates declared above.
+ ***************************************************************/
+
+namespace ns3 {
+
+template <typename T>
+Ipv4PrefixTrie<T>::Ipv4PrefixTrie ()
+  : m_root (CreateNode (0, 0)),
+    m_size (0),
+    m_order (0)
+{
+}
+
+template <typename T>
+Ipv4PrefixTrie<T>::~Ipv4PrefixTrie ()
+{
+  Delete (m_root);
+}
+
+template <typename T>
+bool
+Ipv4PrefixTrie<T>::IsPrefix (Ipv4Mask mask, uint8_t &length)
+{
+  length = mask.GetPrefixLength ();
+  return mask.Get () == GetMask (length);
+}
+
+template <typename T>
+uint32_t
+Ipv4PrefixTrie<T>::GetMask (uint8_t length)
+{
+  return length == 0 ? 0 : 0xffffffffU << (32 - length);
+}
+
+template <typename T>
+uint32_t
+Ipv4PrefixTrie<T>::GetBit (uint32_t address, uint8_t index)
+{
+  return (address >> (31 - index)) & 1;
+}
+
+template <typename T>
+bool
+Ipv4PrefixTrie<T>::IsInsertedBefore (const Value &a, const Value &b)
+{
+  return a.first < b.first;
+}
+
+template <typename T>
+typename Ipv4PrefixTrie<T>::Node *
+Ipv4PrefixTrie<T>::CreateNode (uint32_t prefix, uint8_t length)
+{
+  Node *node = new Node;
+  node->prefix = prefix;
+  node->length = length;
+  node->child[0] = 0;
+  node->child[1] = 0;
+  return node;
+}
+
+template <typename T>
+void
+Ipv4PrefixTrie<T>::Delete (Node *node)
+{
+  if (node != 0)
+    {
+      Delete (node->child[0]);
+      Delete (node->child[1]);
+      delete node;
+    }
+}
+
+template <typename T>
+void
+Ipv4PrefixTrie<T>::Insert (Ipv4Address address, uint8_t length, T value)
+{
+  NS_ASSERT (length <= 32);
+  uint32_t prefix = address.Get () & GetMask (length);
+  Node *node = m_root;
+  while (node->length < length)
+    {
+      uint32_t bit = GetBit (prefix, node->length);
+      Node *child = node->child[bit];
+      if (child == 0)
+        {
+          node = node->child[bit] = CreateNode (prefix, length);
+          break;
+        }
+      // Length of the prefix common to the child and the new prefix
+      uint32_t diff = (child->prefix ^ prefix) & GetMask (std::min (child->length, length));
+      uint8_t common = std::min (child->length, length);
+      for (uint8_t i = node->length; i < common; i++)
+        {
+          if (GetBit (diff, i))
+            {
+              common = i;
+              break;
+            }
+        }
+      if (common == child->length)
+        {
+          node = child;
+          continue;
+        }
+      // The new prefix or the branching point goes between node and child
+      Node *split = CreateNode (prefix & GetMask (common), common);
+      split->child[GetBit (child->prefix, common)] = child;
+      node->child[bit] = split;
+      node = split;
+      if (common < length)
+        {
+          node = split->child[GetBit (prefix, common)] = CreateNode (prefix, length);
+        }
+      break;
+    }
+  node->values.push_back (std::make_pair (m_order++, value));
+  m_size++;
+}
+
+template <typename T>
+bool
+Ipv4PrefixTrie<T>::Remove (Ipv4Address address, uint8_t length, T value)
+{
+  NS_ASSERT (length <= 32);
+  uint32_t prefix = address.Get () & GetMask (length);
+  Node *parent = 0;
+  Node *node = m_root;
+  while (node != 0 && node->length < length)
+    {
+      parent = node;
+      node = node->child[GetBit (prefix, node->length)];
+      if (node != 0 && (prefix & GetMask (node->length)) != node->prefix)
+        {
+          return false;
+        }
+    }
+  if (node == 0 || node->length != length)
+    {
+      return false;
+    }
+  typename Values::iterator i = node->values.begin ();
+  while (i != node->values.end () && !(i->second == value))
+    {
+      i++;
+    }
+  if (i == node->values.end ())
+    {
+      return false;
+    }
+  node->values.erase (i);
+  m_size--;
+
+  // Remove the nodes which no longer hold values nor branch
+  while (node != m_root && node->values.empty ()
+         && (node->child[0] == 0 || node->child[1] == 0))
+    {
+      Node *child = node->child[0] != 0 ? node->child[0] : node->child[1];
+      parent->child[GetBit (node->prefix, parent->length)] = child;
+      delete node;
+      if (child != 0)
+        {
+          break;
+        }
+      // The parent may now be a branching point with a single child
+      node = parent;
+      parent = m_root;
+      while (parent != node && parent->child[GetBit (node->prefix, parent->length)] != node)
+        {
+          parent = parent->child[GetBit (node->prefix, parent->length)];
+        }
+    }
+  return true;
+}
+
+template <typename T>
+void
+Ipv4PrefixTrie<T>::Clear (void)
+{
+  Delete (m_root);
+  m_root = CreateNode (0, 0);
+  m_size = 0;
+}
+
+template <typename T>
+uint32_t
+Ipv4PrefixTrie<T>::GetSize (void) const
+{
+  return m_size;
+}
+
+template <typename T>
+uint32_t
+Ipv4PrefixTrie<T>::Match (Ipv4Address address, const Values *matches[33], uint8_t lengths[33]) const
+{
+  uint32_t dest = address.Get ();
+  uint32_t n = 0;
+  const Node *node = m_root;
+  while (node != 0 && (dest & GetMask (node->length)) == node->prefix)
+    {
+      if (!node->values.empty ())
+        {
+          matches[n] = &node->values;
+          lengths[n] = node->length;
+          n++;
+        }
+      if (node->length == 32)
+        {
+          break;
+        }
+      node = node->child[GetBit (dest, node->length)];
+    }
+  return n;
+}
+
+template <typename T>
+void
+Ipv4PrefixTrie<T>::MatchAll (Ipv4Address address, std::vector<T> &values) const
+{
+  const Values *matches[33];
+  uint8_t lengths[33];
+  uint32_t n = Match (address, matches, lengths);
+  if (n == 1)
+    {
+      for (typename Values::const_iterator i = matches[0]->begin (); i != matches[0]->end (); i++)
+        {
+          values.push_back (i->second);
+        }
+      return;
+    }
+  Values all;
+  for (uint32_t k = 0; k < n; k++)
+    {
+      all.insert (all.end (), matches[k]->begin (), matches[k]->end ());
+    }
+  std::sort (all.begin (), all.end (), IsInsertedBefore);
+  for (typename Values::const_iterator i = all.begin (); i != all.end (); i++)
+    {
+      values.push_back (i->second);
+    }
+}
+
+} // namespace ns3
+
+#endif /* IPV4_PREFIX_TRIE_H */
@@ -54,7 +54,8 @@ Ipv4StaticRouting::GetTypeId (void)
 }
 
 Ipv4StaticRouting::Ipv4StaticRouting () 
-  : m_ipv4 (0)
+  : m_nonPrefixRoutes (0),
+    m_ipv4 (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -72,7 +73,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         nextHop,
                                                         interface);
-  m_networkRoutes.push_back (make_pair (route,metric));
+  AddRoute (route, metric);
 }
 
 void 
@@ -86,7 +87,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
   *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (network,
                                                         networkMask,
                                                         interface);
-  m_networkRoutes.push_back (make_pair (route,metric));
+  AddRoute (route, metric);
 }
 
 void 
@@ -143,7 +144,7 @@ Ipv4StaticRouting::SetDefaultMulticastRoute (uint32_t outputInterface)
   *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (network,
                                                         networkMask,
                                                         outputInterface);
-  m_networkRoutes.push_back (make_pair (route,0));
+  AddRoute (route, 0);
 }
 
 uint32_t 
@@ -219,13 +220,44 @@ Ipv4StaticRouting::RemoveMulticastRoute (uint32_t index)
     }
 }
 
+void
+Ipv4StaticRouting::AddRoute (Ipv4RoutingTableEntry *route, uint32_t metric)
+{
+  NS_LOG_FUNCTION (this << route << metric);
+  NetworkRoutesI i = m_networkRoutes.insert (m_networkRoutes.end (), make_pair (route, metric));
+  uint8_t length;
+  if (Ipv4PrefixTrie<NetworkRoutesI>::IsPrefix (route->GetDestNetworkMask (), length))
+    {
+      m_networkRouteTrie.Insert (route->GetDestNetwork (), length, i);
+    }
+  else
+    {
+      m_nonPrefixRoutes++;
+    }
+}
+
+Ipv4StaticRouting::NetworkRoutesI
+Ipv4StaticRouting::EraseRoute (NetworkRoutesI i)
+{
+  NS_LOG_FUNCTION (this << i->first);
+  uint8_t length;
+  if (Ipv4PrefixTrie<NetworkRoutesI>::IsPrefix (i->first->GetDestNetworkMask (), length))
+    {
+      m_networkRouteTrie.Remove (i->first->GetDestNetwork (), length, i);
+    }
+  else
+    {
+      m_nonPrefixRoutes--;
+    }
+  delete i->first;
+  return m_networkRoutes.erase (i);
+}
+
 Ptr<Ipv4Route>
 Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
 {
   NS_LOG_FUNCTION (this << dest << " " << oif);
   Ptr<Ipv4Route> rtentry = 0;
-  uint16_t longest_mask = 0;
-  uint32_t shortest_metric = 0xffffffff;
   /* when sending on local multicast, there have to be interface specified */
   if (dest.IsLocalMulticast ())
     {
@@ -239,6 +271,78 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
       return rtentry;
     }
 
+  Ipv4RoutingTableEntry *route = 0;
+  if (m_nonPrefixRoutes > 0)
+    {
+      route = LookupStaticLinear (dest, oif);
+    }
+  else
+    {
+      // The longest prefix with a route on the requested interface wins.
+      // Among its routes, as when walking the table, the first host route
+      // is chosen, or the last one with the smallest metric.
+      const Ipv4PrefixTrie<NetworkRoutesI>::Values *matches[33];
+      uint8_t lengths[33];
+      uint32_t n = m_networkRouteTrie.Match (dest, matches, lengths);
+      while (route == 0 && n-- > 0)
+        {
+          uint32_t shortest_metric = 0xffffffff;
+          for (Ipv4PrefixTrie<NetworkRoutesI>::Values::const_iterator k = matches[n]->begin ();
+               k != matches[n]->end ();
+               k++)
+            {
+              Ipv4RoutingTableEntry *j = k->second->first;
+              uint32_t metric = k->second->second;
+              NS_LOG_LOGIC ("Found network route " << j << ", mask length " << uint16_t (lengths[n]) << ", metric " << metric);
+              if (oif != 0)
+                {
+                  if (oif != m_ipv4->GetNetDevice (j->GetInterface ()))
+                    {
+                      NS_LOG_LOGIC ("Not on requested interface, skipping");
+                      continue;
+                    }
+                }
+              if (metric > shortest_metric)
+                {
+                  NS_LOG_LOGIC ("Equal mask length, but previous metric shorter, skipping");
+                  continue;
+                }
+              shortest_metric = metric;
+              route = j;
+              if (lengths[n] == 32)
+                {
+                  break;
+                }
+            }
+        }
+    }
+  if (route != 0)
+    {
+      uint32_t interfaceIdx = route->GetInterface ();
+      rtentry = Create<Ipv4Route> ();
+      rtentry->SetDestination (route->GetDest ());
+      rtentry->SetSource (m_ipv4->SourceAddressSelection (interfaceIdx, route->GetDest ()));
+      rtentry->SetGateway (route->GetGateway ());
+      rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
+    }
+  if (rtentry != 0)
+    {
+      NS_LOG_LOGIC ("Matching route via " << rtentry->GetGateway () << " at the end");
+    }
+  else
+    {
+      NS_LOG_LOGIC ("No matching route to " << dest << " found");
+    }
+  return rtentry;
+}
+
+Ipv4RoutingTableEntry *
+Ipv4StaticRouting::LookupStaticLinear (Ipv4Address dest, Ptr<NetDevice> oif)
+{
+  NS_LOG_FUNCTION (this << dest << " " << oif);
+  Ipv4RoutingTableEntry *route = 0;
+  uint16_t longest_mask = 0;
+  uint32_t shortest_metric = 0xffffffff;
 
   for (NetworkRoutesI i = m_networkRoutes.begin (); 
        i != m_networkRoutes.end (); 
@@ -277,28 +381,14 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
               continue;
             }
           shortest_metric = metric;
-          Ipv4RoutingTableEntry* route = (j);
-          uint32_t interfaceIdx = route->GetInterface ();
-          rtentry = Create<Ipv4Route> ();
-          rtentry->SetDestination (route->GetDest ());
-          rtentry->SetSource (m_ipv4->SourceAddressSelection (interfaceIdx, route->GetDest ()));
-          rtentry->SetGateway (route->GetGateway ());
-          rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
+          route = j;
           if (masklen == 32)
             {
               break;
             }
         }
     }
-  if (rtentry != 0)
-    {
-      NS_LOG_LOGIC ("Matching route via " << rtentry->GetGateway () << " at the end");
-    }
-  else
-    {
-      NS_LOG_LOGIC ("No matching route to " << dest << " found");
-    }
-  return rtentry;
+  return route;
 }
 
 Ptr<Ipv4MulticastRoute>
@@ -447,8 +537,7 @@ Ipv4StaticRouting::RemoveRoute (uint32_t index)
     {
       if (tmp == index)
         {
-          delete j->first;
-          m_networkRoutes.erase (j);
+          EraseRoute (j);
           return;
         }
       tmp++;
@@ -575,6 +664,8 @@ Ipv4StaticRouting::DoDispose (void)
     {
       delete (j->first);
     }
+  m_networkRouteTrie.Clear ();
+  m_nonPrefixRoutes = 0;
   for (MulticastRoutesI i = m_multicastRoutes.begin (); 
        i != m_multicastRoutes.end (); 
        i = m_multicastRoutes.erase (i)) 
@@ -613,8 +704,7 @@ Ipv4StaticRouting::NotifyInterfaceDown (uint32_t i)
     {
       if (it->first->GetInterface () == i)
         {
-          delete it->first;
-          it = m_networkRoutes.erase (it);
+          it = EraseRoute (it);
         }
       else
         {
@@ -660,8 +750,7 @@ Ipv4StaticRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
           && it->first->GetDestNetwork () == networkAddress
           && it->first->GetDestNetworkMask () == networkMask)
         {
-          delete it->first;
-          it = m_networkRoutes.erase (it);
+          it = EraseRoute (it);
         }
       else
         {
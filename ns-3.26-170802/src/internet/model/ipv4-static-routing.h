@@ -31,6 +31,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-prefix-trie.h"
 
 namespace ns3 {
 
@@ -58,6 +59,11 @@ class Node;
  * Ipv4RoutingProtocol that defines the interface methods that a routing 
  * protocol must support.
  *
+ * The unicast routes are indexed by prefix in an Ipv4PrefixTrie, updated
+ * as routes are added and removed, so that a lookup does not depend on
+ * the size of the table.  Routes with a non-contiguous mask, if any, are
+ * looked up by walking the whole table.
+ *
  * \see Ipv4RoutingProtocol
  * \see Ipv4ListRouting
  * \see Ipv4ListRouting::AddRoutingProtocol
@@ -413,11 +419,44 @@ private:
   Ptr<Ipv4MulticastRoute> LookupStatic (Ipv4Address origin, Ipv4Address group,
                                         uint32_t interface);
 
+  /**
+   * \brief Lookup in the forwarding table for destination, by walking all
+   * the routes.
+   * \param dest destination address
+   * \param oif output interface if any (put 0 otherwise)
+   * \return the route to reach dest address, or 0
+   */
+  Ipv4RoutingTableEntry *LookupStaticLinear (Ipv4Address dest, Ptr<NetDevice> oif);
+
+  /**
+   * \brief Add a route at the end of the forwarding table.
+   * \param route the route
+   * \param metric metric of route
+   */
+  void AddRoute (Ipv4RoutingTableEntry *route, uint32_t metric);
+
+  /**
+   * \brief Remove a route from the forwarding table and delete it.
+   * \param i the route
+   * \return the next route
+   */
+  NetworkRoutesI EraseRoute (NetworkRoutesI i);
+
   /**
    * \brief the forwarding table for network.
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief The routes of m_networkRoutes with a contiguous mask, by prefix.
+   */
+  Ipv4PrefixTrie<NetworkRoutesI> m_networkRouteTrie;
+
+  /**
+   * \brief The number of routes with a non-contiguous mask.
+   */
+  uint32_t m_nonPrefixRoutes;
+
   /**
    * \brief the forwarding table for multicast.
    */
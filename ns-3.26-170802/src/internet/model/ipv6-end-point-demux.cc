@@ -18,6 +18,9 @@
  * Author: Sebastien Vincent <vincent@clarinet.u-strasbg.fr>
  */
 
+#include <algorithm>
+#include <iterator>
+#include <vector>
 #include "ipv6-end-point-demux.h"
 #include "ipv6-end-point.h"
 #include "ns3/log.h"
@@ -26,10 +29,41 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv6EndPointDemux");
 
+Ipv6EndPointDemux::FourTuple::FourTuple (Ipv6Address localAddress, uint16_t localPort,
+                                         Ipv6Address peerAddress, uint16_t peerPort)
+  : localAddress (localAddress),
+    localPort (localPort),
+    peerAddress (peerAddress),
+    peerPort (peerPort)
+{
+}
+
+bool Ipv6EndPointDemux::FourTuple::operator == (const FourTuple &other) const
+{
+  return localPort == other.localPort && peerPort == other.peerPort
+         && localAddress == other.localAddress && peerAddress == other.peerAddress;
+}
+
+size_t Ipv6EndPointDemux::FourTupleHash::operator () (const FourTuple &tuple) const
+{
+  Ipv6AddressHash hash;
+  uint64_t h = hash (tuple.localAddress) * 0x9e3779b97f4a7c15ULL;
+  h ^= hash (tuple.peerAddress);
+  h ^= ((static_cast<uint64_t> (tuple.localPort) << 16) | tuple.peerPort) * 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 32;
+  return static_cast<size_t> (h);
+}
+
+Ipv6EndPointDemux::PortEntry::PortEntry ()
+  : connected (0)
+{
+}
+
 Ipv6EndPointDemux::Ipv6EndPointDemux ()
   : m_ephemeral (49152),
     m_portFirst (49152),
-    m_portLast (65535)
+    m_portLast (65535),
+    m_nextOrder (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -37,38 +71,145 @@ Ipv6EndPointDemux::Ipv6EndPointDemux ()
 Ipv6EndPointDemux::~Ipv6EndPointDemux ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (EndPointMap::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
-      Ipv6EndPoint *endPoint = *i;
+      Ipv6EndPoint *endPoint = i->second;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_ports.clear ();
+  m_connected.clear ();
 }
 
-bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+bool Ipv6EndPointDemux::IsConnected (Ipv6Address localAddress, Ipv6Address peerAddress, uint16_t peerPort)
+{
+  return localAddress != Ipv6Address::GetAny () && peerAddress != Ipv6Address::GetAny ()
+         && peerPort != 0;
+}
+
+bool Ipv6EndPointDemux::IsConnected (Ipv6EndPoint *endPoint)
+{
+  return IsConnected (endPoint->m_localAddr, endPoint->m_peerAddr, endPoint->m_peerPort);
+}
+
+bool Ipv6EndPointDemux::IsAllocatedBefore (Ipv6EndPoint *a, Ipv6EndPoint *b)
+{
+  return a->m_order < b->m_order;
+}
+
+void Ipv6EndPointDemux::InsertSorted (EndPoints &endPoints, Ipv6EndPoint *endPoint)
+{
+  /* The endpoints are most often indexed right after their allocation */
+  EndPoints::reverse_iterator i = endPoints.rbegin ();
+  while (i != endPoints.rend () && IsAllocatedBefore (endPoint, *i))
+    {
+      i++;
+    }
+  endPoints.insert (i.base (), endPoint);
+}
+
+void Ipv6EndPointDemux::Add (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  endPoint->m_demux = this;
+  endPoint->m_order = m_nextOrder++;
+  m_endPoints.insert (m_endPoints.end (), std::make_pair (endPoint->m_order, endPoint));
+  Index (endPoint);
+}
+
+void Ipv6EndPointDemux::Index (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  PortEntry &entry = m_ports[endPoint->m_localPort];
+  if (IsConnected (endPoint))
+    {
+      FourTuple tuple (endPoint->m_localAddr, endPoint->m_localPort,
+                       endPoint->m_peerAddr, endPoint->m_peerPort);
+      InsertSorted (m_connected[tuple], endPoint);
+      entry.connected++;
+    }
+  else
+    {
+      InsertSorted (entry.wildcard, endPoint);
+    }
+}
+
+void Ipv6EndPointDemux::Unindex (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  std::unordered_map<uint16_t, PortEntry>::iterator entry = m_ports.find (endPoint->m_localPort);
+  NS_ASSERT (entry != m_ports.end ());
+  if (IsConnected (endPoint))
+    {
+      FourTuple tuple (endPoint->m_localAddr, endPoint->m_localPort,
+                       endPoint->m_peerAddr, endPoint->m_peerPort);
+      std::unordered_map<FourTuple, EndPoints, FourTupleHash>::iterator i = m_connected.find (tuple);
+      NS_ASSERT (i != m_connected.end ());
+      i->second.remove (endPoint);
+      if (i->second.empty ())
+        {
+          m_connected.erase (i);
+        }
+      entry->second.connected--;
+    }
+  else
+    {
+      entry->second.wildcard.remove (endPoint);
+    }
+  if (entry->second.wildcard.empty () && entry->second.connected == 0)
+    {
+      m_ports.erase (entry);
+    }
+}
+
+Ipv6EndPoint* Ipv6EndPointDemux::FindFirstConnected (uint16_t port)
 {
   NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (EndPointMap::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
-      if ((*i)->GetLocalPort  () == port)
+      if (i->second->m_localPort == port && IsConnected (i->second))
         {
-          return true;
+          return i->second;
         }
     }
-  return false;
+  return 0;
+}
+
+bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool Ipv6EndPointDemux::LookupLocal (Ipv6Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::unordered_map<uint16_t, PortEntry>::iterator entry = m_ports.find (port);
+  if (entry == m_ports.end ())
     {
-      if ((*i)->GetLocalPort () == port
-          && (*i)->GetLocalAddress () == addr)
+      return false;
+    }
+  for (EndPointsI i = entry->second.wildcard.begin (); i != entry->second.wildcard.end (); i++)
+    {
+      if ((*i)->GetLocalAddress () == addr)
         {
           return true;
         }
     }
+  if (entry->second.connected > 0 && addr != Ipv6Address::GetAny ())
+    {
+      /* Binding to a port which has connections is rare enough to walk
+         all the endpoints */
+      for (EndPointMap::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+        {
+          if (i->second->GetLocalPort () == port
+              && i->second->GetLocalAddress () == addr)
+            {
+              return true;
+            }
+        }
+    }
   return false;
 }
 
@@ -82,7 +223,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Add (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -97,7 +238,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Add (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -118,7 +259,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address, uint16_t port)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Add (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -127,21 +268,38 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  bool duplicate = false;
+  if (IsConnected (localAddress, peerAddress, peerPort))
+    {
+      FourTuple tuple (localAddress, localPort, peerAddress, peerPort);
+      duplicate = m_connected.find (tuple) != m_connected.end ();
+    }
+  else
     {
-      if ((*i)->GetLocalPort () == localPort
-          && (*i)->GetLocalAddress () == localAddress
-          && (*i)->GetPeerPort () == peerPort
-          && (*i)->GetPeerAddress () == peerAddress)
+      std::unordered_map<uint16_t, PortEntry>::iterator entry = m_ports.find (localPort);
+      if (entry != m_ports.end ())
         {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
+          for (EndPointsI i = entry->second.wildcard.begin (); i != entry->second.wildcard.end (); i++)
+            {
+              if ((*i)->GetLocalAddress () == localAddress
+                  && (*i)->GetPeerPort () == peerPort
+                  && (*i)->GetPeerAddress () == peerAddress)
+                {
+                  duplicate = true;
+                  break;
+                }
+            }
         }
     }
+  if (duplicate)
+    {
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
+    }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Add (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -151,14 +309,13 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
 void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  EndPointMap::iterator i = m_endPoints.find (endPoint->m_order);
+  if (i != m_endPoints.end () && i->second == endPoint)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      Unindex (endPoint);
+      m_endPoints.erase (i);
+      endPoint->m_demux = 0;
+      delete endPoint;
     }
 }
 
@@ -179,7 +336,34 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
   EndPoints retval4; /* Exact match on all 4 */
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::unordered_map<uint16_t, PortEntry>::iterator entry = m_ports.find (dport);
+  if (entry == m_ports.end ())
+    {
+      NS_LOG_LOGIC ("No endpoint bound to port " << dport);
+      return retval1;
+    }
+
+  /* The endpoints to look at are the ones bound to the port which are not
+     connected, and the connected ones with the four-tuple of the packet,
+     merged in allocation order. */
+  std::vector<Ipv6EndPoint *> candidates;
+  std::unordered_map<FourTuple, EndPoints, FourTupleHash>::iterator connected = m_connected.end ();
+  if (entry->second.connected > 0)
+    {
+      connected = m_connected.find (FourTuple (daddr, dport, saddr, sport));
+    }
+  if (connected == m_connected.end ())
+    {
+      candidates.assign (entry->second.wildcard.begin (), entry->second.wildcard.end ());
+    }
+  else
+    {
+      std::merge (entry->second.wildcard.begin (), entry->second.wildcard.end (),
+                  connected->second.begin (), connected->second.end (),
+                  std::back_inserter (candidates), IsAllocatedBefore);
+    }
+
+  for (std::vector<Ipv6EndPoint *>::iterator i = candidates.begin (); i != candidates.end (); i++)
     {
       Ipv6EndPoint* endP = *i;
 
@@ -293,16 +477,31 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
 
 Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport, Ipv6Address src, uint16_t sport)
 {
+  std::unordered_map<uint16_t, PortEntry>::iterator entry = m_ports.find (dport);
+  if (entry == m_ports.end ())
+    {
+      return 0;
+    }
+  Ipv6EndPoint *exact = 0;
+  if (entry->second.connected > 0)
+    {
+      std::unordered_map<FourTuple, EndPoints, FourTupleHash>::iterator connected =
+        m_connected.find (FourTuple (dst, dport, src, sport));
+      if (connected != m_connected.end ())
+        {
+          exact = connected->second.front ();
+        }
+    }
   uint32_t genericity = 3;
   Ipv6EndPoint *generic = 0;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (EndPointsI i = entry->second.wildcard.begin (); i != entry->second.wildcard.end (); i++)
     {
       uint32_t tmp = 0;
 
-      if ((*i)->GetLocalPort () != dport)
+      if (exact != 0 && IsAllocatedBefore (exact, *i))
         {
-          continue;
+          break;
         }
 
       if ((*i)->GetLocalAddress () == dst && (*i)->GetPeerPort () == sport
@@ -328,6 +527,20 @@ Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport,
           genericity = tmp;
         }
     }
+  if (exact != 0)
+    {
+      return exact;
+    }
+  if (entry->second.connected > 0)
+    {
+      /* The connected endpoints are not generic at all: the first one is
+         returned, unless an endpoint as specific was allocated before it */
+      Ipv6EndPoint *first = FindFirstConnected (dport);
+      if (genericity > 0 || IsAllocatedBefore (first, generic))
+        {
+          return first;
+        }
+    }
   return generic;
 }
 
@@ -355,7 +568,12 @@ uint16_t Ipv6EndPointDemux::AllocateEphemeralPort ()
 
 Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::GetEndPoints () const
 {
-  return m_endPoints;
+  EndPoints ret;
+  for (EndPointMap::const_iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+    {
+      ret.push_back (i->second);
+    }
+  return ret;
 }
 
 } /* namespace ns3 */
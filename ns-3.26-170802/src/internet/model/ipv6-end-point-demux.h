@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <unordered_map>
 #include "ns3/ipv6-address.h"
 #include "ipv6-interface.h"
 
@@ -34,6 +36,10 @@ class Ipv6EndPoint;
  * \ingroup ipv6
  *
  * \brief Demultiplexer for end points.
+ *
+ * As in Ipv4EndPointDemux, the connected endpoints are indexed by their
+ * four-tuple and the other ones by their local port, so that a lookup
+ * does not depend on the number of connections of the node.
  */
 class Ipv6EndPointDemux
 {
@@ -147,6 +153,124 @@ public:
   EndPoints GetEndPoints () const;
 
 private:
+  friend class Ipv6EndPoint;
+
+  /**
+   * \brief The four-tuple of a connected endpoint.
+   */
+  struct FourTuple
+  {
+    /**
+     * \brief Constructor.
+     * \param localAddress local address
+     * \param localPort local port
+     * \param peerAddress peer address
+     * \param peerPort peer port
+     */
+    FourTuple (Ipv6Address localAddress, uint16_t localPort,
+               Ipv6Address peerAddress, uint16_t peerPort);
+    /**
+     * \param other the four-tuple to compare with
+     * \returns true if both four-tuples are equal
+     */
+    bool operator == (const FourTuple &other) const;
+
+    Ipv6Address localAddress; //!< the local address
+    uint16_t localPort;       //!< the local port
+    Ipv6Address peerAddress;  //!< the peer address
+    uint16_t peerPort;        //!< the peer port
+  };
+
+  /**
+   * \brief Hash function of the four-tuples.
+   */
+  struct FourTupleHash
+  {
+    /**
+     * \param tuple the four-tuple
+     * \returns the hash of the four-tuple
+     */
+    size_t operator () (const FourTuple &tuple) const;
+  };
+
+  /**
+   * \brief The endpoints bound to a local port.
+   */
+  struct PortEntry
+  {
+    /**
+     * \brief Constructor.
+     */
+    PortEntry ();
+
+    EndPoints wildcard; //!< the endpoints which are not connected, in allocation order
+    uint32_t connected; //!< the number of connected endpoints
+  };
+
+  /**
+   * \brief Container of the IPv6 endpoints, by allocation order.
+   */
+  typedef std::map<uint64_t, Ipv6EndPoint *> EndPointMap;
+
+  /**
+   * \brief Check whether an endpoint with the given addresses and peer port
+   * is connected, and thus indexed by its four-tuple.
+   * \param localAddress local address
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \return true if neither of them is a wildcard
+   */
+  static bool IsConnected (Ipv6Address localAddress, Ipv6Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Check whether an endpoint is connected.
+   * \param endPoint the endpoint
+   * \return true if the endpoint is indexed by its four-tuple
+   */
+  static bool IsConnected (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Compare two endpoints by allocation order.
+   * \param a an endpoint
+   * \param b another endpoint
+   * \return true if \p a was allocated before \p b
+   */
+  static bool IsAllocatedBefore (Ipv6EndPoint *a, Ipv6EndPoint *b);
+
+  /**
+   * \brief Insert an endpoint in a list sorted by allocation order.
+   * \param endPoints the list
+   * \param endPoint the endpoint
+   */
+  static void InsertSorted (EndPoints &endPoints, Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Find the first connected endpoint bound to a local port.
+   * \param port the local port
+   * \return the endpoint (0 if not found)
+   */
+  Ipv6EndPoint *FindFirstConnected (uint16_t port);
+
+  /**
+   * \brief Add a new endpoint to the demux.
+   * \param endPoint the endpoint
+   */
+  void Add (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Index an endpoint by its current addresses and ports.
+   * \param endPoint the endpoint
+   */
+  void Index (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Remove an endpoint from the index, before its addresses or ports
+   * change or before it is deallocated.
+   * \param endPoint the endpoint
+   */
+  void Unindex (Ipv6EndPoint *endPoint);
+
+
   /**
    * \brief Allocate a ephemeral port.
    * \return a port
@@ -169,9 +293,24 @@ private:
   uint16_t m_portLast;
 
   /**
-   * \brief A list of IPv6 end points.
+   * \brief The allocation order of the next endpoint.
+   */
+  uint64_t m_nextOrder;
+
+  /**
+   * \brief All the IPv6 end points, by allocation order.
+   */
+  EndPointMap m_endPoints;
+
+  /**
+   * \brief The IPv6 end points by local port.
+   */
+  std::unordered_map<uint16_t, PortEntry> m_ports;
+
+  /**
+   * \brief The connected IPv6 end points by four-tuple.
    */
-  EndPoints m_endPoints;
+  std::unordered_map<FourTuple, EndPoints, FourTupleHash> m_connected;
 };
 
 } /* namespace ns3 */
@@ -114,9 +114,9 @@ TcpRxBuffer::MaxRxSequence (void) const
     { // No data allowed beyond FIN
       return m_finSeq;
     }
-  else if (m_data.size ())
+  else if (m_size > 0)
     { // No data allowed beyond Rx window allowed
-      return m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      return HeadSequence () + SequenceNumber32 (m_maxBuffer);
     }
   return m_nextRxSeq + SequenceNumber32 (m_maxBuffer);
 }
@@ -137,6 +137,18 @@ TcpRxBuffer::Finished (void)
   return (m_gotFin && m_finSeq < m_nextRxSeq);
 }
 
+SequenceNumber32
+TcpRxBuffer::HeadSequence (void) const
+{
+  NS_ASSERT (m_size > 0);
+  if (m_availBytes > 0)
+    { // The data to read ends at RCV.NXT, or at the FIN once accounted for
+      SequenceNumber32 end = (m_gotFin && m_finSeq < m_nextRxSeq) ? m_finSeq : m_nextRxSeq.Get ();
+      return end - static_cast<int32_t> (m_availBytes);
+    }
+  return m_data.begin ()->first;
+}
+
 bool
 TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
 {
@@ -150,35 +162,36 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
 
   // Trim packet to fit Rx window specification
   if (headSeq < m_nextRxSeq) headSeq = m_nextRxSeq;
-  if (m_data.size ())
+  if (m_size > 0)
     {
-      SequenceNumber32 maxSeq = m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      SequenceNumber32 maxSeq = HeadSequence () + SequenceNumber32 (m_maxBuffer);
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end () && i->first <= tailSeq)
+  // Remove overlapped bytes from packet: the interval before it may
+  // overlap its head, the ones starting within it are either embedded in
+  // it or overlap its tail
+  BufIterator i = m_data.upper_bound (headSeq);
+  if (i != m_data.begin ())
     {
-      SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      if (lastByteSeq > headSeq)
-        {
-          if (i->first > headSeq && lastByteSeq < tailSeq)
-            { // Rare case: Existing packet is embedded fully in the new packet
-              m_size -= i->second->GetSize ();
-              m_data.erase (i++);
-              continue;
-            }
-          if (i->first <= headSeq)
-            { // Incoming head is overlapped
-              headSeq = lastByteSeq;
-            }
-          if (lastByteSeq >= tailSeq)
-            { // Incoming tail is overlapped
-              tailSeq = i->first;
-            }
+      BufIterator prev = i;
+      --prev;
+      if (prev->second.end > headSeq)
+        { // Incoming head is overlapped
+          headSeq = prev->second.end;
         }
-      ++i;
+    }
+  while (i != m_data.end () && i->first <= tailSeq && headSeq < tailSeq)
+    {
+      if (i->second.end < tailSeq)
+        { // Rare case: Existing interval is embedded fully in the new packet
+          m_size -= i->second.end - i->first;
+          m_data.erase (i++);
+          continue;
+        }
+      // Incoming tail is overlapped
+      tailSeq = i->first;
+      break;
     }
   // We now know how much we are going to store, trim the packet
   if (headSeq >= tailSeq)
@@ -186,31 +199,43 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
       NS_LOG_LOGIC ("Nothing to buffer");
       return false; // Nothing to buffer anyway
     }
-  else
+  uint32_t start = headSeq - tcph.GetSequenceNumber ();
+  uint32_t length = tailSeq - headSeq;
+  if (length != pktSize)
     {
-      uint32_t start = headSeq - tcph.GetSequenceNumber ();
-      uint32_t length = tailSeq - headSeq;
       p = p->CreateFragment (start, length);
-      NS_ASSERT (length == p->GetSize ());
     }
-  // Insert packet into buffer
-  NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
-  m_data [ headSeq ] = p;
-  NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
-  // Update variables
-  m_size += p->GetSize ();      // Occupancy
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  NS_ASSERT (length == p->GetSize ());
+  NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << length);
+  m_size += length;      // Occupancy
+
+  // Insert packet into buffer, coalesced with the adjacent intervals
+  BufIterator next = m_data.lower_bound (tailSeq);
+  BufIterator interval = next;
+  if (interval != m_data.begin () && (--interval)->second.end == headSeq)
     {
-      if (i->first < m_nextRxSeq)
-        {
-          continue;
-        }
-      else if (i->first > m_nextRxSeq)
-        {
-          break;
-        };
-      m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      m_availBytes += i->second->GetSize ();
+      interval->second.packets.push_back (p);
+      interval->second.end = tailSeq;
+    }
+  else
+    {
+      interval = m_data.insert (next, std::make_pair (headSeq, Interval ()));
+      interval->second.packets.push_back (p);
+      interval->second.end = tailSeq;
+    }
+  if (next != m_data.end () && next->first == tailSeq)
+    {
+      interval->second.packets.splice (interval->second.packets.end (), next->second.packets);
+      interval->second.end = next->second.end;
+      m_data.erase (next);
+    }
+  // Update variables
+  if (interval->first == m_nextRxSeq)
+    { // The hole at the head is filled: the interval becomes readable
+      m_availBytes += interval->second.end - interval->first;
+      m_nextRxSeq = interval->second.end;
+      m_inOrder.splice (m_inOrder.end (), interval->second.packets);
+      m_data.erase (interval);
     }
   NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
   if (m_gotFin && m_nextRxSeq == m_finSeq)
@@ -228,40 +253,39 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   uint32_t extractSize = std::min (maxSize, m_availBytes);
   NS_LOG_LOGIC ("Requested to extract " << extractSize << " bytes from TcpRxBuffer of size=" << m_size);
   if (extractSize == 0) return 0;  // No contiguous block to return
-  NS_ASSERT (m_data.size ()); // At least we have something to extract
-  Ptr<Packet> outPkt = Create<Packet> (); // The packet that contains all the data to return
-  BufIterator i;
+  NS_ASSERT (m_inOrder.size ()); // At least we have something to extract
+  Ptr<Packet> outPkt; // The packet that contains all the data to return
+  m_size -= extractSize;
+  m_availBytes -= extractSize;
   while (extractSize)
     { // Check the buffered data for delivery
-      i = m_data.begin ();
-      NS_ASSERT (i->first <= m_nextRxSeq); // in-sequence data expected
+      Ptr<Packet> front = m_inOrder.front ();
       // Check if we send the whole pkt or just a partial
-      uint32_t pktSize = i->second->GetSize ();
+      uint32_t pktSize = front->GetSize ();
+      Ptr<Packet> data;
       if (pktSize <= extractSize)
         { // Whole packet is extracted
-          outPkt->AddAtEnd (i->second);
-          m_data.erase (i);
-          m_size -= pktSize;
-          m_availBytes -= pktSize;
+          m_inOrder.pop_front ();
+          data = front;
           extractSize -= pktSize;
         }
       else
         { // Partial is extracted and done
-          outPkt->AddAtEnd (i->second->CreateFragment (0, extractSize));
-          m_data[i->first + SequenceNumber32 (extractSize)] = i->second->CreateFragment (extractSize, pktSize - extractSize);
-          m_data.erase (i);
-          m_size -= extractSize;
-          m_availBytes -= extractSize;
+          data = front->CreateFragment (0, extractSize);
+          m_inOrder.front () = front->CreateFragment (extractSize, pktSize - extractSize);
           extractSize = 0;
         }
-    }
-  if (outPkt->GetSize () == 0)
-    {
-      NS_LOG_LOGIC ("Nothing extracted.");
-      return 0;
+      if (!outPkt)
+        { // The buffered packets are not handed out themselves
+          outPkt = data->Copy ();
+        }
+      else
+        {
+          outPkt->AddAtEnd (data);
+        }
     }
   NS_LOG_LOGIC ("Extracted " << outPkt->GetSize ( ) << " bytes, bufsize=" << m_size
-                             << ", num pkts in buffer=" << m_data.size ());
+                             << ", num pkts in buffer=" << m_inOrder.size () + m_data.size ());
   return outPkt;
 }
 
@@ -22,6 +22,7 @@
 #define TCP_RX_BUFFER_H
 
 #include <map>
+#include <list>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/sequence-number.h"
@@ -36,6 +37,14 @@ class Packet;
  *
  * \brief class for the reordering buffer that keeps the data from lower layer, i.e.
  *        TcpL4Protocol, sent to the application
+ *
+ * The data received in order waits to be read in a list of packets.  The
+ * data received out of order is kept as intervals of contiguous bytes,
+ * each a list of packets indexed by its first sequence number, which
+ * are coalesced as the segments in between arrive.  A segment is thus
+ * compared with its neighbour intervals only, and when it fills the hole
+ * at the head of the buffer the interval after it is moved as a whole to
+ * the data ready to be read.  No bytes are copied before Extract().
  */
 class TcpRxBuffer : public Object
 {
@@ -126,15 +135,28 @@ public:
   Ptr<Packet> Extract (uint32_t maxSize);
 
 private:
+  /// Contiguous data received out of order
+  struct Interval
+  {
+    SequenceNumber32 end;             //!< Sequence number of the byte after the data
+    std::list<Ptr<Packet> > packets;  //!< The data, in order
+  };
   /// container for data stored in the buffer
-  typedef std::map<SequenceNumber32, Ptr<Packet> >::iterator BufIterator;
+  typedef std::map<SequenceNumber32, Interval>::iterator BufIterator;
+
+  /**
+   * \returns The sequence number of the first byte in the buffer.
+   */
+  SequenceNumber32 HeadSequence (void) const;
+
   TracedValue<SequenceNumber32> m_nextRxSeq; //!< Seqnum of the first missing byte in data (RCV.NXT)
   SequenceNumber32 m_finSeq;                 //!< Seqnum of the FIN packet
   bool m_gotFin;                             //!< Did I received FIN packet?
   uint32_t m_size;                           //!< Number of total data bytes in the buffer, not necessarily contiguous
   uint32_t m_maxBuffer;                      //!< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //!< Number of bytes available to read, i.e. contiguous block at head
-  std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Corresponding data (may be null)
+  std::list<Ptr<Packet> > m_inOrder;         //!< Data available to read, ending at RCV.NXT
+  std::map<SequenceNumber32, Interval> m_data; //!< Data received out of order, by first sequence number
 };
 
 } //namepsace ns3
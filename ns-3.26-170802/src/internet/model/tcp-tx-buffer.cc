@@ -57,7 +57,7 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_data (0)
+  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_coalesce (false)
 {
 }
 
@@ -111,7 +111,26 @@ TcpTxBuffer::Add (Ptr<Packet> p)
     {
       if (p->GetSize () > 0)
         {
-          m_data.push_back (p);
+          bool tagged = p->GetPacketTagIterator ().HasNext ();
+          if (m_coalesce && !tagged
+              && m_data.back ().packet->GetSize () + p->GetSize () <= COALESCE_SIZE)
+            {
+              Chunk &last = m_data.back ();
+              if (last.packet->GetReferenceCount () > 1)
+                { // The packet is also held by the application or a copy of this buffer
+                  last.packet = last.packet->Copy ();
+                }
+              last.packet->AddAtEnd (p);
+              NS_LOG_LOGIC ("Appended to the last chunk, now of size " << last.packet->GetSize ());
+            }
+          else
+            {
+              Chunk chunk;
+              chunk.packet = p;
+              chunk.seq = TailSequence ();
+              m_data.push_back (chunk);
+              m_coalesce = !tagged && p->GetSize () < COALESCE_SIZE;
+            }
           m_size += p->GetSize ();
           NS_LOG_LOGIC ("Updated size=" << m_size << ", lastSeq=" << m_firstByteSeq + SequenceNumber32 (m_size));
         }
@@ -133,6 +152,24 @@ TcpTxBuffer::SizeFromSequence (const SequenceNumber32& seq) const
   return lastSeq - seq;
 }
 
+bool
+TcpTxBuffer::IsBeforeChunk (const SequenceNumber32& seq, const Chunk& chunk)
+{
+  return seq < chunk.seq;
+}
+
+TcpTxBuffer::BufIterator
+TcpTxBuffer::FindChunk (const SequenceNumber32& seq)
+{
+  NS_ASSERT (!m_data.empty () && m_data.front ().seq <= seq);
+  BufIterator i = m_data.end ();
+  if (seq < m_data.back ().seq)
+    { // Not new data, which is most often in the last chunk
+      i = std::upper_bound (m_data.begin (), i, seq, IsBeforeChunk);
+    }
+  return --i;
+}
+
 Ptr<Packet>
 TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
 {
@@ -148,54 +185,41 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
     }
 
   // Extract data from the buffer and return
-  uint32_t offset = seq - m_firstByteSeq.Get ();
-  uint32_t count = 0;      // Offset of the first byte of a packet in the buffer
-  uint32_t pktSize = 0;
-  bool beginFound = false;
-  int pktCount = 0;
-  Ptr<Packet> outPacket;
-  NS_LOG_LOGIC ("There are " << m_data.size () << " number of packets in buffer");
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  BufIterator i = FindChunk (seq);
+  uint32_t packetOffset = seq - i->seq;
+  uint32_t fragmentLength = i->packet->GetSize () - packetOffset;
+  NS_LOG_LOGIC ("First byte found in the chunk of sequence number " << i->seq
+                << ", len=" << i->packet->GetSize ());
+  if (i + 1 == m_data.end ())
+    { // Once sent, the last chunk is no longer extended
+      m_coalesce = false;
+    }
+  if (fragmentLength >= s)
+    { // Data to be copied falls entirely in this chunk
+      return i->packet->CreateFragment (packetOffset, s);
+    }
+  Ptr<Packet> outPacket = i->packet->CreateFragment (packetOffset, fragmentLength);
+  uint32_t remaining = s - fragmentLength;
+  while (remaining > 0)
     {
-      pktCount++;
-      pktSize = (*i)->GetSize ();
-      if (!beginFound)
-        { // Look for first fragment
-          if (count + pktSize > offset)
-            {
-              NS_LOG_LOGIC ("First byte found in packet #" << pktCount << " at buffer offset " << count
-                                                           << ", packet len=" << pktSize);
-              beginFound = true;
-              uint32_t packetOffset = offset - count;
-              uint32_t fragmentLength = count + pktSize - offset;
-              if (fragmentLength >= s)
-                { // Data to be copied falls entirely in this packet
-                  return (*i)->CreateFragment (packetOffset, s);
-                }
-              else
-                { // This packet only fulfills part of the request
-                  outPacket = (*i)->CreateFragment (packetOffset, fragmentLength);
-                }
-              NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-            }
+      ++i;
+      NS_ASSERT (i != m_data.end ());
+      uint32_t pktSize = i->packet->GetSize ();
+      if (i + 1 == m_data.end ())
+        {
+          m_coalesce = false;
         }
-      else if (count + pktSize >= offset + s)
+      if (pktSize > remaining)
         { // Last packet fragment found
-          NS_LOG_LOGIC ("Last byte found in packet #" << pktCount << " at buffer offset " << count
-                                                      << ", packet len=" << pktSize);
-          uint32_t fragmentLength = offset + s - count;
-          Ptr<Packet> endFragment = (*i)->CreateFragment (0, fragmentLength);
-          outPacket->AddAtEnd (endFragment);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-          break;
+          outPacket->AddAtEnd (i->packet->CreateFragment (0, remaining));
+          remaining = 0;
         }
       else
         {
-          NS_LOG_LOGIC ("Appending to output the packet #" << pktCount << " of offset " << count << " len=" << pktSize);
-          outPacket->AddAtEnd (*i);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
+          outPacket->AddAtEnd (i->packet);
+          remaining -= pktSize;
         }
-      count += pktSize;
+      NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
     }
   NS_ASSERT (outPacket->GetSize () == s);
   return outPacket;
@@ -205,6 +229,11 @@ void
 TcpTxBuffer::SetHeadSequence (const SequenceNumber32& seq)
 {
   NS_LOG_FUNCTION (this << seq);
+  // Data written before the connection is set up moves with the head
+  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+    {
+      i->seq = seq + SequenceNumber32 (i->seq - m_firstByteSeq.Get ());
+    }
   m_firstByteSeq = seq;
 }
 
@@ -213,44 +242,31 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
 {
   NS_LOG_FUNCTION (this << seq);
   NS_LOG_LOGIC ("current data size=" << m_size << ", headSeq=" << m_firstByteSeq << ", maxBuffer=" << m_maxBuffer
-                                     << ", numPkts=" << m_data.size ());
+                                     << ", numChunks=" << m_data.size ());
   // Cases do not need to scan the buffer
   if (m_firstByteSeq >= seq) return;
 
-  // Scan the buffer and discard packets
   uint32_t offset = seq - m_firstByteSeq.Get ();  // Number of bytes to remove
-  uint32_t pktSize;
-  NS_LOG_LOGIC ("Offset=" << offset);
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end ())
-    {
-      if (offset > (*i)->GetSize ())
-        { // This packet is behind the seqnum. Remove this packet from the buffer
-          pktSize = (*i)->GetSize ();
-          m_size -= pktSize;
-          offset -= pktSize;
-          m_firstByteSeq += pktSize;
-          i = m_data.erase (i);
-          NS_LOG_LOGIC ("Removed one packet of size " << pktSize << ", offset=" << offset);
-        }
-      else if (offset > 0)
-        { // Part of the packet is behind the seqnum. Fragment
-          pktSize = (*i)->GetSize () - offset;
-          *i = (*i)->CreateFragment (offset, pktSize);
-          m_size -= offset;
-          m_firstByteSeq += offset;
-          NS_LOG_LOGIC ("Fragmented one packet by size " << offset << ", new size=" << pktSize);
-          break;
-        }
+  if (offset >= m_size)
+    { // Everything is acknowledged, including maybe a FIN
+      m_data.clear ();
+      m_size = 0;
+      m_coalesce = false;
     }
-  // Catching the case of ACKing a FIN
-  if (m_size == 0)
+  else
     {
-      m_firstByteSeq = seq;
+      m_size -= offset;
+      // Remove the chunks behind the seqnum; the first chunk left may
+      // start before it
+      while (m_data.front ().seq + SequenceNumber32 (m_data.front ().packet->GetSize ()) <= seq)
+        {
+          NS_LOG_LOGIC ("Removed one chunk of size " << m_data.front ().packet->GetSize ());
+          m_data.pop_front ();
+        }
     }
+  m_firstByteSeq = seq;
   NS_LOG_LOGIC ("size=" << m_size << " headSeq=" << m_firstByteSeq << " maxBuffer=" << m_maxBuffer
-                        <<" numPkts="<< m_data.size ());
-  NS_ASSERT (m_firstByteSeq == seq);
+                        <<" numChunks="<< m_data.size ());
 }
 
 } // namepsace ns3
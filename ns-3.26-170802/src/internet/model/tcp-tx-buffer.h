@@ -21,7 +21,7 @@
 #ifndef TCP_TX_BUFFER_H
 #define TCP_TX_BUFFER_H
 
-#include <list>
+#include <deque>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/object.h"
@@ -36,6 +36,18 @@ class Packet;
  *
  * \brief class for keeping the data sent by the application to the TCP socket, i.e.
  *        the sending buffer.
+ *
+ * The data is kept as a queue of packets, the chunks, each with the
+ * sequence number of its first byte.  CopyFromSequence() finds the chunk
+ * holding a sequence number with a binary search and returns a fragment
+ * of it, which shares its bytes, so that sending or retransmitting a
+ * segment which lies in a single chunk does not copy any byte.  The
+ * packets written by the application are appended to the last chunk
+ * while it has not been sent and stays below COALESCE_SIZE bytes, so
+ * that small writes do not make every segment a merge of many packets.
+ * Packets carrying packet tags are kept as chunks of their own, for the
+ * segments taken from them to keep their tags.  DiscardUpTo() removes
+ * the chunks once all their bytes are acknowledged.
  */
 class TcpTxBuffer : public Object
 {
@@ -128,13 +140,38 @@ public:
   void DiscardUpTo (const SequenceNumber32& seq);
 
 private:
+  /**
+   * Chunks up to this size, in bytes, are extended with the packets
+   * written after them.
+   */
+  static const uint32_t COALESCE_SIZE = 8192;
+
+  /// A chunk of data and the sequence number of its first byte
+  struct Chunk
+  {
+    Ptr<Packet> packet;       //!< The data
+    SequenceNumber32 seq;     //!< Sequence number of the first byte of the data
+  };
   /// container for data stored in the buffer
-  typedef std::list<Ptr<Packet> >::iterator BufIterator;
+  typedef std::deque<Chunk>::iterator BufIterator;
+
+  /**
+   * \param seq A sequence number in [HeadSequence, TailSequence).
+   * \returns The chunk holding the byte of sequence number \p seq.
+   */
+  BufIterator FindChunk (const SequenceNumber32& seq);
+  /**
+   * \param seq A sequence number.
+   * \param chunk A chunk.
+   * \returns true if \p seq is before the first byte of \p chunk.
+   */
+  static bool IsBeforeChunk (const SequenceNumber32& seq, const Chunk& chunk);
 
   TracedValue<SequenceNumber32> m_firstByteSeq; //!< Sequence number of the first byte in data (SND.UNA)
   uint32_t m_size;                              //!< Number of data bytes
   uint32_t m_maxBuffer;                         //!< Max number of data bytes in buffer (SND.WND)
-  std::list<Ptr<Packet> > m_data;               //!< Corresponding data (may be null)
+  std::deque<Chunk> m_data;                     //!< Corresponding data; the first chunk may start before SND.UNA
+  bool m_coalesce;                              //!< Whether the last chunk may be extended
 };
 
 } // namepsace ns3
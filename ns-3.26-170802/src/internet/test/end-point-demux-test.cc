@@ -0,0 +1,689 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv4-interface-address.h"
+#include "ns3/ipv6-interface.h"
+#include "../model/ipv4-end-point.h"
+#include "../model/ipv4-end-point-demux.h"
+#include "../model/ipv6-end-point.h"
+#include "../model/ipv6-end-point-demux.h"
+
+namespace ns3 {
+
+/*
+ * The reference lookups below walk all the endpoints in allocation order,
+ * as Ipv4EndPointDemux and Ipv6EndPointDemux did before they were indexed.
+ */
+
+/**
+ * \param endPoints all the endpoints, in allocation order
+ * \param daddr destination address
+ * \param dport destination port
+ * \param saddr source address
+ * \param sport source port
+ * \param incomingInterface the incoming interface
+ * \return the most matching endpoints
+ */
+static Ipv4EndPointDemux::EndPoints
+ReferenceLookup (Ipv4EndPointDemux::EndPoints endPoints,
+                 Ipv4Address daddr, uint16_t dport, Ipv4Address saddr, uint16_t sport,
+                 Ptr<Ipv4Interface> incomingInterface)
+{
+  Ipv4EndPointDemux::EndPoints retval1, retval2, retval3, retval4;
+  for (Ipv4EndPointDemux::EndPointsI i = endPoints.begin (); i != endPoints.end (); i++)
+    {
+      Ipv4EndPoint* endP = *i;
+      if (!endP->IsRxEnabled () || endP->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      if (endP->GetBoundNetDevice () && endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+        {
+          continue;
+        }
+      bool subnetDirected = false;
+      Ipv4Address incomingInterfaceAddr = daddr;
+      for (uint32_t j = 0; j < incomingInterface->GetNAddresses (); j++)
+        {
+          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (j);
+          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ())
+              && daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+            {
+              subnetDirected = true;
+              incomingInterfaceAddr = addr.GetLocal ();
+            }
+        }
+      bool isBroadcast = daddr.IsBroadcast () || subnetDirected;
+      bool localWildCard = endP->GetLocalAddress () == Ipv4Address::GetAny ();
+      bool localExact = endP->GetLocalAddress () == daddr;
+      if (isBroadcast && !localWildCard)
+        {
+          localExact = endP->GetLocalAddress () == incomingInterfaceAddr;
+        }
+      if (!(localExact || localWildCard))
+        {
+          continue;
+        }
+      bool peerExact = endP->GetPeerPort () == sport;
+      bool peerWildCard = endP->GetPeerPort () == 0;
+      bool remoteExact = endP->GetPeerAddress () == saddr;
+      bool remoteWildCard = endP->GetPeerAddress () == Ipv4Address::GetAny ();
+      if (!(peerExact || peerWildCard) || !(remoteExact || remoteWildCard))
+        {
+          continue;
+        }
+      if (localWildCard && peerWildCard && remoteWildCard)
+        {
+          retval1.push_back (endP);
+        }
+      if ((localExact || (isBroadcast && localWildCard)) && peerWildCard && remoteWildCard)
+        {
+          retval2.push_back (endP);
+        }
+      if (localWildCard && peerExact && remoteExact)
+        {
+          retval3.push_back (endP);
+        }
+      if (localExact && peerExact && remoteExact)
+        {
+          retval4.push_back (endP);
+        }
+    }
+  if (!retval4.empty ())
+    {
+      return retval4;
+    }
+  if (!retval3.empty ())
+    {
+      return retval3;
+    }
+  if (!retval2.empty ())
+    {
+      return retval2;
+    }
+  return retval1;
+}
+
+/**
+ * \param endPoints all the endpoints, in allocation order
+ * \param daddr destination address
+ * \param dport destination port
+ * \param saddr source address
+ * \param sport source port
+ * \return the exact or most generic endpoint
+ */
+template <typename EndPoints, typename Address>
+static typename EndPoints::value_type
+ReferenceSimpleLookup (EndPoints endPoints,
+                       Address daddr, uint16_t dport, Address saddr, uint16_t sport)
+{
+  uint32_t genericity = 3;
+  typename EndPoints::value_type generic = 0;
+  for (typename EndPoints::iterator i = endPoints.begin (); i != endPoints.end (); i++)
+    {
+      if ((*i)->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      if ((*i)->GetLocalAddress () == daddr && (*i)->GetPeerPort () == sport
+          && (*i)->GetPeerAddress () == saddr)
+        {
+          return *i;
+        }
+      uint32_t tmp = 0;
+      if ((*i)->GetLocalAddress () == Address::GetAny ())
+        {
+          tmp++;
+        }
+      if ((*i)->GetPeerAddress () == Address::GetAny ())
+        {
+          tmp++;
+        }
+      if (tmp < genericity)
+        {
+          generic = *i;
+          genericity = tmp;
+        }
+    }
+  return generic;
+}
+
+/**
+ * \param endPoints all the endpoints, in allocation order
+ * \param daddr destination address
+ * \param dport destination port
+ * \param saddr source address
+ * \param sport source port
+ * \param incomingInterface the incoming interface
+ * \return the most matching endpoints
+ */
+static Ipv6EndPointDemux::EndPoints
+ReferenceLookup (Ipv6EndPointDemux::EndPoints endPoints,
+                 Ipv6Address daddr, uint16_t dport, Ipv6Address saddr, uint16_t sport,
+                 Ptr<Ipv6Interface> incomingInterface)
+{
+  Ipv6EndPointDemux::EndPoints retval1, retval2, retval3, retval4;
+  for (Ipv6EndPointDemux::EndPointsI i = endPoints.begin (); i != endPoints.end (); i++)
+    {
+      Ipv6EndPoint* endP = *i;
+      if (!endP->IsRxEnabled () || endP->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      if (endP->GetBoundNetDevice ()
+          && (!incomingInterface || endP->GetBoundNetDevice () != incomingInterface->GetDevice ()))
+        {
+          continue;
+        }
+      bool localWildCard = endP->GetLocalAddress () == Ipv6Address::GetAny ();
+      bool localExact = endP->GetLocalAddress () == daddr;
+      bool localAllRouters = endP->GetLocalAddress () == Ipv6Address::GetAllRoutersMulticast ();
+      if (!(localExact || localWildCard))
+        {
+          continue;
+        }
+      bool peerExact = endP->GetPeerPort () == sport;
+      bool peerWildCard = endP->GetPeerPort () == 0;
+      bool remoteExact = endP->GetPeerAddress () == saddr;
+      bool remoteWildCard = endP->GetPeerAddress () == Ipv6Address::GetAny ();
+      if (!(peerExact || peerWildCard) || !(remoteExact || remoteWildCard))
+        {
+          continue;
+        }
+      if (localWildCard && peerWildCard && remoteWildCard)
+        {
+          retval1.push_back (endP);
+        }
+      if ((localExact || localAllRouters) && peerWildCard && remoteWildCard)
+        {
+          retval2.push_back (endP);
+        }
+      if (localWildCard && peerExact && remoteExact)
+        {
+          retval3.push_back (endP);
+        }
+      if (localExact && peerExact && remoteExact)
+        {
+          retval4.push_back (endP);
+        }
+    }
+  if (!retval4.empty ())
+    {
+      return retval4;
+    }
+  if (!retval3.empty ())
+    {
+      return retval3;
+    }
+  if (!retval2.empty ())
+    {
+      return retval2;
+    }
+  return retval1;
+}
+
+/**
+ * \param endPoints all the endpoints, in allocation order
+ * \param address local address
+ * \param port local port
+ * \return true if an endpoint is bound to \p address and \p port
+ */
+template <typename EndPoints, typename Address>
+static bool
+ReferenceLookupLocal (EndPoints endPoints, Address address, uint16_t port)
+{
+  for (typename EndPoints::iterator i = endPoints.begin (); i != endPoints.end (); i++)
+    {
+      if ((*i)->GetLocalPort () == port && (*i)->GetLocalAddress () == address)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+/**
+ * \param endPoints all the endpoints, in allocation order
+ * \param port local port
+ * \return true if an endpoint is bound to \p port
+ */
+template <typename EndPoints>
+static bool
+ReferenceLookupPortLocal (EndPoints endPoints, uint16_t port)
+{
+  for (typename EndPoints::iterator i = endPoints.begin (); i != endPoints.end (); i++)
+    {
+      if ((*i)->GetLocalPort () == port)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+/**
+ * \param endPoints all the endpoints, in allocation order
+ * \param localAddress local address
+ * \param localPort local port
+ * \param peerAddress peer address
+ * \param peerPort peer port
+ * \return true if an endpoint has this four-tuple
+ */
+template <typename EndPoints, typename Address>
+static bool
+ReferenceLookupFourTuple (EndPoints endPoints, Address localAddress, uint16_t localPort,
+                          Address peerAddress, uint16_t peerPort)
+{
+  for (typename EndPoints::iterator i = endPoints.begin (); i != endPoints.end (); i++)
+    {
+      if ((*i)->GetLocalPort () == localPort && (*i)->GetLocalAddress () == localAddress
+          && (*i)->GetPeerPort () == peerPort && (*i)->GetPeerAddress () == peerAddress)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the lookups of Ipv4EndPointDemux against a walk of all the
+ * endpoints, while endpoints are allocated, changed and deallocated.
+ */
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Check the IPv4 endpoint lookups against a walk of all the endpoints")
+{
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+  Ipv4EndPointDemux demux;
+
+  Ptr<NetDevice> devices[2] = { CreateObject<SimpleNetDevice> (), CreateObject<SimpleNetDevice> () };
+  Ptr<Ipv4Interface> interfaces[2];
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      interfaces[i] = CreateObject<Ipv4Interface> ();
+      interfaces[i]->SetDevice (devices[i]);
+    }
+  interfaces[0]->AddAddress (Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.255.255.0")));
+  interfaces[1]->AddAddress (Ipv4InterfaceAddress (Ipv4Address ("10.0.1.1"), Ipv4Mask ("255.255.255.0")));
+  interfaces[1]->AddAddress (Ipv4InterfaceAddress (Ipv4Address ("10.0.2.1"), Ipv4Mask ("255.255.255.0")));
+
+  const char *local[] = { "0.0.0.0", "10.0.0.1", "10.0.1.1", "10.0.2.1", "255.255.255.255" };
+  const char *destination[] = { "10.0.0.1", "10.0.1.1", "10.0.2.1", "10.0.0.255", "10.0.1.255",
+                                "10.0.2.255", "255.255.255.255", "10.0.0.7" };
+  const char *peer[] = { "0.0.0.0", "10.0.0.9", "10.0.1.9" };
+  const uint16_t ports[] = { 0, 7, 8 };
+
+  std::vector<Ipv4EndPoint *> endPoints;
+  for (uint32_t round = 0; round < 1500; round++)
+    {
+      Ipv4Address address (local[x->GetInteger (0, 4)]);
+      uint16_t port = x->GetInteger (1, 3);
+      Ipv4Address peerAddress (peer[x->GetInteger (0, 2)]);
+      uint16_t peerPort = ports[x->GetInteger (0, 2)];
+      Ipv4EndPoint *endPoint = 0;
+      switch (x->GetInteger (0, 12))
+        {
+        case 0:
+          endPoint = demux.Allocate ();
+          break;
+        case 1:
+          endPoint = demux.Allocate (address);
+          break;
+        case 2:
+          {
+            bool duplicate = ReferenceLookupLocal (demux.GetAllEndPoints (), Ipv4Address::GetAny (), port);
+            endPoint = demux.Allocate (port);
+            NS_TEST_ASSERT_MSG_EQ ((endPoint == 0), duplicate, "Wrong duplicate port");
+          }
+          break;
+        case 3:
+          {
+            bool duplicate = ReferenceLookupLocal (demux.GetAllEndPoints (), address, port);
+            endPoint = demux.Allocate (address, port);
+            NS_TEST_ASSERT_MSG_EQ ((endPoint == 0), duplicate, "Wrong duplicate address and port");
+          }
+          break;
+        case 4:
+        case 5:
+          {
+            bool duplicate = ReferenceLookupFourTuple (demux.GetAllEndPoints (), address, port,
+                                                       peerAddress, peerPort);
+            endPoint = demux.Allocate (address, port, peerAddress, peerPort);
+            NS_TEST_ASSERT_MSG_EQ ((endPoint == 0), duplicate, "Wrong duplicate four-tuple");
+          }
+          break;
+        case 6:
+        case 7:
+          if (!endPoints.empty ())
+            {
+              uint32_t i = x->GetInteger (0, endPoints.size () - 1);
+              demux.DeAllocate (endPoints[i]);
+              endPoints[i] = endPoints.back ();
+              endPoints.pop_back ();
+            }
+          break;
+        case 8:
+        case 9:
+          if (!endPoints.empty ())
+            {
+              endPoints[x->GetInteger (0, endPoints.size () - 1)]->SetPeer (peerAddress, peerPort);
+            }
+          break;
+        case 10:
+          if (!endPoints.empty ())
+            {
+              endPoints[x->GetInteger (0, endPoints.size () - 1)]->SetLocalAddress (address);
+            }
+          break;
+        case 11:
+          if (!endPoints.empty ())
+            {
+              endPoints[x->GetInteger (0, endPoints.size () - 1)]->SetRxEnabled (x->GetInteger (0, 3) != 0);
+            }
+          break;
+        case 12:
+          if (!endPoints.empty ())
+            {
+              uint32_t device = x->GetInteger (0, 3);
+              endPoints[x->GetInteger (0, endPoints.size () - 1)]->BindToNetDevice (device < 2 ? devices[device] : 0);
+            }
+          break;
+        }
+      if (endPoint != 0)
+        {
+          endPoints.push_back (endPoint);
+        }
+
+      Ipv4EndPointDemux::EndPoints all = demux.GetAllEndPoints ();
+      NS_TEST_ASSERT_MSG_EQ (all.size (), endPoints.size (), "Wrong number of endpoints");
+      for (uint32_t i = 0; i < 8; i++)
+        {
+          Ipv4Address daddr (destination[x->GetInteger (0, 7)]);
+          uint16_t dport = x->GetInteger (1, 3);
+          Ipv4Address saddr (peer[x->GetInteger (1, 2)]);
+          uint16_t sport = ports[x->GetInteger (0, 2)];
+          Ptr<Ipv4Interface> interface = interfaces[x->GetInteger (0, 1)];
+          bool found = ReferenceLookup (all, daddr, dport, saddr, sport, interface)
+            == demux.Lookup (daddr, dport, saddr, sport, interface);
+          NS_TEST_ASSERT_MSG_EQ (found, true, "Wrong Lookup");
+          NS_TEST_ASSERT_MSG_EQ (demux.SimpleLookup (daddr, dport, saddr, sport),
+                                 ReferenceSimpleLookup (all, daddr, dport, saddr, sport),
+                                 "Wrong SimpleLookup");
+          Ipv4Address address (local[x->GetInteger (0, 4)]);
+          NS_TEST_ASSERT_MSG_EQ (demux.LookupLocal (address, dport),
+                                 ReferenceLookupLocal (all, address, dport), "Wrong LookupLocal");
+          NS_TEST_ASSERT_MSG_EQ (demux.LookupPortLocal (dport),
+                                 ReferenceLookupPortLocal (all, dport), "Wrong LookupPortLocal");
+        }
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the lookups of Ipv6EndPointDemux against a walk of all the
+ * endpoints, while endpoints are allocated, changed and deallocated.
+ */
+class Ipv6EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv6EndPointDemuxTestCase::Ipv6EndPointDemuxTestCase ()
+  : TestCase ("Check the IPv6 endpoint lookups against a walk of all the endpoints")
+{
+}
+
+void
+Ipv6EndPointDemuxTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+  Ipv6EndPointDemux demux;
+
+  Ptr<NetDevice> devices[2] = { CreateObject<SimpleNetDevice> (), CreateObject<SimpleNetDevice> () };
+  Ptr<Ipv6Interface> interfaces[3];
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      interfaces[i] = CreateObject<Ipv6Interface> ();
+      interfaces[i]->SetDevice (devices[i]);
+    }
+
+  const char *local[] = { "::", "2001:1::1", "2001:2::1", "ff02::2" };
+  const char *peer[] = { "::", "2001:1::9", "2001:2::9" };
+  const uint16_t ports[] = { 0, 7, 8 };
+
+  std::vector<Ipv6EndPoint *> endPoints;
+  for (uint32_t round = 0; round < 1500; round++)
+    {
+      Ipv6Address address (local[x->GetInteger (0, 3)]);
+      uint16_t port = x->GetInteger (1, 3);
+      Ipv6Address peerAddress (peer[x->GetInteger (0, 2)]);
+      uint16_t peerPort = ports[x->GetInteger (0, 2)];
+      Ipv6EndPoint *endPoint = 0;
+      switch (x->GetInteger (0, 12))
+        {
+        case 0:
+          endPoint = demux.Allocate ();
+          break;
+        case 1:
+          endPoint = demux.Allocate (address);
+          break;
+        case 2:
+          {
+            bool duplicate = ReferenceLookupLocal (demux.GetEndPoints (), Ipv6Address::GetAny (), port);
+            endPoint = demux.Allocate (port);
+            NS_TEST_ASSERT_MSG_EQ ((endPoint == 0), duplicate, "Wrong duplicate port");
+          }
+          break;
+        case 3:
+          {
+            bool duplicate = ReferenceLookupLocal (demux.GetEndPoints (), address, port);
+            endPoint = demux.Allocate (address, port);
+            NS_TEST_ASSERT_MSG_EQ ((endPoint == 0), duplicate, "Wrong duplicate address and port");
+          }
+          break;
+        case 4:
+        case 5:
+          {
+            bool duplicate = ReferenceLookupFourTuple (demux.GetEndPoints (), address, port,
+                                                       peerAddress, peerPort);
+            endPoint = demux.Allocate (address, port, peerAddress, peerPort);
+            NS_TEST_ASSERT_MSG_EQ ((endPoint == 0), duplicate, "Wrong duplicate four-tuple");
+          }
+          break;
+        case 6:
+        case 7:
+          if (!endPoints.empty ())
+            {
+              uint32_t i = x->GetInteger (0, endPoints.size () - 1);
+              demux.DeAllocate (endPoints[i]);
+              endPoints[i] = endPoints.back ();
+              endPoints.pop_back ();
+            }
+          break;
+        case 8:
+        case 9:
+          if (!endPoints.empty ())
+            {
+              endPoints[x->GetInteger (0, endPoints.size () - 1)]->SetPeer (peerAddress, peerPort);
+            }
+          break;
+        case 10:
+          if (!endPoints.empty ())
+            {
+              endPoints[x->GetInteger (0, endPoints.size () - 1)]->SetLocalAddress (address);
+            }
+          break;
+        case 11:
+          if (!endPoints.empty ())
+            {
+              endPoints[x->GetInteger (0, endPoints.size () - 1)]->SetRxEnabled (x->GetInteger (0, 3) != 0);
+            }
+          break;
+        case 12:
+          if (!endPoints.empty ())
+            {
+              uint32_t device = x->GetInteger (0, 3);
+              endPoints[x->GetInteger (0, endPoints.size () - 1)]->BindToNetDevice (device < 2 ? devices[device] : 0);
+            }
+          break;
+        }
+      if (endPoint != 0)
+        {
+          endPoints.push_back (endPoint);
+        }
+
+      Ipv6EndPointDemux::EndPoints all = demux.GetEndPoints ();
+      NS_TEST_ASSERT_MSG_EQ (all.size (), endPoints.size (), "Wrong number of endpoints");
+      for (uint32_t i = 0; i < 8; i++)
+        {
+          Ipv6Address daddr (local[x->GetInteger (1, 3)]);
+          uint16_t dport = x->GetInteger (1, 3);
+          Ipv6Address saddr (peer[x->GetInteger (1, 2)]);
+          uint16_t sport = ports[x->GetInteger (0, 2)];
+          Ptr<Ipv6Interface> interface = interfaces[x->GetInteger (0, 2)];
+          bool found = ReferenceLookup (all, daddr, dport, saddr, sport, interface)
+            == demux.Lookup (daddr, dport, saddr, sport, interface);
+          NS_TEST_ASSERT_MSG_EQ (found, true, "Wrong Lookup");
+          NS_TEST_ASSERT_MSG_EQ (demux.SimpleLookup (daddr, dport, saddr, sport),
+                                 ReferenceSimpleLookup (all, daddr, dport, saddr, sport),
+                                 "Wrong SimpleLookup");
+          Ipv6Address address (local[x->GetInteger (0, 3)]);
+          NS_TEST_ASSERT_MSG_EQ (demux.LookupLocal (address, dport),
+                                 ReferenceLookupLocal (all, address, dport), "Wrong LookupLocal");
+          NS_TEST_ASSERT_MSG_EQ (demux.LookupPortLocal (dport),
+                                 ReferenceLookupPortLocal (all, dport), "Wrong LookupPortLocal");
+        }
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the lookups in a demux holding 10000 connections to the
+ * same listening port, as on a server, and that they do not walk the
+ * connections: a lookup must cost no more with 10000 connections than
+ * with 100.
+ */
+class EndPointDemuxScaleTestCase : public TestCase
+{
+public:
+  EndPointDemuxScaleTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * \param connections number of connections
+   * \param lookups number of lookups to time
+   * \return the time per lookup, in nanoseconds
+   */
+  double RunLookups (uint32_t connections, uint32_t lookups);
+};
+
+EndPointDemuxScaleTestCase::EndPointDemuxScaleTestCase ()
+  : TestCase ("Check the lookups among 10000 connections")
+{
+}
+
+double
+EndPointDemuxScaleTestCase::RunLookups (uint32_t connections, uint32_t lookups)
+{
+  Ipv4EndPointDemux demux;
+  Ptr<Ipv4Interface> interface = CreateObject<Ipv4Interface> ();
+  interface->AddAddress (Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.0.0.0")));
+  Ipv4Address server ("10.0.0.1");
+  Ipv4EndPoint *listener = demux.Allocate (server, 80);
+  std::vector<Ipv4EndPoint *> endPoints;
+  for (uint32_t i = 0; i < connections; i++)
+    {
+      endPoints.push_back (demux.Allocate (server, 80, Ipv4Address (0x0b000000 + i), 1024 + i % 16));
+    }
+  Ipv4Address unknown ("12.0.0.1");
+  NS_TEST_EXPECT_MSG_EQ (demux.Lookup (server, 80, unknown, 1024, interface).front (), listener,
+                         "A new connection goes to the listener");
+  NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (server, 80, unknown, 1024), endPoints.front (),
+                         "The first connection is the least generic endpoint");
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  uint32_t found = 0;
+  for (uint32_t i = 0; i < lookups; i++)
+    {
+      uint32_t j = (i * 7919) % connections;
+      Ipv4EndPointDemux::EndPoints ret = demux.Lookup (server, 80, Ipv4Address (0x0b000000 + j),
+                                                      1024 + j % 16, interface);
+      found += ret.size () == 1 && ret.front () == endPoints[j];
+    }
+  int64_t ms = clock.End ();
+  NS_TEST_EXPECT_MSG_EQ (found, lookups, "Wrong connection found");
+  return ms * 1e6 / lookups;
+}
+
+void
+EndPointDemuxScaleTestCase::DoRun (void)
+{
+  double small = RunLookups (100, 100000);
+  double large = RunLookups (10000, 100000);
+  // Walking the endpoints would cost about 100 times more; only a large
+  // margin is checked, for the time measures to be reliable enough
+  NS_TEST_EXPECT_MSG_LT (large, 10 * small + 1000, "Lookups among 10000 connections are too slow");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 and IPv6 endpoint demux TestSuite
+ */
+static class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite ()
+    : TestSuite ("end-point-demux", UNIT)
+  {
+    AddTestCase (new Ipv4EndPointDemuxTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv6EndPointDemuxTestCase, TestCase::QUICK);
+    AddTestCase (new EndPointDemuxScaleTestCase, TestCase::QUICK);
+  }
+} g_endPointDemuxTestSuite;
+
+} // namespace ns3
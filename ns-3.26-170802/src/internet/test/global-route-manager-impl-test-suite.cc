@@ -26,7 +26,10 @@
 #include "ns3/global-route-manager-impl.h"
 #include "ns3/candidate-queue.h"
 #include "ns3/simulator.h"
+#include "ns3/random-variable-stream.h"
 #include <cstdlib> // for rand()
+#include <list>
+#include <algorithm>
 
 using namespace ns3;
 
@@ -214,6 +217,116 @@ GlobalRouteManagerImplTestCase::DoRun (void)
 }
 
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that the CandidateQueue pops the vertices in the order of
+ * a list kept sorted by distance, network vertices first, the way the SPF
+ * computation uses it: pushes, pops, and decreases of the distance of a
+ * queued vertex followed by a Reorder.
+ */
+class CandidateQueueTestCase : public TestCase
+{
+public:
+  CandidateQueueTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \param v1 first vertex
+   * \param v2 second vertex
+   * \returns true if v1 is popped before v2 when pushed before it
+   */
+  static bool Compare (const SPFVertex *v1, const SPFVertex *v2);
+};
+
+CandidateQueueTestCase::CandidateQueueTestCase ()
+  : TestCase ("CandidateQueue pops the vertices of a sorted list")
+{
+}
+
+bool
+CandidateQueueTestCase::Compare (const SPFVertex *v1, const SPFVertex *v2)
+{
+  if (v1->GetDistanceFromRoot () != v2->GetDistanceFromRoot ())
+    {
+      return v1->GetDistanceFromRoot () < v2->GetDistanceFromRoot ();
+    }
+  return v1->GetVertexType () == SPFVertex::VertexNetwork
+    && v2->GetVertexType () == SPFVertex::VertexRouter;
+}
+
+void
+CandidateQueueTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+
+  CandidateQueue candidate;
+  std::list<SPFVertex *> reference;
+  uint32_t id = 1;
+  for (uint32_t step = 0; step < 5000; step++)
+    {
+      uint32_t action = rng->GetInteger (0, 9);
+      if (action < 5 || reference.empty ())
+        {
+          SPFVertex *v = new SPFVertex;
+          v->SetVertexId (Ipv4Address (id++));
+          v->SetVertexType (rng->GetInteger (0, 1) ? SPFVertex::VertexRouter : SPFVertex::VertexNetwork);
+          v->SetDistanceFromRoot (rng->GetInteger (0, 30));
+          candidate.Push (v);
+          reference.insert (std::upper_bound (reference.begin (), reference.end (), v, &Compare), v);
+        }
+      else if (action < 8)
+        {
+          SPFVertex *v = candidate.Pop ();
+          NS_TEST_ASSERT_MSG_EQ (v, reference.front (), "Wrong vertex popped at step " << step);
+          reference.pop_front ();
+          delete v;
+        }
+      else if (action < 9)
+        {
+          std::list<SPFVertex *>::iterator i = reference.begin ();
+          std::advance (i, rng->GetInteger (0, reference.size () - 1));
+          SPFVertex *v = *i;
+          NS_TEST_ASSERT_MSG_EQ (candidate.Find (v->GetVertexId ()), v, "Vertex not found at step " << step);
+          // Reorder (v) is for the shorter paths found to a queued vertex
+          if (v->GetDistanceFromRoot () > 0)
+            {
+              v->SetDistanceFromRoot (v->GetDistanceFromRoot () - std::min<uint32_t> (v->GetDistanceFromRoot (),
+                                                                                       rng->GetInteger (1, 5)));
+              candidate.Reorder (v);
+              reference.sort (&Compare);
+            }
+        }
+      else
+        {
+          for (std::list<SPFVertex *>::iterator i = reference.begin (); i != reference.end (); i++)
+            {
+              if (rng->GetInteger (0, 3) == 0)
+                {
+                  (*i)->SetDistanceFromRoot (rng->GetInteger (0, 30));
+                }
+            }
+          candidate.Reorder ();
+          reference.sort (&Compare);
+        }
+      NS_TEST_ASSERT_MSG_EQ (candidate.Size (), reference.size (), "Wrong size at step " << step);
+      NS_TEST_ASSERT_MSG_EQ (candidate.Top (), (reference.empty () ? 0 : reference.front ()),
+                             "Wrong top at step " << step);
+    }
+  NS_TEST_ASSERT_MSG_EQ (candidate.Find (Ipv4Address (id)), 0, "Found a vertex never pushed");
+  while (!reference.empty ())
+    {
+      SPFVertex *v = candidate.Pop ();
+      NS_TEST_ASSERT_MSG_EQ (v, reference.front (), "Wrong vertex popped at the end");
+      reference.pop_front ();
+      delete v;
+    }
+  NS_TEST_ASSERT_MSG_EQ (candidate.Empty (), true, "Queue not empty at the end");
+}
+
 static class GlobalRouteManagerImplTestSuite : public TestSuite
 {
 public:
@@ -221,5 +334,6 @@ public:
     : TestSuite ("global-route-manager-impl", UNIT)
   {
     AddTestCase (new GlobalRouteManagerImplTestCase (), TestCase::QUICK);
+    AddTestCase (new CandidateQueueTestCase (), TestCase::QUICK);
   }
 } g_globalRoutingManagerImplTestSuite;
@@ -15,6 +15,7 @@
  */
 
 #include <vector>
+#include <sstream>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
 #include "ns3/inet-socket-address.h"
@@ -42,6 +43,8 @@
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/ipv4-global-routing.h"
 #include "ns3/bridge-helper.h"
+#include "ns3/global-value.h"
+#include "ns3/random-variable-stream.h"
 
 using namespace ns3;
 
@@ -1167,6 +1170,179 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+// Parallel and incremental SPF test:
+//   A random mesh of routers with point-to-point links, a LAN among three
+//   of them, stub routers attached to some of them, and a separate pair of
+//   routers.  The routes computed by several threads, and the routes
+//   recomputed incrementally as links go down and up, are checked against
+//   the routes computed by one thread from scratch.
+class Ipv4GlobalRoutingSpfTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingSpfTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+
+  /**
+   * \brief Connect two nodes with a point-to-point link.
+   * \param a a node
+   * \param b another node
+   * \returns the interface of the link on node a
+   */
+  uint32_t Connect (Ptr<Node> a, Ptr<Node> b);
+
+  /**
+   * \returns the routes of each node, printed
+   */
+  std::vector<std::string> GetRoutes (void) const;
+
+  /**
+   * \brief Recompute the routes, then compute them again from scratch
+   * with one thread, and compare.
+   * \param incremental whether the routes are recomputed incrementally
+   * \param threads the number of threads computing them
+   * \param step the name of the step
+   */
+  void CheckRecompute (bool incremental, uint32_t threads, std::string step);
+
+  NodeContainer m_nodes;            //!< All the routers
+  Ipv4AddressHelper m_addresses;    //!< The addresses of the links
+  Ptr<UniformRandomVariable> m_metrics; //!< The metrics of the links
+  std::vector<std::pair<Ptr<Node>, uint32_t> > m_meshLinks; //!< The mesh links, by node and interface
+  std::pair<Ptr<Node>, uint32_t> m_stubLink;   //!< The link of a stub router
+  std::pair<Ptr<Node>, uint32_t> m_islandLink; //!< The link of the separate pair
+};
+
+Ipv4GlobalRoutingSpfTestCase::Ipv4GlobalRoutingSpfTestCase ()
+  : TestCase ("Parallel and incremental SPF computations")
+{
+}
+
+uint32_t
+Ipv4GlobalRoutingSpfTestCase::Connect (Ptr<Node> a, Ptr<Node> b)
+{
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  SimpleNetDeviceHelper simpleHelper;
+  simpleHelper.SetNetDevicePointToPointMode (true);
+  NetDeviceContainer net = simpleHelper.Install (NodeContainer (a, b), channel);
+  Ipv4InterfaceContainer interfaces = m_addresses.Assign (net);
+  m_addresses.NewNetwork ();
+  // Random metrics, so that the shortest paths are shorter than the others
+  // and need reordering the candidates: the SPF computation does not
+  // support equal cost paths through a LAN
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      interfaces.Get (i).first->SetMetric (interfaces.Get (i).second, m_metrics->GetInteger (1, 60000));
+    }
+  return interfaces.Get (0).second;
+}
+
+void
+Ipv4GlobalRoutingSpfTestCase::DoSetup (void)
+{
+  uint32_t meshRouters = 20;
+  uint32_t stubRouters = 6;
+  m_nodes.Create (meshRouters + stubRouters + 2);
+
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (m_nodes);
+  m_addresses.SetBase ("10.0.0.0", "255.255.255.252");
+
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+  m_metrics = CreateObject<UniformRandomVariable> ();
+  m_metrics->SetStream (2);
+  // A random tree, plus random links
+  for (uint32_t i = 1; i < meshRouters + 12; i++)
+    {
+      uint32_t a = i < meshRouters ? i : rng->GetInteger (0, meshRouters - 1);
+      uint32_t b = i < meshRouters ? rng->GetInteger (0, i - 1) : rng->GetInteger (0, meshRouters - 1);
+      if (a != b)
+        {
+          Ptr<Node> node = m_nodes.Get (a);
+          m_meshLinks.push_back (std::make_pair (node, Connect (node, m_nodes.Get (b))));
+        }
+    }
+  for (uint32_t i = 0; i < stubRouters; i++)
+    {
+      Ptr<Node> node = m_nodes.Get (meshRouters + i);
+      m_stubLink = std::make_pair (node, Connect (node, m_nodes.Get (rng->GetInteger (0, meshRouters - 1))));
+    }
+  Ptr<Node> node = m_nodes.Get (meshRouters + stubRouters);
+  m_islandLink = std::make_pair (node, Connect (node, m_nodes.Get (meshRouters + stubRouters + 1)));
+
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  SimpleNetDeviceHelper simpleHelper;
+  NetDeviceContainer net = simpleHelper.Install (NodeContainer (m_nodes.Get (0), m_nodes.Get (1), m_nodes.Get (2)),
+                                                 channel);
+  m_addresses.SetBase ("10.1.0.0", "255.255.255.0");
+  m_addresses.Assign (net);
+}
+
+std::vector<std::string>
+Ipv4GlobalRoutingSpfTestCase::GetRoutes (void) const
+{
+  std::vector<std::string> routes;
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<Ipv4GlobalRouting> globalRouting = m_nodes.Get (i)->GetObject<Ipv4> ()
+        ->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+      std::ostringstream oss;
+      for (uint32_t j = 0; j < globalRouting->GetNRoutes (); j++)
+        {
+          oss << *globalRouting->GetRoute (j) << std::endl;
+        }
+      routes.push_back (oss.str ());
+    }
+  return routes;
+}
+
+void
+Ipv4GlobalRoutingSpfTestCase::CheckRecompute (bool incremental, uint32_t threads, std::string step)
+{
+  GlobalValue::Bind ("GlobalRoutingIncrementalSpf", BooleanValue (incremental));
+  GlobalValue::Bind ("GlobalRoutingSpfThreads", UintegerValue (threads));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::vector<std::string> routes = GetRoutes ();
+
+  GlobalValue::Bind ("GlobalRoutingIncrementalSpf", BooleanValue (false));
+  GlobalValue::Bind ("GlobalRoutingSpfThreads", UintegerValue (1));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::vector<std::string> expected = GetRoutes ();
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (routes[i], expected[i], step << ": wrong routes on node " << i);
+    }
+}
+
+void
+Ipv4GlobalRoutingSpfTestCase::DoRun (void)
+{
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  CheckRecompute (false, 4, "Four threads");
+  CheckRecompute (true, 1, "No change");
+  m_meshLinks[3].first->GetObject<Ipv4> ()->SetDown (m_meshLinks[3].second);
+  CheckRecompute (true, 1, "Mesh link down");
+  m_meshLinks[25].first->GetObject<Ipv4> ()->SetDown (m_meshLinks[25].second);
+  CheckRecompute (true, 3, "Another mesh link down, three threads");
+  m_stubLink.first->GetObject<Ipv4> ()->SetDown (m_stubLink.second);
+  CheckRecompute (true, 1, "Stub link down");
+  m_islandLink.first->GetObject<Ipv4> ()->SetDown (m_islandLink.second);
+  CheckRecompute (true, 1, "Separate link down");
+  m_meshLinks[3].first->GetObject<Ipv4> ()->SetUp (m_meshLinks[3].second);
+  m_meshLinks[25].first->GetObject<Ipv4> ()->SetUp (m_meshLinks[25].second);
+  m_stubLink.first->GetObject<Ipv4> ()->SetUp (m_stubLink.second);
+  m_islandLink.first->GetObject<Ipv4> ()->SetUp (m_islandLink.second);
+  CheckRecompute (true, 2, "Links up");
+
+  Simulator::Destroy ();
+}
+
 class Ipv4GlobalRoutingTestSuite : public TestSuite
 {
 public:
@@ -1184,6 +1360,7 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
     AddTestCase (new TwoBridgeTest, TestCase::QUICK);
     AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
     AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingSpfTestCase, TestCase::QUICK);
   }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -0,0 +1,497 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Check the indexed route lookups of Ipv4StaticRouting and
+// Ipv4GlobalRouting against a walk of the whole routing table.
+
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-interface-address.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-prefix-trie.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+/**
+ * \param x a random variable
+ * \return an address of 10.0.0.0/8, with bits which often collide
+ */
+static Ipv4Address
+CreateAddress (Ptr<UniformRandomVariable> x)
+{
+  static const uint8_t bytes[] = { 0, 1, 2, 128, 129, 255 };
+  uint32_t address = 10;
+  for (int i = 0; i < 3; i++)
+    {
+      address = (address << 8) | bytes[x->GetInteger (0, 5)];
+    }
+  return Ipv4Address (address);
+}
+
+/**
+ * \param x a random variable
+ * \return a prefix length, from 0 to 32
+ */
+static uint8_t
+CreateLength (Ptr<UniformRandomVariable> x)
+{
+  return x->GetInteger (0, 4) == 0 ? x->GetInteger (0, 8) : x->GetInteger (8, 32);
+}
+
+/**
+ * \param length a prefix length
+ * \return the mask of the prefix length
+ */
+static Ipv4Mask
+CreateMask (uint8_t length)
+{
+  return Ipv4Mask (length == 0 ? 0 : 0xffffffffU << (32 - length));
+}
+
+/**
+ * \param a a route
+ * \param b another route
+ * \return true if both routes are null, or go to the same next hop
+ */
+static bool
+IsSameRoute (Ptr<Ipv4Route> a, Ptr<Ipv4Route> b)
+{
+  if (a == 0 || b == 0)
+    {
+      return a == b;
+    }
+  return a->GetDestination () == b->GetDestination ()
+         && a->GetGateway () == b->GetGateway ()
+         && a->GetOutputDevice () == b->GetOutputDevice ();
+}
+
+/**
+ * \param ipv4 the IPv4 stack of the node
+ * \param route a routing table entry
+ * \return the route of the entry, as built by the routing protocols
+ */
+static Ptr<Ipv4Route>
+CreateRoute (Ptr<Ipv4> ipv4, const Ipv4RoutingTableEntry &route)
+{
+  Ptr<Ipv4Route> rtentry = Create<Ipv4Route> ();
+  rtentry->SetDestination (route.GetDest ());
+  rtentry->SetGateway (route.GetGateway ());
+  rtentry->SetOutputDevice (ipv4->GetNetDevice (route.GetInterface ()));
+  return rtentry;
+}
+
+/**
+ * \param routing a routing protocol
+ * \param dest a destination
+ * \param oif the output device, or 0
+ * \return the route returned by \p routing
+ */
+static Ptr<Ipv4Route>
+RouteOutput (Ptr<Ipv4RoutingProtocol> routing, Ipv4Address dest, Ptr<NetDevice> oif)
+{
+  Ipv4Header header;
+  header.SetDestination (dest);
+  Socket::SocketErrno err;
+  return routing->RouteOutput (Create<Packet> (), header, oif, err);
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the prefixes found by Ipv4PrefixTrie against a list of
+ * prefixes, with random insertions and removals.
+ */
+class Ipv4PrefixTrieTestCase : public TestCase
+{
+public:
+  Ipv4PrefixTrieTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4PrefixTrieTestCase::Ipv4PrefixTrieTestCase ()
+  : TestCase ("Check the prefixes matched by the prefix trie")
+{
+}
+
+void
+Ipv4PrefixTrieTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+  Ipv4PrefixTrie<uint32_t> trie;
+  // The prefixes in insertion order: prefix, mask and value
+  struct Prefix
+  {
+    Ipv4Address prefix;
+    uint8_t length;
+    uint32_t value;
+  };
+  std::vector<Prefix> prefixes;
+
+  uint8_t length;
+  NS_TEST_ASSERT_MSG_EQ (Ipv4PrefixTrie<uint32_t>::IsPrefix (Ipv4Mask ("255.255.240.0"), length), true,
+                         "Contiguous mask");
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (length), 20, "Wrong prefix length");
+  NS_TEST_ASSERT_MSG_EQ (Ipv4PrefixTrie<uint32_t>::IsPrefix (Ipv4Mask ("255.0.255.0"), length), false,
+                         "Non-contiguous mask");
+
+  for (uint32_t round = 0; round < 3000; round++)
+    {
+      if (prefixes.empty () || x->GetInteger (0, 2) != 0)
+        {
+          Prefix p;
+          p.prefix = CreateAddress (x);
+          p.length = CreateLength (x);
+          p.value = round;
+          trie.Insert (p.prefix, p.length, p.value);
+          prefixes.push_back (p);
+        }
+      else
+        {
+          uint32_t i = x->GetInteger (0, prefixes.size () - 1);
+          NS_TEST_ASSERT_MSG_EQ (trie.Remove (prefixes[i].prefix, prefixes[i].length, prefixes[i].value),
+                                 true, "Value not found");
+          NS_TEST_ASSERT_MSG_EQ (trie.Remove (prefixes[i].prefix, prefixes[i].length, prefixes[i].value),
+                                 false, "Value found after its removal");
+          prefixes.erase (prefixes.begin () + i);
+        }
+      NS_TEST_ASSERT_MSG_EQ (trie.GetSize (), prefixes.size (), "Wrong size");
+
+      for (uint32_t i = 0; i < 4; i++)
+        {
+          Ipv4Address dest = CreateAddress (x);
+          std::vector<uint32_t> expected;
+          int32_t longest = -1;
+          for (std::vector<Prefix>::const_iterator p = prefixes.begin (); p != prefixes.end (); p++)
+            {
+              if (CreateMask (p->length).IsMatch (dest, p->prefix))
+                {
+                  expected.push_back (p->value);
+                  longest = std::max (longest, static_cast<int32_t> (p->length));
+                }
+            }
+          std::vector<uint32_t> values;
+          trie.MatchAll (dest, values);
+          NS_TEST_ASSERT_MSG_EQ ((values == expected), true, "Wrong values matching " << dest);
+
+          const Ipv4PrefixTrie<uint32_t>::Values *matches[33];
+          uint8_t lengths[33];
+          uint32_t n = trie.Match (dest, matches, lengths);
+          NS_TEST_ASSERT_MSG_EQ ((n == 0), (longest == -1), "Wrong number of prefixes matching " << dest);
+          if (n > 0)
+            {
+              NS_TEST_ASSERT_MSG_EQ (static_cast<int32_t> (lengths[n - 1]), longest,
+                                     "Wrong longest prefix matching " << dest);
+            }
+        }
+    }
+  trie.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (trie.GetSize (), 0, "Values left after Clear");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Base class of the routing protocol tests: a node with three
+ * interfaces besides the loopback one.
+ */
+class Ipv4RouteLookupTestCase : public TestCase
+{
+public:
+  /**
+   * \param name the name of the test case
+   */
+  Ipv4RouteLookupTestCase (std::string name);
+protected:
+  /**
+   * \brief Create the node and its interfaces.
+   */
+  void CreateNode (void);
+
+  Ptr<Node> m_node;                 //!< The node
+  Ptr<Ipv4> m_ipv4;                 //!< The IPv4 stack of the node
+  Ptr<UniformRandomVariable> m_x;   //!< A random variable
+};
+
+Ipv4RouteLookupTestCase::Ipv4RouteLookupTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+Ipv4RouteLookupTestCase::CreateNode (void)
+{
+  m_x = CreateObject<UniformRandomVariable> ();
+  m_node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (m_node);
+  m_ipv4 = m_node->GetObject<Ipv4> ();
+  for (uint32_t i = 1; i <= 3; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      m_node->AddDevice (device);
+      uint32_t interface = m_ipv4->AddInterface (device);
+      m_ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address (0xc0a80001 + (i << 8)),
+                                                           Ipv4Mask ("/24")));
+      m_ipv4->SetUp (interface);
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the routes found by Ipv4StaticRouting against the longest
+ * match with the smallest metric in the routing table, with random
+ * routes, removals and interfaces going down.
+ */
+class Ipv4StaticRouteLookupTestCase : public Ipv4RouteLookupTestCase
+{
+public:
+  Ipv4StaticRouteLookupTestCase ();
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \param routing the routing protocol
+   * \param dest a destination
+   * \param oif the output device, or 0
+   * \return the route found by walking the routing table
+   */
+  Ptr<Ipv4Route> Lookup (Ptr<Ipv4StaticRouting> routing, Ipv4Address dest, Ptr<NetDevice> oif);
+};
+
+Ipv4StaticRouteLookupTestCase::Ipv4StaticRouteLookupTestCase ()
+  : Ipv4RouteLookupTestCase ("Check the routes found by static routing")
+{
+}
+
+Ptr<Ipv4Route>
+Ipv4StaticRouteLookupTestCase::Lookup (Ptr<Ipv4StaticRouting> routing, Ipv4Address dest,
+                                       Ptr<NetDevice> oif)
+{
+  int32_t found = -1;
+  int32_t longest = -1;
+  uint32_t shortestMetric = 0;
+  for (uint32_t i = 0; i < routing->GetNRoutes (); i++)
+    {
+      Ipv4RoutingTableEntry route = routing->GetRoute (i);
+      int32_t length = route.GetDestNetworkMask ().GetPrefixLength ();
+      uint32_t metric = routing->GetMetric (i);
+      if (!route.GetDestNetworkMask ().IsMatch (dest, route.GetDestNetwork ())
+          || (oif != 0 && oif != m_ipv4->GetNetDevice (route.GetInterface ()))
+          || length < longest)
+        {
+          continue;
+        }
+      if (length > longest || metric <= shortestMetric)
+        {
+          // A host route is never replaced by another host route
+          if (length == 32 && length == longest)
+            {
+              continue;
+            }
+          found = i;
+          longest = length;
+          shortestMetric = metric;
+        }
+    }
+  return found == -1 ? 0 : CreateRoute (m_ipv4, routing->GetRoute (found));
+}
+
+void
+Ipv4StaticRouteLookupTestCase::DoRun (void)
+{
+  CreateNode ();
+  Ipv4StaticRoutingHelper helper;
+  Ptr<Ipv4StaticRouting> routing = helper.GetStaticRouting (m_ipv4);
+
+  for (uint32_t round = 0; round < 1500; round++)
+    {
+      uint32_t action = m_x->GetInteger (0, 99);
+      uint32_t interface = m_x->GetInteger (1, 3);
+      uint32_t metric = m_x->GetInteger (0, 3);
+      Ipv4Address nextHop (0xc0a80002 + (interface << 8) + m_x->GetInteger (0, 3));
+      if (action < 55)
+        {
+          uint8_t length = CreateLength (m_x);
+          Ipv4Address network = CreateAddress (m_x).CombineMask (CreateMask (length));
+          routing->AddNetworkRouteTo (network, CreateMask (length), nextHop, interface, metric);
+        }
+      else if (action < 70)
+        {
+          routing->AddHostRouteTo (CreateAddress (m_x), nextHop, interface, metric);
+        }
+      else if (action < 72 && round < 1000)
+        {
+          // The lookup walks the whole table while such a route remains
+          routing->AddNetworkRouteTo (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.0.255.0"),
+                                      nextHop, interface, metric);
+        }
+      else if (action < 73)
+        {
+          // The routes through the interface go away
+          m_ipv4->SetDown (interface);
+          m_ipv4->SetUp (interface);
+        }
+      else if (routing->GetNRoutes () > 0)
+        {
+          routing->RemoveRoute (m_x->GetInteger (0, routing->GetNRoutes () - 1));
+        }
+
+      for (uint32_t i = 0; i < 4; i++)
+        {
+          Ipv4Address dest = CreateAddress (m_x);
+          uint32_t oifInterface = m_x->GetInteger (0, 3);
+          Ptr<NetDevice> oif = oifInterface == 0 ? 0 : m_ipv4->GetNetDevice (oifInterface);
+          NS_TEST_ASSERT_MSG_EQ (IsSameRoute (RouteOutput (routing, dest, oif), Lookup (routing, dest, oif)),
+                                 true, "Wrong route to " << dest << " in round " << round);
+        }
+    }
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the routes found by Ipv4GlobalRouting against the first
+ * matching host, network or external route in the routing table, with
+ * random routes and removals.
+ */
+class Ipv4GlobalRouteLookupTestCase : public Ipv4RouteLookupTestCase
+{
+public:
+  Ipv4GlobalRouteLookupTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4GlobalRouteLookupTestCase::Ipv4GlobalRouteLookupTestCase ()
+  : Ipv4RouteLookupTestCase ("Check the routes found by global routing")
+{
+}
+
+void
+Ipv4GlobalRouteLookupTestCase::DoRun (void)
+{
+  CreateNode ();
+  Ptr<Ipv4GlobalRouting> routing = CreateObject<Ipv4GlobalRouting> ();
+  routing->SetIpv4 (m_ipv4);
+  // The routes of each kind, in the order of the routing table
+  std::vector<Ipv4RoutingTableEntry> routes[3];
+
+  for (uint32_t round = 0; round < 1500; round++)
+    {
+      uint32_t action = m_x->GetInteger (0, 99);
+      uint32_t interface = m_x->GetInteger (1, 3);
+      Ipv4Address nextHop (0xc0a80002 + (interface << 8) + m_x->GetInteger (0, 3));
+      uint8_t length = CreateLength (m_x);
+      Ipv4Mask mask = CreateMask (length);
+      if (action < 2 && round < 1000)
+        {
+          mask = Ipv4Mask ("255.0.255.0");
+        }
+      Ipv4Address network = CreateAddress (m_x).CombineMask (mask);
+      if (action < 40)
+        {
+          routing->AddNetworkRouteTo (network, mask, nextHop, interface);
+          routes[1].push_back (Ipv4RoutingTableEntry::CreateNetworkRouteTo (network, mask, nextHop, interface));
+        }
+      else if (action < 60)
+        {
+          Ipv4Address dest = CreateAddress (m_x);
+          routing->AddHostRouteTo (dest, nextHop, interface);
+          routes[0].push_back (Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface));
+        }
+      else if (action < 75)
+        {
+          routing->AddASExternalRouteTo (network, mask, nextHop, interface);
+          routes[2].push_back (Ipv4RoutingTableEntry::CreateNetworkRouteTo (network, mask, nextHop, interface));
+        }
+      else if (routing->GetNRoutes () > 0)
+        {
+          uint32_t index = m_x->GetInteger (0, routing->GetNRoutes () - 1);
+          routing->RemoveRoute (index);
+          for (uint32_t kind = 0; kind < 3; kind++)
+            {
+              if (index < routes[kind].size ())
+                {
+                  routes[kind].erase (routes[kind].begin () + index);
+                  break;
+                }
+              index -= routes[kind].size ();
+            }
+        }
+
+      for (uint32_t i = 0; i < 4; i++)
+        {
+          Ipv4Address dest = CreateAddress (m_x);
+          uint32_t oifInterface = m_x->GetInteger (0, 3);
+          Ptr<NetDevice> oif = oifInterface == 0 ? 0 : m_ipv4->GetNetDevice (oifInterface);
+          Ptr<Ipv4Route> expected = 0;
+          for (uint32_t kind = 0; kind < 3 && expected == 0; kind++)
+            {
+              for (std::vector<Ipv4RoutingTableEntry>::const_iterator j = routes[kind].begin ();
+                   j != routes[kind].end () && expected == 0;
+                   j++)
+                {
+                  if (j->GetDestNetworkMask ().IsMatch (dest, j->GetDestNetwork ())
+                      && (oif == 0 || oif == m_ipv4->GetNetDevice (j->GetInterface ())))
+                    {
+                      expected = CreateRoute (m_ipv4, *j);
+                    }
+                }
+            }
+          NS_TEST_ASSERT_MSG_EQ (IsSameRoute (RouteOutput (routing, dest, oif), expected),
+                                 true, "Wrong route to " << dest << " in round " << round);
+        }
+    }
+  routing->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 route lookup TestSuite
+ */
+static class Ipv4RouteLookupTestSuite : public TestSuite
+{
+public:
+  Ipv4RouteLookupTestSuite ()
+    : TestSuite ("ipv4-route-lookup", UNIT)
+  {
+    AddTestCase (new Ipv4PrefixTrieTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4StaticRouteLookupTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRouteLookupTestCase, TestCase::QUICK);
+  }
+} g_ipv4RouteLookupTestSuite;
@@ -0,0 +1,264 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <vector>
+#include <algorithm>
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/tcp-tx-buffer.h"
+#include "ns3/tcp-rx-buffer.h"
+#include "ns3/tcp-header.h"
+
+namespace ns3 {
+
+/**
+ * \param [in] start Offset of the first byte in the stream.
+ * \param [in] size Number of bytes.
+ * \returns A packet holding the bytes of the stream from \p start.
+ */
+static Ptr<Packet>
+CreateStreamPacket (uint32_t start, uint32_t size)
+{
+  std::vector<uint8_t> bytes (size);
+  for (uint32_t i = 0; i < size; i++)
+    {
+      bytes[i] = (start + i) % 251;
+    }
+  return Create<Packet> (size == 0 ? 0 : &bytes[0], size);
+}
+
+/**
+ * \param [in] p A packet.
+ * \param [in] start Offset in the stream of the first byte of \p p.
+ * \returns \c true if \p p holds the bytes of the stream from \p start.
+ */
+static bool
+IsStreamPacket (Ptr<const Packet> p, uint32_t start)
+{
+  std::vector<uint8_t> bytes (p->GetSize () + 1);
+  p->CopyData (&bytes[0], p->GetSize ());
+  for (uint32_t i = 0; i < p->GetSize (); i++)
+    {
+      if (bytes[i] != (start + i) % 251)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the segments taken from a TcpTxBuffer against the
+ * bytes written to it, with random writes, segments and acknowledgments.
+ */
+class TcpTxBufferTestCase : public TestCase
+{
+public:
+  TcpTxBufferTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpTxBufferTestCase::TcpTxBufferTestCase ()
+  : TestCase ("Check the data of the segments taken from the send buffer")
+{
+}
+
+void
+TcpTxBufferTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+  Ptr<TcpTxBuffer> tx = CreateObject<TcpTxBuffer> ();
+  tx->SetMaxBufferSize (65536);
+
+  // Data written before the connection is set up follows the head
+  NS_TEST_ASSERT_MSG_EQ (tx->Add (CreateStreamPacket (0, 100)), true, "Add failed");
+  tx->SetHeadSequence (SequenceNumber32 (1000));
+  NS_TEST_ASSERT_MSG_EQ (tx->TailSequence (), SequenceNumber32 (1100), "Wrong tail");
+  NS_TEST_ASSERT_MSG_EQ (IsStreamPacket (tx->CopyFromSequence (100, SequenceNumber32 (1000)), 0),
+                         true, "Wrong data after SetHeadSequence");
+
+  // Offset in the stream of the head of the buffer
+  uint32_t head = 0;
+  uint32_t written = 100;
+  for (uint32_t round = 0; round < 2000; round++)
+    {
+      uint32_t size = x->GetInteger (1, round % 2 ? 3000 : 200);
+      if (size <= tx->Available ())
+        {
+          Ptr<Packet> p = CreateStreamPacket (written, size);
+          if (round % 13 == 0)
+            {
+              SocketIpTtlTag tag;
+              tag.SetTtl (round % 256);
+              p->AddPacketTag (tag);
+            }
+          NS_TEST_ASSERT_MSG_EQ (tx->Add (p), true, "Add failed");
+          written += size;
+        }
+      NS_TEST_ASSERT_MSG_EQ (tx->Size (), written - head, "Wrong size");
+
+      for (uint32_t i = 0; i < 4 && written > head; i++)
+        {
+          uint32_t offset = x->GetInteger (0, written - head - 1);
+          uint32_t numBytes = x->GetInteger (1, 1500);
+          SequenceNumber32 seq = tx->HeadSequence () + SequenceNumber32 (offset);
+          Ptr<Packet> p = tx->CopyFromSequence (numBytes, seq);
+          NS_TEST_ASSERT_MSG_EQ (p->GetSize (), std::min (numBytes, written - head - offset),
+                                 "Wrong segment size");
+          NS_TEST_ASSERT_MSG_EQ (IsStreamPacket (p, head + offset), true, "Wrong segment data");
+        }
+
+      uint32_t acked = x->GetInteger (0, written - head);
+      tx->DiscardUpTo (tx->HeadSequence () + SequenceNumber32 (acked));
+      head += acked;
+      NS_TEST_ASSERT_MSG_EQ (tx->Size (), written - head, "Wrong size after DiscardUpTo");
+    }
+
+  // A segment taken from the start of a tagged write keeps its tag
+  tx->DiscardUpTo (tx->TailSequence ());
+  tx->Add (CreateStreamPacket (0, 10));
+  Ptr<Packet> tagged = CreateStreamPacket (10, 10);
+  SocketIpTtlTag tag;
+  tag.SetTtl (42);
+  tagged->AddPacketTag (tag);
+  tx->Add (tagged);
+  tx->Add (CreateStreamPacket (20, 10));
+  Ptr<Packet> p = tx->CopyFromSequence (5, tx->HeadSequence () + SequenceNumber32 (12));
+  NS_TEST_ASSERT_MSG_EQ (p->PeekPacketTag (tag), true, "Packet tag lost");
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (tag.GetTtl ()), 42, "Wrong packet tag");
+  p = tx->CopyFromSequence (5, tx->HeadSequence () + SequenceNumber32 (22));
+  NS_TEST_ASSERT_MSG_EQ (p->PeekPacketTag (tag), false, "Packet tag of another write");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check a TcpRxBuffer against a model of the bytes it holds, with
+ * random, overlapping and out of order segments.
+ */
+class TcpRxBufferTestCase : public TestCase
+{
+public:
+  TcpRxBufferTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpRxBufferTestCase::TcpRxBufferTestCase ()
+  : TestCase ("Check the data received by the receive buffer")
+{
+}
+
+void
+TcpRxBufferTestCase::DoRun (void)
+{
+  const uint32_t maxBuffer = 8000;
+  const uint32_t streamSize = 200000;
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+  Ptr<TcpRxBuffer> rx = CreateObject<TcpRxBuffer> ();
+  rx->SetMaxBufferSize (maxBuffer);
+  SequenceNumber32 isn (4294960000U); // The sequence numbers wrap around
+  rx->SetNextRxSequence (isn);
+
+  // Model: the bytes received, the first byte not read and RCV.NXT
+  std::vector<bool> received (streamSize + 4 * maxBuffer, false);
+  uint32_t read = 0;
+  uint32_t next = 0;
+  TcpHeader header;
+  while (read < streamSize)
+    {
+      uint32_t start = next + x->GetInteger (0, maxBuffer) - std::min (next, 1000U);
+      uint32_t size = x->GetInteger (1, 1500);
+      header.SetSequenceNumber (isn + SequenceNumber32 (start));
+      rx->Add (CreateStreamPacket (start, size), header);
+
+      // The data before RCV.NXT is dropped, and the data beyond the first
+      // byte in the buffer plus the maximum size of the buffer
+      uint32_t head = std::max (start, next);
+      uint32_t tail = start + size;
+      uint32_t first = read;
+      if (read == next)
+        {
+          while (first < next + 3 * maxBuffer && !received[first])
+            {
+              first++;
+            }
+        }
+      if (first < next + 3 * maxBuffer)
+        {
+          tail = std::min (tail, first + maxBuffer);
+        }
+      for (uint32_t i = head; i < tail; i++)
+        {
+          received[i] = true;
+        }
+      while (received[next])
+        {
+          next++;
+        }
+      uint32_t outOfOrder = 0;
+      for (uint32_t i = next; i < next + 3 * maxBuffer; i++)
+        {
+          outOfOrder += received[i];
+        }
+      NS_TEST_ASSERT_MSG_EQ (rx->NextRxSequence (), isn + SequenceNumber32 (next), "Wrong RCV.NXT");
+      NS_TEST_ASSERT_MSG_EQ (rx->Available (), next - read, "Wrong available bytes");
+      NS_TEST_ASSERT_MSG_EQ (rx->Size (), next - read + outOfOrder, "Wrong size");
+
+      if (x->GetInteger (0, 3) == 0 || next - read > maxBuffer / 2)
+        {
+          uint32_t maxSize = x->GetInteger (1, 5000);
+          Ptr<Packet> p = rx->Extract (maxSize);
+          if (next == read)
+            {
+              NS_TEST_ASSERT_MSG_EQ ((p == 0), true, "Extracted data not available");
+            }
+          else
+            {
+              NS_TEST_ASSERT_MSG_EQ (p->GetSize (), std::min (maxSize, next - read), "Wrong extracted size");
+              NS_TEST_ASSERT_MSG_EQ (IsStreamPacket (p, read), true, "Wrong extracted data");
+              read += p->GetSize ();
+            }
+        }
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP send and receive buffers TestSuite
+ */
+static class TcpBuffersTestSuite : public TestSuite
+{
+public:
+  TcpBuffersTestSuite ()
+    : TestSuite ("tcp-buffers", UNIT)
+  {
+    AddTestCase (new TcpTxBufferTestCase, TestCase::QUICK);
+    AddTestCase (new TcpRxBufferTestCase, TestCase::QUICK);
+  }
+} g_tcpBuffersTestSuite;
+
+} // namespace ns3
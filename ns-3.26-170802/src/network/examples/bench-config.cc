@@ -0,0 +1,132 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Measure the setup time of the Config paths on a large topology.
+//
+// The program creates --nodes nodes with --devices SimpleNetDevices each,
+// then times the usual setup calls of the simulation scripts:
+//  - Config::Set on a path with wildcards, --repeat times;
+//  - Config::Set on the path of each node, one node after the other;
+//  - Config::Connect on the path of each node;
+//  - Config::LookupMatches on a path with wildcards, --repeat times.
+// The time of each step is printed in milliseconds.
+//
+//   ./waf --run "bench-config --nodes=1000"
+
+#include "ns3/core-module.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/packet.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+using namespace ns3;
+
+static uint32_t g_drops = 0;
+
+static void
+PhyRxDrop (std::string context, Ptr<const Packet> packet)
+{
+  g_drops++;
+}
+
+/**
+ * Print the time of a step.
+ * \param [in] step The step name.
+ * \param [in] count The number of Config calls of the step.
+ * \param [in] ms The time of the step, in milliseconds.
+ */
+static void
+Report (std::string step, uint32_t count, int64_t ms)
+{
+  std::cout << std::setw (24) << step << std::setw (10) << count
+            << std::setw (12) << ms << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nNodes = 1000;
+  uint32_t nDevices = 2;
+  uint32_t repeat = 20;
+
+  CommandLine cmd;
+  cmd.Usage ("Measure the setup time of the Config paths on a large topology");
+  cmd.AddValue ("nodes", "number of nodes", nNodes);
+  cmd.AddValue ("devices", "number of devices per node", nDevices);
+  cmd.AddValue ("repeat", "number of calls of the paths with wildcards", repeat);
+  cmd.Parse (argc, argv);
+
+  NodeContainer nodes;
+  nodes.Create (nNodes);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      for (uint32_t j = 0; j < nDevices; j++)
+        {
+          Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+          device->SetChannel (channel);
+          (*i)->AddDevice (device);
+        }
+    }
+
+  std::cout << std::setw (24) << "step" << std::setw (10) << "calls"
+            << std::setw (12) << "ms" << std::endl;
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  for (uint32_t i = 0; i < repeat; i++)
+    {
+      Config::Set ("/NodeList/*/DeviceList/*/$ns3::SimpleNetDevice/TxQueue/MaxPackets",
+                   UintegerValue (100 + i));
+    }
+  Report ("set wildcard", repeat, clock.End ());
+
+  clock.Start ();
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      std::ostringstream oss;
+      oss << "/NodeList/" << i << "/DeviceList/0/$ns3::SimpleNetDevice/PointToPointMode";
+      Config::Set (oss.str (), BooleanValue (true));
+    }
+  Report ("set per node", nNodes, clock.End ());
+
+  clock.Start ();
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      std::ostringstream oss;
+      oss << "/NodeList/" << i << "/DeviceList/*/$ns3::SimpleNetDevice/PhyRxDrop";
+      Config::Connect (oss.str (), MakeCallback (&PhyRxDrop));
+    }
+  Report ("connect per node", nNodes, clock.End ());
+
+  clock.Start ();
+  uint32_t matches = 0;
+  for (uint32_t i = 0; i < repeat; i++)
+    {
+      matches += Config::LookupMatches ("/NodeList/*/DeviceList/*/$ns3::SimpleNetDevice").GetN ();
+    }
+  Report ("lookup wildcard", repeat, clock.End ());
+
+  if (matches != repeat * nNodes * nDevices)
+    {
+      std::cout << "unexpected number of matches: " << matches << std::endl;
+      return 1;
+    }
+  Simulator::Destroy ();
+  return 0;
+}
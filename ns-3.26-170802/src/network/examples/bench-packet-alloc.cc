@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Measure the cost of the packet allocations of a broadcast channel.
+//
+// The program creates --n packets of --size bytes with two headers, and
+// hands a copy of each packet to --receivers receivers, as
+// YansWifiChannel::Send does.  Each receiver removes the outer header,
+// and one receiver out of two adds a header of its own, which forces
+// the copy of the buffer.  The copies are then held in a queue of
+// --inflight packets, as the queues of the devices do, so that the
+// memory of a packet is freed long after its allocation.  The time per
+// packet is printed in nanoseconds, with the statistics of the packet
+// allocator.
+//
+//   ./waf --run "bench-packet-alloc --n=1000000 --metadata=1"
+//   ./waf --run "bench-packet-alloc --inflight=100000"
+//   ./waf --run "bench-packet-alloc --PacketPoolEnabled=0"
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/packet.h"
+#include "ns3/header.h"
+#include "ns3/packet-allocator.h"
+#include <iostream>
+#include <deque>
+
+using namespace ns3;
+
+/**
+ * A header of a fixed size.
+ */
+class BenchHeader : public Header
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+};
+
+TypeId
+BenchHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BenchHeader")
+    .SetParent<Header> ()
+    .AddConstructor<BenchHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+BenchHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+BenchHeader::Print (std::ostream &os) const
+{
+}
+
+uint32_t
+BenchHeader::GetSerializedSize (void) const
+{
+  return 24;
+}
+
+void
+BenchHeader::Serialize (Buffer::Iterator start) const
+{
+  start.WriteU64 (0);
+  start.WriteU64 (0);
+  start.WriteU64 (0);
+}
+
+uint32_t
+BenchHeader::Deserialize (Buffer::Iterator start)
+{
+  start.Next (24);
+  return 24;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 1000000;
+  uint32_t size = 1000;
+  uint32_t receivers = 8;
+  uint32_t inflight = 1000;
+  bool metadata = false;
+
+  CommandLine cmd;
+  cmd.Usage ("Measure the cost of the packet allocations of a broadcast channel");
+  cmd.AddValue ("n", "number of packets", n);
+  cmd.AddValue ("size", "payload size of the packets", size);
+  cmd.AddValue ("receivers", "number of receivers of each packet", receivers);
+  cmd.AddValue ("inflight", "number of packets held in the queue", inflight);
+  cmd.AddValue ("metadata", "enable the packet metadata", metadata);
+  cmd.Parse (argc, argv);
+
+  if (metadata)
+    {
+      Packet::EnablePrinting ();
+    }
+
+  BenchHeader header;
+  std::deque<Ptr<Packet> > queue;
+  uint64_t bytes = 0;
+  SystemWallClockMs clock;
+  clock.Start ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> packet = Create<Packet> (size);
+      packet->AddHeader (header);
+      packet->AddHeader (header);
+      for (uint32_t j = 0; j < receivers; j++)
+        {
+          Ptr<Packet> copy = packet->Copy ();
+          copy->RemoveHeader (header);
+          if (j & 1)
+            {
+              copy->AddHeader (header);
+            }
+          bytes += copy->GetSize ();
+          queue.push_back (copy);
+          if (queue.size () > inflight)
+            {
+              queue.pop_front ();
+            }
+        }
+    }
+  queue.clear ();
+  int64_t ms = clock.End ();
+  std::cout << "ns/packet " << ms * 1e6 / n << std::endl;
+
+  PacketAllocator::Statistics stats = PacketAllocator::GetStatistics ();
+  std::cout << "allocations " << stats.allocations
+            << " from free lists " << stats.pooled
+            << " malloc " << stats.heapAllocations
+            << " largest in use " << stats.maxInUse
+            << " free bytes " << stats.freeBytes << std::endl;
+
+  if (bytes != (uint64_t)n * receivers * (size + 24) + (uint64_t)n * (receivers / 2) * 24)
+    {
+      std::cout << "unexpected number of bytes: " << bytes << std::endl;
+      return 1;
+    }
+  return 0;
+}
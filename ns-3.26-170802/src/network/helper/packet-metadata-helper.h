@@ -0,0 +1,73 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PACKET_METADATA_HELPER_H
+#define PACKET_METADATA_HELPER_H
+
+#include "ns3/node-container.h"
+
+namespace ns3 {
+
+/**
+ * \brief Record the packet metadata of the packets of some nodes only.
+ *
+ * Packet::EnablePrinting makes every packet record the headers and
+ * trailers added to it, which slows down all the simulation.  This
+ * helper selects the nodes whose packets record their metadata: a packet
+ * created in the context of a selected node records it, as do its copies
+ * and fragments wherever they go, while the other packets skip the
+ * metadata entirely.  Packet::Print and the ascii traces then describe
+ * the packets of the selected nodes only.
+ *
+ * A packet is in the context of a node when it is created by an event
+ * scheduled for the node, such as the start of an application or the
+ * reception of a packet by one of its devices.  The selection is made
+ * per node only: the simulator context, which decides whether a packet
+ * records, identifies a node, not one of its devices, so the packets of
+ * all the devices of a selected node record their metadata.
+ *
+ * The selection applies to the packets created after the call, and
+ * lasts until PacketMetadata::Disable is called.
+ */
+class PacketMetadataHelper
+{
+public:
+  /**
+   * Record the metadata of the packets created by a node.
+   *
+   * \param node The node.
+   */
+  void Enable (Ptr<Node> node) const;
+
+  /**
+   * Record the metadata of the packets created by a node.
+   *
+   * \param nodeName The name of the node.
+   */
+  void Enable (std::string nodeName) const;
+
+  /**
+   * Record the metadata of the packets created by each node of a
+   * container.
+   *
+   * \param c The nodes.
+   */
+  void Enable (NodeContainer c) const;
+};
+
+} // namespace ns3
+
+#endif /* PACKET_METADATA_HELPER_H */
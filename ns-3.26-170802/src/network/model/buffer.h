@@ -21,12 +21,11 @@
 #define BUFFER_H
 
 #include <stdint.h>
+#include <atomic>
 #include <vector>
 #include <ostream>
 #include "ns3/assert.h"
 
-#define BUFFER_FREE_LIST 1
-
 namespace ns3 {
 
 /**
@@ -610,6 +609,16 @@ private:
    */
   uint32_t CopyData (uint8_t *buffer, uint32_t size) const;
 
+  /**
+   * \brief Create a copy of the buffer which does not share its data.
+   *
+   * The copy has the same offsets as this buffer, zero area included,
+   * and may be handed to another thread while this buffer is still used.
+   *
+   * \returns a copy of the buffer
+   */
+  Buffer DeepCopy (void) const;
+
   /**
    * \brief Copy constructor
    * \param o the buffer to copy
@@ -764,9 +773,9 @@ private:
   /**
    * location in a newly-allocated buffer where you should start
    * writing data. i.e., m_start should be initialized to this 
-   * value.
+   * value.  Shared by the threads, with relaxed atomic accesses.
    */
-  static uint32_t g_recommendedStart;
+  static std::atomic<uint32_t> g_recommendedStart;
 
   /**
    * offset to the start of the virtual zero area from the start
@@ -789,18 +798,13 @@ private:
    */
   uint32_t m_end;
 
-#ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  /// Local static destructor structure
-  struct LocalStaticDestructor 
-  {
-    ~LocalStaticDestructor ();
-  };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
-#endif
+  /**
+   * Largest size of the storages freed, up to the largest size of the
+   * pools of the PacketAllocator.  New storages are created at least
+   * this large, so that the buffers seldom have to grow.  Shared by the
+   * threads, with relaxed atomic accesses.
+   */
+  static std::atomic<uint32_t> g_maxSize;
 };
 
 } // namespace ns3
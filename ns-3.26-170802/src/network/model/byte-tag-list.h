@@ -188,6 +188,12 @@ private:
    */ 
   void RemoveAll (void);
 
+  /**
+   * \returns a copy of the list which does not share its data, and may
+   * be handed to another thread while this list is still used.
+   */
+  ByteTagList DeepCopy (void) const;
+
   /**
    * \param offsetStart the offset which uniquely identifies the first data byte 
    *        present in the byte buffer associated to this ByteTagList.
@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "packet-allocator.h"
+#include "ns3/size-class-allocator.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/log.h"
+
+/**
+ * \file
+ * \ingroup packet
+ * ns3::PacketAllocator implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PacketAllocator");
+
+/**
+ * \ingroup packet
+ * Whether the packets are allocated from pools.
+ */
+static GlobalValue g_packetPoolEnabled = GlobalValue ("PacketPoolEnabled",
+                                                      "Allocate the packets, their buffers and their metadata "
+                                                      "from size-classed pools instead of calling malloc for each",
+                                                      BooleanValue (true),
+                                                      MakeBooleanChecker ());
+
+/**
+ * \ingroup packet
+ * The bytes kept in the free lists of the packet pools.
+ */
+static GlobalValue g_packetPoolMaxFreeBytes = GlobalValue ("PacketPoolMaxFreeBytes",
+                                                           "Largest number of bytes kept in the free lists "
+                                                           "of the packet pools of a thread",
+                                                           UintegerValue (16 * 1024 * 1024),
+                                                           MakeUintegerChecker<uint64_t> ());
+
+/**
+ * \ingroup packet
+ * Whether each thread has its own packet pools.
+ */
+static GlobalValue g_packetPoolThreadLocal = GlobalValue ("PacketPoolThreadLocal",
+                                                          "Give each thread its own packet pools, without lock, "
+                                                          "instead of sharing the pools among the threads",
+                                                          BooleanValue (true),
+                                                          MakeBooleanChecker ());
+
+namespace {
+
+/**
+ * \returns The pools of the packets.  Never destroyed, so that the
+ *          packets freed by the static destructors find them.
+ */
+SizeClassAllocator &
+GetAllocator (void)
+{
+  static const SizeClassAllocator::Layout layout = {
+    PacketAllocator::MIN_CLASS_SIZE, 4, PacketAllocator::MAX_POOLED_SIZE
+  };
+  static SizeClassAllocator *allocator =
+    new SizeClassAllocator (layout, "PacketPoolEnabled", "PacketPoolMaxFreeBytes", "PacketPoolThreadLocal");
+  return *allocator;
+}
+
+} // unnamed namespace
+
+void *
+PacketAllocator::Allocate (std::size_t size, std::size_t &usable)
+{
+  return GetAllocator ().Allocate (size, usable);
+}
+
+void *
+PacketAllocator::Allocate (std::size_t size)
+{
+  return GetAllocator ().Allocate (size);
+}
+
+void
+PacketAllocator::Deallocate (void *p)
+{
+  GetAllocator ().Deallocate (p);
+}
+
+bool
+PacketAllocator::IsEnabled (void)
+{
+  return GetAllocator ().IsEnabled ();
+}
+
+void
+PacketAllocator::Reconfigure (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  GetAllocator ().Reconfigure ();
+}
+
+PacketAllocator::Statistics
+PacketAllocator::GetStatistics (void)
+{
+  return GetAllocator ().GetStatistics ();
+}
+
+void
+PacketAllocator::ResetStatistics (void)
+{
+  GetAllocator ().ResetStatistics ();
+}
+
+void
+PacketAllocator::Trim (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  GetAllocator ().Trim ();
+}
+
+} // namespace ns3
@@ -0,0 +1,111 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef PACKET_ALLOCATOR_H
+#define PACKET_ALLOCATOR_H
+
+#include <stdint.h>
+#include <cstddef>
+#include "ns3/size-class-allocator.h"
+
+/**
+ * \file
+ * \ingroup packet
+ * ns3::PacketAllocator declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ * \brief Memory allocator of the Packet objects and of the storage of
+ * the Buffer, ByteTagList and PacketMetadata instances.
+ *
+ * The memory is served by a SizeClassAllocator, in size classes from
+ * MIN_CLASS_SIZE to MAX_POOLED_SIZE bytes, four between two powers of
+ * two, each with a free list, so that once a simulation has reached its
+ * largest number of packets in flight, creating, copying and modifying a packet no longer
+ * calls malloc.  Larger blocks are allocated with malloc.  Allocate()
+ * returns the usable size of the block, which the Buffer,
+ * ByteTagList and PacketMetadata storages use entirely to grow in place.
+ *
+ * The behavior is set by GlobalValues, read when the first block is
+ * allocated and again after each call to Reconfigure():
+ *  - "PacketPoolEnabled" enables the pools (default true);
+ *  - "PacketPoolMaxFreeBytes" bounds the bytes kept in the free lists
+ *    of the pools (default 16 MiB); the blocks freed beyond it are given
+ *    back to the system;
+ *  - "PacketPoolThreadLocal" gives each thread its own pools, without
+ *    any lock (default true).  A block freed by another thread than the
+ *    one which allocated it joins the pools of the freeing thread, and
+ *    the free blocks of a thread are given back to the system when it
+ *    exits.  When the packets flow mostly one way between threads, as
+ *    from the reader thread of an emulated device to the simulation
+ *    thread, setting it to false makes all the threads share the same
+ *    pools, protected by a mutex, so that the freed blocks are reused.
+ *
+ * Blocks allocated before a change of the GlobalValues are freed
+ * correctly afterwards.
+ */
+class PacketAllocator
+{
+public:
+  /** Smallest size class, in bytes, including the block header. */
+  static const std::size_t MIN_CLASS_SIZE = 64;
+  /** Largest size class, in bytes, including the block header. */
+  static const std::size_t MAX_POOLED_SIZE = 16384;
+
+  /** Allocation statistics of a pool. */
+  typedef SizeClassAllocator::Statistics Statistics;
+
+  /**
+   * \param [in] size The requested size, in bytes.
+   * \param [out] usable The usable size of the block, at least \p size.
+   * \returns The memory of the block.
+   */
+  static void * Allocate (std::size_t size, std::size_t &usable);
+  /**
+   * \param [in] size The requested size, in bytes.
+   * \returns The memory of the block.
+   */
+  static void * Allocate (std::size_t size);
+  /**
+   * \param [in] p The memory of a block returned by Allocate().
+   */
+  static void Deallocate (void *p);
+  /**
+   * \returns \c true if the blocks are allocated from the pools.
+   */
+  static bool IsEnabled (void);
+  /**
+   * Read the GlobalValues again before the next allocation.
+   */
+  static void Reconfigure (void);
+  /**
+   * \returns The statistics of the pools used by the calling thread.
+   */
+  static Statistics GetStatistics (void);
+  /** Reset the statistics of the pools used by the calling thread. */
+  static void ResetStatistics (void);
+  /**
+   * Give back to the system the free blocks of the pools used by the
+   * calling thread.
+   */
+  static void Trim (void);
+};
+
+} // namespace ns3
+
+#endif /* PACKET_ALLOCATOR_H */
@@ -19,10 +19,13 @@
  */
 #include <utility>
 #include <list>
+#include <algorithm>
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/simulator.h"
 #include "packet-metadata.h"
+#include "packet-allocator.h"
 #include "buffer.h"
 #include "header.h"
 #include "trailer.h"
@@ -33,32 +36,15 @@ NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
-bool PacketMetadata::m_metadataSkipped = false;
-uint32_t PacketMetadata::m_maxSize = 0;
-uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
-
-PacketMetadata::DataFreeList::~DataFreeList ()
-{
-  NS_LOG_FUNCTION (this);
-  for (iterator i = begin (); i != end (); i++)
-    {
-      PacketMetadata::Deallocate (*i);
-    }
-  PacketMetadata::m_enable = false;
-}
+bool PacketMetadata::m_enableNodes = false;
+std::vector<bool> PacketMetadata::m_nodes;
+std::atomic<uint32_t> PacketMetadata::m_maxSize (0);
+std::atomic<uint16_t> PacketMetadata::m_chunkUid (0);
 
 void 
 PacketMetadata::Enable (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  NS_ASSERT_MSG (!m_metadataSkipped,
-                 "Error: attempting to enable the packet metadata "
-                 "subsystem too late in the simulation, which is not allowed.\n"
-                 "A common cause for this problem is to enable ASCII tracing "
-                 "after sending any packets.  One way to fix this problem is "
-                 "to call ns3::PacketMetadata::Enable () near the beginning of"
-                 " the program, before any packets are sent.");
   m_enable = true;
 }
 
@@ -70,6 +56,58 @@ PacketMetadata::EnableChecking (void)
   m_enableChecking = true;
 }
 
+void
+PacketMetadata::EnableNode (uint32_t nodeId)
+{
+  NS_LOG_FUNCTION (nodeId);
+  if (nodeId >= m_nodes.size ())
+    {
+      m_nodes.resize (nodeId + 1, false);
+    }
+  m_nodes[nodeId] = true;
+  m_enableNodes = true;
+}
+
+void
+PacketMetadata::Disable (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_enable = false;
+  m_enableChecking = false;
+  m_enableNodes = false;
+  m_nodes.clear ();
+}
+
+bool
+PacketMetadata::IsContextRecorded (void)
+{
+  uint32_t context = Simulator::GetContext ();
+  return context < m_nodes.size () && m_nodes[context];
+}
+
+void
+PacketMetadata::StartRecording (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_data == 0)
+    {
+      m_data = PacketMetadata::Create (10);
+      memset (m_data->m_data, 0xff, 4);
+    }
+}
+
+PacketMetadata
+PacketMetadata::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  PacketMetadata copy = *this;
+  if (copy.m_data != 0)
+    {
+      copy.ReserveCopy (0);
+    }
+  return copy;
+}
+
 void
 PacketMetadata::ReserveCopy (uint32_t size)
 {
@@ -129,10 +167,37 @@ PacketMetadata::IsPointerOk (uint16_t pointer) const
   return ok;
 }
 
+bool
+PacketMetadata::IsLinkFree (uint16_t next, uint16_t prev) const
+{
+  NS_LOG_FUNCTION (this << next << prev);
+  // UpdateHead overwrites the prev field of the current head, and
+  // UpdateTail the next field of the current tail.  In data shared with
+  // other packets, this is safe only if no other packet uses that field,
+  // that is, if it is still unset: a packet which had removed the items
+  // before its head, or after its tail, would otherwise break the list
+  // of the packets which still hold them.
+  if (next != 0xffff && next == m_head)
+    {
+      const uint8_t *buffer = &m_data->m_data[m_head + 2];
+      return (buffer[0] | (buffer[1] << 8)) == 0xffff;
+    }
+  if (prev != 0xffff && prev == m_tail)
+    {
+      const uint8_t *buffer = &m_data->m_data[m_tail];
+      return (buffer[0] | (buffer[1] << 8)) == 0xffff;
+    }
+  return true;
+}
+
 bool
 PacketMetadata::IsStateOk (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_data == 0)
+    {
+      return m_head == 0xffff && m_tail == 0xffff && m_used == 0;
+    }
   bool ok = m_used <= m_data->m_size;
   ok &= IsPointerOk (m_head);
   ok &= IsPointerOk (m_tail);
@@ -383,7 +448,7 @@ PacketMetadata::AddSmall (const struct PacketMetadata::SmallItem *item)
   if (m_used + n > m_data->m_size ||
       (m_head != 0xffff &&
        m_data->m_count != 1 &&
-       m_used != m_data->m_dirtyEnd))
+       (m_used != m_data->m_dirtyEnd || !IsLinkFree (item->next, item->prev))))
     {
       ReserveCopy (n);
     }
@@ -421,7 +486,7 @@ PacketMetadata::AddBig (uint32_t next, uint32_t prev,
   if (m_used + n > m_data->m_size ||
       (m_head != 0xffff &&
        m_data->m_count != 1 &&
-       m_used != m_data->m_dirtyEnd))
+       (m_used != m_data->m_dirtyEnd || !IsLinkFree (next, prev))))
     {
       ReserveCopy (n);
     }
@@ -571,48 +636,23 @@ struct PacketMetadata::Data *
 PacketMetadata::Create (uint32_t size)
 {
   NS_LOG_FUNCTION (size);
-  NS_LOG_LOGIC ("create size="<<size<<", max="<<m_maxSize);
-  if (size > m_maxSize)
+  uint32_t maxSize = m_maxSize.load (std::memory_order_relaxed);
+  NS_LOG_LOGIC ("create size="<<size<<", max="<<maxSize);
+  if (size > maxSize)
     {
-      m_maxSize = size;
+      maxSize = size;
+      m_maxSize.store (maxSize, std::memory_order_relaxed);
     }
-  while (!m_freeList.empty ()) 
-    {
-      struct PacketMetadata::Data *data = m_freeList.back ();
-      m_freeList.pop_back ();
-      if (data->m_size >= size) 
-        {
-          NS_LOG_LOGIC ("create found size="<<data->m_size);
-          data->m_count = 1;
-          return data;
-        }
-      PacketMetadata::Deallocate (data);
-      NS_LOG_LOGIC ("create dealloc size="<<data->m_size);
-    }
-  NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
-  return PacketMetadata::Allocate (m_maxSize);
+  NS_LOG_LOGIC ("create alloc size="<<maxSize);
+  return PacketMetadata::Allocate (maxSize);
 }
 
 void
 PacketMetadata::Recycle (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  if (!m_enable)
-    {
-      PacketMetadata::Deallocate (data);
-      return;
-    } 
-  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
   NS_ASSERT (data->m_count == 0);
-  if (m_freeList.size () > 1000 ||
-      data->m_size < m_maxSize) 
-    {
-      PacketMetadata::Deallocate (data);
-    } 
-  else 
-    {
-      m_freeList.push_back (data);
-    }
+  PacketMetadata::Deallocate (data);
 }
 
 struct PacketMetadata::Data *
@@ -625,9 +665,11 @@ PacketMetadata::Allocate (uint32_t n)
       n = PACKET_METADATA_DATA_M_DATA_SIZE;
     }
   size += n - PACKET_METADATA_DATA_M_DATA_SIZE;
-  uint8_t *buf = new uint8_t [size];
-  struct PacketMetadata::Data *data = (struct PacketMetadata::Data *)buf;
-  data->m_size = n;
+  std::size_t usable;
+  void *buf = PacketAllocator::Allocate (size, usable);
+  struct PacketMetadata::Data *data = static_cast<struct PacketMetadata::Data *> (buf);
+  // m_size is 16 bits wide
+  data->m_size = std::min<std::size_t> (usable - sizeof (struct Data) + PACKET_METADATA_DATA_M_DATA_SIZE, 0xffff);
   data->m_count = 1;
   data->m_dirtyEnd = 0;
   return data;
@@ -636,8 +678,7 @@ void
 PacketMetadata::Deallocate (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  uint8_t *buf = (uint8_t *)data;
-  delete [] buf;
+  PacketAllocator::Deallocate (data);
 }
 
 
@@ -655,6 +696,10 @@ void
 PacketMetadata::AddHeader (const Header &header, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &header << size);
+  if (m_data == 0)
+    {
+      return;
+    }
   NS_ASSERT (IsStateOk ());
   uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
   DoAddHeader (uid, size);
@@ -664,33 +709,25 @@ void
 PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
 {
   NS_LOG_FUNCTION (this << uid << size);
-  if (!m_enable)
-    {
-      m_metadataSkipped = true;
-      return;
-    }
-
   struct PacketMetadata::SmallItem item;
   item.next = m_head;
   item.prev = 0xffff;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = m_chunkUid++;
   uint16_t written = AddSmall (&item);
   UpdateHead (written);
 }
 void 
 PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
 {
-  uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &header << size);
-  NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (m_data == 0)
     {
-      m_metadataSkipped = true;
       return;
     }
+  uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
+  NS_ASSERT (IsStateOk ());
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_head, &item, &extraItem);
@@ -731,21 +768,19 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
 void 
 PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
 {
-  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &trailer << size);
-  NS_ASSERT (IsStateOk ());
-  if (!m_enable)
+  if (m_data == 0)
     {
-      m_metadataSkipped = true;
       return;
     }
+  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
+  NS_ASSERT (IsStateOk ());
   struct PacketMetadata::SmallItem item;
   item.next = 0xffff;
   item.prev = m_tail;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = m_chunkUid++;
   uint16_t written = AddSmall (&item);
   UpdateTail (written);
   NS_ASSERT (IsStateOk ());
@@ -753,14 +788,13 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
 void 
 PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
 {
-  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &trailer << size);
-  NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (m_data == 0)
     {
-      m_metadataSkipped = true;
       return;
     }
+  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
+  NS_ASSERT (IsStateOk ());
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_tail, &item, &extraItem);
@@ -802,12 +836,13 @@ void
 PacketMetadata::AddAtEnd (PacketMetadata const&o)
 {
   NS_LOG_FUNCTION (this << &o);
-  NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (m_data == 0 || o.m_data == 0)
     {
-      m_metadataSkipped = true;
+      // the bytes of a packet which does not record its metadata are
+      // appended as padding
       return;
     }
+  NS_ASSERT (IsStateOk ());
   if (m_tail == 0xffff)
     {
       // We have no items so 'AddAtEnd' is 
@@ -880,23 +915,16 @@ void
 PacketMetadata::AddPaddingAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
-  if (!m_enable)
-    {
-      m_metadataSkipped = true;
-      return;
-    }
 }
 void 
 PacketMetadata::RemoveAtStart (uint32_t start)
 {
   NS_LOG_FUNCTION (this << start);
-  NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (m_data == 0)
     {
-      m_metadataSkipped = true;
       return;
     }
-  NS_ASSERT (m_data != 0);
+  NS_ASSERT (IsStateOk ());
   uint32_t leftToRemove = start;
   uint16_t current = m_head;
   while (current != 0xffff && leftToRemove > 0)
@@ -923,6 +951,7 @@ PacketMetadata::RemoveAtStart (uint32_t start)
         {
           // fragment the list item.
           PacketMetadata fragment (m_packetUid, 0);
+          fragment.StartRecording ();
           extraItem.fragmentStart += leftToRemove;
           leftToRemove = 0;
           uint16_t written = fragment.AddBig (0xffff, fragment.m_tail,
@@ -953,13 +982,11 @@ void
 PacketMetadata::RemoveAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
-  NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (m_data == 0)
     {
-      m_metadataSkipped = true;
       return;
     }
-  NS_ASSERT (m_data != 0);
+  NS_ASSERT (IsStateOk ());
 
   uint32_t leftToRemove = end;
   uint16_t current = m_tail;
@@ -987,6 +1014,7 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
         {
           // fragment the list item.
           PacketMetadata fragment (m_packetUid, 0);
+          fragment.StartRecording ();
           NS_ASSERT (extraItem.fragmentEnd > leftToRemove);
           extraItem.fragmentEnd -= leftToRemove;
           leftToRemove = 0;
@@ -1139,10 +1167,10 @@ PacketMetadata::GetSerializedSize (void) const
   // add 8 bytes for the packet uid
   totalSize += 8;
 
-  // if packet-metadata not enabled, total size
+  // if packet-metadata not recorded, total size
   // is simply 4-bytes for itself plus 8-bytes 
   // for packet uid
-  if (!m_enable)
+  if (m_data == 0)
     {
       return totalSize;
     }
@@ -1288,6 +1316,10 @@ PacketMetadata::Deserialize (const uint8_t* buffer, uint32_t size)
 
   struct PacketMetadata::SmallItem item = {0};
   struct PacketMetadata::ExtraItem extraItem = {0};
+  if (desSize > 0)
+    {
+      StartRecording ();
+    }
   while (desSize > 0)
     {
       uint32_t uidStringSize = 0;
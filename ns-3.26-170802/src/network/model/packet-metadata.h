@@ -21,6 +21,7 @@
 #define PACKET_METADATA_H
 
 #include <stdint.h>
+#include <atomic>
 #include <vector>
 #include <limits>
 #include "ns3/callback.h"
@@ -74,6 +75,12 @@ class Trailer;
  * integers, and some others as variable-size 32-bit integers.
  * The variable-size 32 bit integers are stored using the uleb128
  * encoding.
+ *
+ * Whether a packet records its metadata is decided when it is created,
+ * and inherited by its copies and fragments: the packets created while
+ * the metadata is enabled, or in the context of a node selected with
+ * EnableNode(), record it; the other packets have no storage at all and
+ * skip all the work of this class.
  */
 class PacketMetadata 
 {
@@ -152,13 +159,26 @@ private:
   };
 
   /**
-   * \brief Enable the packet metadata
+   * \brief Enable the packet metadata of all the packets created from
+   * now on
    */
   static void Enable (void);
   /**
    * \brief Enable the packet metadata checking
    */
   static void EnableChecking (void);
+  /**
+   * \brief Enable the packet metadata of the packets created from now
+   * on in the context of a node
+   * \param nodeId the id of the node
+   */
+  static void EnableNode (uint32_t nodeId);
+  /**
+   * \brief Disable the packet metadata, and its checking, for the
+   * packets created from now on, and forget the nodes enabled with
+   * EnableNode
+   */
+  static void Disable (void);
 
   /**
    * \brief Constructor
@@ -178,6 +198,17 @@ private:
    */
   inline PacketMetadata &operator = (PacketMetadata const& o);
   inline ~PacketMetadata ();
+  /**
+   * \brief Create a copy which does not share its data, and may be
+   * handed to another thread while this object is still used.
+   * \returns the copy, with the same packet uid
+   */
+  PacketMetadata DeepCopy (void) const;
+
+  /**
+   * \returns true if the metadata of this packet is recorded
+   */
+  inline bool IsRecording (void) const;
 
   /**
    * \brief Add an header
@@ -491,16 +522,6 @@ private:
     uint64_t packetUid;
   };
 
-  /**
-   * \brief Class to hold all the metadata
-   */
-  class DataFreeList : public std::vector<struct Data *>
-  {
-public:
-    ~DataFreeList ();
-  };
-
-  friend DataFreeList::~DataFreeList ();
   friend class ItemIterator;
 
   PacketMetadata ();
@@ -632,6 +653,14 @@ public:
    * \returns true if the position is valid
    */
   bool IsSharedPointerOk (uint16_t pointer) const;
+  /**
+   * \brief Check if a new item can be linked in place to the head or
+   * the tail of the list
+   * \param next the next field of the new item
+   * \param prev the prev field of the new item
+   * \returns true if the link to overwrite is not used by another packet
+   */
+  bool IsLinkFree (uint16_t next, uint16_t prev) const;
 
   /**
    * \brief Recycle the buffer memory
@@ -655,22 +684,25 @@ public:
    * \param data the buffer data storage
    */
   static void Deallocate (struct PacketMetadata::Data *data);
+  /**
+   * \brief Start recording the metadata of this packet, if not already
+   */
+  void StartRecording (void);
+  /**
+   * \returns true if the packets created in the current context
+   * record their metadata
+   */
+  static bool IsContextRecorded (void);
 
-  static DataFreeList m_freeList; //!< the metadata data storage
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
+  static bool m_enableNodes; //!< Enable the packet metadata of some nodes
+  static std::vector<bool> m_nodes; //!< Nodes whose packets record their metadata
 
-  /**
-   * Set to true when adding metadata to a packet is skipped because
-   * m_enable is false; used to detect enabling of metadata in the
-   * middle of a simulation, which isn't allowed.
-   */
-  static bool m_metadataSkipped;
-
-  static uint32_t m_maxSize; //!< maximum metadata size
-  static uint16_t m_chunkUid; //!< Chunk Uid
+  static std::atomic<uint32_t> m_maxSize; //!< maximum metadata size, shared by the threads
+  static std::atomic<uint16_t> m_chunkUid; //!< Chunk Uid
 
-  struct Data *m_data; //!< Metadata storage
+  struct Data *m_data; //!< Metadata storage, null if not recorded
   /*
      head -(next)-> tail
        ^             |
@@ -687,16 +719,19 @@ public:
 namespace ns3 {
 
 PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
-  : m_data (PacketMetadata::Create (10)),
+  : m_data (0),
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
     m_packetUid (uid)
 {
-  memset (m_data->m_data, 0xff, 4);
-  if (size > 0)
+  if (m_enable || (m_enableNodes && IsContextRecorded ()))
     {
-      DoAddHeader (0, size);
+      StartRecording ();
+      if (size > 0)
+        {
+          DoAddHeader (0, size);
+        }
     }
 }
 PacketMetadata::PacketMetadata (PacketMetadata const &o)
@@ -706,9 +741,11 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
     m_used (o.m_used),
     m_packetUid (o.m_packetUid)
 {
-  NS_ASSERT (m_data != 0);
-  NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  if (m_data != 0)
+    {
+      NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
+      m_data->m_count++;
+    }
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -716,15 +753,19 @@ PacketMetadata::operator = (PacketMetadata const& o)
   if (m_data != o.m_data) 
     {
       // not self assignment
-      NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (m_data != 0)
         {
-          PacketMetadata::Recycle (m_data);
+          m_data->m_count--;
+          if (m_data->m_count == 0) 
+            {
+              PacketMetadata::Recycle (m_data);
+            }
         }
       m_data = o.m_data;
-      NS_ASSERT (m_data != 0);
-      m_data->m_count++;
+      if (m_data != 0)
+        {
+          m_data->m_count++;
+        }
     }
   m_head = o.m_head;
   m_tail = o.m_tail;
@@ -734,13 +775,20 @@ PacketMetadata::operator = (PacketMetadata const& o)
 }
 PacketMetadata::~PacketMetadata ()
 {
-  NS_ASSERT (m_data != 0);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (m_data != 0)
     {
-      PacketMetadata::Recycle (m_data);
+      m_data->m_count--;
+      if (m_data->m_count == 0) 
+        {
+          PacketMetadata::Recycle (m_data);
+        }
     }
 }
+bool
+PacketMetadata::IsRecording (void) const
+{
+  return m_data != 0;
+}
 
 } // namespace ns3
 
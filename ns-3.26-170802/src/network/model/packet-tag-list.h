@@ -233,6 +233,11 @@ public:
    * Remove all tags from this list (up to the first merge).
    */
   inline void RemoveAll (void);
+  /**
+   * \returns a copy of the list whose TagData are not shared, and which
+   *          may be handed to another thread while this list is still used.
+   */
+  PacketTagList DeepCopy (void) const;
   /**
    * \returns pointer to head of tag list
    */
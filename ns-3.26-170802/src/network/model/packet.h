@@ -21,6 +21,7 @@
 #define PACKET_H
 
 #include <stdint.h>
+#include <atomic>
 #include "buffer.h"
 #include "header.h"
 #include "trailer.h"
@@ -244,6 +245,17 @@ public:
    * \return the copied object
    */
   Packet &operator = (const Packet &o);
+  /**
+   * \brief Allocate a packet with PacketAllocator.
+   * \param size the size of the packet
+   * \returns the memory of the packet
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * \brief Free a packet allocated with PacketAllocator.
+   * \param p the memory of the packet
+   */
+  static void operator delete (void *p);
   /**
    * \brief Create a packet with a zero-filled payload.
    *
@@ -424,6 +436,18 @@ public:
    */
   Ptr<Packet> Copy (void) const;
 
+  /**
+   * \brief performs a deep copy of the packet.
+   *
+   * \returns a copy of the packet sharing no data with it.
+   *
+   * Unlike Copy, the returned packet shares neither its buffer, nor its
+   * tags, nor its metadata with the original packet, and may be handed
+   * to another thread while the original packet is still used.  It has
+   * the same uid.
+   */
+  Ptr<Packet> DeepCopy (void) const;
+
   /**
    * \brief Returns the packet's Uid.
    *
@@ -727,7 +751,7 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
-  static uint32_t m_globalUid; //!< Global counter of packets Uid
+  static std::atomic<uint32_t> m_globalUid; //!< Global counter of packets Uid
 };
 
 /**
@@ -0,0 +1,321 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet-allocator.h"
+#include "ns3/packet.h"
+#include "ns3/config.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/system-thread.h"
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Restore the default configuration of the PacketAllocator.
+ */
+static void
+RestorePacketAllocatorDefaults (void)
+{
+  Config::SetGlobal ("PacketPoolEnabled", BooleanValue (true));
+  Config::SetGlobal ("PacketPoolMaxFreeBytes", UintegerValue (16 * 1024 * 1024));
+  Config::SetGlobal ("PacketPoolThreadLocal", BooleanValue (true));
+  PacketAllocator::Reconfigure ();
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Check that the freed blocks are reused, and the statistics.
+ */
+class PacketAllocatorReuseTestCase : public TestCase
+{
+public:
+  PacketAllocatorReuseTestCase ();
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+};
+
+PacketAllocatorReuseTestCase::PacketAllocatorReuseTestCase ()
+  : TestCase ("Check that the freed blocks are reused")
+{
+}
+
+void
+PacketAllocatorReuseTestCase::DoRun (void)
+{
+  RestorePacketAllocatorDefaults ();
+  PacketAllocator::Trim ();
+  PacketAllocator::ResetStatistics ();
+  PacketAllocator::Statistics initial = PacketAllocator::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (initial.freeBytes, 0, "free blocks left after Trim");
+
+  std::vector<void *> blocks;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      std::size_t usable;
+      blocks.push_back (PacketAllocator::Allocate (1000, usable));
+      NS_TEST_EXPECT_MSG_GT_OR_EQ (usable, 1000, "block too small");
+      NS_TEST_EXPECT_MSG_LT (usable, 2000, "block too large");
+    }
+  for (uint32_t i = 0; i < blocks.size (); i++)
+    {
+      PacketAllocator::Deallocate (blocks[i]);
+    }
+  blocks.clear ();
+  PacketAllocator::Statistics stats = PacketAllocator::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.allocations, 100, "unexpected number of allocations");
+  NS_TEST_EXPECT_MSG_EQ (stats.deallocations, 100, "unexpected number of deallocations");
+  NS_TEST_EXPECT_MSG_EQ (stats.heapAllocations, 100, "unexpected number of calls to malloc");
+  NS_TEST_EXPECT_MSG_EQ (stats.inUse, initial.inUse, "unexpected number of blocks in use");
+  NS_TEST_EXPECT_MSG_EQ (stats.maxInUse, initial.inUse + 100, "unexpected high-water mark");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (stats.freeBytes, 100 * 1000, "freed blocks not kept");
+  NS_TEST_EXPECT_MSG_EQ (stats.pooled, 0, "unexpected number of blocks from the free lists");
+
+  // the packets, their buffers and their metadata come from the pools
+  uint64_t allocations = stats.allocations;
+  uint64_t heapAllocations = stats.heapAllocations;
+  uint32_t recording = 0;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Ptr<Packet> packet = Create<Packet> (900);
+      Ptr<Packet> copy = packet->Copy ();
+      copy->AddPaddingAtEnd (10);
+      if (packet->BeginItem ().HasNext ())
+        {
+          recording++;
+        }
+    }
+  stats = PacketAllocator::GetStatistics ();
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (stats.heapAllocations - heapAllocations, 5, "packets not allocated from the pools");
+  // two packets and a buffer per iteration, and a metadata if recorded
+  NS_TEST_EXPECT_MSG_EQ (stats.allocations - allocations, 300 + recording, "unexpected number of allocations");
+  NS_TEST_EXPECT_MSG_EQ (stats.inUse, initial.inUse, "packet blocks not freed");
+
+  PacketAllocator::ResetStatistics ();
+  stats = PacketAllocator::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.allocations, 0, "statistics not reset");
+  NS_TEST_EXPECT_MSG_EQ (stats.maxInUse, stats.inUse, "high-water mark not reset");
+  NS_TEST_EXPECT_MSG_GT (stats.freeBytes, 0, "free bytes not kept over a reset");
+
+  PacketAllocator::Trim ();
+  stats = PacketAllocator::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.freeBytes, 0, "free blocks left after Trim");
+  NS_TEST_EXPECT_MSG_GT (stats.heapDeallocations, 0, "free blocks not given back");
+}
+
+void
+PacketAllocatorReuseTestCase::DoTeardown (void)
+{
+  RestorePacketAllocatorDefaults ();
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Check the bound of the free lists, and the disabled pools.
+ */
+class PacketAllocatorBoundTestCase : public TestCase
+{
+public:
+  PacketAllocatorBoundTestCase ();
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+};
+
+PacketAllocatorBoundTestCase::PacketAllocatorBoundTestCase ()
+  : TestCase ("Check the bound of the free lists and the disabled pools")
+{
+}
+
+void
+PacketAllocatorBoundTestCase::DoRun (void)
+{
+  Config::SetGlobal ("PacketPoolMaxFreeBytes", UintegerValue (10 * 1024));
+  PacketAllocator::Reconfigure ();
+  PacketAllocator::Trim ();
+  PacketAllocator::ResetStatistics ();
+
+  std::vector<void *> blocks;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      blocks.push_back (PacketAllocator::Allocate (1000));
+    }
+  for (uint32_t i = 0; i < blocks.size (); i++)
+    {
+      PacketAllocator::Deallocate (blocks[i]);
+    }
+  blocks.clear ();
+  PacketAllocator::Statistics stats = PacketAllocator::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.freeBytes, 10 * 1024, "free list not bounded");
+  NS_TEST_EXPECT_MSG_EQ (stats.heapDeallocations, 90, "blocks beyond the bound not given back");
+
+  // the blocks larger than the largest class always come from malloc
+  void *large = PacketAllocator::Allocate (PacketAllocator::MAX_POOLED_SIZE);
+  PacketAllocator::Deallocate (large);
+  stats = PacketAllocator::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.heapDeallocations, 91, "large block kept");
+
+  Config::SetGlobal ("PacketPoolEnabled", BooleanValue (false));
+  PacketAllocator::Reconfigure ();
+  NS_TEST_EXPECT_MSG_EQ (PacketAllocator::IsEnabled (), false, "pools not disabled");
+  PacketAllocator::ResetStatistics ();
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Ptr<Packet> packet = Create<Packet> (100);
+      packet->AddPaddingAtEnd (10);
+    }
+  stats = PacketAllocator::GetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.pooled, 0, "pools used while disabled");
+  NS_TEST_EXPECT_MSG_EQ (stats.heapAllocations, stats.allocations, "pools used while disabled");
+}
+
+void
+PacketAllocatorBoundTestCase::DoTeardown (void)
+{
+  RestorePacketAllocatorDefaults ();
+  PacketAllocator::Trim ();
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Check the pools of the threads.
+ */
+class PacketAllocatorThreadTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] threadLocal Whether each thread has its own pools.
+   */
+  PacketAllocatorThreadTestCase (bool threadLocal);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+private:
+  /**
+   * Create and copy packets, as a thread.
+   * \param [in] test The test case.
+   * \param [in] index The index of the thread.
+   */
+  static void Worker (PacketAllocatorThreadTestCase *test, uint32_t index);
+
+  bool m_threadLocal;                                   //!< Each thread has its own pools
+  std::vector<PacketAllocator::Statistics> m_stats;     //!< Statistics of each thread
+  std::vector<uint32_t> m_errors;                       //!< Errors of each thread
+};
+
+PacketAllocatorThreadTestCase::PacketAllocatorThreadTestCase (bool threadLocal)
+  : TestCase (threadLocal ? "Check the thread-local pools" : "Check the pools shared by the threads"),
+    m_threadLocal (threadLocal)
+{
+}
+
+void
+PacketAllocatorThreadTestCase::Worker (PacketAllocatorThreadTestCase *test, uint32_t index)
+{
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      Ptr<Packet> packet = Create<Packet> (100 + (index * 97 + i) % 1400);
+      uint32_t size = packet->GetSize ();
+      for (uint32_t j = 0; j < 4; j++)
+        {
+          Ptr<Packet> copy = packet->Copy ();
+          copy->AddPaddingAtEnd (j);
+          if (copy->GetSize () != size + j)
+            {
+              test->m_errors[index]++;
+            }
+        }
+    }
+  test->m_stats[index] = PacketAllocator::GetStatistics ();
+}
+
+void
+PacketAllocatorThreadTestCase::DoRun (void)
+{
+  Config::SetGlobal ("PacketPoolThreadLocal", BooleanValue (m_threadLocal));
+  PacketAllocator::Reconfigure ();
+  // read the GlobalValues before starting the threads
+  PacketAllocator::IsEnabled ();
+  PacketAllocator::ResetStatistics ();
+
+  const uint32_t nThreads = 4;
+  m_stats.assign (nThreads, PacketAllocator::Statistics ());
+  m_errors.assign (nThreads, 0);
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < nThreads; i++)
+    {
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (&PacketAllocatorThreadTestCase::Worker, this, i)));
+      threads.back ()->Start ();
+    }
+  for (uint32_t i = 0; i < nThreads; i++)
+    {
+      threads[i]->Join ();
+    }
+  for (uint32_t i = 0; i < nThreads; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_errors[i], 0, "unexpected packet size in thread " << i);
+      if (m_threadLocal)
+        {
+          // each thread only sees its own blocks
+          NS_TEST_EXPECT_MSG_EQ (m_stats[i].allocations, m_stats[i].deallocations,
+                                 "unexpected statistics in thread " << i);
+          NS_TEST_EXPECT_MSG_GT (m_stats[i].pooled, 0, "pools not used in thread " << i);
+        }
+    }
+  if (!m_threadLocal)
+    {
+      PacketAllocator::Statistics stats = PacketAllocator::GetStatistics ();
+      NS_TEST_EXPECT_MSG_EQ (stats.allocations, stats.deallocations, "unexpected shared statistics");
+      NS_TEST_EXPECT_MSG_GT_OR_EQ (stats.allocations, nThreads * 2000 * 5, "unexpected shared statistics");
+    }
+}
+
+void
+PacketAllocatorThreadTestCase::DoTeardown (void)
+{
+  RestorePacketAllocatorDefaults ();
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * PacketAllocator test suite.
+ */
+class PacketAllocatorTestSuite : public TestSuite
+{
+public:
+  PacketAllocatorTestSuite ()
+    : TestSuite ("packet-allocator", UNIT)
+  {
+    AddTestCase (new PacketAllocatorReuseTestCase, TestCase::QUICK);
+    AddTestCase (new PacketAllocatorBoundTestCase, TestCase::QUICK);
+    AddTestCase (new PacketAllocatorThreadTestCase (false), TestCase::QUICK);
+    AddTestCase (new PacketAllocatorThreadTestCase (true), TestCase::QUICK);
+  }
+};
+
+static PacketAllocatorTestSuite g_packetAllocatorTestSuite;
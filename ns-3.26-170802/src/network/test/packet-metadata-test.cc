@@ -25,6 +25,10 @@
 #include "ns3/trailer.h"
 #include "ns3/packet.h"
 #include "ns3/packet-metadata.h"
+#include "ns3/packet-metadata-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
 
 using namespace ns3;
 
@@ -821,6 +825,137 @@ PacketMetadataTest::DoRun (void)
                                  p3->GetSize ());
   delete [] buf;
   NS_TEST_EXPECT_MSG_EQ (msg, std::string ("hello world"), "Could not find original data in received packet");
+
+  // A header added in place to a fragment, in data shared with the packet
+  // it was taken from, must leave the history of that packet unchanged.
+  p = Create<Packet> (100);
+  p->AddAtEnd (Create<Packet> (100));
+  p1 = p->CreateFragment (100, 100);
+  ADD_HEADER (p1, 10);
+  CHECK_HISTORY (p1, 2, 10, 100);
+  p2 = p->CreateFragment (0, 150);
+  CHECK_HISTORY (p2, 2, 100, 50);
+  CHECK_HISTORY (p, 2, 100, 100);
+}
+//-----------------------------------------------------------------------------
+class PacketMetadataNodeTest : public TestCase {
+public:
+  PacketMetadataNodeTest ();
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+private:
+  /**
+   * Create a packet with a header, from the context of a node.
+   * \param index the index of the packet in m_packets
+   */
+  void CreatePacket (uint32_t index);
+  /**
+   * \param p a packet
+   * \returns the number of metadata items of the packet
+   */
+  static uint32_t CountItems (Ptr<const Packet> p);
+  Ptr<Packet> m_packets[3]; //!< packets created by each node
+};
+
+PacketMetadataNodeTest::PacketMetadataNodeTest ()
+  : TestCase ("Packet metadata recorded for selected nodes only")
+{
+}
+
+void
+PacketMetadataNodeTest::CreatePacket (uint32_t index)
+{
+  Ptr<Packet> p = Create<Packet> (10);
+  p->AddHeader (HistoryHeader<4> ());
+  m_packets[index] = p;
+}
+
+uint32_t
+PacketMetadataNodeTest::CountItems (Ptr<const Packet> p)
+{
+  uint32_t n = 0;
+  PacketMetadata::ItemIterator k = p->BeginItem ();
+  while (k.HasNext ())
+    {
+      k.Next ();
+      n++;
+    }
+  return n;
+}
+
+void
+PacketMetadataNodeTest::DoRun (void)
+{
+  PacketMetadata::Disable ();
+  Ptr<Packet> p = Create<Packet> (10);
+  p->AddHeader (HistoryHeader<4> ());
+  NS_TEST_EXPECT_MSG_EQ (CountItems (p), 0, "metadata recorded while disabled");
+
+  Ptr<Node> nodes[3];
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      nodes[i] = CreateObject<Node> ();
+    }
+  Ptr<NetDevice> device = CreateObject<SimpleNetDevice> ();
+  nodes[2]->AddDevice (device);
+  PacketMetadataHelper helper;
+  helper.Enable (nodes[1]);
+  helper.Enable (device->GetNode ());
+  p = Create<Packet> (10);
+  NS_TEST_EXPECT_MSG_EQ (CountItems (p), 0, "metadata recorded outside of a node");
+
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Simulator::ScheduleWithContext (nodes[i]->GetId (), Seconds (0),
+                                      &PacketMetadataNodeTest::CreatePacket, this, i);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (CountItems (m_packets[0]), 0, "metadata recorded for a node not selected");
+  NS_TEST_EXPECT_MSG_EQ (CountItems (m_packets[1]), 2, "metadata not recorded for a selected node");
+  NS_TEST_EXPECT_MSG_EQ (CountItems (m_packets[2]), 2, "metadata not recorded for the node of a device");
+
+  // the copies and fragments of a packet record its metadata, anywhere
+  Ptr<Packet> copy = m_packets[1]->Copy ();
+  copy->AddHeader (HistoryHeader<2> ());
+  NS_TEST_EXPECT_MSG_EQ (CountItems (copy), 3, "metadata of a copy not recorded");
+  Ptr<Packet> fragment = copy->CreateFragment (1, 10);
+  NS_TEST_EXPECT_MSG_EQ (CountItems (fragment), 3, "metadata of a fragment not recorded");
+  copy->RemoveAtStart (3);
+  NS_TEST_EXPECT_MSG_EQ (CountItems (copy), 2, "metadata not trimmed");
+
+  // the bytes of a packet which does not record are appended as padding
+  copy = m_packets[1]->Copy ();
+  copy->AddAtEnd (m_packets[0]);
+  NS_TEST_EXPECT_MSG_EQ (copy->GetSize (), 28, "unexpected size");
+  NS_TEST_EXPECT_MSG_EQ (CountItems (copy), 2, "unexpected metadata");
+  copy = m_packets[0]->Copy ();
+  copy->AddAtEnd (m_packets[1]);
+  NS_TEST_EXPECT_MSG_EQ (CountItems (copy), 0, "metadata recorded for a packet not recording");
+
+  // the recording survives the serialization
+  uint32_t size = m_packets[1]->GetSerializedSize ();
+  uint8_t *buffer = new uint8_t[size];
+  m_packets[1]->Serialize (buffer, size);
+  Ptr<Packet> other = Create<Packet> (buffer, size, true);
+  NS_TEST_EXPECT_MSG_EQ (CountItems (other), 2, "metadata lost by the serialization");
+  size = m_packets[0]->GetSerializedSize ();
+  m_packets[0]->Serialize (buffer, size);
+  other = Create<Packet> (buffer, size, true);
+  NS_TEST_EXPECT_MSG_EQ (CountItems (other), 0, "metadata created by the serialization");
+  delete [] buffer;
+
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      m_packets[i] = 0;
+    }
+}
+
+void
+PacketMetadataNodeTest::DoTeardown (void)
+{
+  PacketMetadata::Disable ();
 }
 //-----------------------------------------------------------------------------
 class PacketMetadataTestSuite : public TestSuite
@@ -833,6 +968,7 @@ PacketMetadataTestSuite::PacketMetadataTestSuite ()
   : TestSuite ("packet-metadata", UNIT)
 {
   AddTestCase (new PacketMetadataTest, TestCase::QUICK);
+  AddTestCase (new PacketMetadataNodeTest, TestCase::QUICK);
 }
 
 PacketMetadataTestSuite g_packetMetadataTest;
@@ -582,6 +582,37 @@ PacketTest::DoRun (void)
     tmp->AddPaddingAtEnd (50);
     CHECK (tmp, 1, E (25, 0, 50));
   }
+
+  /* Test DeepCopy: the copy shares no storage with the original. */
+  {
+    Ptr<Packet> tmp = Create<Packet> (reinterpret_cast<const uint8_t*> ("hello world"), 11);
+    tmp->AddHeader (ATestHeader<10> ());
+    tmp->AddByteTag (ATestTag<20> ());
+    tmp->AddPacketTag (ATestTag<3> (7));
+    Ptr<Packet> copy = tmp->DeepCopy ();
+    NS_TEST_EXPECT_MSG_EQ (copy->GetUid (), tmp->GetUid (), "DeepCopy keeps the uid");
+    NS_TEST_EXPECT_MSG_EQ (copy->GetSize (), 21, "DeepCopy keeps the size");
+    CHECK (copy, 1, E (20, 0, 21));
+    ATestTag<3> tag;
+    NS_TEST_EXPECT_MSG_EQ (copy->PeekPacketTag (tag), true, "DeepCopy keeps the packet tags");
+    NS_TEST_EXPECT_MSG_EQ (tag.GetData (), 7, "DeepCopy keeps the packet tags");
+
+    copy->RemoveAtStart (10);
+    uint8_t buf[11];
+    copy->CopyData (buf, 11);
+    NS_TEST_EXPECT_MSG_EQ (std::string (reinterpret_cast<const char *> (buf), 11), "hello world",
+                           "DeepCopy keeps the bytes");
+    copy->AddByteTag (ATestTag<21> ());
+    copy->RemovePacketTag (tag);
+    copy->AddPaddingAtEnd (5);
+
+    NS_TEST_EXPECT_MSG_EQ (tmp->GetSize (), 21, "the original keeps its size");
+    CHECK (tmp, 1, E (20, 0, 21));
+    NS_TEST_EXPECT_MSG_EQ (tmp->PeekPacketTag (tag), true, "the original keeps its packet tags");
+    ATestHeader<10> h;
+    tmp->RemoveHeader (h);
+    NS_TEST_EXPECT_MSG_EQ (h.m_error, false, "the original keeps its bytes");
+  }
 }
 //--------------------------------------
 class PacketTagListTest : public TestCase
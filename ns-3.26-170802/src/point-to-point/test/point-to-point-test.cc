@@ -23,6 +23,12 @@
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+
+#include <vector>
 
 using namespace ns3;
 
@@ -100,6 +106,170 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test of the MultithreadedSimulatorImpl on PointToPoint links
+ *
+ * Two nodes send packets to a third one over links of different delays,
+ * with the MultithreadedSimulatorImpl run by a single thread, and the
+ * packets must arrive at the same times as with the DefaultSimulatorImpl.
+ * The lookahead is derived from the smallest delay of the links.
+ */
+class PointToPointMultithreadedTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointMultithreadedTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+  /**
+   * \brief Restore the default simulator implementation
+   */
+  virtual void DoTeardown (void);
+
+private:
+  /**
+   * \brief Connect two nodes with a PointToPoint link
+   *
+   * \param a first node
+   * \param b second node
+   * \param delay the delay of the link
+   * \returns the devices of the link, on a then on b
+   */
+  std::pair<Ptr<PointToPointNetDevice>, Ptr<PointToPointNetDevice> >
+  Connect (Ptr<Node> a, Ptr<Node> b, Time delay);
+
+  /**
+   * \brief Send one packet to the other end of the link
+   *
+   * \param device the NetDevice to send from
+   */
+  void SendOnePacket (Ptr<PointToPointNetDevice> device);
+
+  /**
+   * \brief Record the reception of a packet
+   *
+   * \param device the receiving NetDevice
+   * \param packet the packet
+   * \param protocol the protocol of the packet
+   * \param from the sender
+   * \returns true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  /**
+   * \brief Run the topology
+   *
+   * \param simulatorType the simulator implementation type
+   * \returns the reception times of the packets
+   */
+  std::vector<Time> RunTopology (std::string simulatorType);
+
+  std::vector<Time> m_received; //!< Reception times of the packets
+};
+
+PointToPointMultithreadedTest::PointToPointMultithreadedTest ()
+  : TestCase ("PointToPoint with the MultithreadedSimulatorImpl")
+{
+}
+
+std::pair<Ptr<PointToPointNetDevice>, Ptr<PointToPointNetDevice> >
+PointToPointMultithreadedTest::Connect (Ptr<Node> a, Ptr<Node> b, Time delay)
+{
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (delay));
+  Ptr<Node> nodes[2] = { a, b };
+  Ptr<PointToPointNetDevice> devices[2];
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      devices[i] = CreateObject<PointToPointNetDevice> ();
+      devices[i]->SetDataRate (DataRate ("100Mb/s"));
+      devices[i]->Attach (channel);
+      devices[i]->SetAddress (Mac48Address::Allocate ());
+      devices[i]->SetQueue (CreateObject<DropTailQueue> ());
+      nodes[i]->AddDevice (devices[i]);
+      Ptr<NetDeviceQueueInterface> iface = CreateObject<NetDeviceQueueInterface> ();
+      devices[i]->AggregateObject (iface);
+      iface->CreateTxQueues ();
+      devices[i]->SetReceiveCallback (MakeCallback (&PointToPointMultithreadedTest::Receive, this));
+    }
+  return std::make_pair (devices[0], devices[1]);
+}
+
+void
+PointToPointMultithreadedTest::SendOnePacket (Ptr<PointToPointNetDevice> device)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  device->Send (p, device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointMultithreadedTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                        uint16_t protocol, const Address &from)
+{
+  m_received.push_back (Simulator::Now ());
+  return true;
+}
+
+std::vector<Time>
+PointToPointMultithreadedTest::RunTopology (std::string simulatorType)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (simulatorType));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (1));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::PartitionCount", UintegerValue (3));
+
+  m_received.clear ();
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<Node> c = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> fromA = Connect (a, b, MilliSeconds (3)).first;
+  Ptr<PointToPointNetDevice> fromC = Connect (c, b, MilliSeconds (2)).first;
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Simulator::ScheduleWithContext (a->GetId (), MicroSeconds (700 * i),
+                                      &PointToPointMultithreadedTest::SendOnePacket, this, fromA);
+      Simulator::ScheduleWithContext (c->GetId (), MicroSeconds (500 * i),
+                                      &PointToPointMultithreadedTest::SendOnePacket, this, fromC);
+    }
+  Simulator::Run ();
+
+  Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  if (impl != 0)
+    {
+      NS_TEST_EXPECT_MSG_EQ (impl->GetLookahead (), MilliSeconds (2), "lookahead not derived from the links");
+      NS_TEST_EXPECT_MSG_GT (impl->GetWindowCount (), 0, "no window run");
+      NS_TEST_EXPECT_MSG_LT (impl->GetWindowCount (), 20, "the windows should span several events");
+    }
+  Simulator::Destroy ();
+  return m_received;
+}
+
+void
+PointToPointMultithreadedTest::DoRun (void)
+{
+  std::vector<Time> expected = RunTopology ("ns3::DefaultSimulatorImpl");
+  std::vector<Time> received = RunTopology ("ns3::MultithreadedSimulatorImpl");
+  NS_TEST_ASSERT_MSG_EQ (expected.size (), 20, "unexpected number of packets");
+  NS_TEST_ASSERT_MSG_EQ (received.size (), expected.size (), "unexpected number of packets");
+  for (uint32_t i = 0; i < received.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (received[i], expected[i], "unexpected reception time of packet " << i);
+    }
+}
+
+void
+PointToPointMultithreadedTest::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (0));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::PartitionCount", UintegerValue (0));
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -116,6 +286,7 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointMultithreadedTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
@@ -0,0 +1,250 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "cached-propagation-loss-model.h"
+#include "ns3/log.h"
+#include "ns3/mobility-model.h"
+#include "ns3/pointer.h"
+#include "ns3/abort.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CachedPropagationLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED (CachedPropagationLossModel);
+
+TypeId
+CachedPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CachedPropagationLossModel")
+    .SetParent<PropagationLossModel> ()
+    .SetGroupName ("Propagation")
+    .AddConstructor<CachedPropagationLossModel> ()
+    .AddAttribute ("Model",
+                   "The deterministic propagation loss model whose results are cached. "
+                   "Models drawing random variables, or with a model chained to them, are rejected.",
+                   PointerValue (),
+                   MakePointerAccessor (&CachedPropagationLossModel::DoSetModel,
+                                        &CachedPropagationLossModel::GetModel),
+                   MakePointerChecker<PropagationLossModel> ())
+  ;
+  return tid;
+}
+
+CachedPropagationLossModel::CachedPropagationLossModel ()
+  : m_model (0),
+    m_hits (0),
+    m_misses (0),
+    m_bypasses (0),
+    m_invalidations (0)
+{
+}
+
+CachedPropagationLossModel::~CachedPropagationLossModel ()
+{
+  Flush ();
+}
+
+void
+CachedPropagationLossModel::DoDispose (void)
+{
+  Flush ();
+  m_model = 0;
+  PropagationLossModel::DoDispose ();
+}
+
+void
+CachedPropagationLossModel::SetModel (Ptr<PropagationLossModel> model)
+{
+  NS_LOG_FUNCTION (this << model);
+  NS_ABORT_MSG_UNLESS (CanCache (model),
+                       "CachedPropagationLossModel: the cached model must be deterministic, with no next model; "
+                       "chain the other models to the CachedPropagationLossModel instead");
+  Flush ();
+  m_model = model;
+}
+
+bool
+CachedPropagationLossModel::DoSetModel (Ptr<PropagationLossModel> model)
+{
+  NS_LOG_FUNCTION (this << model);
+  if (!CanCache (model))
+    {
+      NS_LOG_WARN ("Rejecting model " << model << ", which is not deterministic or has a next model");
+      return false;
+    }
+  SetModel (model);
+  return true;
+}
+
+bool
+CachedPropagationLossModel::CanCache (Ptr<PropagationLossModel> model)
+{
+  return model == 0 || (model->GetNext () == 0 && model->IsDeterministic ());
+}
+
+Ptr<PropagationLossModel>
+CachedPropagationLossModel::GetModel (void) const
+{
+  return m_model;
+}
+
+void
+CachedPropagationLossModel::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (PeerMap::iterator i = m_peers.begin (); i != m_peers.end (); ++i)
+    {
+      i->first->TraceDisconnectWithoutContext ("CourseChange",
+                                               MakeCallback (&CachedPropagationLossModel::NotifyCourseChange, this));
+    }
+  m_peers.clear ();
+  m_cache.clear ();
+}
+
+uint64_t
+CachedPropagationLossModel::GetHits (void) const
+{
+  return m_hits;
+}
+
+uint64_t
+CachedPropagationLossModel::GetMisses (void) const
+{
+  return m_misses;
+}
+
+uint64_t
+CachedPropagationLossModel::GetBypasses (void) const
+{
+  return m_bypasses;
+}
+
+uint64_t
+CachedPropagationLossModel::GetInvalidations (void) const
+{
+  return m_invalidations;
+}
+
+uint32_t
+CachedPropagationLossModel::GetSize (void) const
+{
+  return m_cache.size ();
+}
+
+void
+CachedPropagationLossModel::ResetStats (void)
+{
+  m_hits = 0;
+  m_misses = 0;
+  m_bypasses = 0;
+  m_invalidations = 0;
+}
+
+void
+CachedPropagationLossModel::Track (Ptr<MobilityModel> mobility) const
+{
+  if (m_peers.find (mobility) == m_peers.end ())
+    {
+      mobility->TraceConnectWithoutContext ("CourseChange",
+                                            MakeCallback (&CachedPropagationLossModel::NotifyCourseChange, this));
+      m_peers[mobility];
+    }
+}
+
+void
+CachedPropagationLossModel::NotifyCourseChange (Ptr<const MobilityModel> mobility) const
+{
+  NS_LOG_FUNCTION (this << mobility);
+  PeerMap::iterator i = m_peers.find (ConstCast<MobilityModel> (mobility));
+  if (i == m_peers.end ())
+    {
+      return;
+    }
+  const MobilityModel *self = PeekPointer (mobility);
+  for (std::set<const MobilityModel *>::const_iterator j = i->second.begin (); j != i->second.end (); ++j)
+    {
+      m_invalidations += m_cache.erase (std::make_pair (self, *j));
+      m_invalidations += m_cache.erase (std::make_pair (*j, self));
+      if (*j != self)
+        {
+          PeerMap::iterator peer = m_peers.find (ConstCast<MobilityModel> (Ptr<const MobilityModel> (*j)));
+          if (peer != m_peers.end ())
+            {
+              peer->second.erase (self);
+            }
+        }
+    }
+  i->second.clear ();
+}
+
+double
+CachedPropagationLossModel::DoCalcRxPower (double txPowerDbm,
+                                           Ptr<MobilityModel> a,
+                                           Ptr<MobilityModel> b) const
+{
+  NS_ASSERT_MSG (m_model != 0, "CachedPropagationLossModel requires a Model to wrap");
+  Vector va = a->GetVelocity ();
+  Vector vb = b->GetVelocity ();
+  if (va.x != 0 || va.y != 0 || va.z != 0 || vb.x != 0 || vb.y != 0 || vb.z != 0)
+    {
+      m_bypasses++;
+      return m_model->CalcRxPower (txPowerDbm, a, b);
+    }
+  PathKey key = std::make_pair (PeekPointer (a), PeekPointer (b));
+  PathCache::iterator it = m_cache.find (key);
+  if (it != m_cache.end () && it->second.txPowerDbm == txPowerDbm)
+    {
+      m_hits++;
+      return it->second.rxPowerDbm;
+    }
+  m_misses++;
+  double rxPowerDbm = m_model->CalcRxPower (txPowerDbm, a, b);
+  NS_LOG_DEBUG ("caching path " << a << "->" << b << " tx=" << txPowerDbm << "dBm rx=" << rxPowerDbm << "dBm");
+  if (it != m_cache.end ())
+    {
+      it->second.txPowerDbm = txPowerDbm;
+      it->second.rxPowerDbm = rxPowerDbm;
+      return rxPowerDbm;
+    }
+  Entry entry;
+  entry.txPowerDbm = txPowerDbm;
+  entry.rxPowerDbm = rxPowerDbm;
+  m_cache.insert (std::make_pair (key, entry));
+  Track (a);
+  Track (b);
+  m_peers[a].insert (PeekPointer (b));
+  m_peers[b].insert (PeekPointer (a));
+  return rxPowerDbm;
+}
+
+int64_t
+CachedPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  if (m_model == 0)
+    {
+      return 0;
+    }
+  return m_model->AssignStreams (stream);
+}
+
+bool
+CachedPropagationLossModel::DoIsDeterministic (void) const
+{
+  return m_model == 0 || m_model->IsDeterministic ();
+}
+
+} // namespace ns3
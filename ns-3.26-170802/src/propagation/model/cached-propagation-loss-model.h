@@ -0,0 +1,191 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef CACHED_PROPAGATION_LOSS_MODEL_H
+#define CACHED_PROPAGATION_LOSS_MODEL_H
+
+#include "propagation-loss-model.h"
+#include <map>
+#include <set>
+
+namespace ns3 {
+
+class MobilityModel;
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Memoize the result of a deterministic propagation loss model.
+ *
+ * This model wraps another PropagationLossModel (the "Model" attribute)
+ * and remembers, for each ordered pair of mobility models, the receive
+ * power it returned for the last transmit power.  Later calls for the
+ * same pair and the same transmit power are answered from the cache
+ * without evaluating the wrapped model.
+ *
+ * The wrapped model must be deterministic: its result may depend only
+ * on the transmit power and on the positions of the two nodes (see
+ * PropagationLossModel::IsDeterministic), and it must have no model
+ * chained to it with SetNext().  Other models are rejected.  Models to
+ * apply after the cached one, such as the stochastic
+ * NakagamiPropagationLossModel, should be chained to this model
+ * instead, in which case they are evaluated for every call as usual:
+ *
+ * \code
+ *   Ptr<CachedPropagationLossModel> cached = CreateObject<CachedPropagationLossModel> ();
+ *   cached->SetModel (CreateObject<LogDistancePropagationLossModel> ());
+ *   cached->SetNext (CreateObject<NakagamiPropagationLossModel> ());
+ * \endcode
+ *
+ * A cache entry is dropped whenever one of its two mobility models
+ * fires its CourseChange trace.  Pairs in which either node has a
+ * non-zero velocity are never cached, since such nodes move without
+ * notifying a course change.
+ */
+class CachedPropagationLossModel : public PropagationLossModel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  CachedPropagationLossModel ();
+  virtual ~CachedPropagationLossModel ();
+
+  /**
+   * \param model the deterministic loss model whose results are cached
+   *
+   * Setting a new model flushes the cache.  The simulation is aborted
+   * if the model cannot be cached, see CanCache.
+   */
+  void SetModel (Ptr<PropagationLossModel> model);
+  /**
+   * \param model a loss model
+   * \return true if the model is deterministic, with no model chained to
+   * it, so that its results can be cached
+   */
+  static bool CanCache (Ptr<PropagationLossModel> model);
+  /**
+   * \return the loss model whose results are cached
+   */
+  Ptr<PropagationLossModel> GetModel (void) const;
+
+  /**
+   * Drop all cache entries and stop listening to course changes.
+   * The hit/miss statistics are left untouched.
+   */
+  void Flush (void);
+
+  /**
+   * \return the number of calls answered from the cache
+   */
+  uint64_t GetHits (void) const;
+  /**
+   * \return the number of calls which evaluated the wrapped model and
+   * stored the result
+   */
+  uint64_t GetMisses (void) const;
+  /**
+   * \return the number of calls which evaluated the wrapped model without
+   * caching the result because one of the nodes was moving
+   */
+  uint64_t GetBypasses (void) const;
+  /**
+   * \return the number of cache entries dropped because of course changes
+   */
+  uint64_t GetInvalidations (void) const;
+  /**
+   * \return the number of cache entries currently stored
+   */
+  uint32_t GetSize (void) const;
+  /**
+   * Reset the hit, miss, bypass and invalidation counters to zero.
+   */
+  void ResetStats (void);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  CachedPropagationLossModel (const CachedPropagationLossModel &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  CachedPropagationLossModel & operator = (const CachedPropagationLossModel &);
+
+  virtual double DoCalcRxPower (double txPowerDbm,
+                                Ptr<MobilityModel> a,
+                                Ptr<MobilityModel> b) const;
+  virtual int64_t DoAssignStreams (int64_t stream);
+  virtual bool DoIsDeterministic (void) const;
+
+  /**
+   * Set the model through the Model attribute.
+   *
+   * \param model the loss model whose results are cached
+   * \return false, leaving the model unchanged, if the model cannot be
+   * cached
+   */
+  bool DoSetModel (Ptr<PropagationLossModel> model);
+
+  /**
+   * Start listening to the course changes of a mobility model.
+   *
+   * \param mobility the mobility model
+   */
+  void Track (Ptr<MobilityModel> mobility) const;
+  /**
+   * Drop all cache entries involving the mobility model which moved.
+   *
+   * \param mobility the mobility model which fired its CourseChange trace
+   */
+  void NotifyCourseChange (Ptr<const MobilityModel> mobility) const;
+
+  /// A cached result: receive power for a given transmit power
+  struct Entry
+  {
+    double txPowerDbm; //!< transmit power the entry was computed for
+    double rxPowerDbm; //!< receive power returned by the wrapped model
+  };
+  /// Ordered (sender, receiver) pair of mobility models
+  typedef std::pair<const MobilityModel *, const MobilityModel *> PathKey;
+  /// Cached results, indexed by path
+  typedef std::map<PathKey, Entry> PathCache;
+  /// For each tracked mobility model, the peers it has a cache entry with
+  typedef std::map<Ptr<MobilityModel>, std::set<const MobilityModel *> > PeerMap;
+
+  Ptr<PropagationLossModel> m_model; //!< wrapped deterministic model
+  mutable PathCache m_cache;         //!< cached results
+  mutable PeerMap m_peers;           //!< tracked mobility models and their peers
+  mutable uint64_t m_hits;           //!< number of cache hits
+  mutable uint64_t m_misses;         //!< number of cache misses
+  mutable uint64_t m_bypasses;       //!< number of uncacheable calls
+  mutable uint64_t m_invalidations;  //!< number of entries dropped on course changes
+};
+
+} // namespace ns3
+
+#endif /* CACHED_PROPAGATION_LOSS_MODEL_H */
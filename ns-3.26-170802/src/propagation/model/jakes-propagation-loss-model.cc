@@ -79,5 +79,11 @@ JakesPropagationLossModel::DoAssignStreams (int64_t stream)
   return 1;
 }
 
+bool
+JakesPropagationLossModel::DoIsDeterministic (void) const
+{
+  return false;
+}
+
 } // namespace ns3
 
@@ -94,6 +94,25 @@ PropagationLossModel::AssignStreams (int64_t stream)
   return (currentStream - stream);
 }
 
+bool
+PropagationLossModel::IsDeterministic (void) const
+{
+  for (const PropagationLossModel *model = this; model != 0; model = PeekPointer (model->m_next))
+    {
+      if (!model->DoIsDeterministic ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+bool
+PropagationLossModel::DoIsDeterministic (void) const
+{
+  return true;
+}
+
 // ------------------------------------------------------------------------- //
 
 NS_OBJECT_ENSURE_REGISTERED (RandomPropagationLossModel);
@@ -138,6 +157,12 @@ RandomPropagationLossModel::DoAssignStreams (int64_t stream)
   return 1;
 }
 
+bool
+RandomPropagationLossModel::DoIsDeterministic (void) const
+{
+  return false;
+}
+
 // ------------------------------------------------------------------------- //
 
 NS_OBJECT_ENSURE_REGISTERED (FriisPropagationLossModel);
@@ -757,6 +782,12 @@ NakagamiPropagationLossModel::DoAssignStreams (int64_t stream)
   return 2;
 }
 
+bool
+NakagamiPropagationLossModel::DoIsDeterministic (void) const
+{
+  return false;
+}
+
 // ------------------------------------------------------------------------- //
 
 NS_OBJECT_ENSURE_REGISTERED (FixedRssLossModel);
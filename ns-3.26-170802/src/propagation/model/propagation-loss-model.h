@@ -106,6 +106,13 @@ public:
    */
   int64_t AssignStreams (int64_t stream);
 
+  /**
+   * \returns true if the reception power computed by this model, and by
+   * the models chained to it, depends only on the transmission power
+   * and on the positions of the nodes
+   */
+  bool IsDeterministic (void) const;
+
 private:
   /**
    * \brief Copy constructor
@@ -140,6 +147,15 @@ private:
    */
   virtual int64_t DoAssignStreams (int64_t stream) = 0;
 
+  /**
+   * Subclasses drawing random variables, or otherwise not computing the
+   * same reception power for the same transmission power and positions,
+   * must return false.
+   *
+   * \returns true if this model, alone, is deterministic
+   */
+  virtual bool DoIsDeterministic (void) const;
+
   Ptr<PropagationLossModel> m_next; //!< Next propagation loss model in the list
 };
 
@@ -178,6 +194,7 @@ private:
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual bool DoIsDeterministic (void) const;
   Ptr<RandomVariableStream> m_variable; //!< random generator
 };
 
@@ -684,6 +701,7 @@ private:
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual bool DoIsDeterministic (void) const;
 
   double m_distance1; //!< Distance1
   double m_distance2; //!< Distance2
@@ -0,0 +1,207 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/jakes-propagation-loss-model.h"
+#include "ns3/pointer.h"
+#include "ns3/cached-propagation-loss-model.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("CachedPropagationLossModelTest");
+
+/**
+ * Check that CachedPropagationLossModel returns exactly the results of
+ * the model it wraps, that it reuses them for static nodes, and that it
+ * drops them when a node moves.
+ */
+class CachedPropagationLossModelTestCase : public TestCase
+{
+public:
+  CachedPropagationLossModelTestCase ();
+  virtual ~CachedPropagationLossModelTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CachedPropagationLossModelTestCase::CachedPropagationLossModelTestCase ()
+  : TestCase ("Check CachedPropagationLossModel hits, misses and invalidation")
+{
+}
+
+CachedPropagationLossModelTestCase::~CachedPropagationLossModelTestCase ()
+{
+}
+
+void
+CachedPropagationLossModelTestCase::DoRun (void)
+{
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (0, 0, 0));
+  Ptr<MobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  b->SetPosition (Vector (50, 0, 0));
+  Ptr<MobilityModel> c = CreateObject<ConstantPositionMobilityModel> ();
+  c->SetPosition (Vector (0, 120, 0));
+
+  Ptr<LogDistancePropagationLossModel> reference = CreateObject<LogDistancePropagationLossModel> ();
+  Ptr<CachedPropagationLossModel> cached = CreateObject<CachedPropagationLossModel> ();
+  cached->SetModel (CreateObject<LogDistancePropagationLossModel> ());
+
+  double txPowerDbm = 16.0206;
+
+  // First evaluation of each path is a miss, the following ones are hits.
+  for (uint32_t round = 0; round < 3; round++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (cached->CalcRxPower (txPowerDbm, a, b), reference->CalcRxPower (txPowerDbm, a, b), "a->b differs from wrapped model");
+      NS_TEST_EXPECT_MSG_EQ (cached->CalcRxPower (txPowerDbm, b, a), reference->CalcRxPower (txPowerDbm, b, a), "b->a differs from wrapped model");
+      NS_TEST_EXPECT_MSG_EQ (cached->CalcRxPower (txPowerDbm, a, c), reference->CalcRxPower (txPowerDbm, a, c), "a->c differs from wrapped model");
+    }
+  NS_TEST_EXPECT_MSG_EQ (cached->GetMisses (), 3, "unexpected number of misses");
+  NS_TEST_EXPECT_MSG_EQ (cached->GetHits (), 6, "unexpected number of hits");
+  NS_TEST_EXPECT_MSG_EQ (cached->GetSize (), 3, "unexpected cache size");
+
+  // A different transmit power replaces the entry for that path.
+  NS_TEST_EXPECT_MSG_EQ (cached->CalcRxPower (10.0, a, b), reference->CalcRxPower (10.0, a, b), "a->b differs after tx power change");
+  NS_TEST_EXPECT_MSG_EQ (cached->GetMisses (), 4, "tx power change should miss");
+  NS_TEST_EXPECT_MSG_EQ (cached->GetSize (), 3, "tx power change should not add an entry");
+
+  // Moving b drops both a->b and b->a but keeps a->c.
+  b->SetPosition (Vector (200, 0, 0));
+  NS_TEST_EXPECT_MSG_EQ (cached->GetInvalidations (), 2, "course change should drop two entries");
+  NS_TEST_EXPECT_MSG_EQ (cached->GetSize (), 1, "unexpected cache size after course change");
+  NS_TEST_EXPECT_MSG_EQ (cached->CalcRxPower (txPowerDbm, a, b), reference->CalcRxPower (txPowerDbm, a, b), "stale result after course change");
+  NS_TEST_EXPECT_MSG_EQ (cached->CalcRxPower (txPowerDbm, a, c), reference->CalcRxPower (txPowerDbm, a, c), "a->c differs from wrapped model");
+  NS_TEST_EXPECT_MSG_EQ (cached->GetMisses (), 5, "unexpected number of misses after course change");
+  NS_TEST_EXPECT_MSG_EQ (cached->GetHits (), 7, "unexpected number of hits after course change");
+
+  // Nodes with a velocity move silently and are never cached.
+  Ptr<ConstantVelocityMobilityModel> d = CreateObject<ConstantVelocityMobilityModel> ();
+  d->SetPosition (Vector (10, 10, 0));
+  d->SetVelocity (Vector (1, 0, 0));
+  cached->CalcRxPower (txPowerDbm, a, d);
+  cached->CalcRxPower (txPowerDbm, a, d);
+  NS_TEST_EXPECT_MSG_EQ (cached->GetBypasses (), 2, "moving node should bypass the cache");
+  NS_TEST_EXPECT_MSG_EQ (cached->GetSize (), 2, "moving node should not be cached");
+
+  // Stochastic models chained after the cache are evaluated on each call.
+  Ptr<RandomPropagationLossModel> random = CreateObject<RandomPropagationLossModel> ();
+  random->SetAttribute ("Variable", StringValue ("ns3::UniformRandomVariable[Min=0.0|Max=10.0]"));
+  cached->SetNext (random);
+  double first = cached->CalcRxPower (txPowerDbm, a, c);
+  bool changed = false;
+  for (uint32_t i = 0; i < 10 && !changed; i++)
+    {
+      changed = (cached->CalcRxPower (txPowerDbm, a, c) != first);
+    }
+  NS_TEST_EXPECT_MSG_EQ (changed, true, "chained random model should not be cached");
+
+  cached->Flush ();
+  NS_TEST_EXPECT_MSG_EQ (cached->GetSize (), 0, "flush should empty the cache");
+  b->SetPosition (Vector (300, 0, 0));
+  NS_TEST_EXPECT_MSG_EQ (cached->GetInvalidations (), 2, "flushed cache should not track course changes");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * Check that CachedPropagationLossModel rejects the models which are not
+ * deterministic, or have a model chained to them.
+ */
+class CachedPropagationLossModelRejectTestCase : public TestCase
+{
+public:
+  CachedPropagationLossModelRejectTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CachedPropagationLossModelRejectTestCase::CachedPropagationLossModelRejectTestCase ()
+  : TestCase ("Check that CachedPropagationLossModel rejects stochastic and chained models")
+{
+}
+
+void
+CachedPropagationLossModelRejectTestCase::DoRun (void)
+{
+  Ptr<PropagationLossModel> logDistance = CreateObject<LogDistancePropagationLossModel> ();
+  NS_TEST_EXPECT_MSG_EQ (logDistance->IsDeterministic (), true, "log distance model should be deterministic");
+  NS_TEST_EXPECT_MSG_EQ (CachedPropagationLossModel::CanCache (logDistance), true, "log distance model should be cached");
+
+  Ptr<PropagationLossModel> stochastic[3] = {
+    CreateObject<RandomPropagationLossModel> (),
+    CreateObject<NakagamiPropagationLossModel> (),
+    CreateObject<JakesPropagationLossModel> ()
+  };
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (stochastic[i]->IsDeterministic (), false, "model " << i << " should be stochastic");
+      NS_TEST_EXPECT_MSG_EQ (CachedPropagationLossModel::CanCache (stochastic[i]), false,
+                             "model " << i << " should not be cached");
+    }
+
+  // a deterministic model followed by a stochastic stage
+  Ptr<PropagationLossModel> chained = CreateObject<LogDistancePropagationLossModel> ();
+  chained->SetNext (CreateObject<NakagamiPropagationLossModel> ());
+  NS_TEST_EXPECT_MSG_EQ (chained->IsDeterministic (), false, "chain with a stochastic stage should be stochastic");
+  NS_TEST_EXPECT_MSG_EQ (CachedPropagationLossModel::CanCache (chained), false, "chained model should not be cached");
+
+  // a chain of deterministic models is rejected too, since the next
+  // models belong after the cache
+  Ptr<PropagationLossModel> twoStages = CreateObject<LogDistancePropagationLossModel> ();
+  twoStages->SetNext (CreateObject<FriisPropagationLossModel> ());
+  NS_TEST_EXPECT_MSG_EQ (twoStages->IsDeterministic (), true, "deterministic chain should be deterministic");
+  NS_TEST_EXPECT_MSG_EQ (CachedPropagationLossModel::CanCache (twoStages), false, "chained model should not be cached");
+
+  // the Model attribute refuses the rejected models, and keeps the
+  // previous one
+  Ptr<CachedPropagationLossModel> cached = CreateObject<CachedPropagationLossModel> ();
+  NS_TEST_EXPECT_MSG_EQ (cached->SetAttributeFailSafe ("Model", PointerValue (logDistance)), true,
+                         "deterministic model should be accepted");
+  NS_TEST_EXPECT_MSG_EQ (cached->SetAttributeFailSafe ("Model", PointerValue (stochastic[1])), false,
+                         "stochastic model should be rejected");
+  NS_TEST_EXPECT_MSG_EQ (cached->SetAttributeFailSafe ("Model", PointerValue (chained)), false,
+                         "chained model should be rejected");
+  NS_TEST_EXPECT_MSG_EQ (cached->GetModel (), logDistance, "rejected model should not replace the cached one");
+  NS_TEST_EXPECT_MSG_EQ (cached->IsDeterministic (), true, "cache of a deterministic model should be deterministic");
+
+  // a cache is a deterministic model, which a chained stage may not be
+  cached->SetNext (stochastic[0]);
+  NS_TEST_EXPECT_MSG_EQ (cached->IsDeterministic (), false, "cache followed by a stochastic stage is stochastic");
+}
+
+class CachedPropagationLossModelTestSuite : public TestSuite
+{
+public:
+  CachedPropagationLossModelTestSuite ();
+};
+
+CachedPropagationLossModelTestSuite::CachedPropagationLossModelTestSuite ()
+  : TestSuite ("cached-propagation-loss-model", UNIT)
+{
+  AddTestCase (new CachedPropagationLossModelTestCase, TestCase::QUICK);
+  AddTestCase (new CachedPropagationLossModelRejectTestCase, TestCase::QUICK);
+}
+
+static CachedPropagationLossModelTestSuite cachedPropagationLossModelTestSuite;
@@ -0,0 +1,143 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Measure the cost of ErrorRateModel::GetChunkSuccessRate for the analytic
+// models and for TabulatedErrorRateModel wrapping them.
+//
+// Each model is called for a sweep of SNRs and OFDM modes with chunks of
+// --bits bits; the program prints the time per call and, for the
+// tabulated models, the largest difference with the analytic result.
+//
+//   ./waf --run "bench-error-rate-models --n=200"
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/double.h"
+#include "ns3/nist-error-rate-model.h"
+#include "ns3/yans-error-rate-model.h"
+#include "ns3/tabulated-error-rate-model.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+
+using namespace ns3;
+
+static const char *g_modes[] = {
+  "OfdmRate6Mbps", "OfdmRate12Mbps", "OfdmRate24Mbps", "OfdmRate54Mbps",
+  "HtMcs0", "HtMcs4", "HtMcs7", "VhtMcs8"
+};
+
+static double
+RunBench (Ptr<ErrorRateModel> model, const std::vector<double> &snrs, uint32_t nbits, uint32_t n, double *checksum)
+{
+  WifiTxVector txVector;
+  std::vector<WifiMode> modes;
+  for (uint32_t m = 0; m < sizeof (g_modes) / sizeof (g_modes[0]); m++)
+    {
+      modes.push_back (WifiMode (g_modes[m]));
+    }
+  double sum = 0;
+  uint64_t calls = 0;
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      for (std::vector<WifiMode>::const_iterator mode = modes.begin (); mode != modes.end (); ++mode)
+        {
+          for (std::vector<double>::const_iterator snr = snrs.begin (); snr != snrs.end (); ++snr)
+            {
+              sum += model->GetChunkSuccessRate (*mode, txVector, *snr, nbits);
+              calls++;
+            }
+        }
+    }
+  uint64_t ms = time.End ();
+  *checksum = sum;
+  return ms * 1e6 / calls;
+}
+
+static double
+MaxError (Ptr<ErrorRateModel> exact, Ptr<ErrorRateModel> approx, const std::vector<double> &snrs, uint32_t nbits)
+{
+  WifiTxVector txVector;
+  double maxError = 0;
+  for (uint32_t m = 0; m < sizeof (g_modes) / sizeof (g_modes[0]); m++)
+    {
+      WifiMode mode (g_modes[m]);
+      for (std::vector<double>::const_iterator snr = snrs.begin (); snr != snrs.end (); ++snr)
+        {
+          double error = std::abs (exact->GetChunkSuccessRate (mode, txVector, *snr, nbits)
+                                   - approx->GetChunkSuccessRate (mode, txVector, *snr, nbits));
+          maxError = std::max (maxError, error);
+        }
+    }
+  return maxError;
+}
+
+static void
+Report (std::string name, Ptr<ErrorRateModel> analytic, Ptr<ErrorRateModel> tabulated,
+        const std::vector<double> &snrs, uint32_t nbits, uint32_t n)
+{
+  double checksum;
+  double analyticNs = RunBench (analytic, snrs, nbits, n, &checksum);
+  std::cout << std::setw (12) << name << " analytic:  " << std::setw (10) << analyticNs << " ns/call"
+            << " (checksum " << checksum << ")" << std::endl;
+  // The first call of each mode builds its table; keep it out of the timing.
+  SystemWallClockMs build;
+  build.Start ();
+  MaxError (analytic, tabulated, snrs, nbits);
+  uint64_t buildMs = build.End ();
+  double tabulatedNs = RunBench (tabulated, snrs, nbits, n, &checksum);
+  std::cout << std::setw (12) << name << " tabulated: " << std::setw (10) << tabulatedNs << " ns/call"
+            << " (checksum " << checksum << ")" << std::endl;
+  std::cout << std::setw (12) << name << " speedup " << analyticNs / tabulatedNs
+            << ", max error " << MaxError (analytic, tabulated, snrs, nbits)
+            << ", table build and check " << buildMs << " ms" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 100;
+  uint32_t nbits = 1500 * 8;
+  double maxError = 1e-5;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the analytic and tabulated error rate models");
+  cmd.AddValue ("n", "number of sweeps over all the modes and SNRs", n);
+  cmd.AddValue ("bits", "number of bits of each chunk", nbits);
+  cmd.AddValue ("max-error", "accuracy bound of the tabulated models", maxError);
+  cmd.Parse (argc, argv);
+
+  // SNR sweep from 0 dB to 40 dB, off the table grid
+  std::vector<double> snrs;
+  for (double snrDb = 0.0; snrDb < 40.0; snrDb += 0.0737)
+    {
+      snrs.push_back (std::pow (10.0, snrDb / 10.0));
+    }
+
+  Ptr<TabulatedErrorRateModel> nist = CreateObject<TabulatedErrorRateModel> ();
+  nist->SetAttribute ("MaxError", DoubleValue (maxError));
+  nist->SetModel (CreateObject<NistErrorRateModel> ());
+  Report ("Nist", CreateObject<NistErrorRateModel> (), nist, snrs, nbits, n);
+
+  Ptr<TabulatedErrorRateModel> yans = CreateObject<TabulatedErrorRateModel> ();
+  yans->SetAttribute ("MaxError", DoubleValue (maxError));
+  yans->SetModel (CreateObject<YansErrorRateModel> ());
+  Report ("Yans", CreateObject<YansErrorRateModel> (), yans, snrs, nbits, n);
+
+  return 0;
+}
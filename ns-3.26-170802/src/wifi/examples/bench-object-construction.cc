@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Measure the cost of the attribute handling of the objects.
+//
+// The program creates --n objects of each of the types of a wifi node
+// through an ObjectFactory, which sets every attribute of the type and
+// of its parents, then sets, gets and connects by name --n times an
+// attribute and a trace source of a YansWifiPhy, whose attributes are
+// spread over two classes.  The time of each step is printed, in
+// nanoseconds per object or per call.
+//
+//   ./waf --run "bench-object-construction --n=100000"
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/object-factory.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/packet.h"
+#include "ns3/yans-wifi-phy.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace ns3;
+
+static void
+PhyRxDrop (Ptr<const Packet> packet)
+{
+}
+
+/**
+ * Print the time of a step.
+ * \param [in] step The step name.
+ * \param [in] n The number of objects or calls of the step.
+ * \param [in] ms The time of the step, in milliseconds.
+ */
+static void
+Report (std::string step, uint32_t n, int64_t ms)
+{
+  std::cout << std::setw (40) << step << std::setw (12)
+            << std::fixed << std::setprecision (0) << ms * 1e6 / n << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 100000;
+
+  CommandLine cmd;
+  cmd.Usage ("Measure the cost of the attribute handling of the objects");
+  cmd.AddValue ("n", "number of objects or calls per step", n);
+  cmd.Parse (argc, argv);
+
+  std::vector<std::string> types;
+  types.push_back ("ns3::Node");
+  types.push_back ("ns3::AdhocWifiMac");
+  types.push_back ("ns3::YansWifiPhy");
+  types.push_back ("ns3::ConstantRateWifiManager");
+  types.push_back ("ns3::MinstrelWifiManager");
+
+  std::cout << std::setw (40) << "step" << std::setw (12) << "ns/op" << std::endl;
+  SystemWallClockMs clock;
+  for (std::vector<std::string>::const_iterator i = types.begin (); i != types.end (); ++i)
+    {
+      ObjectFactory factory;
+      factory.SetTypeId (*i);
+      clock.Start ();
+      for (uint32_t j = 0; j < n; j++)
+        {
+          factory.Create ();
+        }
+      Report ("create " + *i, n, clock.End ());
+    }
+
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  clock.Start ();
+  for (uint32_t j = 0; j < n; j++)
+    {
+      phy->SetAttribute ("ShortGuardEnabled", BooleanValue (j & 1));
+    }
+  Report ("SetAttribute ShortGuardEnabled", n, clock.End ());
+
+  DoubleValue gain;
+  clock.Start ();
+  for (uint32_t j = 0; j < n; j++)
+    {
+      phy->GetAttribute ("TxGain", gain);
+    }
+  Report ("GetAttribute TxGain", n, clock.End ());
+
+  clock.Start ();
+  for (uint32_t j = 0; j < n; j++)
+    {
+      phy->TraceConnectWithoutContext ("PhyRxDrop", MakeCallback (&PhyRxDrop));
+      phy->TraceDisconnectWithoutContext ("PhyRxDrop", MakeCallback (&PhyRxDrop));
+    }
+  Report ("TraceConnect/Disconnect PhyRxDrop", n, clock.End ());
+  phy->Dispose ();
+  return 0;
+}
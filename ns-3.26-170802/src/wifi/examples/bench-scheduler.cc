@@ -0,0 +1,268 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Compare the event schedulers on the event times of a wifi simulation.
+//
+// The program first runs an infrastructure network of --stations
+// stations, each sending a packet to the access point every --interval,
+// with the beacons, the DCF slot and timeout timers and the one second
+// ticks of the stations, and records the delay of each scheduled event
+// and the average number of pending events.  It then replays these delays
+// with each scheduler: the pending events are scheduled at once, and each
+// event run schedules the next one with the next recorded delay, until
+// --total events have run.  The rate of events run is printed per
+// scheduler.
+//
+//   ./waf --run "bench-scheduler --stations=20"
+
+#include "ns3/command-line.h"
+#include "ns3/simulator.h"
+#include "ns3/map-scheduler.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/string.h"
+#include "ns3/ssid.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/wifi-helper.h"
+#include "ns3/yans-wifi-helper.h"
+#include "ns3/nqos-wifi-mac-helper.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * A MapScheduler which records the delay of each inserted event and the
+ * number of pending events.
+ */
+class RecordingScheduler : public MapScheduler
+{
+public:
+  static TypeId GetTypeId (void);
+  RecordingScheduler ();
+
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+  /// Recorded delays, in time steps, shared by all the instances
+  static std::vector<uint64_t> s_delays;
+  /// Sum of the number of pending events at each insertion
+  static uint64_t s_pendingSum;
+
+private:
+  uint64_t m_now;       //!< Time of the last event removed
+  uint64_t m_pending;   //!< Number of pending events
+};
+
+std::vector<uint64_t> RecordingScheduler::s_delays;
+uint64_t RecordingScheduler::s_pendingSum = 0;
+
+NS_OBJECT_ENSURE_REGISTERED (RecordingScheduler);
+
+TypeId
+RecordingScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RecordingScheduler")
+    .SetParent<MapScheduler> ()
+    .AddConstructor<RecordingScheduler> ()
+  ;
+  return tid;
+}
+
+RecordingScheduler::RecordingScheduler ()
+  : m_now (0),
+    m_pending (0)
+{
+}
+
+void
+RecordingScheduler::Insert (const Scheduler::Event &ev)
+{
+  s_delays.push_back (ev.key.m_ts - m_now);
+  s_pendingSum += m_pending;
+  m_pending++;
+  MapScheduler::Insert (ev);
+}
+
+Scheduler::Event
+RecordingScheduler::RemoveNext (void)
+{
+  Scheduler::Event ev = MapScheduler::RemoveNext ();
+  m_now = ev.key.m_ts;
+  m_pending--;
+  return ev;
+}
+
+void
+RecordingScheduler::Remove (const Scheduler::Event &ev)
+{
+  m_pending--;
+  MapScheduler::Remove (ev);
+}
+
+static void
+SendPacket (Ptr<NetDevice> device, Address to, Time interval)
+{
+  device->Send (Create<Packet> (1000), to, 0x0800);
+  Simulator::Schedule (interval, &SendPacket, device, to, interval);
+}
+
+static void
+Tick (void)
+{
+  Simulator::Schedule (Seconds (1), &Tick);
+}
+
+/// Run the wifi network with the recording scheduler
+static void
+Record (uint32_t nStations, Time interval, Time duration)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (RecordingScheduler::GetTypeId ());
+  Simulator::SetScheduler (factory);
+
+  NodeContainer ap;
+  ap.Create (1);
+  NodeContainer stations;
+  stations.Create (nStations);
+  MobilityHelper mobility;
+  mobility.Install (ap);
+  mobility.Install (stations);
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (YansWifiChannelHelper::Default ().Create ());
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211a);
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode", StringValue ("OfdmRate24Mbps"));
+  NqosWifiMacHelper mac = NqosWifiMacHelper::Default ();
+  Ssid ssid ("bench");
+  mac.SetType ("ns3::ApWifiMac", "Ssid", SsidValue (ssid));
+  NetDeviceContainer apDevice = wifi.Install (phy, mac, ap);
+  mac.SetType ("ns3::StaWifiMac", "Ssid", SsidValue (ssid));
+  NetDeviceContainer staDevices = wifi.Install (phy, mac, stations);
+
+  for (uint32_t i = 0; i < nStations; i++)
+    {
+      // spread the first packets once the stations are associated
+      Time start = Seconds (0.5) + interval * i / nStations;
+      Simulator::Schedule (start, &SendPacket, staDevices.Get (i), apDevice.Get (0)->GetAddress (), interval);
+      Simulator::Schedule (start, &Tick);
+    }
+  Simulator::Stop (duration);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+/// Replay the recorded delays with a scheduler
+class Replay
+{
+public:
+  Replay (uint64_t total)
+    : m_next (0),
+      m_count (0),
+      m_total (total)
+  {
+  }
+  void Start (uint32_t population)
+  {
+    for (uint32_t i = 0; i < population; i++)
+      {
+        Schedule ();
+      }
+  }
+  uint64_t GetCount (void) const
+  {
+    return m_count;
+  }
+
+private:
+  void Schedule (void)
+  {
+    Simulator::Schedule (TimeStep (RecordingScheduler::s_delays[m_next]), &Replay::Cb, this);
+    m_next = (m_next + 1) % RecordingScheduler::s_delays.size ();
+  }
+  void Cb (void)
+  {
+    if (m_count++ < m_total)
+      {
+        Schedule ();
+      }
+  }
+
+  std::size_t m_next;
+  uint64_t m_count;
+  uint64_t m_total;
+};
+
+int main (int argc, char *argv[])
+{
+  uint32_t nStations = 20;
+  Time interval = MilliSeconds (2);
+  Time duration = Seconds (3);
+  uint64_t total = 2000000;
+  uint32_t population = 0;
+  bool list = true;
+
+  CommandLine cmd;
+  cmd.Usage ("Compare the event schedulers on the event times of a wifi simulation");
+  cmd.AddValue ("stations", "number of stations of the recorded network", nStations);
+  cmd.AddValue ("interval", "interval between the packets of a station", interval);
+  cmd.AddValue ("duration", "duration of the recorded simulation", duration);
+  cmd.AddValue ("total", "number of events run per scheduler", total);
+  cmd.AddValue ("population", "number of pending events (default: the recorded average)", population);
+  cmd.AddValue ("list", "include the ns3::ListScheduler, linear in the number of pending events", list);
+  cmd.Parse (argc, argv);
+
+  Record (nStations, interval, duration);
+  uint64_t recorded = RecordingScheduler::s_delays.size ();
+  if (population == 0)
+    {
+      population = std::max<uint64_t> (1, RecordingScheduler::s_pendingSum / recorded);
+    }
+  std::cout << "recorded " << recorded << " events, replaying "
+            << population << " pending events" << std::endl;
+
+  std::vector<std::string> schedulers;
+  if (list)
+    {
+      schedulers.push_back ("ns3::ListScheduler");
+    }
+  schedulers.push_back ("ns3::MapScheduler");
+  schedulers.push_back ("ns3::HeapScheduler");
+  schedulers.push_back ("ns3::CalendarScheduler");
+  schedulers.push_back ("ns3::TimingWheelScheduler");
+
+  std::cout << std::setw (28) << "scheduler" << std::setw (16) << "events/s" << std::endl;
+  for (std::vector<std::string>::const_iterator i = schedulers.begin (); i != schedulers.end (); ++i)
+    {
+      ObjectFactory factory;
+      factory.SetTypeId (*i);
+      Simulator::SetScheduler (factory);
+      Replay replay (total);
+      SystemWallClockMs time;
+      time.Start ();
+      replay.Start (population);
+      Simulator::Run ();
+      uint64_t ms = std::max<uint64_t> (1, time.End ());
+      Simulator::Destroy ();
+      std::cout << std::setw (28) << *i << std::setw (16)
+                << std::fixed << std::setprecision (0) << replay.GetCount () * 1000.0 / ms << std::endl;
+    }
+  return 0;
+}
@@ -0,0 +1,106 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Measure the cost of the per-frame station lookups of
+// WifiRemoteStationManager as the number of known stations grows.
+//
+// For each station count, the manager first learns the stations, then
+// the program times --n rounds over all of them of IsAssociated (state
+// lookup) and GetDataTxVector for a QoS data frame (per-TID station
+// lookup), and prints the time per lookup.
+//
+//   ./waf --run "bench-station-lookup --n=200"
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/string.h"
+#include "ns3/yans-wifi-phy.h"
+#include "ns3/constant-rate-wifi-manager.h"
+#include "ns3/wifi-mac-header.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace ns3;
+
+static double
+RunBench (uint32_t nStations, uint32_t n, uint32_t *checksum)
+{
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+  Ptr<ConstantRateWifiManager> manager = CreateObject<ConstantRateWifiManager> ();
+  manager->SetAttribute ("DataMode", StringValue ("OfdmRate24Mbps"));
+  manager->SetupPhy (phy);
+
+  std::vector<Mac48Address> addresses;
+  for (uint32_t i = 0; i < nStations; i++)
+    {
+      addresses.push_back (Mac48Address::Allocate ());
+    }
+  Ptr<Packet> packet = Create<Packet> (1000);
+  WifiMacHeader header;
+  header.SetType (WIFI_MAC_QOSDATA);
+  header.SetQosTid (3);
+  for (std::vector<Mac48Address>::const_iterator i = addresses.begin (); i != addresses.end (); ++i)
+    {
+      header.SetAddr1 (*i);
+      manager->GetDataTxVector (*i, &header, packet);
+    }
+
+  uint32_t sum = 0;
+  uint64_t lookups = 0;
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t round = 0; round < n; round++)
+    {
+      for (std::vector<Mac48Address>::const_iterator i = addresses.begin (); i != addresses.end (); ++i)
+        {
+          header.SetAddr1 (*i);
+          sum += manager->IsAssociated (*i);
+          sum += manager->GetDataTxVector (*i, &header, packet).GetNss ();
+          lookups += 2;
+        }
+    }
+  uint64_t ms = time.End ();
+  *checksum = sum;
+  manager->Dispose ();
+  phy->Dispose ();
+  return ms * 1e6 / lookups;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t lookups = 2000000;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the station lookups of WifiRemoteStationManager");
+  cmd.AddValue ("n", "number of rounds over all the stations (default: about --lookups lookups)", n);
+  cmd.AddValue ("lookups", "number of lookups per station count when --n is not given", lookups);
+  cmd.Parse (argc, argv);
+
+  uint32_t counts[] = { 10, 30, 100, 300, 1000 };
+  std::cout << std::setw (10) << "stations" << std::setw (16) << "ns/lookup" << std::endl;
+  for (uint32_t i = 0; i < sizeof (counts) / sizeof (counts[0]); i++)
+    {
+      uint32_t rounds = n != 0 ? n : std::max<uint32_t> (1, lookups / 2 / counts[i]);
+      uint32_t checksum;
+      double ns = RunBench (counts[i], rounds, &checksum);
+      std::cout << std::setw (10) << counts[i] << std::setw (16) << ns
+                << "  (checksum " << checksum << ")" << std::endl;
+    }
+  return 0;
+}
@@ -1,6 +1,7 @@
 #include "mr-wifi-helper.h"
 #include "wifi-helper.h"
 #include "ns3/mr-wifi-net-device.h"
+#include "ns3/mr-selection-policy.h"
 #include "ns3/wifi-net-device.h"
 #include "ns3/wifi-mac.h"
 #include "ns3/regular-wifi-mac.h"
@@ -28,6 +29,7 @@ namespace ns3 {
 MrWifiHelper::MrWifiHelper() {
     m_standard = WIFI_PHY_STANDARD_80211a;
     m_numRadios = 1;        // default: single radio
+    m_selectionPolicySet = false;
 }
 
 MrWifiHelper::~MrWifiHelper() { }
@@ -63,6 +65,22 @@ MrWifiHelper::SetRemoteStationManager (std::string type,
   m_stationManager.Set (n7, v7);
 }
 
+void
+MrWifiHelper::SetSelectionPolicy (std::string type,
+                                  std::string n0, const AttributeValue &v0,
+                                  std::string n1, const AttributeValue &v1,
+                                  std::string n2, const AttributeValue &v2,
+                                  std::string n3, const AttributeValue &v3)
+{
+  m_selectionPolicy = ObjectFactory ();
+  m_selectionPolicy.SetTypeId (type);
+  m_selectionPolicy.Set (n0, v0);
+  m_selectionPolicy.Set (n1, v1);
+  m_selectionPolicy.Set (n2, v2);
+  m_selectionPolicy.Set (n3, v3);
+  m_selectionPolicySet = true;
+}
+
 void
 MrWifiHelper::SetStandard (enum WifiPhyStandard standard)
 {
@@ -102,6 +120,9 @@ MrWifiHelper::Install(const WifiPhyHelper &phyHelper,
 
         // create MrWifiNetDevice
         Ptr<MrWifiNetDevice> mrdevice = CreateObject<MrWifiNetDevice>();
+        if(m_selectionPolicySet) {
+            mrdevice->SetSelectionPolicy(m_selectionPolicy.Create<MrSelectionPolicy>());
+        }
 
         // for now, use a common address for all radios
         Mac48Address addr = Mac48Address::Allocate();
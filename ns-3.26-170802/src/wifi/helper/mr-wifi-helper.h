@@ -35,6 +35,27 @@ public:
                               std::string n6 = "", const AttributeValue &v6 = EmptyAttributeValue (),
                               std::string n7 = "", const AttributeValue &v7 = EmptyAttributeValue ());
 
+    /**
+     * \param type the type of MrSelectionPolicy of the devices
+     * \param n0 the name of the attribute to set
+     * \param v0 the value of the attribute to set
+     * \param n1 the name of the attribute to set
+     * \param v1 the value of the attribute to set
+     * \param n2 the name of the attribute to set
+     * \param v2 the value of the attribute to set
+     * \param n3 the name of the attribute to set
+     * \param v3 the value of the attribute to set
+     *
+     * Every device installed gets its own policy.  Without this call the
+     * devices use the default of the MrWifiNetDevice::SelectionPolicy
+     * attribute.
+     */
+    void SetSelectionPolicy (std::string type,
+                              std::string n0 = "", const AttributeValue &v0 = EmptyAttributeValue (),
+                              std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),
+                              std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue (),
+                              std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue ());
+
     virtual NetDeviceContainer Install (const WifiPhyHelper &phy,
                               const WifiMacHelper &mac, NodeContainer c) const;
 
@@ -54,6 +75,8 @@ public:
 
 protected:
     ObjectFactory m_stationManager;
+    ObjectFactory m_selectionPolicy;
+    bool m_selectionPolicySet;
     enum WifiPhyStandard m_standard;
     uint16_t m_numRadios;
 };
@@ -354,6 +354,9 @@ DcfManager::DcfManager ()
     m_lastSwitchingDuration (MicroSeconds (0)),
     m_rxing (false),
     m_sleeping (false),
+    m_accessTimeoutsScheduled (0),
+    m_accessTimeoutsCancelled (0),
+    m_accessTimeoutsFired (0),
     m_slotTimeUs (0),
     m_sifs (Seconds (0.0)),
     m_phyListener (0),
@@ -558,7 +561,7 @@ DcfManager::RequestReaccess(DcfState *state)
   	    return;
   	}
 
-	if(m_low->GetDebug()) {
+	if(m_low != 0 && m_low->GetDebug()) {
 		NS_LOG_UNCOND(Simulator::Now() << " " << m_low->GetAddress() << " <" << m_low->GetIfIndex() << "> RequestReaccess" );
 	}
 
@@ -592,7 +595,7 @@ DcfManager::RequestAccess(DcfState *state)
   	    return;
   	}
 
-	if(m_low->GetDebug()) {
+	if(m_low != 0 && m_low->GetDebug()) {
 		NS_LOG_UNCOND(Simulator::Now() << " " << m_low->GetAddress() << " <" << m_low->GetIfIndex() << "> RequestAccess" );
 	}
 
@@ -693,7 +696,7 @@ DcfManager::DoGrantAccess (void)
            * could change the global state of the manager, and, thus, could change
            * the result of the calculations.
            */
-			if(m_low->GetDebug()) NS_LOG_UNCOND(Simulator::Now() << " " << m_low->GetAddress() << " <" << m_low->GetIfIndex() << "> NotifyAccessGranted");
+			if(m_low != 0 && m_low->GetDebug()) NS_LOG_UNCOND(Simulator::Now() << " " << m_low->GetAddress() << " <" << m_low->GetIfIndex() << "> NotifyAccessGranted");
           state->NotifyAccessGranted ();
           for (std::vector<DcfState *>::const_iterator k = internalCollisionStates.begin ();
                k != internalCollisionStates.end (); k++)
@@ -711,6 +714,7 @@ DcfManager::AccessTimeout (void)
 {
 	//if(m_low->GetIfIndex() == 2) NS_LOG_UNCOND(Simulator::Now() << " " << m_low->GetAddress() << " <" << m_low->GetIfIndex() << "> AccessTimeout");
   NS_LOG_FUNCTION (this);
+  m_accessTimeoutsFired++;
   UpdateBackoff ();
   DoGrantAccess ();
   DoRestartAccessTimeoutIfNeeded ();
@@ -835,6 +839,11 @@ void
 DcfManager::DoRestartAccessTimeoutIfNeeded (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_rxing)
+    {
+      NS_LOG_DEBUG ("Access timeout deferred to the end of reception");
+      return;
+    }
   /**
    * Is there a DcfState which needs to access the medium, and,
    * if there is one, how many slots for AIFS+backoff does it require ?
@@ -863,15 +872,53 @@ DcfManager::DoRestartAccessTimeoutIfNeeded (void)
       if (m_accessTimeout.IsRunning ()
           && Simulator::GetDelayLeft (m_accessTimeout) > expectedBackoffDelay)
         {
-          m_accessTimeout.Cancel ();
+          CancelAccessTimeout ();
         }
       if (m_accessTimeout.IsExpired ())
         {
+          m_accessTimeoutsScheduled++;
           m_accessTimeout = Simulator::Schedule (expectedBackoffDelay,
                                                  &DcfManager::AccessTimeout, this);
         }
     }
 }
+
+void
+DcfManager::CancelAccessTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_accessTimeout.IsRunning ())
+    {
+      m_accessTimeoutsCancelled++;
+      m_accessTimeout.Cancel ();
+    }
+}
+
+uint64_t
+DcfManager::GetAccessTimeoutsScheduled (void) const
+{
+  return m_accessTimeoutsScheduled;
+}
+
+uint64_t
+DcfManager::GetAccessTimeoutsCancelled (void) const
+{
+  return m_accessTimeoutsCancelled;
+}
+
+uint64_t
+DcfManager::GetAccessTimeoutsFired (void) const
+{
+  return m_accessTimeoutsFired;
+}
+
+void
+DcfManager::ResetAccessTimeoutStats (void)
+{
+  m_accessTimeoutsScheduled = 0;
+  m_accessTimeoutsCancelled = 0;
+  m_accessTimeoutsFired = 0;
+}
 //------------------------------------------------------------------------------
 
 
@@ -885,6 +932,16 @@ DcfManager::NotifyRxStartNow (Time duration)
   m_lastRxStart = Simulator::Now ();
   m_lastRxDuration = duration;
   m_rxing = true;
+  /**
+   * No access can be granted before the end of this reception, so a
+   * timeout expiring earlier would only reschedule itself.  The end of
+   * reception restarts it.
+   */
+  if (m_accessTimeout.IsRunning ()
+      && Simulator::GetDelayLeft (m_accessTimeout) <= duration)
+    {
+      CancelAccessTimeout ();
+    }
 
 
 	/*
@@ -935,6 +992,8 @@ DcfManager::NotifyRxEndOkNow (void)
 	}
 	*/
 
+  	DoRestartAccessTimeoutIfNeeded ();
+
 	/*
 	// NETSYS ------------------------------------------------------------------
 	// 1. Set the backoff counter to zero
@@ -964,6 +1023,7 @@ DcfManager::NotifyRxEndErrorNow (void)
   	m_lastRxEnd = Simulator::Now ();
   	m_lastRxReceivedOk = false;
   	m_rxing = false;
+  	DoRestartAccessTimeoutIfNeeded ();
 }
 //------------------------------------------------------------------------------
 
@@ -973,6 +1033,7 @@ void
 DcfManager::NotifyTxStartNow (Time duration)
 {
   NS_LOG_FUNCTION (this << duration);
+  bool rxAborted = m_rxing;
   if (m_rxing)
     {
       if (Simulator::Now () - m_lastRxStart <= m_sifs)
@@ -1001,6 +1062,11 @@ DcfManager::NotifyTxStartNow (Time duration)
   UpdateBackoff ();
   m_lastTxStart = Simulator::Now ();
   m_lastTxDuration = duration;
+  if (rxAborted)
+    {
+      // the reception ends without NotifyRxEnd*Now
+      DoRestartAccessTimeoutIfNeeded ();
+    }
 }
 
 void
@@ -1047,10 +1113,7 @@ DcfManager::NotifySwitchingStartNow (Time duration)
     }
 
   //Cancel timeout
-  if (m_accessTimeout.IsRunning ())
-    {
-      m_accessTimeout.Cancel ();
-    }
+  CancelAccessTimeout ();
 
   //Reset backoffs
   for (States::iterator i = m_states.begin (); i != m_states.end (); i++)
@@ -1079,10 +1142,7 @@ DcfManager::NotifySleepNow (void)
   NS_LOG_FUNCTION (this);
   m_sleeping = true;
   //Cancel timeout
-  if (m_accessTimeout.IsRunning ())
-    {
-      m_accessTimeout.Cancel ();
-    }
+  CancelAccessTimeout ();
 
   //Reset backoffs
   for (States::iterator i = m_states.begin (); i != m_states.end (); i++)
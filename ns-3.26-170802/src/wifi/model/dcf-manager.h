@@ -448,6 +448,23 @@ public:
 	void ResetBackoff();
 //------------------------------------------------------------------------------
 
+  /**
+   * \return the number of access timeout events scheduled so far
+   */
+  uint64_t GetAccessTimeoutsScheduled (void) const;
+  /**
+   * \return the number of access timeout events cancelled before they expired
+   */
+  uint64_t GetAccessTimeoutsCancelled (void) const;
+  /**
+   * \return the number of access timeout events which expired
+   */
+  uint64_t GetAccessTimeoutsFired (void) const;
+  /**
+   * Reset the access timeout event counters.
+   */
+  void ResetAccessTimeoutStats (void);
+
 
 
 private:
@@ -538,7 +555,20 @@ private:
    * \return the time when the backoff procedure ended (or will ended)
    */
   Time GetBackoffEndFor (DcfState *state);
+  /**
+   * Make sure the access timeout expires no later than the earliest
+   * backoff end of the DcfStates which requested access.
+   *
+   * While a reception is ongoing no timeout is armed: the backoff end
+   * depends on the outcome of the reception (EIFS), and the end of
+   * reception restarts the timeout.
+   */
   void DoRestartAccessTimeoutIfNeeded (void);
+  /**
+   * Cancel the pending access timeout, if any.  Whether it is removed
+   * from the event list is decided by the CancelPolicy of the simulator.
+   */
+  void CancelAccessTimeout (void);
 
   /**
    * Called when access timeout should occur
@@ -590,6 +620,9 @@ private:
   bool m_sleeping;
   Time m_eifsNoDifs;
   EventId m_accessTimeout;
+  uint64_t m_accessTimeoutsScheduled; //!< access timeout events scheduled
+  uint64_t m_accessTimeoutsCancelled; //!< access timeout events cancelled before expiry
+  uint64_t m_accessTimeoutsFired;     //!< access timeout events which expired
   uint32_t m_slotTimeUs;
   Time m_sifs;
   PhyListener* m_phyListener;
@@ -24,6 +24,7 @@
 #include "error-rate-model.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/size-class-allocator.h"
 #include <algorithm>
 
 namespace ns3 {
@@ -34,6 +35,34 @@ NS_LOG_COMPONENT_DEFINE ("InterferenceHelper");
  *       Phy event class
  ****************************************************************/
 
+namespace {
+
+/**
+ * \returns The pools of the phy events.  Never destroyed, so that the
+ *          events freed by the static destructors find them.
+ */
+SizeClassAllocator &
+GetEventAllocator (void)
+{
+  static const SizeClassAllocator::Layout layout = { 32, 4, 512 };
+  static SizeClassAllocator *allocator = new SizeClassAllocator (layout, "", "", "");
+  return *allocator;
+}
+
+} // unnamed namespace
+
+void *
+InterferenceHelper::Event::operator new (std::size_t size)
+{
+  return GetEventAllocator ().Allocate (size);
+}
+
+void
+InterferenceHelper::Event::operator delete (void *p)
+{
+  GetEventAllocator ().Deallocate (p);
+}
+
 InterferenceHelper::Event::Event (uint32_t size, WifiTxVector txVector,
                                   enum WifiPreamble preamble,
                                   Time duration, double rxPower)
@@ -42,7 +71,9 @@ InterferenceHelper::Event::Event (uint32_t size, WifiTxVector txVector,
     m_preamble (preamble),
     m_startTime (Simulator::Now ()),
     m_endTime (m_startTime + duration),
-    m_rxPowerW (rxPower)
+    m_rxPowerW (rxPower),
+    m_startNiW (0.0),
+    m_startRank (0)
 {
 }
 
@@ -135,7 +166,9 @@ InterferenceHelper::NiChange::operator < (const InterferenceHelper::NiChange& o)
 
 InterferenceHelper::InterferenceHelper ()
   : m_errorRateModel (0),
+    m_position (0),
     m_firstPower (0.0),
+    m_maxDuration (Seconds (0)),
     m_rxing (false)
 {
 }
@@ -158,6 +191,10 @@ InterferenceHelper::Add (uint32_t size, WifiTxVector txVector,
                                              preamble,
                                              duration,
                                              rxPowerW);
+  if (duration > m_maxDuration)
+    {
+      m_maxDuration = duration;
+    }
   AppendEvent (event);
   return event;
 }
@@ -166,9 +203,10 @@ void
 InterferenceHelper::AddForeignSignal (Time duration, double rxPowerW)
 {
   // Parameters other than duration and rxPowerW are unused for this type
-  // of signal, so we provide dummy versions
+  // of signal, so we provide dummy versions.  The signal is never received,
+  // so that it does not lengthen the changes kept.
   WifiTxVector fakeTxVector;
-  Add (0, fakeTxVector, WIFI_PREAMBLE_NONE, duration, rxPowerW);
+  AppendEvent (Create<InterferenceHelper::Event> (0, fakeTxVector, WIFI_PREAMBLE_NONE, duration, rxPowerW));
 }
 
 void
@@ -198,18 +236,14 @@ InterferenceHelper::GetErrorRateModel (void) const
 Time
 InterferenceHelper::GetEnergyDuration (double energyW)
 {
+  UpdatePosition ();
   Time now = Simulator::Now ();
-  double noiseInterferenceW = 0.0;
+  double noiseInterferenceW = m_firstPower;
   Time end = now;
-  noiseInterferenceW = m_firstPower;
-  for (NiChanges::const_iterator i = m_niChanges.begin (); i != m_niChanges.end (); i++)
+  for (NiChanges::const_iterator i = m_niChanges.begin () + m_position; i != m_niChanges.end (); i++)
     {
       noiseInterferenceW += i->GetDelta ();
       end = i->GetTime ();
-      if (end < now)
-        {
-          continue;
-        }
       if (noiseInterferenceW < energyW)
         {
           break;
@@ -220,24 +254,42 @@ InterferenceHelper::GetEnergyDuration (double energyW)
 
 void
 InterferenceHelper::AppendEvent (Ptr<InterferenceHelper::Event> event)
+{
+  UpdatePosition ();
+  // the changes at the start time added before come first, and count in
+  // the noise and interference of the signal
+  double noiseInterferenceW = m_firstPower;
+  uint32_t rank = 0;
+  NiChanges::iterator i = m_niChanges.begin () + m_position;
+  while (i != m_niChanges.end () && i->GetTime () == event->GetStartTime ())
+    {
+      noiseInterferenceW += i->GetDelta ();
+      rank++;
+      i++;
+    }
+  event->m_startNiW = noiseInterferenceW;
+  event->m_startRank = rank;
+  m_niChanges.insert (i, NiChange (event->GetStartTime (), event->GetRxPowerW ()));
+  AddNiChangeEvent (NiChange (event->GetEndTime (), -event->GetRxPowerW ()));
+}
+
+void
+InterferenceHelper::UpdatePosition (void)
 {
   Time now = Simulator::Now ();
-  if (!m_rxing)
+  while (m_position < m_niChanges.size () && m_niChanges[m_position].GetTime () < now)
     {
-      NiChanges::iterator nowIterator = GetPosition (now);
-      for (NiChanges::iterator i = m_niChanges.begin (); i != nowIterator; i++)
-        {
-          m_firstPower += i->GetDelta ();
-        }
-      m_niChanges.erase (m_niChanges.begin (), nowIterator);
-      m_niChanges.insert (m_niChanges.begin (), NiChange (event->GetStartTime (), event->GetRxPowerW ()));
+      m_firstPower += m_niChanges[m_position].GetDelta ();
+      m_position++;
     }
-  else
+  // a reception going on started at most m_maxDuration ago, and needs
+  // the changes from its start only
+  Time oldest = now - m_maxDuration;
+  while (m_position > 0 && m_niChanges.front ().GetTime () < oldest)
     {
-      AddNiChangeEvent (NiChange (event->GetStartTime (), event->GetRxPowerW ()));
+      m_niChanges.pop_front ();
+      m_position--;
     }
-  AddNiChangeEvent (NiChange (event->GetEndTime (), -event->GetRxPowerW ()));
-
 }
 
 
@@ -259,17 +311,19 @@ InterferenceHelper::CalculateSnr (double signal, double noiseInterference, uint3
 double
 InterferenceHelper::CalculateNoiseInterferenceW (Ptr<InterferenceHelper::Event> event, NiChanges *ni) const
 {
-  double noiseInterference = m_firstPower;
+  double noiseInterference = event->m_startNiW;
   NS_ASSERT (m_rxing);
-  for (NiChanges::const_iterator i = m_niChanges.begin () + 1; i != m_niChanges.end (); i++)
+  NiChanges::const_iterator i = std::lower_bound (m_niChanges.begin (), m_niChanges.end (),
+                                                  NiChange (event->GetStartTime (), 0));
+  i += event->m_startRank;
+  NS_ASSERT (i != m_niChanges.end () && i->GetTime () == event->GetStartTime ()
+             && i->GetDelta () == event->GetRxPowerW ());
+  ni->push_back (NiChange (event->GetStartTime (), noiseInterference));
+  // the changes at the end time make chunks of no duration
+  for (i++; i != m_niChanges.end () && i->GetTime () < event->GetEndTime (); i++)
     {
-      if ((event->GetEndTime () == i->GetTime ()) && event->GetRxPowerW () == -i->GetDelta ())
-        {
-          break;
-        }
       ni->push_back (*i);
     }
-  ni->insert (ni->begin (), NiChange (event->GetStartTime (), noiseInterference));
   ni->push_back (NiChange (event->GetEndTime (), 0));
   return noiseInterference;
 }
@@ -838,6 +892,7 @@ InterferenceHelper::EraseEvents (void)
 {
   m_niChanges.clear ();
   m_rxing = false;
+  m_position = 0;
   m_firstPower = 0.0;
 }
 
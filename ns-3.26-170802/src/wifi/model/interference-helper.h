@@ -22,8 +22,7 @@
 #define INTERFERENCE_HELPER_H
 
 #include <stdint.h>
-#include <vector>
-#include <list>
+#include <deque>
 #include "wifi-mode.h"
 #include "wifi-preamble.h"
 #include "wifi-phy-standard.h"
@@ -61,6 +60,23 @@ public:
            Time duration, double rxPower);
     ~Event ();
 
+    /**
+     * \brief Allocate an Event from the pools of the events.
+     *
+     * Events are created and released for every received signal, so
+     * they are recycled by per-thread pools of their own.
+     *
+     * \param size the size of the object to allocate
+     * \return the allocated memory
+     */
+    static void * operator new (std::size_t size);
+    /**
+     * \brief Free an Event allocated from the pools of the events.
+     *
+     * \param p the memory to release
+     */
+    static void operator delete (void *p);
+
     /**
      * Return the duration of the signal.
      *
@@ -112,12 +128,18 @@ public:
 
 
 private:
+    friend class InterferenceHelper;
+
     uint32_t m_size;
     WifiTxVector m_txVector;
     enum WifiPreamble m_preamble;
     Time m_startTime;
     Time m_endTime;
     double m_rxPowerW;
+    /// Noise and interference power (W) when the signal starts, set by AppendEvent
+    double m_startNiW;
+    /// Number of changes at the start time which precede the start of the signal
+    uint32_t m_startRank;
   };
 
   /**
@@ -261,13 +283,13 @@ private:
     double m_delta;
   };
   /**
-   * typedef for a vector of NiChanges
-   */
-  typedef std::vector <NiChange> NiChanges;
-  /**
-   * typedef for a list of Events
+   * typedef for a time-ordered sequence of NiChanges.
+   *
+   * Changes are inserted after the current time, close to the back, and
+   * expired from the front, which a deque does without moving the
+   * others; sorted insertion uses a binary search.
    */
-  typedef std::list<Ptr<Event> > Events;
+  typedef std::deque<NiChange> NiChanges;
 
   /**
    * Append the given Event.
@@ -278,6 +300,9 @@ private:
   /**
    * Calculate noise and interference power in W.
    *
+   * Only the changes between the start and the end of the event are
+   * walked.
+   *
    * \param event
    * \param ni
    *
@@ -330,9 +355,18 @@ private:
 
   double m_noiseFigure; /**< noise figure (linear) */
   Ptr<ErrorRateModel> m_errorRateModel;
-  /// Experimental: needed for energy duration calculation
+  /**
+   * The changes of the noise and interference power.  The changes older
+   * than the longest signal added with Add() are expired, since no
+   * reception which is still going on can have started before them.
+   */
   NiChanges m_niChanges;
+  /// Index in m_niChanges of the first change not before the current time
+  std::size_t m_position;
+  /// Accumulated power of all the changes before m_position, expired or not
   double m_firstPower;
+  /// Duration of the longest signal added with Add()
+  Time m_maxDuration;
   bool m_rxing;
   /// Returns an iterator to the first nichange, which is later than moment
   NiChanges::iterator GetPosition (Time moment);
@@ -342,6 +376,12 @@ private:
    * \param change
    */
   void AddNiChangeEvent (NiChange change);
+  /**
+   * Move m_position to the first change at or after the current time,
+   * accumulating the power of the changes it passes, and expire the
+   * changes older than the longest signal.
+   */
+  void UpdatePosition (void);
 };
 
 } //namespace ns3
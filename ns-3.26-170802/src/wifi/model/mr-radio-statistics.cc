@@ -0,0 +1,178 @@
+#include "mr-radio-statistics.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/log.h"
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE("MrRadioStatistics");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(MrRadioStatistics);
+
+MrRadioStatistics::Snapshot::Snapshot()
+    : acksReceived(0),
+      acksMissed(0),
+      acksOverheard(0),
+      txBytes(0),
+      rxBytes(0),
+      queueHighWater(0),
+      tokenHoldTime(Seconds(0)) {
+}
+
+MrRadioStatistics::Snapshot &
+MrRadioStatistics::Snapshot::operator+=(const Snapshot &other) {
+    acksReceived += other.acksReceived;
+    acksMissed += other.acksMissed;
+    acksOverheard += other.acksOverheard;
+    txBytes += other.txBytes;
+    rxBytes += other.rxBytes;
+    queueHighWater = std::max(queueHighWater, other.queueHighWater);
+    tokenHoldTime += other.tokenHoldTime;
+    return *this;
+}
+
+TypeId
+MrRadioStatistics::GetTypeId(void) {
+    static TypeId tid = TypeId("ns3::MrRadioStatistics")
+        .SetParent<Object>()
+        .SetGroupName("Wifi")
+        .AddConstructor<MrRadioStatistics>()
+        .AddTraceSource("AcksReceived", "Number of ACKs received for unicast data frames",
+                        MakeTraceSourceAccessor(&MrRadioStatistics::m_acksReceived),
+                        "ns3::TracedValueCallback::Uint32")
+        .AddTraceSource("AcksMissed", "Number of ACK timeouts",
+                        MakeTraceSourceAccessor(&MrRadioStatistics::m_acksMissed),
+                        "ns3::TracedValueCallback::Uint32")
+        .AddTraceSource("AcksOverheard", "Number of ACKs overheard for frames of other stations",
+                        MakeTraceSourceAccessor(&MrRadioStatistics::m_acksOverheard),
+                        "ns3::TracedValueCallback::Uint32")
+        .AddTraceSource("TxBytes", "Number of bytes handed to the radio for transmission",
+                        MakeTraceSourceAccessor(&MrRadioStatistics::m_txBytes),
+                        "ns3::MrRadioStatistics::Uint64TracedCallback")
+        .AddTraceSource("RxBytes", "Number of bytes received by the radio",
+                        MakeTraceSourceAccessor(&MrRadioStatistics::m_rxBytes),
+                        "ns3::MrRadioStatistics::Uint64TracedCallback")
+        .AddTraceSource("QueueHighWater", "Largest best-effort queue length seen after a transmission request",
+                        MakeTraceSourceAccessor(&MrRadioStatistics::m_queueHighWater),
+                        "ns3::TracedValueCallback::Uint32")
+        .AddTraceSource("TokenHoldTime", "Time the radio held the token, updated when the token is released",
+                        MakeTraceSourceAccessor(&MrRadioStatistics::m_tokenHoldTime),
+                        "ns3::TracedValueCallback::Time")
+    ;
+    return tid;
+}
+
+MrRadioStatistics::MrRadioStatistics()
+    : m_acksReceived(0),
+      m_acksMissed(0),
+      m_acksOverheard(0),
+      m_txBytes(0),
+      m_rxBytes(0),
+      m_queueHighWater(0),
+      m_tokenHoldTime(Seconds(0)),
+      m_token(false) {
+    NS_LOG_FUNCTION(this);
+}
+
+MrRadioStatistics::~MrRadioStatistics() {
+    NS_LOG_FUNCTION(this);
+}
+
+// operator new does not honor the alignment of the class before C++17
+void *
+MrRadioStatistics::operator new(std::size_t size) {
+    void *p;
+    if(posix_memalign(&p, CACHE_LINE_SIZE, size) != 0) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void
+MrRadioStatistics::operator delete(void *p) {
+    free(p);
+}
+
+void
+MrRadioStatistics::NotifyAckReceived(void) {
+    m_acksReceived++;
+}
+
+void
+MrRadioStatistics::NotifyAckMissed(void) {
+    m_acksMissed++;
+}
+
+void
+MrRadioStatistics::NotifyAckOverheard(void) {
+    m_acksOverheard++;
+}
+
+void
+MrRadioStatistics::NotifyTx(uint32_t bytes, uint32_t queueLength) {
+    m_txBytes += bytes;
+    if(queueLength > m_queueHighWater) {
+        m_queueHighWater = queueLength;
+    }
+}
+
+void
+MrRadioStatistics::NotifyRx(uint32_t bytes) {
+    m_rxBytes += bytes;
+}
+
+void
+MrRadioStatistics::NotifyToken(bool token) {
+    if(token == m_token) return;
+
+    if(token) {
+        m_tokenSince = Simulator::Now();
+    }
+    else {
+        m_tokenHoldTime += Simulator::Now() - m_tokenSince;
+    }
+    m_token = token;
+}
+
+uint32_t
+MrRadioStatistics::GetAcksReceived(void) const {
+    return m_acksReceived;
+}
+
+uint32_t
+MrRadioStatistics::GetAcksMissed(void) const {
+    return m_acksMissed;
+}
+
+MrRadioStatistics::Snapshot
+MrRadioStatistics::GetSnapshot(void) const {
+    Snapshot snapshot;
+    snapshot.acksReceived = m_acksReceived;
+    snapshot.acksMissed = m_acksMissed;
+    snapshot.acksOverheard = m_acksOverheard;
+    snapshot.txBytes = m_txBytes;
+    snapshot.rxBytes = m_rxBytes;
+    snapshot.queueHighWater = m_queueHighWater;
+    snapshot.tokenHoldTime = m_tokenHoldTime;
+    if(m_token) {
+        snapshot.tokenHoldTime += Simulator::Now() - m_tokenSince;
+    }
+    return snapshot;
+}
+
+void
+MrRadioStatistics::Reset(void) {
+    m_acksReceived = 0;
+    m_acksMissed = 0;
+    m_acksOverheard = 0;
+    m_txBytes = 0;
+    m_rxBytes = 0;
+    m_queueHighWater = 0;
+    m_tokenHoldTime = Seconds(0);
+    m_tokenSince = Simulator::Now();
+}
+
+}   // namespace ns3
@@ -0,0 +1,101 @@
+#ifndef MR_RADIO_STATISTICS_H
+#define MR_RADIO_STATISTICS_H
+
+#include "ns3/object.h"
+#include "ns3/traced-value.h"
+#include "ns3/nstime.h"
+#include <cstddef>
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * Statistics of one radio of a MrWifiNetDevice.
+ *
+ * Every counter is a TracedValue, so it can be followed through the
+ * config path /NodeList/[i]/DeviceList/[j]/$ns3::MrWifiNetDevice/RadioStatistics/[k]/...
+ * without polling.  GetSnapshot reads all of them at once.
+ *
+ * The MrWifiNetDevice keeps one instance per radio, created by AddRadio.
+ * Each instance starts on its own cache line, so that the counters of two
+ * radios never share one.
+ */
+class alignas(64) MrRadioStatistics : public Object
+{
+public:
+    /// size of the cache line the statistics are aligned on
+    static const std::size_t CACHE_LINE_SIZE = 64;
+
+    /// values of the statistics of a radio, or of several radios added up
+    struct Snapshot {
+        Snapshot();
+        /**
+         * Add the statistics of another radio; the queue high-water mark is
+         * the largest of the two.
+         */
+        Snapshot &operator+=(const Snapshot &other);
+
+        uint32_t acksReceived;      //!< ACKs received for unicast data frames
+        uint32_t acksMissed;        //!< ACK timeouts
+        uint32_t acksOverheard;     //!< ACKs overheard for frames of other stations
+        uint64_t txBytes;           //!< bytes handed to the radio for transmission
+        uint64_t rxBytes;           //!< bytes received by the radio
+        uint32_t queueHighWater;    //!< largest best-effort queue length seen
+        Time tokenHoldTime;         //!< time the radio held the token
+    };
+
+    /**
+     * TracedValue callback signature for the byte counters.
+     *
+     * \param oldValue the previous number of bytes
+     * \param newValue the new number of bytes
+     */
+    typedef void (* Uint64TracedCallback)(uint64_t oldValue, uint64_t newValue);
+
+    static TypeId GetTypeId(void);
+
+    MrRadioStatistics();
+    virtual ~MrRadioStatistics();
+
+    static void *operator new(std::size_t size);
+    static void operator delete(void *p);
+
+    void NotifyAckReceived(void);
+    void NotifyAckMissed(void);
+    void NotifyAckOverheard(void);
+    void NotifyTx(uint32_t bytes, uint32_t queueLength);
+    void NotifyRx(uint32_t bytes);
+    /**
+     * \param token whether the radio holds the token from now on
+     */
+    void NotifyToken(bool token);
+
+    uint32_t GetAcksReceived(void) const;
+    uint32_t GetAcksMissed(void) const;
+    /**
+     * \return the statistics; the token hold time includes the current
+     *         holding period, if any
+     */
+    Snapshot GetSnapshot(void) const;
+    /**
+     * Reset all the statistics.  A token held by the radio is counted from
+     * now on.
+     */
+    void Reset(void);
+
+private:
+    TracedValue<uint32_t> m_acksReceived;
+    TracedValue<uint32_t> m_acksMissed;
+    TracedValue<uint32_t> m_acksOverheard;
+    TracedValue<uint64_t> m_txBytes;
+    TracedValue<uint64_t> m_rxBytes;
+    TracedValue<uint32_t> m_queueHighWater;
+    TracedValue<Time> m_tokenHoldTime;      // updated when the token is released
+    bool m_token;                           // the radio holds the token
+    Time m_tokenSince;                      // start of the current holding period
+};
+
+}   // namespace ns3
+
+#endif
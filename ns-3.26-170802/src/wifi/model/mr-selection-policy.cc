@@ -0,0 +1,361 @@
+#include "mr-selection-policy.h"
+#include "mr-wifi-net-device.h"
+#include "wifi-net-device.h"
+#include "wifi-remote-station-manager.h"
+#include "wifi-mac-header.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/hash.h"
+#include "ns3/log.h"
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <limits>
+
+NS_LOG_COMPONENT_DEFINE("MrSelectionPolicy");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(MrSelectionPolicy);
+NS_OBJECT_ENSURE_REGISTERED(MrQueueLengthSelectionPolicy);
+NS_OBJECT_ENSURE_REGISTERED(MrRoundRobinSelectionPolicy);
+NS_OBJECT_ENSURE_REGISTERED(MrFlowHashSelectionPolicy);
+NS_OBJECT_ENSURE_REGISTERED(MrAckRatioSelectionPolicy);
+NS_OBJECT_ENSURE_REGISTERED(MrExpectedTxTimeSelectionPolicy);
+
+// MAC header, FCS and LLC/SNAP header added to the packets handed to Send
+static const uint32_t MR_MAC_OVERHEAD = 26 + 4 + 8;
+
+// ACK ratio of a radio, with one success and one failure added so that
+// radios without any history are neither favoured nor excluded
+static double
+GetAckRatio(Ptr<MrWifiNetDevice> device, uint32_t radio) {
+    double received = device->GetNumAcksReceived(radio);
+    double missed = device->GetNumAcksMissed(radio);
+    return (received + 1) / (received + missed + 2);
+}
+
+//------------------------------------------------------------------------------
+// MrSelectionPolicy
+//------------------------------------------------------------------------------
+TypeId
+MrSelectionPolicy::GetTypeId(void) {
+    static TypeId tid = TypeId("ns3::MrSelectionPolicy")
+        .SetParent<Object>()
+        .SetGroupName("Wifi")
+    ;
+    return tid;
+}
+
+MrSelectionPolicy::MrSelectionPolicy() {
+    NS_LOG_FUNCTION(this);
+}
+
+MrSelectionPolicy::~MrSelectionPolicy() {
+    NS_LOG_FUNCTION(this);
+}
+
+//------------------------------------------------------------------------------
+// MrQueueLengthSelectionPolicy
+//------------------------------------------------------------------------------
+TypeId
+MrQueueLengthSelectionPolicy::GetTypeId(void) {
+    static TypeId tid = TypeId("ns3::MrQueueLengthSelectionPolicy")
+        .SetParent<MrSelectionPolicy>()
+        .SetGroupName("Wifi")
+        .AddConstructor<MrQueueLengthSelectionPolicy>()
+        .AddAttribute("Bias",
+                      "Number of packets added to the queue length of the radios other than PreferredRadio.",
+                      UintegerValue(10),
+                      MakeUintegerAccessor(&MrQueueLengthSelectionPolicy::m_bias),
+                      MakeUintegerChecker<uint32_t>())
+        .AddAttribute("PreferredRadio",
+                      "Index of the radio whose queue length is not biased.",
+                      UintegerValue(0),
+                      MakeUintegerAccessor(&MrQueueLengthSelectionPolicy::m_preferredRadio),
+                      MakeUintegerChecker<uint32_t>())
+    ;
+    return tid;
+}
+
+MrQueueLengthSelectionPolicy::MrQueueLengthSelectionPolicy() {
+    NS_LOG_FUNCTION(this);
+}
+
+MrQueueLengthSelectionPolicy::~MrQueueLengthSelectionPolicy() {
+    NS_LOG_FUNCTION(this);
+}
+
+uint32_t
+MrQueueLengthSelectionPolicy::SelectRadio(Ptr<MrWifiNetDevice> device, Ptr<const Packet> packet,
+                                          Mac48Address dest, uint16_t protocolNumber) {
+    uint32_t numRadios = device->GetNRadios();
+    uint32_t min_radio = m_preferredRadio < numRadios ? m_preferredRadio : 0;
+    uint32_t min_size = device->GetPhysicalNetDevice(min_radio)->GetBEQueueSize();
+
+    for(uint32_t i=0; i<numRadios; i++) {
+        if(i == min_radio) continue;
+        uint32_t adjusted_size = device->GetPhysicalNetDevice(i)->GetBEQueueSize() + m_bias;
+        if(adjusted_size < min_size) {
+            min_radio = i;
+            min_size = adjusted_size;
+        }
+    }
+
+    return min_radio;
+}
+
+//------------------------------------------------------------------------------
+// MrRoundRobinSelectionPolicy
+//------------------------------------------------------------------------------
+TypeId
+MrRoundRobinSelectionPolicy::GetTypeId(void) {
+    static TypeId tid = TypeId("ns3::MrRoundRobinSelectionPolicy")
+        .SetParent<MrSelectionPolicy>()
+        .SetGroupName("Wifi")
+        .AddConstructor<MrRoundRobinSelectionPolicy>()
+    ;
+    return tid;
+}
+
+MrRoundRobinSelectionPolicy::MrRoundRobinSelectionPolicy()
+    : m_next(0) {
+    NS_LOG_FUNCTION(this);
+}
+
+MrRoundRobinSelectionPolicy::~MrRoundRobinSelectionPolicy() {
+    NS_LOG_FUNCTION(this);
+}
+
+uint32_t
+MrRoundRobinSelectionPolicy::SelectRadio(Ptr<MrWifiNetDevice> device, Ptr<const Packet> packet,
+                                         Mac48Address dest, uint16_t protocolNumber) {
+    uint32_t radio = m_next % device->GetNRadios();
+    m_next = radio + 1;
+    return radio;
+}
+
+//------------------------------------------------------------------------------
+// MrFlowHashSelectionPolicy
+//------------------------------------------------------------------------------
+TypeId
+MrFlowHashSelectionPolicy::GetTypeId(void) {
+    static TypeId tid = TypeId("ns3::MrFlowHashSelectionPolicy")
+        .SetParent<MrSelectionPolicy>()
+        .SetGroupName("Wifi")
+        .AddConstructor<MrFlowHashSelectionPolicy>()
+        .AddAttribute("HashIpFlow",
+                      "Hash the IPv4 addresses, protocol and ports of the packets together with "
+                      "their destination. If false, all the packets to a destination use the same radio.",
+                      BooleanValue(true),
+                      MakeBooleanAccessor(&MrFlowHashSelectionPolicy::m_hashIpFlow),
+                      MakeBooleanChecker())
+    ;
+    return tid;
+}
+
+MrFlowHashSelectionPolicy::MrFlowHashSelectionPolicy() {
+    NS_LOG_FUNCTION(this);
+}
+
+MrFlowHashSelectionPolicy::~MrFlowHashSelectionPolicy() {
+    NS_LOG_FUNCTION(this);
+}
+
+uint32_t
+MrFlowHashSelectionPolicy::GetFlowHash(Ptr<const Packet> packet, Mac48Address dest, uint16_t protocolNumber) const {
+    return HashFlow(packet, dest, protocolNumber, m_hashIpFlow);
+}
+
+uint32_t
+MrFlowHashSelectionPolicy::HashFlow(Ptr<const Packet> packet, Mac48Address dest, uint16_t protocolNumber,
+                                    bool hashIpFlow) {
+    // destination, then IPv4 source and destination, protocol and ports
+    uint8_t key[6 + 8 + 1 + 4];
+    uint32_t size = 6;
+    dest.CopyTo(key);
+
+    if(hashIpFlow && protocolNumber == 0x0800) {
+        uint8_t ip[60 + 4];
+        uint32_t len = packet->CopyData(ip, sizeof(ip));
+        uint32_t ihl = len >= 20 ? (ip[0] & 0x0f) * 4 : 0;
+        if(ihl >= 20 && (ip[0] >> 4) == 4) {
+            memcpy(key + size, ip + 12, 8);
+            size += 8;
+            key[size++] = ip[9];
+            // ports of the first fragment of TCP and UDP datagrams
+            bool firstFragment = ((ip[6] & 0x1f) == 0 && ip[7] == 0);
+            if((ip[9] == 6 || ip[9] == 17) && firstFragment && len >= ihl + 4) {
+                memcpy(key + size, ip + ihl, 4);
+                size += 4;
+            }
+        }
+    }
+
+    return Hash32((const char *)key, size);
+}
+
+uint32_t
+MrFlowHashSelectionPolicy::SelectRadio(Ptr<MrWifiNetDevice> device, Ptr<const Packet> packet,
+                                       Mac48Address dest, uint16_t protocolNumber) {
+    return GetFlowHash(packet, dest, protocolNumber) % device->GetNRadios();
+}
+
+//------------------------------------------------------------------------------
+// MrAckRatioSelectionPolicy
+//------------------------------------------------------------------------------
+TypeId
+MrAckRatioSelectionPolicy::GetTypeId(void) {
+    static TypeId tid = TypeId("ns3::MrAckRatioSelectionPolicy")
+        .SetParent<MrSelectionPolicy>()
+        .SetGroupName("Wifi")
+        .AddConstructor<MrAckRatioSelectionPolicy>()
+    ;
+    return tid;
+}
+
+MrAckRatioSelectionPolicy::MrAckRatioSelectionPolicy() {
+    NS_LOG_FUNCTION(this);
+}
+
+MrAckRatioSelectionPolicy::~MrAckRatioSelectionPolicy() {
+    NS_LOG_FUNCTION(this);
+}
+
+uint32_t
+MrAckRatioSelectionPolicy::SelectRadio(Ptr<MrWifiNetDevice> device, Ptr<const Packet> packet,
+                                       Mac48Address dest, uint16_t protocolNumber) {
+    uint32_t min_radio = 0;
+    double min_cost = std::numeric_limits<double>::max();
+
+    for(uint32_t i=0; i<device->GetNRadios(); i++) {
+        double cost = (device->GetPhysicalNetDevice(i)->GetBEQueueSize() + 1) / GetAckRatio(device, i);
+        if(cost < min_cost) {
+            min_radio = i;
+            min_cost = cost;
+        }
+    }
+
+    return min_radio;
+}
+
+//------------------------------------------------------------------------------
+// MrExpectedTxTimeSelectionPolicy
+//------------------------------------------------------------------------------
+TypeId
+MrExpectedTxTimeSelectionPolicy::GetTypeId(void) {
+    static TypeId tid = TypeId("ns3::MrExpectedTxTimeSelectionPolicy")
+        .SetParent<MrSelectionPolicy>()
+        .SetGroupName("Wifi")
+        .AddConstructor<MrExpectedTxTimeSelectionPolicy>()
+    ;
+    return tid;
+}
+
+MrExpectedTxTimeSelectionPolicy::MrExpectedTxTimeSelectionPolicy() {
+    NS_LOG_FUNCTION(this);
+}
+
+MrExpectedTxTimeSelectionPolicy::~MrExpectedTxTimeSelectionPolicy() {
+    NS_LOG_FUNCTION(this);
+    // the policy may be replaced without being disposed
+    UntrackRadios();
+}
+
+void
+MrExpectedTxTimeSelectionPolicy::DoDispose(void) {
+    NS_LOG_FUNCTION(this);
+    UntrackRadios();
+    MrSelectionPolicy::DoDispose();
+}
+
+void
+MrExpectedTxTimeSelectionPolicy::UntrackRadios(void) {
+    for(uint32_t i=0; i<m_radios.size(); i++) {
+        std::ostringstream context;
+        context << i;
+        m_radios[i].phy->TraceDisconnect("MonitorSnifferTx", context.str(),
+                                         MakeCallback(&MrExpectedTxTimeSelectionPolicy::NotifyTx, this));
+    }
+    m_radios.clear();
+}
+
+void
+MrExpectedTxTimeSelectionPolicy::TrackRadios(Ptr<MrWifiNetDevice> device) {
+    while(m_radios.size() < device->GetNRadios()) {
+        RadioRate radio;
+        radio.phy = device->GetPhysicalNetDevice(m_radios.size())->GetPhy();
+        radio.preamble = WIFI_PREAMBLE_LONG;
+        radio.valid = false;
+        std::ostringstream context;
+        context << m_radios.size();
+        radio.phy->TraceConnect("MonitorSnifferTx", context.str(),
+                                MakeCallback(&MrExpectedTxTimeSelectionPolicy::NotifyTx, this));
+        m_radios.push_back(radio);
+    }
+}
+
+void
+MrExpectedTxTimeSelectionPolicy::NotifyTx(std::string context, Ptr<const Packet> packet, uint16_t channelFreqMhz,
+                                          uint16_t channelNumber, uint32_t rate, WifiPreamble preamble,
+                                          WifiTxVector txVector, struct mpduInfo aMpdu) {
+    if(aMpdu.type == NORMAL_MPDU) {
+        WifiMacHeader hdr;
+        packet->PeekHeader(hdr);
+        if(!hdr.IsData() || hdr.GetAddr1().IsGroup()) return;
+    }
+
+    RadioRate &radio = m_radios[std::atoi(context.c_str())];
+    radio.txVector = txVector;
+    radio.preamble = preamble;
+    radio.valid = true;
+}
+
+Time
+MrExpectedTxTimeSelectionPolicy::GetExpectedTxTime(Ptr<MrWifiNetDevice> device, uint32_t radio, uint32_t size) {
+    TrackRadios(device);
+    const RadioRate &rate = m_radios[radio];
+    Ptr<WifiNetDevice> wifi = device->GetPhysicalNetDevice(radio);
+
+    WifiTxVector txVector = rate.txVector;
+    WifiPreamble preamble = rate.preamble;
+    if(!rate.valid) {
+        Ptr<WifiRemoteStationManager> manager = wifi->GetRemoteStationManager();
+        WifiMode mode = manager->GetDefaultMode();
+        txVector = WifiTxVector(mode, manager->GetDefaultTxPowerLevel(), 0, false, 1, 0,
+                                rate.phy->GetChannelWidth(), false, false);
+        switch(mode.GetModulationClass()) {
+        case WIFI_MOD_CLASS_HT:
+            preamble = WIFI_PREAMBLE_HT_MF;
+            break;
+        case WIFI_MOD_CLASS_VHT:
+            preamble = WIFI_PREAMBLE_VHT;
+            break;
+        default:
+            preamble = WIFI_PREAMBLE_LONG;
+        }
+    }
+
+    Time airtime = rate.phy->CalculateTxDuration(size + MR_MAC_OVERHEAD, txVector, preamble,
+                                                 rate.phy->GetFrequency());
+    return Seconds(airtime.GetSeconds() * (wifi->GetBEQueueSize() + 1) / GetAckRatio(device, radio));
+}
+
+uint32_t
+MrExpectedTxTimeSelectionPolicy::SelectRadio(Ptr<MrWifiNetDevice> device, Ptr<const Packet> packet,
+                                             Mac48Address dest, uint16_t protocolNumber) {
+    uint32_t min_radio = 0;
+    Time min_time = Time::Max();
+
+    for(uint32_t i=0; i<device->GetNRadios(); i++) {
+        Time time = GetExpectedTxTime(device, i, packet->GetSize());
+        if(time < min_time) {
+            min_radio = i;
+            min_time = time;
+        }
+    }
+
+    return min_radio;
+}
+
+}   // namespace ns3
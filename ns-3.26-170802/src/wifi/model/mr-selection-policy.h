@@ -0,0 +1,209 @@
+#ifndef MR_SELECTION_POLICY_H
+#define MR_SELECTION_POLICY_H
+
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/mac48-address.h"
+#include "wifi-tx-vector.h"
+#include "wifi-preamble.h"
+#include "wifi-phy.h"
+#include <vector>
+#include <string>
+
+namespace ns3 {
+
+class MrWifiNetDevice;
+
+/**
+ * \ingroup wifi
+ *
+ * Chooses the radio of a MrWifiNetDevice which transmits a unicast packet.
+ *
+ * A policy is attached to a single MrWifiNetDevice through its
+ * "SelectionPolicy" attribute (see MrWifiHelper::SetSelectionPolicy) and
+ * may keep per-device state.
+ */
+class MrSelectionPolicy : public Object
+{
+public:
+    static TypeId GetTypeId(void);
+
+    MrSelectionPolicy();
+    virtual ~MrSelectionPolicy();
+
+    /**
+     * \param device the multi-radio device sending the packet
+     * \param packet the packet handed to MrWifiNetDevice::Send
+     * \param dest the destination of the packet
+     * \param protocolNumber the protocol number of the packet
+     * \return the index of the radio which transmits the packet
+     */
+    virtual uint32_t SelectRadio(Ptr<MrWifiNetDevice> device, Ptr<const Packet> packet,
+                                 Mac48Address dest, uint16_t protocolNumber) = 0;
+};
+
+/**
+ * \ingroup wifi
+ *
+ * Pick the radio with the shortest best-effort queue.  All radios but
+ * "PreferredRadio" are penalized by "Bias" packets, so that the preferred
+ * radio is used until its queue builds up.
+ */
+class MrQueueLengthSelectionPolicy : public MrSelectionPolicy
+{
+public:
+    static TypeId GetTypeId(void);
+
+    MrQueueLengthSelectionPolicy();
+    virtual ~MrQueueLengthSelectionPolicy();
+
+    virtual uint32_t SelectRadio(Ptr<MrWifiNetDevice> device, Ptr<const Packet> packet,
+                                 Mac48Address dest, uint16_t protocolNumber);
+
+private:
+    uint32_t m_bias;            //!< queue length penalty of the other radios
+    uint32_t m_preferredRadio;  //!< radio which is not penalized
+};
+
+/**
+ * \ingroup wifi
+ *
+ * Use each radio in turn.
+ */
+class MrRoundRobinSelectionPolicy : public MrSelectionPolicy
+{
+public:
+    static TypeId GetTypeId(void);
+
+    MrRoundRobinSelectionPolicy();
+    virtual ~MrRoundRobinSelectionPolicy();
+
+    virtual uint32_t SelectRadio(Ptr<MrWifiNetDevice> device, Ptr<const Packet> packet,
+                                 Mac48Address dest, uint16_t protocolNumber);
+
+private:
+    uint32_t m_next;    //!< radio of the next packet
+};
+
+/**
+ * \ingroup wifi
+ *
+ * Pin every flow to a single radio, by hashing the destination address
+ * and, with "HashIpFlow", the IPv4 addresses, protocol and ports of the
+ * packet.  The packets of a flow are never reordered across radios.
+ */
+class MrFlowHashSelectionPolicy : public MrSelectionPolicy
+{
+public:
+    static TypeId GetTypeId(void);
+
+    MrFlowHashSelectionPolicy();
+    virtual ~MrFlowHashSelectionPolicy();
+
+    virtual uint32_t SelectRadio(Ptr<MrWifiNetDevice> device, Ptr<const Packet> packet,
+                                 Mac48Address dest, uint16_t protocolNumber);
+
+    /**
+     * \param packet the packet handed to MrWifiNetDevice::Send
+     * \param dest the destination of the packet
+     * \param protocolNumber the protocol number of the packet
+     * \return the hash of the flow of the packet
+     */
+    uint32_t GetFlowHash(Ptr<const Packet> packet, Mac48Address dest, uint16_t protocolNumber) const;
+    /**
+     * \param packet the packet handed to MrWifiNetDevice::Send
+     * \param dest the destination of the packet
+     * \param protocolNumber the protocol number of the packet
+     * \param hashIpFlow hash the IPv4 5-tuple, not only the destination
+     * \return the hash of the flow of the packet
+     */
+    static uint32_t HashFlow(Ptr<const Packet> packet, Mac48Address dest, uint16_t protocolNumber,
+                             bool hashIpFlow);
+
+private:
+    bool m_hashIpFlow;  //!< hash the IPv4 5-tuple, not only the destination
+};
+
+/**
+ * \ingroup wifi
+ *
+ * Weight the best-effort queue length of each radio by its ACK ratio:
+ * the radio with the lowest (queue + 1) / ratio is picked, where ratio is
+ * (acks received + 1) / (acks received + acks missed + 2) as counted by
+ * MrWifiNetDevice since the last ResetStatistics.
+ */
+class MrAckRatioSelectionPolicy : public MrSelectionPolicy
+{
+public:
+    static TypeId GetTypeId(void);
+
+    MrAckRatioSelectionPolicy();
+    virtual ~MrAckRatioSelectionPolicy();
+
+    virtual uint32_t SelectRadio(Ptr<MrWifiNetDevice> device, Ptr<const Packet> packet,
+                                 Mac48Address dest, uint16_t protocolNumber);
+};
+
+/**
+ * \ingroup wifi
+ *
+ * Pick the radio which is expected to deliver the packet first: the
+ * airtime of the packet at the rate of the last unicast data frame sent
+ * by the radio (its default mode before that), multiplied by the number
+ * of packets in its best-effort queue plus one, and divided by its ACK
+ * ratio (see MrAckRatioSelectionPolicy).
+ */
+class MrExpectedTxTimeSelectionPolicy : public MrSelectionPolicy
+{
+public:
+    static TypeId GetTypeId(void);
+
+    MrExpectedTxTimeSelectionPolicy();
+    virtual ~MrExpectedTxTimeSelectionPolicy();
+
+    virtual uint32_t SelectRadio(Ptr<MrWifiNetDevice> device, Ptr<const Packet> packet,
+                                 Mac48Address dest, uint16_t protocolNumber);
+
+    /**
+     * \param device the multi-radio device
+     * \param radio the index of a radio of the device
+     * \param size the size of the packet handed to MrWifiNetDevice::Send
+     * \return the expected time for the radio to deliver the packet
+     */
+    Time GetExpectedTxTime(Ptr<MrWifiNetDevice> device, uint32_t radio, uint32_t size);
+
+protected:
+    virtual void DoDispose(void);
+
+private:
+    /// rate of the last unicast data frame sent by a radio
+    struct RadioRate {
+        Ptr<WifiPhy> phy;
+        WifiTxVector txVector;
+        WifiPreamble preamble;
+        bool valid;
+    };
+
+    /**
+     * Track the transmissions of the radios not seen yet.
+     *
+     * \param device the multi-radio device
+     */
+    void TrackRadios(Ptr<MrWifiNetDevice> device);
+    /**
+     * Stop tracking the transmissions of the radios.
+     */
+    void UntrackRadios(void);
+    /**
+     * MonitorSnifferTx trace sink; the context is the radio index.
+     */
+    void NotifyTx(std::string context, Ptr<const Packet> packet, uint16_t channelFreqMhz,
+                  uint16_t channelNumber, uint32_t rate, WifiPreamble preamble,
+                  WifiTxVector txVector, struct mpduInfo aMpdu);
+
+    std::vector<RadioRate> m_radios;   //!< indexed by radio
+};
+
+}   // namespace ns3
+
+#endif
@@ -0,0 +1,87 @@
+#include "mr-sequence-header.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(MrSequenceHeader);
+
+TypeId
+MrSequenceHeader::GetTypeId(void) {
+    static TypeId tid = TypeId("ns3::MrSequenceHeader")
+        .SetParent<Header>()
+        .SetGroupName("Wifi")
+        .AddConstructor<MrSequenceHeader>()
+    ;
+    return tid;
+}
+
+TypeId
+MrSequenceHeader::GetInstanceTypeId(void) const {
+    return GetTypeId();
+}
+
+MrSequenceHeader::MrSequenceHeader()
+    : m_protocol(0),
+      m_flowId(0),
+      m_sequence(0) {
+}
+
+MrSequenceHeader::~MrSequenceHeader() {
+}
+
+void
+MrSequenceHeader::Print(std::ostream &os) const {
+    os << "protocol=0x" << std::hex << m_protocol << std::dec
+       << " flow=" << m_flowId << " seq=" << m_sequence;
+}
+
+uint32_t
+MrSequenceHeader::GetSerializedSize(void) const {
+    return 2 + 4 + 4;
+}
+
+void
+MrSequenceHeader::Serialize(Buffer::Iterator start) const {
+    start.WriteHtonU16(m_protocol);
+    start.WriteHtonU32(m_flowId);
+    start.WriteHtonU32(m_sequence);
+}
+
+uint32_t
+MrSequenceHeader::Deserialize(Buffer::Iterator start) {
+    m_protocol = start.ReadNtohU16();
+    m_flowId = start.ReadNtohU32();
+    m_sequence = start.ReadNtohU32();
+    return GetSerializedSize();
+}
+
+void
+MrSequenceHeader::SetProtocol(uint16_t protocol) {
+    m_protocol = protocol;
+}
+
+void
+MrSequenceHeader::SetFlowId(uint32_t flowId) {
+    m_flowId = flowId;
+}
+
+void
+MrSequenceHeader::SetSequence(uint32_t sequence) {
+    m_sequence = sequence;
+}
+
+uint16_t
+MrSequenceHeader::GetProtocol(void) const {
+    return m_protocol;
+}
+
+uint32_t
+MrSequenceHeader::GetFlowId(void) const {
+    return m_flowId;
+}
+
+uint32_t
+MrSequenceHeader::GetSequence(void) const {
+    return m_sequence;
+}
+
+}   // namespace ns3
@@ -0,0 +1,48 @@
+#ifndef MR_SEQUENCE_HEADER_H
+#define MR_SEQUENCE_HEADER_H
+
+#include "ns3/header.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * Header added by MrWifiNetDevice to the unicast packets it stripes over
+ * its radios, so that the receiving MrWifiNetDevice can deliver the
+ * packets of each flow in order.  The packet is sent with the
+ * MrSequenceHeader::PROT_NUMBER protocol number and the header carries
+ * the original one.
+ */
+class MrSequenceHeader : public Header
+{
+public:
+    /// protocol number (IEEE 802 local experimental ethertype) of striped packets
+    static const uint16_t PROT_NUMBER = 0x88B5;
+
+    MrSequenceHeader();
+    virtual ~MrSequenceHeader();
+
+    static TypeId GetTypeId(void);
+    virtual TypeId GetInstanceTypeId(void) const;
+    virtual void Print(std::ostream &os) const;
+    virtual uint32_t GetSerializedSize(void) const;
+    virtual void Serialize(Buffer::Iterator start) const;
+    virtual uint32_t Deserialize(Buffer::Iterator start);
+
+    void SetProtocol(uint16_t protocol);
+    void SetFlowId(uint32_t flowId);
+    void SetSequence(uint32_t sequence);
+    uint16_t GetProtocol(void) const;
+    uint32_t GetFlowId(void) const;
+    uint32_t GetSequence(void) const;
+
+private:
+    uint16_t m_protocol;    // protocol number of the packet
+    uint32_t m_flowId;      // flow of the packet, chosen by the sender
+    uint32_t m_sequence;    // sequence number of the packet in its flow
+};
+
+}   // namespace ns3
+
+#endif
@@ -1,5 +1,7 @@
 #include "ns3/simulator.h"
 #include "mr-wifi-net-device.h"
+#include "mr-selection-policy.h"
+#include "mr-sequence-header.h"
 #include "wifi-net-device.h"
 #include "wifi-mac.h"
 #include "regular-wifi-mac.h"
@@ -10,11 +12,15 @@
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
+#include "ns3/object-vector.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
 #include "ns3/node.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/log.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/internet-module.h"
+#include <algorithm>
 
 NS_LOG_COMPONENT_DEFINE("MrWifiNetDevice");
 
@@ -27,11 +33,46 @@ MrWifiNetDevice::GetTypeId(void) {
     static TypeId tid = TypeId("ns3::MrWifiNetDevice")
         .SetParent<NetDevice>()
         .AddConstructor<MrWifiNetDevice>()
-        .AddAttribute ("Mtu", "The MAC-level Maximum Transmission Unit",
+        .AddAttribute ("Mtu", "The MAC-level Maximum Transmission Unit; with Striping, the MTU reported "
+                   "leaves room for the sequence header",
                    UintegerValue (MAX_MSDU_SIZE - LLC_SNAP_HEADER_LENGTH),
                    MakeUintegerAccessor (&MrWifiNetDevice::SetMtu,
                                          &MrWifiNetDevice::GetMtu),
                    MakeUintegerChecker<uint16_t> (1,MAX_MSDU_SIZE - LLC_SNAP_HEADER_LENGTH))
+        .AddAttribute ("SelectionPolicy", "The policy which picks the radio transmitting each unicast packet",
+                   StringValue ("ns3::MrQueueLengthSelectionPolicy"),
+                   MakePointerAccessor (&MrWifiNetDevice::SetSelectionPolicy,
+                                        &MrWifiNetDevice::GetSelectionPolicy),
+                   MakePointerChecker<MrSelectionPolicy> ())
+        .AddAttribute ("Striping", "Add a per-flow sequence number to the unicast packets so that the receiver "
+                   "delivers them in order even when the selection policy spreads a flow over several radios",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&MrWifiNetDevice::m_striping),
+                   MakeBooleanChecker ())
+        .AddAttribute ("ResequencingBufferSize", "Maximum number of packets held for a flow while waiting for a missing one",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&MrWifiNetDevice::m_reorderBufferSize),
+                   MakeUintegerChecker<uint32_t> (1))
+        .AddAttribute ("ResequencingTimeout", "Maximum time a packet is held while waiting for a missing one",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&MrWifiNetDevice::m_reorderTimeout),
+                   MakeTimeChecker ())
+        .AddAttribute ("FlowIdleTimeout", "Time without packets after which the resequencing state of a flow is "
+                   "dropped; the sender drops the numbering of a flow after twice this time, so that it only "
+                   "restarts it once the receiver has forgotten the flow",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&MrWifiNetDevice::m_flowIdleTimeout),
+                   MakeTimeChecker ())
+        .AddAttribute ("RadioStatistics", "The statistics of each radio, indexed by radio",
+                   ObjectVectorValue (),
+                   MakeObjectVectorAccessor (&MrWifiNetDevice::m_radioStats),
+                   MakeObjectVectorChecker<MrRadioStatistics> ())
+        .AddTraceSource ("ReorderDepth", "A received packet is held because an earlier packet of its flow is missing",
+                   MakeTraceSourceAccessor (&MrWifiNetDevice::m_reorderDepthTrace),
+                   "ns3::MrWifiNetDevice::ReorderDepthTracedCallback")
+        .AddTraceSource ("HoldTime", "A held packet is delivered, after waiting for the given time",
+                   MakeTraceSourceAccessor (&MrWifiNetDevice::m_holdTimeTrace),
+                   "ns3::Time::TracedCallback")
     ;
     return tid;
 }
@@ -45,6 +86,8 @@ MrWifiNetDevice::MrWifiNetDevice() {
 
 	m_proposed = true;
 	m_debug = 99;
+	m_striping = false;
+	m_reorderBufferSize = 64;
 }
 
 MrWifiNetDevice::~MrWifiNetDevice() {
@@ -63,6 +106,19 @@ void MrWifiNetDevice::DoDispose() {
     }
 
     m_devices.clear();
+    m_radioStats.clear();
+
+    for(std::map<FlowKey, ReorderBuffer>::iterator i = m_reorderBuffers.begin(); i != m_reorderBuffers.end(); i++) {
+        i->second.timeout.Cancel();
+    }
+    m_reorderBuffers.clear();
+    m_txExpiry.Cancel();
+    m_txSequence.clear();
+
+    if(m_selectionPolicy != 0) {
+        m_selectionPolicy->Dispose();
+        m_selectionPolicy = 0;
+    }
 
     NetDevice::DoDispose();
 }
@@ -95,21 +151,16 @@ void MrWifiNetDevice::DoInitialize(void) {
 		*/
     }
 
-	tx_radio = 0;
 	m_token = false;
 
-	for(uint32_t i=0; i<8; i++) {
-		num_acks_received[i] = 0;
-		num_acks_missed[i] = 0;
-	}
+	ResetStatistics();
 
     NetDevice::DoInitialize();
 }
 
 void MrWifiNetDevice::ResetStatistics() {
-	for(uint32_t i=0; i<8; i++) {
-		num_acks_received[i] = 0;
-		num_acks_missed[i] = 0;
+	for(uint32_t i=0; i<m_radioStats.size(); i++) {
+		m_radioStats[i]->Reset();
 	}
 }
 
@@ -125,6 +176,7 @@ void MrWifiNetDevice::AddRadio(Ptr<WifiNetDevice> device) {
 	device->SetGotAckCallback(MakeCallback(&MrWifiNetDevice::GotAck, this));
 	device->SetMissedAckCallback(MakeCallback(&MrWifiNetDevice::MissedAck, this));
 	device->SetOverheardAckCallback(MakeCallback(&MrWifiNetDevice::OverheardAck, this));
+	m_radioStats.push_back(CreateObject<MrRadioStatistics>());
 
     m_numRadios++;
 }
@@ -140,6 +192,18 @@ Ptr<WifiNetDevice> MrWifiNetDevice::GetPhysicalNetDevice(int index) {
     return m_devices[index];
 }
 
+uint32_t MrWifiNetDevice::GetNRadios(void) const {
+    return m_devices.size();
+}
+
+void MrWifiNetDevice::SetSelectionPolicy(Ptr<MrSelectionPolicy> policy) {
+    m_selectionPolicy = policy;
+}
+
+Ptr<MrSelectionPolicy> MrWifiNetDevice::GetSelectionPolicy(void) const {
+    return m_selectionPolicy;
+}
+
 void MrWifiNetDevice::SetReceiveCallback(MrWifiNetDeviceReceiveCallback callback) {
     m_rxCallback = callback;
 }
@@ -149,11 +213,41 @@ void MrWifiNetDevice::SetSendCallback(MrWifiNetDeviceSendCallback callback) {
 }
 
 uint32_t MrWifiNetDevice::GetNumAcksReceived(uint32_t ifIndex) {
-	return num_acks_received[ifIndex];
+	return GetRadioStatistics(ifIndex)->GetAcksReceived();
 }
 
 uint32_t MrWifiNetDevice::GetNumAcksMissed(uint32_t ifIndex) {
-	return num_acks_missed[ifIndex];
+	return GetRadioStatistics(ifIndex)->GetAcksMissed();
+}
+
+Ptr<MrRadioStatistics> MrWifiNetDevice::GetRadioStatistics(uint32_t ifIndex) const {
+	NS_ASSERT_MSG(ifIndex < m_radioStats.size(), "no radio " << ifIndex);
+	return m_radioStats[ifIndex];
+}
+
+std::vector<MrRadioStatistics::Snapshot> MrWifiNetDevice::GetStatisticsSnapshot(void) const {
+	std::vector<MrRadioStatistics::Snapshot> snapshot;
+	snapshot.reserve(m_radioStats.size());
+	for(uint32_t i=0; i<m_radioStats.size(); i++) {
+		snapshot.push_back(m_radioStats[i]->GetSnapshot());
+	}
+	return snapshot;
+}
+
+MrRadioStatistics::Snapshot MrWifiNetDevice::GetAggregateStatistics(void) const {
+	MrRadioStatistics::Snapshot total;
+	for(uint32_t i=0; i<m_radioStats.size(); i++) {
+		total += m_radioStats[i]->GetSnapshot();
+	}
+	return total;
+}
+
+uint32_t MrWifiNetDevice::GetNSequencedFlows(void) const {
+	return m_txSequence.size();
+}
+
+uint32_t MrWifiNetDevice::GetNResequencedFlows(void) const {
+	return m_reorderBuffers.size();
 }
 
 void MrWifiNetDevice::GotAck(uint32_t ifIndex) {
@@ -163,6 +257,7 @@ void MrWifiNetDevice::GotAck(uint32_t ifIndex) {
     	for(int i=1; i<m_numRadios; i++) {
     	    Ptr<WifiNetDevice> device = *(m_devices.begin()+i);
     	    device->SetToken(true);
+    	    m_radioStats[i]->NotifyToken(true);
     	}
 
 		if(m_token == false) {
@@ -171,21 +266,24 @@ void MrWifiNetDevice::GotAck(uint32_t ifIndex) {
 		}
 	}
 
-	num_acks_received[ifIndex]++;
+	GetRadioStatistics(ifIndex)->NotifyAckReceived();
 	return;
 }
 
 void MrWifiNetDevice::MissedAck(uint32_t ifIndex) {
-	num_acks_missed[ifIndex]++;
+	GetRadioStatistics(ifIndex)->NotifyAckMissed();
 	return;
 }
 
 void MrWifiNetDevice::OverheardAck(uint32_t ifIndex) {
 
+	GetRadioStatistics(ifIndex)->NotifyAckOverheard();
+
 	// Except for the first interface, release token.
     for(int i=1; i<m_numRadios; i++) {
         Ptr<WifiNetDevice> device = *(m_devices.begin()+i);
         device->SetToken(false);
+        m_radioStats[i]->NotifyToken(false);
     }
 
 	if(m_token == true) {
@@ -198,13 +296,154 @@ void MrWifiNetDevice::OverheardAck(uint32_t ifIndex) {
 
 bool MrWifiNetDevice::ReceiveFromDevice(Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, Address const &from) {
 
+    GetRadioStatistics(device->GetIfIndex())->NotifyRx(packet->GetSize());
+
+    if(protocol == MrSequenceHeader::PROT_NUMBER) {
+        Ptr<Packet> copy = packet->Copy();
+        MrSequenceHeader header;
+        copy->RemoveHeader(header);
+        Resequence(device, copy, header, from);
+        return true;
+    }
+
+    Deliver(device, packet, protocol, from);
+    return true;
+}
+
+void MrWifiNetDevice::Deliver(Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from) {
+
     // call callback function for statistics collection
     if(!m_rxCallback.IsNull()) {
         m_rxCallback(GetNode()->GetId(), device, packet, protocol);
     }
 
     m_forwardUp(this, packet, protocol, from);
-    return true;
+}
+
+//------------------------------------------------------------------------------
+// resequencing of striped flows
+//------------------------------------------------------------------------------
+void MrWifiNetDevice::Resequence(Ptr<NetDevice> device, Ptr<Packet> packet, const MrSequenceHeader &header, const Address &from) {
+    NS_LOG_FUNCTION(this << packet << header);
+
+    FlowKey key(Mac48Address::ConvertFrom(from), header.GetFlowId());
+    uint32_t sequence = header.GetSequence();
+
+    std::map<FlowKey, ReorderBuffer>::iterator it = m_reorderBuffers.find(key);
+    if(it == m_reorderBuffers.end()) {
+        // the first packet of a flow sets its starting sequence number
+        ReorderBuffer buffer;
+        buffer.from = from;
+        buffer.expected = sequence;
+        it = m_reorderBuffers.insert(std::make_pair(key, buffer)).first;
+    }
+    ReorderBuffer &buffer = it->second;
+    buffer.lastSeen = Simulator::Now();
+
+    int32_t offset = (int32_t)(sequence - buffer.expected);
+    if(offset < 0) {
+        // late packet, its successors were already delivered
+        NS_LOG_DEBUG("late packet " << sequence << " expected " << buffer.expected);
+        Deliver(device, packet, header.GetProtocol(), from);
+        return;
+    }
+    if(offset == 0) {
+        Deliver(device, packet, header.GetProtocol(), from);
+        buffer.expected++;
+        ReleaseInOrder(buffer);
+        ScheduleReorderTimeout(key, buffer);
+        return;
+    }
+
+    HeldPacket held;
+    held.device = device;
+    held.packet = packet;
+    held.protocol = header.GetProtocol();
+    held.arrival = Simulator::Now();
+    if(!buffer.held.insert(std::make_pair(sequence, held)).second) {
+        NS_LOG_DEBUG("duplicate packet " << sequence);
+        return;
+    }
+    m_reorderDepthTrace(buffer.held.size());
+
+    if(buffer.held.size() > m_reorderBufferSize) {
+        // give up on the missing packets before the oldest held one
+        buffer.expected = buffer.held.begin()->first;
+        ReleaseInOrder(buffer);
+    }
+    ScheduleReorderTimeout(key, buffer);
+}
+
+void MrWifiNetDevice::ExpireTxFlows(void) {
+    NS_LOG_FUNCTION(this);
+    std::map<FlowKey, TxFlow>::iterator i = m_txSequence.begin();
+    while(i != m_txSequence.end()) {
+        if(i->second.lastSent + m_flowIdleTimeout + m_flowIdleTimeout <= Simulator::Now()) {
+            m_txSequence.erase(i++);
+        }
+        else {
+            i++;
+        }
+    }
+    if(!m_txSequence.empty()) {
+        m_txExpiry = Simulator::Schedule(m_flowIdleTimeout, &MrWifiNetDevice::ExpireTxFlows, this);
+    }
+}
+
+void MrWifiNetDevice::ReleaseInOrder(ReorderBuffer &buffer) {
+    while(!buffer.held.empty() && buffer.held.begin()->first == buffer.expected) {
+        HeldPacket held = buffer.held.begin()->second;
+        buffer.held.erase(buffer.held.begin());
+        buffer.expected++;
+        m_holdTimeTrace(Simulator::Now() - held.arrival);
+        Deliver(held.device, held.packet, held.protocol, buffer.from);
+    }
+}
+
+void MrWifiNetDevice::ScheduleReorderTimeout(const FlowKey &key, ReorderBuffer &buffer) {
+    if(buffer.held.empty()) {
+        // once drained, a single timer checks whether the flow went idle
+        if(!buffer.timeout.IsRunning()) {
+            buffer.timeout = Simulator::Schedule(buffer.lastSeen + m_flowIdleTimeout - Simulator::Now(),
+                                                 &MrWifiNetDevice::ReorderTimeout, this, key);
+        }
+        return;
+    }
+    buffer.timeout.Cancel();
+
+    // no packet is held longer than m_reorderTimeout
+    Time oldest = buffer.held.begin()->second.arrival;
+    for(std::map<uint32_t, HeldPacket, SequenceLess>::const_iterator i = buffer.held.begin(); i != buffer.held.end(); i++) {
+        if(i->second.arrival < oldest) oldest = i->second.arrival;
+    }
+    buffer.timeout = Simulator::Schedule(oldest + m_reorderTimeout - Simulator::Now(),
+                                         &MrWifiNetDevice::ReorderTimeout, this, key);
+}
+
+void MrWifiNetDevice::ReorderTimeout(FlowKey key) {
+    NS_LOG_FUNCTION(this);
+    std::map<FlowKey, ReorderBuffer>::iterator it = m_reorderBuffers.find(key);
+    NS_ASSERT(it != m_reorderBuffers.end());
+    ReorderBuffer &buffer = it->second;
+    while(!buffer.held.empty()) {
+        bool expired = false;
+        for(std::map<uint32_t, HeldPacket, SequenceLess>::const_iterator i = buffer.held.begin(); i != buffer.held.end(); i++) {
+            if(i->second.arrival + m_reorderTimeout <= Simulator::Now()) {
+                expired = true;
+                break;
+            }
+        }
+        if(!expired) break;
+        // skip the gap before the first held packet
+        buffer.expected = buffer.held.begin()->first;
+        ReleaseInOrder(buffer);
+    }
+    if(buffer.held.empty() && buffer.lastSeen + m_flowIdleTimeout <= Simulator::Now()) {
+        NS_LOG_DEBUG("flow " << key.second << " of " << key.first << " is idle");
+        m_reorderBuffers.erase(it);
+        return;
+    }
+    ScheduleReorderTimeout(key, buffer);
 }
 
 void MrWifiNetDevice::SetDebug(uint32_t intf) {
@@ -270,6 +509,11 @@ MrWifiNetDevice::SetMtu(const uint16_t mtu) {
 uint16_t
 MrWifiNetDevice::GetMtu(void) const {
     NS_LOG_FUNCTION(this << m_mtu);
+    if(m_striping) {
+        // the unicast packets carry the sequence header
+        uint16_t maxMtu = MAX_MSDU_SIZE - LLC_SNAP_HEADER_LENGTH - MrSequenceHeader().GetSerializedSize();
+        return std::min(m_mtu, maxMtu);
+    }
     return m_mtu;
 }
 
@@ -324,23 +568,7 @@ MrWifiNetDevice::IsBridge(void) const {
 
 uint32_t
 MrWifiNetDevice::SelectInterface(Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber) {
-
-	// Check queue
-	uint32_t min_radio = 0;
-	uint32_t min_size = m_devices[0]->GetBEQueueSize();
-
-	for(uint16_t i=1; i<m_devices.size(); i++) {
-		uint32_t adjusted_size = m_devices[i]->GetBEQueueSize() + 10;
-		if(adjusted_size < min_size) {
-			min_radio = i;
-			min_size = adjusted_size;
-		}
-	}
-
-	return min_radio;
-
-	//tx_radio = (tx_radio + 1) % m_numRadios;
-    //return tx_radio;
+	return m_selectionPolicy->SelectRadio(this, packet, Mac48Address::ConvertFrom(dest), protocolNumber);
 }
 
 bool
@@ -357,14 +585,32 @@ MrWifiNetDevice::Send(Ptr<Packet> packet, const Address& dest, uint16_t protocol
             m_devices[i]->Send(p, dest, protocolNumber);
         }
 		*/
+		uint32_t size = packet->GetSize();
 		m_devices[0]->Send(packet, dest, protocolNumber);
+		m_radioStats[0]->NotifyTx(size, m_devices[0]->GetBEQueueSize());
     }
 
     // unicast packets ---------------------------------------------------------
     else {
         uint32_t k = SelectInterface(packet, dest, protocolNumber);
 		//if(GetAddress() == Mac48Address("00:00:00:00:00:02")) NS_LOG_UNCOND(Simulator::Now() << " " << GetAddress() << " Sending Packet to Interface " << k);
+        if(m_striping) {
+            Mac48Address to = Mac48Address::ConvertFrom(dest);
+            MrSequenceHeader header;
+            header.SetProtocol(protocolNumber);
+            header.SetFlowId(MrFlowHashSelectionPolicy::HashFlow(packet, to, protocolNumber, true));
+            TxFlow &flow = m_txSequence[FlowKey(to, header.GetFlowId())];
+            header.SetSequence(flow.next++);
+            flow.lastSent = Simulator::Now();
+            if(!m_txExpiry.IsRunning()) {
+                m_txExpiry = Simulator::Schedule(m_flowIdleTimeout, &MrWifiNetDevice::ExpireTxFlows, this);
+            }
+            packet->AddHeader(header);
+            protocolNumber = MrSequenceHeader::PROT_NUMBER;
+        }
+        uint32_t size = packet->GetSize();
         m_devices[k]->Send(packet, dest, protocolNumber);
+        m_radioStats[k]->NotifyTx(size, m_devices[k]->GetBEQueueSize());
     }
 
     return true;
@@ -417,7 +663,9 @@ MrWifiNetDevice::SendFrom(Ptr<Packet> packet, const Address& source, const Addre
 
     // for now, send the packet to the first radio
     Ptr<WifiNetDevice> device = *(m_devices.begin());
+    uint32_t size = packet->GetSize();
     device->SendFrom(packet, source, dest, protocolNumber);
+    m_radioStats[0]->NotifyTx(size, device->GetBEQueueSize());
 
     return true;
 }
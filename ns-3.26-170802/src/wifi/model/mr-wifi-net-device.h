@@ -5,7 +5,11 @@
 #include "ns3/packet.h"
 #include "ns3/traced-callback.h"
 #include "ns3/mac48-address.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "mr-radio-statistics.h"
 #include <vector>
+#include <map>
 
 namespace ns3 {
 
@@ -14,6 +18,8 @@ class WifiRemoteStationManager;
 class WifiChannel;
 class WifiPhy;
 class WifiMac;
+class MrSelectionPolicy;
+class MrSequenceHeader;
 
 class MrWifiNetDevice : public NetDevice
 {
@@ -37,6 +43,13 @@ public:
 	void OverheardAck(uint32_t ifIndex);
     void SendUp(Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
 
+	/**
+	 * TracedCallback signature for the resequencing buffer depth.
+	 *
+	 * \param depth the number of packets held for the flow of the packet just buffered
+	 */
+	typedef void (* ReorderDepthTracedCallback)(uint32_t depth);
+
 	void SetDebug(uint32_t intf);
 	uint32_t GetDebug();
 	//------------------------------------------------------------------------------------------------------------------
@@ -79,9 +92,12 @@ public:
 	// additional functions
 	void AddRadio(Ptr<WifiNetDevice> device);
 	Ptr<WifiNetDevice> GetPhysicalNetDevice(int index);
+	uint32_t GetNRadios(void) const;
 	void SetReceiveCallback(MrWifiNetDeviceReceiveCallback callback);
 	void SetSendCallback(MrWifiNetDeviceSendCallback callback);
 	uint32_t SelectInterface(Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber);
+	void SetSelectionPolicy(Ptr<MrSelectionPolicy> policy);
+	Ptr<MrSelectionPolicy> GetSelectionPolicy(void) const;
 	//------------------------------------------------------------------------------------------------------------------
 
 	void ResetStatistics();
@@ -89,6 +105,23 @@ public:
 
 	uint32_t GetNumAcksReceived(uint32_t ifIndex);
 	uint32_t GetNumAcksMissed(uint32_t ifIndex);
+	Ptr<MrRadioStatistics> GetRadioStatistics(uint32_t ifIndex) const;
+	/**
+	 * \return the statistics of every radio, indexed by radio
+	 */
+	std::vector<MrRadioStatistics::Snapshot> GetStatisticsSnapshot(void) const;
+	/**
+	 * \return the statistics of all the radios added up
+	 */
+	MrRadioStatistics::Snapshot GetAggregateStatistics(void) const;
+	/**
+	 * \return the number of flows the device numbers the packets of
+	 */
+	uint32_t GetNSequencedFlows(void) const;
+	/**
+	 * \return the number of flows the device keeps resequencing state for
+	 */
+	uint32_t GetNResequencedFlows(void) const;
 
 protected:
     virtual void DoDispose(void);
@@ -101,8 +134,57 @@ private:
     void LinkUp(void);
     void LinkDown(void);
 
+	//------------------------------------------------------------------------------------------------------------------
+	// striping
+	typedef std::pair<Mac48Address, uint32_t> FlowKey;     // peer address and flow id
+
+	// serial number order of the sequence numbers
+	struct SequenceLess {
+		bool operator()(uint32_t a, uint32_t b) const {
+			return (int32_t)(a - b) < 0;
+		}
+	};
+
+	struct HeldPacket {
+		Ptr<NetDevice> device;
+		Ptr<Packet> packet;
+		uint16_t protocol;
+		Time arrival;
+	};
+
+	struct ReorderBuffer {
+		Address from;
+		uint32_t expected;      // next sequence number to deliver
+		std::map<uint32_t, HeldPacket, SequenceLess> held;
+		EventId timeout;        // hold timer, or idle check once drained
+		Time lastSeen;          // arrival of the last packet of the flow
+	};
+
+	struct TxFlow {
+		uint32_t next;          // sequence number of the next packet
+		Time lastSent;
+	};
+
+	void Deliver(Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+	void Resequence(Ptr<NetDevice> device, Ptr<Packet> packet, const MrSequenceHeader &header, const Address &from);
+	void ReleaseInOrder(ReorderBuffer &buffer);
+	void ScheduleReorderTimeout(const FlowKey &key, ReorderBuffer &buffer);
+	void ReorderTimeout(FlowKey key);
+	void ExpireTxFlows(void);
+
+	bool m_striping;
+	uint32_t m_reorderBufferSize;
+	Time m_reorderTimeout;
+	Time m_flowIdleTimeout;
+	std::map<FlowKey, TxFlow> m_txSequence;
+	EventId m_txExpiry;
+	std::map<FlowKey, ReorderBuffer> m_reorderBuffers;
+	TracedCallback<uint32_t> m_reorderDepthTrace;
+	TracedCallback<Time> m_holdTimeTrace;
+	//------------------------------------------------------------------------------------------------------------------
+
     Ptr<Node> m_node;                   // node that this netdevice is attached to
-	uint32_t tx_radio;
+    Ptr<MrSelectionPolicy> m_selectionPolicy;   // picks the radio of unicast packets
 
 	//------------------------------------------------------------------------------------------------------------------
 	// slave network interfaces
@@ -122,8 +204,7 @@ private:
 	//------------------------------------------------------------------------------------------------------------------
 
 	// statistics
-	uint32_t num_acks_received[8];
-	uint32_t num_acks_missed[8];
+	std::vector<Ptr<MrRadioStatistics> > m_radioStats;    // indexed by radio
 	bool m_proposed;
 	bool m_token;
 	uint32_t m_debug;	
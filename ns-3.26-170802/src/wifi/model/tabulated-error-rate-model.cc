@@ -0,0 +1,307 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <algorithm>
+#include "tabulated-error-rate-model.h"
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TabulatedErrorRateModel");
+
+NS_OBJECT_ENSURE_REGISTERED (TabulatedErrorRateModel);
+
+/**
+ * Largest chunk, in bits, the accuracy bound is guaranteed for.  This
+ * covers a maximum-size VHT A-MPDU (1048575 bytes).
+ */
+static const double TABULATED_MAX_CHUNK_BITS = 8388608.0;
+
+TypeId
+TabulatedErrorRateModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TabulatedErrorRateModel")
+    .SetParent<ErrorRateModel> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<TabulatedErrorRateModel> ()
+    .AddAttribute ("Model",
+                   "The analytic error rate model which is tabulated.",
+                   StringValue ("ns3::NistErrorRateModel"),
+                   MakePointerAccessor (&TabulatedErrorRateModel::SetModel,
+                                        &TabulatedErrorRateModel::GetModel),
+                   MakePointerChecker<ErrorRateModel> ())
+    .AddAttribute ("MinSnrDb",
+                   "Lowest SNR (dB) covered by the tables.",
+                   DoubleValue (-10.0),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_minSnrDb),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxSnrDb",
+                   "Highest SNR (dB) covered by the tables.",
+                   DoubleValue (60.0),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_maxSnrDb),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("StepDb",
+                   "Initial SNR step (dB) of the tables.",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_stepDb),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("MinStepDb",
+                   "Finest SNR step (dB) used when refining a table to meet MaxError.",
+                   DoubleValue (0.01),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_minStepDb),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("MaxError",
+                   "Bound on the absolute difference between the tabulated and the "
+                   "analytic chunk success rate, for any chunk size.",
+                   DoubleValue (1e-5),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_maxError),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Shared",
+                   "Share tables with the other instances wrapping a model of the same "
+                   "type with the same table settings.  Disable if the wrapped model "
+                   "has a per-instance configuration.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&TabulatedErrorRateModel::m_shared),
+                   MakeBooleanChecker ())
+  ;
+  return tid;
+}
+
+TabulatedErrorRateModel::TabulatedErrorRateModel ()
+  : m_tableLookups (0),
+    m_modelLookups (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TabulatedErrorRateModel::~TabulatedErrorRateModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TabulatedErrorRateModel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_model = 0;
+  m_tables.clear ();
+  ErrorRateModel::DoDispose ();
+}
+
+void
+TabulatedErrorRateModel::SetModel (Ptr<ErrorRateModel> model)
+{
+  NS_LOG_FUNCTION (this << model);
+  m_model = model;
+  m_tables.clear ();
+}
+
+Ptr<ErrorRateModel>
+TabulatedErrorRateModel::GetModel (void) const
+{
+  return m_model;
+}
+
+uint64_t
+TabulatedErrorRateModel::GetTableLookups (void) const
+{
+  return m_tableLookups;
+}
+
+uint64_t
+TabulatedErrorRateModel::GetModelLookups (void) const
+{
+  return m_modelLookups;
+}
+
+double
+TabulatedErrorRateModel::GetTableStepDb (WifiMode mode, WifiTxVector txVector) const
+{
+  return GetTable (mode, txVector)->stepDb;
+}
+
+double
+TabulatedErrorRateModel::GetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint32_t nbits) const
+{
+  NS_LOG_FUNCTION (this << mode << snr << nbits);
+  if (snr > 0 && nbits > 0)
+    {
+      double snrDb = 10.0 * std::log10 (snr);
+      if (snrDb >= m_minSnrDb && snrDb < m_maxSnrDb)
+        {
+          Ptr<const Table> table = GetTable (mode, txVector);
+          double position = (snrDb - table->minSnrDb) * table->invStepDb;
+          uint32_t i = static_cast<uint32_t> (position);
+          NS_ASSERT (i + 1 < table->y.size ());
+          if (!table->forward[i])
+            {
+              m_tableLookups++;
+              double y0 = table->y[i];
+              if (std::abs (y0) == std::numeric_limits<double>::infinity ())
+                {
+                  // the per-bit success rate is exactly 1 (or 0) over the whole cell
+                  return y0 < 0 ? 1.0 : 0.0;
+                }
+              double y = y0 + (position - i) * (table->y[i + 1] - y0);
+              return std::exp (-std::exp (y) * nbits);
+            }
+        }
+    }
+  m_modelLookups++;
+  return m_model->GetChunkSuccessRate (mode, txVector, snr, nbits);
+}
+
+double
+TabulatedErrorRateModel::Sample (WifiMode mode, WifiTxVector txVector, double snrDb) const
+{
+  double s = m_model->GetChunkSuccessRate (mode, txVector, std::pow (10.0, snrDb / 10.0), 1);
+  if (s >= 1.0)
+    {
+      return -std::numeric_limits<double>::infinity ();
+    }
+  if (s <= 0.0)
+    {
+      return std::numeric_limits<double>::infinity ();
+    }
+  return std::log (-std::log (s));
+}
+
+Ptr<TabulatedErrorRateModel::Table>
+TabulatedErrorRateModel::BuildTable (WifiMode mode, WifiTxVector txVector) const
+{
+  NS_LOG_FUNCTION (this << mode);
+  NS_ASSERT (m_maxSnrDb > m_minSnrDb);
+  Ptr<Table> table = Create<Table> ();
+  table->minSnrDb = m_minSnrDb;
+  table->stepDb = m_stepDb;
+  uint32_t n = static_cast<uint32_t> (std::ceil ((m_maxSnrDb - m_minSnrDb) / m_stepDb)) + 1;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      table->y.push_back (Sample (mode, txVector, m_minSnrDb + i * m_stepDb));
+    }
+  while (true)
+    {
+      // Sample the middle of every cell, both to check the accuracy of the
+      // current grid and to refine it if needed.
+      std::vector<double> middles;
+      middles.reserve (table->y.size () - 1);
+      table->forward.assign (table->y.size () - 1, 0);
+      uint32_t failed = 0;
+      double maxError = 0;
+      for (uint32_t i = 0; i + 1 < table->y.size (); i++)
+        {
+          double exact = Sample (mode, txVector, table->minSnrDb + (i + 0.5) * table->stepDb);
+          middles.push_back (exact);
+          double y0 = table->y[i];
+          double y1 = table->y[i + 1];
+          if (y0 == y1 && std::abs (y0) == std::numeric_limits<double>::infinity ())
+            {
+              // the per-bit success rate is exactly 0 or 1 over the whole cell
+              continue;
+            }
+          if (std::abs (y0) == std::numeric_limits<double>::infinity ()
+              || std::abs (y1) == std::numeric_limits<double>::infinity ()
+              || std::abs (exact) == std::numeric_limits<double>::infinity ())
+            {
+              table->forward[i] = 1;
+              continue;
+            }
+          // A relative error r on -log (s) changes s^n by at most
+          // r * n * a * exp (-n * a) <= r * min (1/e, n * a), with a = -log (s).
+          double a = std::exp (exact);
+          double r = std::abs (std::exp ((y0 + y1) / 2 - exact) - 1);
+          double error = r * std::min (std::exp (-1.0), TABULATED_MAX_CHUNK_BITS * a);
+          if (error > m_maxError)
+            {
+              table->forward[i] = 1;
+              maxError = std::max (maxError, error);
+              failed++;
+            }
+        }
+      if (failed == 0 || table->stepDb / 2 < m_minStepDb)
+        {
+          NS_LOG_DEBUG ("table for " << mode << ": " << failed << " cells above MaxError=" << m_maxError
+                        << " (up to " << maxError << ") are forwarded to the model");
+          break;
+        }
+      std::vector<double> y;
+      y.reserve (table->y.size () + middles.size ());
+      for (uint32_t i = 0; i < middles.size (); i++)
+        {
+          y.push_back (table->y[i]);
+          y.push_back (middles[i]);
+        }
+      y.push_back (table->y.back ());
+      table->y.swap (y);
+      table->stepDb /= 2;
+    }
+  table->invStepDb = 1 / table->stepDb;
+  NS_LOG_DEBUG ("built table for " << mode << ": " << table->y.size () << " points, step " << table->stepDb << "dB");
+  return table;
+}
+
+std::string
+TabulatedErrorRateModel::GetSharingKey (void) const
+{
+  std::ostringstream oss;
+  oss.precision (17);
+  oss << m_model->GetInstanceTypeId ().GetName () << "|" << m_minSnrDb << "|" << m_maxSnrDb
+      << "|" << m_stepDb << "|" << m_minStepDb << "|" << m_maxError;
+  return oss.str ();
+}
+
+std::map<std::string, TabulatedErrorRateModel::Tables> *
+TabulatedErrorRateModel::GetSharedTables (void)
+{
+  static std::map<std::string, Tables> *tables = new std::map<std::string, Tables> ();
+  return tables;
+}
+
+Ptr<const TabulatedErrorRateModel::Table>
+TabulatedErrorRateModel::GetTable (WifiMode mode, WifiTxVector txVector) const
+{
+  Tables::const_iterator it = m_tables.find (mode.GetUid ());
+  if (it != m_tables.end ())
+    {
+      return it->second;
+    }
+  NS_ASSERT_MSG (m_model != 0, "TabulatedErrorRateModel requires a Model to tabulate");
+  Ptr<Table> table;
+  if (m_shared)
+    {
+      Ptr<Table> &shared = (*GetSharedTables ())[GetSharingKey ()][mode.GetUid ()];
+      if (shared == 0)
+        {
+          shared = BuildTable (mode, txVector);
+        }
+      table = shared;
+    }
+  else
+    {
+      table = BuildTable (mode, txVector);
+    }
+  m_tables[mode.GetUid ()] = table;
+  return table;
+}
+
+} //namespace ns3
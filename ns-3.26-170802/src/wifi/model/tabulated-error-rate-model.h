@@ -0,0 +1,157 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TABULATED_ERROR_RATE_MODEL_H
+#define TABULATED_ERROR_RATE_MODEL_H
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "ns3/simple-ref-count.h"
+#include "error-rate-model.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * An error rate model which answers GetChunkSuccessRate from a
+ * precomputed table instead of evaluating an analytic model.
+ *
+ * The analytic models shipped with this module (NistErrorRateModel,
+ * YansErrorRateModel and the DSSS models) all compute the success rate
+ * of a chunk of n bits as s^n, where s is the success rate of a single
+ * bit at the given SNR.  This model samples y = log (-log (s)) of the
+ * wrapped model (the "Model" attribute) on a grid uniform in dB, one
+ * table per WifiMode, and computes s^n = exp (-n * exp (y)) by linear
+ * interpolation of y.  This replaces erfc, the BER polynomial and the
+ * final pow of the analytic models by a log10 and two exp.
+ *
+ * The grid step starts at "StepDb" and is halved until, at the middle of
+ * every grid cell, the interpolated chunk success rate differs from the
+ * wrapped model by less than "MaxError" for any chunk size, or until the
+ * step reaches "MinStepDb".  Cells which still exceed the bound (close to
+ * the SNR where the model clamps its BER, or where the per-bit success
+ * rate jumps to exactly 0 or 1) are forwarded to the wrapped model, as
+ * are SNRs outside [MinSnrDb, MaxSnrDb].
+ *
+ * Tables are built lazily, the first time a mode is used, and by default
+ * they are shared by all instances wrapping the same model type with the
+ * same grid settings, so that all the PHYs of a simulation pay for each
+ * table only once.  The wrapped model must only depend on the mode, the
+ * SNR and the number of bits: the TXVECTOR of the first call is used to
+ * build the table of a mode.
+ */
+class TabulatedErrorRateModel : public ErrorRateModel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  TabulatedErrorRateModel ();
+  virtual ~TabulatedErrorRateModel ();
+
+  /**
+   * \param model the analytic model to tabulate
+   *
+   * Tables built for a previous model are dropped.
+   */
+  void SetModel (Ptr<ErrorRateModel> model);
+  /**
+   * \return the analytic model which is tabulated
+   */
+  Ptr<ErrorRateModel> GetModel (void) const;
+
+  virtual double GetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint32_t nbits) const;
+
+  /**
+   * \param mode the WifiMode
+   * \param txVector the TXVECTOR used to build the table if needed
+   * \return the grid step (dB) of the table used for the given mode
+   */
+  double GetTableStepDb (WifiMode mode, WifiTxVector txVector) const;
+  /**
+   * \return the number of calls answered from the tables
+   */
+  uint64_t GetTableLookups (void) const;
+  /**
+   * \return the number of calls forwarded to the wrapped model
+   */
+  uint64_t GetModelLookups (void) const;
+
+
+protected:
+  virtual void DoDispose (void);
+
+
+private:
+  /// SNR-indexed table for a single mode
+  struct Table : public SimpleRefCount<Table>
+  {
+    double minSnrDb;       //!< SNR (dB) of the first sample
+    double stepDb;         //!< grid step (dB)
+    double invStepDb;      //!< 1 / stepDb
+    std::vector<double> y; //!< log (-log (s)) at each grid point
+    std::vector<uint8_t> forward; //!< non-zero for cells forwarded to the wrapped model
+  };
+  /// Tables indexed by WifiMode UID
+  typedef std::map<uint32_t, Ptr<Table> > Tables;
+
+  /**
+   * \param mode the WifiMode
+   * \param txVector the TXVECTOR passed to the wrapped model
+   * \return the table of the given mode, built if needed
+   */
+  Ptr<const Table> GetTable (WifiMode mode, WifiTxVector txVector) const;
+  /**
+   * \param mode the WifiMode
+   * \param txVector the TXVECTOR passed to the wrapped model
+   * \return a table meeting the accuracy bound, or the finest one allowed
+   */
+  Ptr<Table> BuildTable (WifiMode mode, WifiTxVector txVector) const;
+  /**
+   * \param mode the WifiMode
+   * \param txVector the TXVECTOR passed to the wrapped model
+   * \param snrDb the SNR (dB)
+   * \return log (-log (s)) where s is the per-bit success rate of the wrapped model
+   */
+  double Sample (WifiMode mode, WifiTxVector txVector, double snrDb) const;
+  /**
+   * \return the key of the tables shared by instances with the same settings
+   */
+  std::string GetSharingKey (void) const;
+  /**
+   * \return the tables shared between instances, indexed by sharing key
+   *
+   * The registry is never destroyed so that it outlives every instance.
+   */
+  static std::map<std::string, Tables> * GetSharedTables (void);
+
+  Ptr<ErrorRateModel> m_model; //!< the tabulated model
+  double m_minSnrDb;           //!< lower end of the tables (dB)
+  double m_maxSnrDb;           //!< upper end of the tables (dB)
+  double m_stepDb;             //!< initial grid step (dB)
+  double m_minStepDb;          //!< finest grid step (dB)
+  double m_maxError;           //!< bound on the chunk success rate error
+  bool m_shared;               //!< share tables with other instances
+  mutable Tables m_tables;     //!< tables used by this instance
+  mutable uint64_t m_tableLookups; //!< calls answered from the tables
+  mutable uint64_t m_modelLookups; //!< calls forwarded to the wrapped model
+};
+
+} //namespace ns3
+
+#endif /* TABULATED_ERROR_RATE_MODEL_H */
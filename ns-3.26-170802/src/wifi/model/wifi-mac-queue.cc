@@ -66,8 +66,11 @@ WifiMacQueue::GetTypeId (void)
 }
 
 WifiMacQueue::WifiMacQueue ()
-  : m_size (0)
+  : m_frontOrder (-1),
+    m_backOrder (0),
+    m_size (0)
 {
+  m_peeked = m_queue.end ();
 }
 
 WifiMacQueue::~WifiMacQueue ()
@@ -111,38 +114,67 @@ WifiMacQueue::Enqueue (Ptr<const Packet> packet, const WifiMacHeader &hdr)
         }
       else if (m_dropPolicy == DROP_OLDEST)
         {
-          m_queue.pop_front ();
-          m_size--;
+          Erase (m_queue.begin ());
         }
     }
-  Time now = Simulator::Now ();
-  m_queue.push_back (Item (packet, hdr, now));
-  m_size++;
+  Insert (packet, hdr, false);
 }
 
 void
-WifiMacQueue::Cleanup (void)
+WifiMacQueue::Insert (Ptr<const Packet> packet, const WifiMacHeader &hdr, bool front)
 {
-  if (m_queue.empty ())
+  PacketQueueI it = m_queue.insert (front ? m_queue.begin () : m_queue.end (),
+                                    Item (packet, hdr, Simulator::Now ()));
+  // every packet is stamped with the current time, so the packets are
+  // appended to the arrival order even when pushed at the front
+  it->arrival = m_arrivals.insert (m_arrivals.end (), it);
+  it->order = front ? m_frontOrder-- : m_backOrder++;
+  PacketList *fifo = &m_others;
+  if (hdr.IsQosData ())
     {
-      return;
+      it->flow = m_flows.insert (std::make_pair (FlowKey (hdr.GetAddr1 (), hdr.GetQosTid ()), PacketList ())).first;
+      fifo = &it->flow->second;
     }
+  else
+    {
+      it->flow = m_flows.end ();
+    }
+  it->inFlow = fifo->insert (front ? fifo->begin () : fifo->end (), it);
+  m_size++;
+}
 
-  Time now = Simulator::Now ();
-  uint32_t n = 0;
-  for (PacketQueueI i = m_queue.begin (); i != m_queue.end (); )
+void
+WifiMacQueue::Erase (PacketQueueI it)
+{
+  if (it == m_peeked)
     {
-      if (i->tstamp + m_maxDelay > now)
-        {
-          i++;
-        }
-      else
+      m_peeked = m_queue.end ();
+    }
+  m_arrivals.erase (it->arrival);
+  if (it->flow != m_flows.end ())
+    {
+      it->flow->second.erase (it->inFlow);
+      if (it->flow->second.empty ())
         {
-          i = m_queue.erase (i);
-          n++;
+          m_flows.erase (it->flow);
         }
     }
-  m_size -= n;
+  else
+    {
+      m_others.erase (it->inFlow);
+    }
+  m_queue.erase (it);
+  m_size--;
+}
+
+void
+WifiMacQueue::Cleanup (void)
+{
+  Time now = Simulator::Now ();
+  while (!m_arrivals.empty () && m_arrivals.front ()->tstamp + m_maxDelay <= now)
+    {
+      Erase (m_arrivals.front ());
+    }
 }
 
 Ptr<const Packet>
@@ -151,11 +183,10 @@ WifiMacQueue::Dequeue (WifiMacHeader *hdr)
   Cleanup ();
   if (!m_queue.empty ())
     {
-      Item i = m_queue.front ();
-      m_queue.pop_front ();
-      m_size--;
-      *hdr = i.hdr;
-      return i.packet;
+      Ptr<const Packet> packet = m_queue.front ().packet;
+      *hdr = m_queue.front ().hdr;
+      Erase (m_queue.begin ());
+      return packet;
     }
   return 0;
 }
@@ -166,38 +197,45 @@ WifiMacQueue::Peek (WifiMacHeader *hdr)
   Cleanup ();
   if (!m_queue.empty ())
     {
-      Item i = m_queue.front ();
-      *hdr = i.hdr;
-      return i.packet;
+      *hdr = m_queue.front ().hdr;
+      return m_queue.front ().packet;
     }
   return 0;
 }
 
+WifiMacQueue::PacketQueueI
+WifiMacQueue::FindByTidAndAddress (WifiMacHeader::AddressType type, uint8_t tid, Mac48Address addr)
+{
+  if (type == WifiMacHeader::ADDR1)
+    {
+      Flows::const_iterator flow = m_flows.find (FlowKey (addr, tid));
+      return flow != m_flows.end () ? flow->second.front () : m_queue.end ();
+    }
+  for (PacketQueueI it = m_queue.begin (); it != m_queue.end (); ++it)
+    {
+      if (it->hdr.IsQosData ()
+          && GetAddressForPacket (type, it) == addr
+          && it->hdr.GetQosTid () == tid)
+        {
+          return it;
+        }
+    }
+  return m_queue.end ();
+}
+
 Ptr<const Packet>
 WifiMacQueue::DequeueByTidAndAddress (WifiMacHeader *hdr, uint8_t tid,
                                       WifiMacHeader::AddressType type, Mac48Address dest)
 {
   Cleanup ();
-  Ptr<const Packet> packet = 0;
-  if (!m_queue.empty ())
+  PacketQueueI it = FindByTidAndAddress (type, tid, dest);
+  if (it == m_queue.end ())
     {
-      PacketQueueI it;
-      for (it = m_queue.begin (); it != m_queue.end (); ++it)
-        {
-          if (it->hdr.IsQosData ())
-            {
-              if (GetAddressForPacket (type, it) == dest
-                  && it->hdr.GetQosTid () == tid)
-                {
-                  packet = it->packet;
-                  *hdr = it->hdr;
-                  m_queue.erase (it);
-                  m_size--;
-                  break;
-                }
-            }
-        }
+      return 0;
     }
+  Ptr<const Packet> packet = it->packet;
+  *hdr = it->hdr;
+  Erase (it);
   return packet;
 }
 
@@ -206,24 +244,15 @@ WifiMacQueue::PeekByTidAndAddress (WifiMacHeader *hdr, uint8_t tid,
                                    WifiMacHeader::AddressType type, Mac48Address dest, Time *timestamp)
 {
   Cleanup ();
-  if (!m_queue.empty ())
+  PacketQueueI it = FindByTidAndAddress (type, tid, dest);
+  if (it == m_queue.end ())
     {
-      PacketQueueI it;
-      for (it = m_queue.begin (); it != m_queue.end (); ++it)
-        {
-          if (it->hdr.IsQosData ())
-            {
-              if (GetAddressForPacket (type, it) == dest
-                  && it->hdr.GetQosTid () == tid)
-                {
-                  *hdr = it->hdr;
-                  *timestamp = it->tstamp;
-                  return it->packet;
-                }
-            }
-        }
+      return 0;
     }
-  return 0;
+  m_peeked = it;
+  *hdr = it->hdr;
+  *timestamp = it->tstamp;
+  return it->packet;
 }
 
 bool
@@ -244,6 +273,10 @@ void
 WifiMacQueue::Flush (void)
 {
   m_queue.erase (m_queue.begin (), m_queue.end ());
+  m_arrivals.clear ();
+  m_flows.clear ();
+  m_others.clear ();
+  m_peeked = m_queue.end ();
   m_size = 0;
 }
 
@@ -268,13 +301,18 @@ WifiMacQueue::GetAddressForPacket (enum WifiMacHeader::AddressType type, PacketQ
 bool
 WifiMacQueue::Remove (Ptr<const Packet> packet)
 {
+  // the aggregation code removes the packet it has just peeked
+  if (m_peeked != m_queue.end () && m_peeked->packet == packet)
+    {
+      Erase (m_peeked);
+      return true;
+    }
   PacketQueueI it = m_queue.begin ();
   for (; it != m_queue.end (); it++)
     {
       if (it->packet == packet)
         {
-          m_queue.erase (it);
-          m_size--;
+          Erase (it);
           return true;
         }
     }
@@ -289,9 +327,7 @@ WifiMacQueue::PushFront (Ptr<const Packet> packet, const WifiMacHeader &hdr)
     {
       return;
     }
-  Time now = Simulator::Now ();
-  m_queue.push_front (Item (packet, hdr, now));
-  m_size++;
+  Insert (packet, hdr, true);
 }
 
 uint32_t
@@ -299,6 +335,11 @@ WifiMacQueue::GetNPacketsByTidAndAddress (uint8_t tid, WifiMacHeader::AddressTyp
                                           Mac48Address addr)
 {
   Cleanup ();
+  if (type == WifiMacHeader::ADDR1)
+    {
+      Flows::const_iterator flow = m_flows.find (FlowKey (addr, tid));
+      return flow != m_flows.end () ? flow->second.size () : 0;
+    }
   uint32_t nPackets = 0;
   if (!m_queue.empty ())
     {
@@ -317,25 +358,36 @@ WifiMacQueue::GetNPacketsByTidAndAddress (uint8_t tid, WifiMacHeader::AddressTyp
   return nPackets;
 }
 
+WifiMacQueue::PacketQueueI
+WifiMacQueue::FindFirstAvailable (const QosBlockedDestinations *blockedPackets)
+{
+  PacketQueueI first = m_others.empty () ? m_queue.end () : m_others.front ();
+  for (Flows::const_iterator flow = m_flows.begin (); flow != m_flows.end (); flow++)
+    {
+      PacketQueueI head = flow->second.front ();
+      if ((first == m_queue.end () || head->order < first->order)
+          && !blockedPackets->IsBlocked (flow->first.first, flow->first.second))
+        {
+          first = head;
+        }
+    }
+  return first;
+}
+
 Ptr<const Packet>
 WifiMacQueue::DequeueFirstAvailable (WifiMacHeader *hdr, Time &timestamp,
                                      const QosBlockedDestinations *blockedPackets)
 {
   Cleanup ();
-  Ptr<const Packet> packet = 0;
-  for (PacketQueueI it = m_queue.begin (); it != m_queue.end (); it++)
+  PacketQueueI it = FindFirstAvailable (blockedPackets);
+  if (it == m_queue.end ())
     {
-      if (!it->hdr.IsQosData ()
-          || !blockedPackets->IsBlocked (it->hdr.GetAddr1 (), it->hdr.GetQosTid ()))
-        {
-          *hdr = it->hdr;
-          timestamp = it->tstamp;
-          packet = it->packet;
-          m_queue.erase (it);
-          m_size--;
-          return packet;
-        }
+      return 0;
     }
+  Ptr<const Packet> packet = it->packet;
+  *hdr = it->hdr;
+  timestamp = it->tstamp;
+  Erase (it);
   return packet;
 }
 
@@ -344,17 +396,14 @@ WifiMacQueue::PeekFirstAvailable (WifiMacHeader *hdr, Time &timestamp,
                                   const QosBlockedDestinations *blockedPackets)
 {
   Cleanup ();
-  for (PacketQueueI it = m_queue.begin (); it != m_queue.end (); it++)
+  PacketQueueI it = FindFirstAvailable (blockedPackets);
+  if (it == m_queue.end ())
     {
-      if (!it->hdr.IsQosData ()
-          || !blockedPackets->IsBlocked (it->hdr.GetAddr1 (), it->hdr.GetQosTid ()))
-        {
-          *hdr = it->hdr;
-          timestamp = it->tstamp;
-          return it->packet;
-        }
+      return 0;
     }
-  return 0;
+  *hdr = it->hdr;
+  timestamp = it->tstamp;
+  return it->packet;
 }
 
 } //namespace ns3
@@ -24,6 +24,7 @@
 #define WIFI_MAC_QUEUE_H
 
 #include <list>
+#include <map>
 #include <utility>
 #include "ns3/packet.h"
 #include "ns3/nstime.h"
@@ -47,6 +48,16 @@ class QosBlockedDestinations;
  * to verify whether or not it should be dropped. If
  * dot11EDCATableMSDULifetime has elapsed, it is dropped.
  * Otherwise, it is returned to the caller.
+ *
+ * Besides the transmission order, the queue links the QoS data packets
+ * of each (receiver address, TID) pair into a FIFO, so that the lookups
+ * by TID and ADDR1 made when building aggregates do not scan the whole
+ * queue, the other packets into a FIFO of their own, and all the packets
+ * into a list in arrival order, so that the expired packets are found
+ * from the oldest one.  The first available packet is the earliest of
+ * the FIFO heads, skipping the FIFOs blocked by the BlockAckManager, so
+ * that finding it costs the number of FIFOs rather than the number of
+ * packets.
  */
 class WifiMacQueue : public Object
 {
@@ -156,8 +167,9 @@ public:
                                          Time *timestamp);
   /**
    * If exists, removes <i>packet</i> from queue and returns true. Otherwise it
-   * takes no effects and return false. Deletion of the packet is
-   * performed in linear time (O(n)).
+   * takes no effects and return false. Deletion of the packet last returned
+   * by PeekByTidAndAddress is performed in constant time, deletion of
+   * other packets in linear time (O(n)).
    *
    * \param packet the packet to be removed
    *
@@ -230,6 +242,33 @@ protected:
    */
   virtual void Cleanup (void);
 
+  struct Item;
+
+  /**
+   * typedef for packet (struct Item) queue.
+   */
+  typedef std::list<struct Item> PacketQueue;
+  /**
+   * typedef for packet (struct Item) queue reverse iterator.
+   */
+  typedef std::list<struct Item>::reverse_iterator PacketQueueRI;
+  /**
+   * typedef for packet (struct Item) queue iterator.
+   */
+  typedef std::list<struct Item>::iterator PacketQueueI;
+  /**
+   * typedef for a list of packets of the queue, in a given order.
+   */
+  typedef std::list<PacketQueueI> PacketList;
+  /**
+   * typedef for the key of the QoS data packets of a receiver and TID.
+   */
+  typedef std::pair<Mac48Address, uint8_t> FlowKey;
+  /**
+   * typedef for the FIFOs of QoS data packets of each receiver and TID.
+   */
+  typedef std::map<FlowKey, PacketList> Flows;
+
   /**
    * A struct that holds information about a packet for putting
    * in a packet queue.
@@ -249,31 +288,58 @@ protected:
     Ptr<const Packet> packet; //!< Actual packet
     WifiMacHeader hdr;        //!< Wifi MAC header associated with the packet
     Time tstamp;              //!< timestamp when the packet arrived at the queue
+    int64_t order;                  //!< increasing along the queue, to compare FIFO heads
+    PacketList::iterator arrival;   //!< position of the packet in m_arrivals
+    Flows::iterator flow;           //!< FIFO of the packet, if it is a QoS data packet
+    PacketList::iterator inFlow;    //!< position of the packet in its FIFO, or in m_others
   };
-
   /**
-   * typedef for packet (struct Item) queue.
+   * Return the appropriate address for the given packet (given by PacketQueue iterator).
+   *
+   * \param type
+   * \param it
+   *
+   * \return the address
    */
-  typedef std::list<struct Item> PacketQueue;
+  Mac48Address GetAddressForPacket (enum WifiMacHeader::AddressType type, PacketQueueI it);
   /**
-   * typedef for packet (struct Item) queue reverse iterator.
+   * Insert a packet in the queue, in arrival order and in its FIFO.
+   *
+   * \param packet the packet
+   * \param hdr the header of the packet
+   * \param front whether the packet is inserted at the front of the
+   *        queue rather than at its end
    */
-  typedef std::list<struct Item>::reverse_iterator PacketQueueRI;
+  void Insert (Ptr<const Packet> packet, const WifiMacHeader &hdr, bool front);
   /**
-   * typedef for packet (struct Item) queue iterator.
+   * Remove a packet from the queue, from the arrival order and from its FIFO.
+   *
+   * \param it the packet
    */
-  typedef std::list<struct Item>::iterator PacketQueueI;
+  void Erase (PacketQueueI it);
   /**
-   * Return the appropriate address for the given packet (given by PacketQueue iterator).
+   * \param type the given address type
+   * \param tid the given TID
+   * \param addr the given address
    *
-   * \param type
-   * \param it
+   * \return the first QoS data packet with the TID and address, or m_queue.end ()
+   */
+  PacketQueueI FindByTidAndAddress (WifiMacHeader::AddressType type, uint8_t tid, Mac48Address addr);
+  /**
+   * \param blockedPackets the (ADDR1, TID) pairs whose QoS data packets
+   *        must not be transmitted
    *
-   * \return the address
+   * \return the first packet which is not blocked, or m_queue.end ()
    */
-  Mac48Address GetAddressForPacket (enum WifiMacHeader::AddressType type, PacketQueueI it);
+  PacketQueueI FindFirstAvailable (const QosBlockedDestinations *blockedPackets);
 
   PacketQueue m_queue; //!< Packet (struct Item) queue
+  PacketList m_arrivals; //!< All the packets, oldest first
+  Flows m_flows;       //!< QoS data packets of each (ADDR1, TID), in queue order
+  PacketList m_others; //!< Packets other than QoS data, in queue order
+  int64_t m_frontOrder; //!< Item::order of the next packet pushed at the front
+  int64_t m_backOrder;  //!< Item::order of the next packet enqueued at the end
+  PacketQueueI m_peeked; //!< last packet returned by PeekByTidAndAddress, or m_queue.end ()
   uint32_t m_size;     //!< Current queue size
   uint32_t m_maxSize;  //!< Queue capacity
   Time m_maxDelay;     //!< Time to live for packets in the queue
@@ -336,6 +336,11 @@ WifiPhy::GetTypeId (void)
                      "in monitor mode to sniff all frames being transmitted",
                      MakeTraceSourceAccessor (&WifiPhy::m_phyMonitorSniffTxTrace),
                      "ns3::WifiPhy::MonitorSnifferTxTracedCallback")
+    .AddTraceSource ("ChannelChange",
+                     "Trace source indicating that the channel number, "
+                     "the center frequency or the channel width has changed",
+                     MakeTraceSourceAccessor (&WifiPhy::m_channelChangeTrace),
+                     "ns3::WifiPhy::ChannelChangeTracedCallback")
   ;
   return tid;
 }
@@ -1103,6 +1108,7 @@ WifiPhy::SetFrequency (uint32_t frequency)
       NS_LOG_DEBUG ("Setting frequency and channel number to zero");
       m_channelCenterFrequency = 0;
       m_channelNumber = 0;
+      NotifyChannelChange ();
       return;
     }
   // If the user has configured both Frequency and ChannelNumber, Frequency
@@ -1117,6 +1123,7 @@ WifiPhy::SetFrequency (uint32_t frequency)
           NS_LOG_DEBUG ("Channel frequency switched to " << frequency << "; channel number to " << nch);
           m_channelCenterFrequency = frequency;
           m_channelNumber = nch;
+          NotifyChannelChange ();
         }
       else
         {
@@ -1131,6 +1138,7 @@ WifiPhy::SetFrequency (uint32_t frequency)
           NS_LOG_DEBUG ("Channel frequency switched to " << frequency << "; channel number to " << 0);
           m_channelCenterFrequency = frequency;
           m_channelNumber = 0;
+          NotifyChannelChange ();
         }
       else
         {
@@ -1151,6 +1159,7 @@ WifiPhy::SetChannelWidth (uint32_t channelwidth)
   NS_ASSERT_MSG (channelwidth == 5 || channelwidth == 10 || channelwidth == 20 || channelwidth == 22 || channelwidth == 40 || channelwidth == 80 || channelwidth == 160, "wrong channel width value");
   m_channelWidth = channelwidth;
   AddSupportedChannelWidth (channelwidth);
+  NotifyChannelChange ();
 }
 
 uint32_t
@@ -1294,6 +1303,7 @@ WifiPhy::SetChannelNumber (uint16_t nch)
       // called by the client
       NS_LOG_DEBUG ("Setting channel number to zero");
       m_channelNumber = 0;
+      NotifyChannelChange ();
       return;
     }
 
@@ -1312,6 +1322,7 @@ WifiPhy::SetChannelNumber (uint16_t nch)
           m_channelCenterFrequency = f.first;
           SetChannelWidth (f.second);
           m_channelNumber = nch;
+          NotifyChannelChange ();
         }
       else
         {
@@ -1331,6 +1342,12 @@ WifiPhy::GetChannelNumber (void) const
   return m_channelNumber;
 }
 
+void
+WifiPhy::NotifyChannelChange (void)
+{
+  m_channelChangeTrace (m_channelNumber, m_channelCenterFrequency, m_channelWidth);
+}
+
 bool
 WifiPhy::DoChannelSwitch (uint16_t nch)
 {
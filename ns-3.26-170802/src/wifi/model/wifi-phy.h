@@ -204,7 +204,7 @@ public:
    * arg1: packet received unsuccessfully
    * arg2: snr of packet
    */
-  typedef Callback<void, Ptr<Packet>, double> RxErrorCallback;
+  typedef Callback<void, Ptr<const Packet>, double> RxErrorCallback;
 
   static TypeId GetTypeId (void);
 
@@ -1237,6 +1237,16 @@ public:
                                             uint16_t channelNumber, uint32_t rate, WifiPreamble preamble,
                                             WifiTxVector txVector, struct mpduInfo aMpdu);
 
+  /**
+   * TracedCallback signature for operating channel changes.
+   *
+   * \param channelNumber the new channel number
+   * \param frequency the new center frequency (MHz)
+   * \param channelWidth the new channel width (MHz)
+   */
+  typedef void (* ChannelChangeTracedCallback)(uint16_t channelNumber, uint32_t frequency,
+                                               uint32_t channelWidth);
+
   /**
    * Assign a fixed random variable stream number to the random variables
    * used by this model. Return the number of streams (possibly zero) that
@@ -1604,6 +1614,11 @@ private:
    * DoInitialize () is called.  
    */
   void InitializeFrequencyChannelNumber (void);
+  /**
+   * Fire the ChannelChange trace source with the current operating
+   * channel of the PHY.
+   */
+  void NotifyChannelChange (void);
   /**
    * Configure WifiPhy with appropriate channel frequency and
    * supported rates for 802.11a standard.
@@ -1754,6 +1769,14 @@ private:
    */
   TracedCallback<Ptr<const Packet>, uint16_t, uint16_t, uint32_t,
                  WifiPreamble, WifiTxVector, struct mpduInfo> m_phyMonitorSniffTxTrace;
+
+  /**
+   * A trace source fired whenever the channel number, the center
+   * frequency or the channel width of the PHY changes.
+   *
+   * \see class CallBackTraceSource
+   */
+  TracedCallback<uint16_t, uint32_t, uint32_t> m_channelChangeTrace;
     
   /**
    * This vector holds the set of transmission modes that this
@@ -19,6 +19,7 @@
  */
 
 #include <iostream>
+#include <algorithm>
 #include "wifi-remote-station-manager.h"
 #include "ns3/simulator.h"
 #include "ns3/assert.h"
@@ -277,6 +278,112 @@ namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED (WifiRemoteStationManager);
 
+/**
+ * \param address a MAC address
+ * \return the 48 bits of the address
+ */
+static uint64_t
+AddressKey (Mac48Address address)
+{
+  uint8_t buffer[6];
+  address.CopyTo (buffer);
+  uint64_t key = 0;
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      key = (key << 8) | buffer[i];
+    }
+  return key;
+}
+
+/**
+ * \param state a remote station state
+ * \return the key of the state in the state index
+ */
+static uint64_t
+IndexKey (const WifiRemoteStationState *state)
+{
+  return AddressKey (state->m_address);
+}
+
+/**
+ * \param station a remote station
+ * \return the key of the station in the station index
+ */
+static uint64_t
+IndexKey (const WifiRemoteStation *station)
+{
+  return AddressKey (station->m_state->m_address) | (static_cast<uint64_t> (station->m_tid) << 48);
+}
+
+/**
+ * \param key the key of an entry
+ * \param size the number of slots of the index, a power of two
+ * \return the first slot probed for the key
+ */
+static uint32_t
+IndexSlot (uint64_t key, uint32_t size)
+{
+  // Fibonacci hashing spreads the consecutive addresses of the helpers
+  return static_cast<uint32_t> ((key * 0x9e3779b97f4a7c15ULL) >> 32) & (size - 1);
+}
+
+/**
+ * \param index an open addressing hash index
+ * \param key the key of the entry
+ * \return the entry with the key, or 0
+ */
+template <typename T>
+static T *
+IndexFind (const std::vector<T *> &index, uint64_t key)
+{
+  if (index.empty ())
+    {
+      return 0;
+    }
+  uint32_t size = index.size ();
+  for (uint32_t slot = IndexSlot (key, size); index[slot] != 0; slot = (slot + 1) & (size - 1))
+    {
+      if (IndexKey (index[slot]) == key)
+        {
+          return index[slot];
+        }
+    }
+  return 0;
+}
+
+/**
+ * Insert an entry which is not in the index yet.  The index is rebuilt
+ * twice as large when it would become more than half full.
+ *
+ * \param index an open addressing hash index
+ * \param entry the entry to insert
+ * \param count the number of entries already in the index
+ */
+template <typename T>
+static void
+IndexInsert (std::vector<T *> &index, T *entry, uint32_t count)
+{
+  if (2 * (count + 1) > index.size ())
+    {
+      std::vector<T *> old (std::max<size_t> (16, 2 * index.size ()), 0);
+      old.swap (index);
+      for (typename std::vector<T *>::const_iterator i = old.begin (); i != old.end (); i++)
+        {
+          if (*i != 0)
+            {
+              IndexInsert (index, *i, 0);
+            }
+        }
+    }
+  uint32_t size = index.size ();
+  uint32_t slot = IndexSlot (IndexKey (entry), size);
+  while (index[slot] != 0)
+    {
+      slot = (slot + 1) & (size - 1);
+    }
+  index[slot] = entry;
+}
+
 TypeId
 WifiRemoteStationManager::GetTypeId (void)
 {
@@ -378,11 +485,13 @@ WifiRemoteStationManager::DoDispose (void)
       delete (*i);
     }
   m_states.clear ();
+  m_stateIndex.clear ();
   for (Stations::const_iterator i = m_stations.begin (); i != m_stations.end (); i++)
     {
       delete (*i);
     }
   m_stations.clear ();
+  m_stationIndex.clear ();
 }
 
 void
@@ -1448,15 +1557,13 @@ WifiRemoteStationState *
 WifiRemoteStationManager::LookupState (Mac48Address address) const
 {
   NS_LOG_FUNCTION (this << address);
-  for (StationStates::const_iterator i = m_states.begin (); i != m_states.end (); i++)
+  WifiRemoteStationState *state = IndexFind (m_stateIndex, AddressKey (address));
+  if (state != 0)
     {
-      if ((*i)->m_address == address)
-        {
-          NS_LOG_DEBUG ("WifiRemoteStationManager::LookupState returning existing state");
-          return (*i);
-        }
+      NS_LOG_DEBUG ("WifiRemoteStationManager::LookupState returning existing state");
+      return state;
     }
-  WifiRemoteStationState *state = new WifiRemoteStationState ();
+  state = new WifiRemoteStationState ();
   state->m_state = WifiRemoteStationState::BRAND_NEW;
   state->m_address = address;
   state->m_operationalRateSet.push_back (GetDefaultMode ());
@@ -1470,7 +1577,9 @@ WifiRemoteStationManager::LookupState (Mac48Address address) const
   state->m_stbc = false;
   state->m_htSupported = false;
   state->m_vhtSupported = false;
-  const_cast<WifiRemoteStationManager *> (this)->m_states.push_back (state);
+  WifiRemoteStationManager *self = const_cast<WifiRemoteStationManager *> (this);
+  IndexInsert (self->m_stateIndex, state, m_states.size ());
+  self->m_states.push_back (state);
   NS_LOG_DEBUG ("WifiRemoteStationManager::LookupState returning new state");
   return state;
 }
@@ -1494,22 +1603,21 @@ WifiRemoteStation *
 WifiRemoteStationManager::Lookup (Mac48Address address, uint8_t tid) const
 {
   NS_LOG_FUNCTION (this << address << (uint16_t)tid);
-  for (Stations::const_iterator i = m_stations.begin (); i != m_stations.end (); i++)
+  WifiRemoteStation *station = IndexFind (m_stationIndex, AddressKey (address) | (static_cast<uint64_t> (tid) << 48));
+  if (station != 0)
     {
-      if ((*i)->m_tid == tid
-          && (*i)->m_state->m_address == address)
-        {
-          return (*i);
-        }
+      return station;
     }
   WifiRemoteStationState *state = LookupState (address);
 
-  WifiRemoteStation *station = DoCreateStation ();
+  station = DoCreateStation ();
   station->m_state = state;
   station->m_tid = tid;
   station->m_ssrc = 0;
   station->m_slrc = 0;
-  const_cast<WifiRemoteStationManager *> (this)->m_stations.push_back (station);
+  WifiRemoteStationManager *self = const_cast<WifiRemoteStationManager *> (this);
+  IndexInsert (self->m_stationIndex, station, m_stations.size ());
+  self->m_stations.push_back (station);
   return station;
 }
 
@@ -1585,6 +1693,7 @@ WifiRemoteStationManager::Reset (void)
       delete (*i);
     }
   m_stations.clear ();
+  m_stationIndex.clear ();
   m_bssBasicRateSet.clear ();
   m_bssBasicRateSet.push_back (m_defaultTxMode);
   m_bssBasicMcsSet.clear ();
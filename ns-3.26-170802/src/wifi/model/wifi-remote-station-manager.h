@@ -1217,6 +1217,18 @@ private:
 
   StationStates m_states;  //!< States of known stations
   Stations m_stations;     //!< Information for each known stations
+  /**
+   * Hash index of m_states, keyed on the station address.  The index uses
+   * open addressing with linear probing; empty slots are null.  It only
+   * refers to the states owned by m_states, so the pointers handed out by
+   * LookupState stay valid when the index grows.
+   */
+  StationStates m_stateIndex;
+  /**
+   * Hash index of m_stations, keyed on the station address and TID; see
+   * m_stateIndex.
+   */
+  Stations m_stationIndex;
 
   WifiMode m_defaultTxMode; //!< The default transmission mode
   WifiMode m_defaultTxMcs;   //!< The default transmission modulation-coding scheme (MCS)
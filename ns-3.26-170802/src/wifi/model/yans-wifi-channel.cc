@@ -24,11 +24,23 @@
 #include "ns3/net-device.h"
 #include "ns3/node.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
 #include "ns3/pointer.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
 #include "ns3/object-factory.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/core-config.h"
 #include "yans-wifi-channel.h"
 #include "ns3/propagation-loss-model.h"
 #include "ns3/propagation-delay-model.h"
+#include "ns3/cached-propagation-loss-model.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/multithreaded-simulator-impl.h"
+#endif
+#include <algorithm>
+#include <cmath>
 
 namespace ns3 {
 
@@ -51,20 +63,76 @@ YansWifiChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&YansWifiChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("SpatialIndexCutoff",
+                   "How receivers far away from the sender are culled. "
+                   "With None, every PHY attached to the channel is evaluated for every transmission. "
+                   "With Range, the PHYs farther than SpatialIndexRange are skipped. "
+                   "With RxPower, the cutoff range is derived from the propagation loss model "
+                   "as the distance at which the received power falls below SpatialIndexMinRxPower; "
+                   "this assumes a deterministic loss model that increases with distance, "
+                   "and the stochastic models of the propagation module are rejected.",
+                   EnumValue (YansWifiChannel::CUTOFF_NONE),
+                   MakeEnumAccessor (&YansWifiChannel::m_cutoff),
+                   MakeEnumChecker (YansWifiChannel::CUTOFF_NONE, "None",
+                                    YansWifiChannel::CUTOFF_RANGE, "Range",
+                                    YansWifiChannel::CUTOFF_RX_POWER, "RxPower"))
+    .AddAttribute ("SpatialIndexRange",
+                   "The distance (m) beyond which receivers are culled, when SpatialIndexCutoff is Range.",
+                   DoubleValue (1000.0),
+                   MakeDoubleAccessor (&YansWifiChannel::m_cutoffRange),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("SpatialIndexMinRxPower",
+                   "The received power (dBm) below which receivers are culled, when SpatialIndexCutoff is RxPower.",
+                   DoubleValue (-110.0),
+                   MakeDoubleAccessor (&YansWifiChannel::m_cutoffRxPowerDbm),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("MinimumDistance",
+                   "The distance (m) the nodes never come closer than, from which the "
+                   "MinimumDelay is derived.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&YansWifiChannel::m_minimumDistance),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("MinimumDelay",
+                   "The propagation delay over MinimumDistance, or zero if the propagation "
+                   "delay model is not a ConstantSpeedPropagationDelayModel: the Lookahead "
+                   "of the MultithreadedSimulatorImpl.",
+                   TypeId::ATTR_GET,
+                   TimeValue (Seconds (0)), //this value is ignored because there is no setter
+                   MakeTimeAccessor (&YansWifiChannel::GetMinimumDelay),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
 
 YansWifiChannel::YansWifiChannel ()
+  : m_bucketsBuilt (false),
+    m_indexBuilt (false),
+    m_cellSize (0.0),
+    m_preparePending (false),
+    m_partitioned (false)
 {
 }
 
 YansWifiChannel::~YansWifiChannel ()
 {
   NS_LOG_FUNCTION_NOARGS ();
+  ClearSpatialIndex ();
+  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+    {
+      (*i)->TraceDisconnectWithoutContext ("ChannelChange", MakeCallback (&YansWifiChannel::NotifyChannelChange, this));
+    }
   m_phyList.clear ();
 }
 
+void
+YansWifiChannel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  ClearSpatialIndex ();
+  m_proxies.clear ();
+  WifiChannel::DoDispose ();
+}
+
 void
 YansWifiChannel::SetPropagationLossModel (Ptr<PropagationLossModel> loss)
 {
@@ -83,50 +151,431 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
 {
   Ptr<MobilityModel> senderMobility = sender->GetMobility ()->GetObject<MobilityModel> ();
   NS_ASSERT (senderMobility != 0);
-  uint32_t j = 0;
-  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++, j++)
+
+  //All the receivers share a single immutable copy of the frame; a
+  //receiver only makes its own copy if it successfully decodes it.
+  Ptr<const Packet> frame = packet->Copy ();
+
+  struct Parameters parameters;
+  parameters.rxPowerDbm = 0;
+  parameters.type = mpdutype;
+  parameters.duration = duration;
+  parameters.txVector = txVector;
+  parameters.preamble = preamble;
+
+#ifdef HAVE_PTHREAD_H
+  if (m_partitioned)
     {
-      if (sender != (*i))
+      uint32_t current = MultithreadedSimulatorImpl::GetThreadPartition ();
+      double range = m_cutoff == CUTOFF_NONE ? 0 : GetCutoffRange (txPowerDbm);
+      struct RemoteTransmission remote;
+      remote.channelNumber = sender->GetChannelNumber ();
+      remote.senderPosition = senderMobility->GetPosition ();
+      remote.txPowerDbm = txPowerDbm;
+      for (uint32_t p = 0; p < m_partitionPhys.size (); p++)
         {
-          //For now don't account for inter channel interference
-          if ((*i)->GetChannelNumber () != sender->GetChannelNumber ())
+          const std::vector<uint32_t> &phys = m_partitionPhys[p];
+          if (phys.empty ())
             {
               continue;
             }
+          if (current != MultithreadedSimulatorImpl::NO_PARTITION && p != current)
+            {
+              //The PHYs of another partition are only reached by its
+              //thread, with a copy of the frame of its own.
+              remote.partition = p;
+              Simulator::ScheduleWithContext (m_contexts[phys.front ()], m_minDelay,
+                                              &YansWifiChannel::ReceiveRemote, this,
+                                              frame->DeepCopy (), parameters, remote);
+              continue;
+            }
+          for (std::vector<uint32_t>::const_iterator i = phys.begin (); i != phys.end (); i++)
+            {
+              const Ptr<YansWifiPhy> &phy = m_phyList[*i];
+              if (phy == sender || phy->GetChannelNumber () != remote.channelNumber)
+                {
+                  continue;
+                }
+              if (m_cutoff != CUTOFF_NONE
+                  && senderMobility->GetDistanceFrom (phy->GetMobility ()->GetObject<MobilityModel> ()) > range)
+                {
+                  continue;
+                }
+              SendTo (*i, senderMobility, frame, txPowerDbm, parameters, Seconds (0));
+            }
+        }
+      return;
+    }
+#endif
 
-          Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->GetObject<MobilityModel> ();
-          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
-          double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
-          NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
-                        "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
-          Ptr<Packet> copy = packet->Copy ();
-          Ptr<Object> dstNetDevice = m_phyList[j]->GetDevice ();
-          uint32_t dstNode;
-          if (dstNetDevice == 0)
+  if (m_cutoff == CUTOFF_NONE)
+    {
+      //For now don't account for inter channel interference
+      if (!m_bucketsBuilt)
+        {
+          BuildChannelBuckets ();
+        }
+      ChannelBuckets::const_iterator bucket = m_channelBuckets.find (sender->GetChannelNumber ());
+      if (bucket == m_channelBuckets.end ())
+        {
+          return;
+        }
+      for (std::vector<uint32_t>::const_iterator i = bucket->second.begin (); i != bucket->second.end (); i++)
+        {
+          if (sender != m_phyList[*i])
             {
-              dstNode = 0xffffffff;
+              SendTo (*i, senderMobility, frame, txPowerDbm, parameters, Seconds (0));
             }
-          else
+        }
+      return;
+    }
+
+  double range = GetCutoffRange (txPowerDbm);
+  if (!m_indexBuilt)
+    {
+      BuildSpatialIndex (range);
+    }
+
+  //Collect the PHYs of the cells overlapping the disc of radius range
+  //around the sender, plus the PHYs which are kept outside of the grid.
+  Vector senderPosition = senderMobility->GetPosition ();
+  CellId center = GetCellId (senderPosition);
+  int32_t rings = static_cast<int32_t> (std::ceil (range / m_cellSize));
+  m_candidates.assign (m_movingPhys.begin (), m_movingPhys.end ());
+  for (int32_t dx = -rings; dx <= rings; dx++)
+    {
+      for (int32_t dy = -rings; dy <= rings; dy++)
+        {
+          CellMap::const_iterator cell = m_cells.find (CellId (center.first + dx, center.second + dy));
+          if (cell != m_cells.end ())
             {
-              dstNode = dstNetDevice->GetObject<NetDevice> ()->GetNode ()->GetId ();
+              m_candidates.insert (m_candidates.end (), cell->second.begin (), cell->second.end ());
             }
+        }
+    }
+  //Schedule the receptions in the same order as without culling
+  std::sort (m_candidates.begin (), m_candidates.end ());
+
+  for (std::vector<uint32_t>::const_iterator i = m_candidates.begin (); i != m_candidates.end (); i++)
+    {
+      Ptr<YansWifiPhy> phy = m_phyList[*i];
+      if (sender == phy || phy->GetChannelNumber () != sender->GetChannelNumber ())
+        {
+          continue;
+        }
+      Ptr<MobilityModel> receiverMobility = phy->GetMobility ()->GetObject<MobilityModel> ();
+      if (senderMobility->GetDistanceFrom (receiverMobility) > range)
+        {
+          continue;
+        }
+      SendTo (*i, senderMobility, frame, txPowerDbm, parameters, Seconds (0));
+    }
+}
+
+void
+YansWifiChannel::SendTo (uint32_t i, Ptr<MobilityModel> senderMobility, Ptr<const Packet> packet,
+                         double txPowerDbm, struct Parameters parameters, Time elapsed) const
+{
+  Ptr<MobilityModel> receiverMobility = m_phyList[i]->GetMobility ()->GetObject<MobilityModel> ();
+  Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
+  NS_ABORT_MSG_IF (delay < elapsed, "YansWifiChannel: PHY " << i << " is closer to the sender than MinimumDistance");
+  double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
+  NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
+                "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
+  Ptr<Object> dstNetDevice = m_phyList[i]->GetDevice ();
+  uint32_t dstNode;
+  if (dstNetDevice == 0)
+    {
+      dstNode = 0xffffffff;
+    }
+  else
+    {
+      dstNode = dstNetDevice->GetObject<NetDevice> ()->GetNode ()->GetId ();
+    }
+
+  parameters.rxPowerDbm = rxPowerDbm;
+
+  Simulator::ScheduleWithContext (dstNode,
+                                  delay - elapsed, &YansWifiChannel::Receive, this,
+                                  i, packet, parameters);
+}
+
+void
+YansWifiChannel::ReceiveRemote (Ptr<const Packet> packet, struct Parameters parameters,
+                                struct RemoteTransmission remote) const
+{
+  //The proxy of the sender belongs to the partition, as the receivers
+  const Ptr<MobilityModel> &senderMobility = m_proxies[remote.partition];
+  senderMobility->SetPosition (remote.senderPosition);
+  double range = m_cutoff == CUTOFF_NONE ? 0 : GetCutoffRange (remote.txPowerDbm);
+  const std::vector<uint32_t> &phys = m_partitionPhys[remote.partition];
+  for (std::vector<uint32_t>::const_iterator i = phys.begin (); i != phys.end (); i++)
+    {
+      const Ptr<YansWifiPhy> &phy = m_phyList[*i];
+      if (phy->GetChannelNumber () != remote.channelNumber)
+        {
+          continue;
+        }
+      if (m_cutoff != CUTOFF_NONE
+          && senderMobility->GetDistanceFrom (phy->GetMobility ()->GetObject<MobilityModel> ()) > range)
+        {
+          continue;
+        }
+      SendTo (*i, senderMobility, packet, remote.txPowerDbm, parameters, m_minDelay);
+    }
+}
+
+void
+YansWifiChannel::Prepare (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_preparePending = false;
+#ifdef HAVE_PTHREAD_H
+  Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  if (impl == 0)
+    {
+      return;
+    }
+  //The models are shared by the threads of the partitions, and the
+  //sender is seen by the other partitions through a proxy.
+  NS_ABORT_MSG_IF (IsStochastic (m_loss),
+                   "YansWifiChannel: the MultithreadedSimulatorImpl needs a deterministic propagation loss model");
+  for (Ptr<PropagationLossModel> loss = m_loss; loss != 0; loss = loss->GetNext ())
+    {
+      NS_ABORT_MSG_IF (DynamicCast<CachedPropagationLossModel> (loss) != 0
+                       || DynamicCast<MatrixPropagationLossModel> (loss) != 0,
+                       "YansWifiChannel: the MultithreadedSimulatorImpl does not support the "
+                       << loss->GetInstanceTypeId ().GetName ());
+    }
+  NS_ABORT_MSG_IF (DynamicCast<ConstantSpeedPropagationDelayModel> (m_delay) == 0,
+                   "YansWifiChannel: the MultithreadedSimulatorImpl needs a ConstantSpeedPropagationDelayModel");
+
+  uint32_t count = impl->GetPartitionCount ();
+  m_contexts.clear ();
+  m_partitionPhys.assign (count + 1, std::vector<uint32_t> ());
+  m_proxies.clear ();
+  for (uint32_t i = 0; i < m_phyList.size (); i++)
+    {
+      Ptr<Object> device = m_phyList[i]->GetDevice ();
+      uint32_t context = device == 0 ? Simulator::NO_CONTEXT : device->GetObject<NetDevice> ()->GetNode ()->GetId ();
+      uint32_t partition = impl->GetPartitionIndex (context);
+      m_partitionPhys[partition == MultithreadedSimulatorImpl::NO_PARTITION ? count : partition].push_back (i);
+      m_contexts.push_back (context);
+    }
+  for (uint32_t p = 0; p <= count; p++)
+    {
+      m_proxies.push_back (CreateObject<ConstantPositionMobilityModel> ());
+    }
+  m_minDelay = GetMinimumDelay ();
+  m_partitioned = true;
+#endif
+}
+
+Time
+YansWifiChannel::GetMinimumDelay (void) const
+{
+  if (DynamicCast<ConstantSpeedPropagationDelayModel> (m_delay) == 0)
+    {
+      return Seconds (0);
+    }
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<MobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  b->SetPosition (Vector (m_minimumDistance, 0.0, 0.0));
+  return m_delay->GetDelay (a, b);
+}
+
+void
+YansWifiChannel::NotifyChannelChange (uint16_t channelNumber, uint32_t frequency, uint32_t channelWidth)
+{
+  NS_LOG_FUNCTION (this << channelNumber << frequency << channelWidth);
+  if (m_partitioned)
+    {
+      return;
+    }
+  //The buckets are rebuilt at the next transmission
+  m_bucketsBuilt = false;
+}
+
+void
+YansWifiChannel::BuildChannelBuckets (void) const
+{
+  NS_LOG_FUNCTION (this);
+  m_channelBuckets.clear ();
+  for (uint32_t i = 0; i < m_phyList.size (); i++)
+    {
+      m_channelBuckets[m_phyList[i]->GetChannelNumber ()].push_back (i);
+    }
+  m_bucketsBuilt = true;
+}
+
+/**
+ * Move a probe of the cutoff range search at the given abscissa.
+ * SetPosition clears the velocity, which is restored.
+ *
+ * \param probe the mobility model of the probe
+ * \param x the abscissa of the probe
+ */
+static void
+PlaceProbe (Ptr<ConstantVelocityMobilityModel> probe, double x)
+{
+  probe->SetPosition (Vector (x, 0.0, 0.0));
+  probe->SetVelocity (Vector (1.0, 0.0, 0.0));
+}
+
+bool
+YansWifiChannel::IsStochastic (Ptr<PropagationLossModel> loss)
+{
+  return loss != 0 && !loss->IsDeterministic ();
+}
+
+double
+YansWifiChannel::GetCutoffRange (double txPowerDbm) const
+{
+  if (m_cutoff == CUTOFF_RANGE)
+    {
+      return m_cutoffRange;
+    }
+  NS_ASSERT (m_cutoff == CUTOFF_RX_POWER);
+  std::lock_guard<std::mutex> lock (m_mutex);
+  std::map<double, double>::const_iterator it = m_cutoffRanges.find (txPowerDbm);
+  if (it != m_cutoffRanges.end ())
+    {
+      return it->second;
+    }
 
-          struct Parameters parameters;
-          parameters.rxPowerDbm = rxPowerDbm;
-          parameters.type = mpdutype;
-          parameters.duration = duration;
-          parameters.txVector = txVector;
-          parameters.preamble = preamble;
+  //Evaluating a stochastic model here would consume random draws, and
+  //change the results of the simulation.
+  NS_ABORT_MSG_IF (IsStochastic (m_loss),
+                   "YansWifiChannel: SpatialIndexCutoff=RxPower needs a deterministic propagation loss model; "
+                   "use SpatialIndexCutoff=Range with stochastic models");
 
-          Simulator::ScheduleWithContext (dstNode,
-                                          delay, &YansWifiChannel::Receive, this,
-                                          j, copy, parameters);
+  //Search the largest distance at which the received power is still
+  //above the threshold: grow the distance exponentially until the power
+  //falls below the threshold, then bisect.  The probes are given a
+  //velocity so that a CachedPropagationLossModel does not store them.
+  Ptr<ConstantVelocityMobilityModel> a = CreateObject<ConstantVelocityMobilityModel> ();
+  Ptr<ConstantVelocityMobilityModel> b = CreateObject<ConstantVelocityMobilityModel> ();
+  PlaceProbe (a, 0.0);
+  double low = 0.0;
+  double high = 1.0;
+  const double maxRange = 1e8;
+  PlaceProbe (b, high);
+  while (high < maxRange && m_loss->CalcRxPower (txPowerDbm, a, b) >= m_cutoffRxPowerDbm)
+    {
+      low = high;
+      high *= 2;
+      PlaceProbe (b, high);
+    }
+  for (uint32_t k = 0; k < 64 && high - low > 1e-3; k++)
+    {
+      double middle = (low + high) / 2;
+      PlaceProbe (b, middle);
+      if (m_loss->CalcRxPower (txPowerDbm, a, b) >= m_cutoffRxPowerDbm)
+        {
+          low = middle;
+        }
+      else
+        {
+          high = middle;
         }
     }
+  NS_LOG_DEBUG ("cutoff range for txPower=" << txPowerDbm << "dbm is " << high << "m");
+  m_cutoffRanges[txPowerDbm] = high;
+  return high;
+}
+
+YansWifiChannel::CellId
+YansWifiChannel::GetCellId (const Vector &position) const
+{
+  return CellId (static_cast<int32_t> (std::floor (position.x / m_cellSize)),
+                 static_cast<int32_t> (std::floor (position.y / m_cellSize)));
 }
 
 void
-YansWifiChannel::Receive (uint32_t i, Ptr<Packet> packet, struct Parameters parameters) const
+YansWifiChannel::BuildSpatialIndex (double cellSize) const
+{
+  NS_LOG_FUNCTION (this << cellSize);
+  ClearSpatialIndex ();
+  m_cellSize = std::max (cellSize, 1.0);
+  m_phyCells.assign (m_phyList.size (), CellId (0, 0));
+  m_phyMoving.assign (m_phyList.size (), true);
+  for (uint32_t i = 0; i < m_phyList.size (); i++)
+    {
+      Ptr<MobilityModel> mobility = m_phyList[i]->GetMobility ()->GetObject<MobilityModel> ();
+      NS_ASSERT (mobility != 0);
+      MobilityPhyMap::iterator it = m_mobilityPhys.find (mobility);
+      if (it == m_mobilityPhys.end ())
+        {
+          mobility->TraceConnectWithoutContext ("CourseChange", MakeCallback (&YansWifiChannel::NotifyCourseChange, this));
+          it = m_mobilityPhys.insert (std::make_pair (mobility, std::vector<uint32_t> ())).first;
+        }
+      it->second.push_back (i);
+      m_movingPhys.push_back (i);
+      UpdateSpatialIndex (i, mobility);
+    }
+  m_indexBuilt = true;
+}
+
+void
+YansWifiChannel::UpdateSpatialIndex (uint32_t i, Ptr<const MobilityModel> mobility) const
+{
+  if (m_phyMoving[i])
+    {
+      m_movingPhys.erase (std::find (m_movingPhys.begin (), m_movingPhys.end (), i));
+    }
+  else
+    {
+      std::vector<uint32_t> &phys = m_cells[m_phyCells[i]];
+      phys.erase (std::find (phys.begin (), phys.end (), i));
+    }
+
+  //A PHY with a non-zero velocity keeps moving without notifying its
+  //course changes, so it cannot be kept in a grid cell.
+  Vector velocity = mobility->GetVelocity ();
+  m_phyMoving[i] = velocity.x != 0 || velocity.y != 0 || velocity.z != 0;
+  if (m_phyMoving[i])
+    {
+      m_movingPhys.push_back (i);
+    }
+  else
+    {
+      m_phyCells[i] = GetCellId (mobility->GetPosition ());
+      m_cells[m_phyCells[i]].push_back (i);
+    }
+}
+
+void
+YansWifiChannel::NotifyCourseChange (Ptr<const MobilityModel> mobility) const
+{
+  NS_LOG_FUNCTION (this << mobility);
+  MobilityPhyMap::const_iterator it = m_mobilityPhys.find (ConstCast<MobilityModel> (mobility));
+  if (it == m_mobilityPhys.end ())
+    {
+      return;
+    }
+  for (std::vector<uint32_t>::const_iterator i = it->second.begin (); i != it->second.end (); i++)
+    {
+      UpdateSpatialIndex (*i, mobility);
+    }
+}
+
+void
+YansWifiChannel::ClearSpatialIndex (void) const
+{
+  for (MobilityPhyMap::const_iterator it = m_mobilityPhys.begin (); it != m_mobilityPhys.end (); it++)
+    {
+      it->first->TraceDisconnectWithoutContext ("CourseChange", MakeCallback (&YansWifiChannel::NotifyCourseChange, this));
+    }
+  m_mobilityPhys.clear ();
+  m_cells.clear ();
+  m_phyCells.clear ();
+  m_phyMoving.clear ();
+  m_movingPhys.clear ();
+  m_indexBuilt = false;
+}
+
+void
+YansWifiChannel::Receive (uint32_t i, Ptr<const Packet> packet, struct Parameters parameters) const
 {
   m_phyList[i]->StartReceivePreambleAndHeader (packet, parameters.rxPowerDbm, parameters.txVector, parameters.preamble, parameters.type, parameters.duration);
 }
@@ -147,6 +596,21 @@ void
 YansWifiChannel::Add (Ptr<YansWifiPhy> phy)
 {
   m_phyList.push_back (phy);
+  phy->TraceConnectWithoutContext ("ChannelChange", MakeCallback (&YansWifiChannel::NotifyChannelChange, this));
+  //The buckets and the receiver grid are rebuilt at the next transmission
+  m_bucketsBuilt = false;
+  m_indexBuilt = false;
+#ifdef HAVE_PTHREAD_H
+  NS_ABORT_MSG_IF (MultithreadedSimulatorImpl::GetThreadPartition () != MultithreadedSimulatorImpl::NO_PARTITION,
+                   "YansWifiChannel: PHY added from a partition of the MultithreadedSimulatorImpl");
+  m_partitioned = false;
+  if (!m_preparePending && DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ()) != 0)
+    {
+      m_preparePending = true;
+      Simulator::ScheduleWithContext (Simulator::NO_CONTEXT, Seconds (0),
+                                      &YansWifiChannel::Prepare, Ptr<YansWifiChannel> (this));
+    }
+#endif
 }
 
 int64_t
@@ -22,8 +22,11 @@
 #define YANS_WIFI_CHANNEL_H
 
 #include <vector>
+#include <map>
+#include <mutex>
 #include <stdint.h>
 #include "ns3/packet.h"
+#include "ns3/vector.h"
 #include "wifi-channel.h"
 #include "wifi-mode.h"
 #include "wifi-preamble.h"
@@ -36,6 +39,7 @@ namespace ns3 {
 class NetDevice;
 class PropagationLossModel;
 class PropagationDelayModel;
+class MobilityModel;
 
 struct Parameters
 {
@@ -57,10 +61,50 @@ struct Parameters
  * class and contains a ns3::PropagationLossModel and a ns3::PropagationDelayModel.
  * By default, no propagation models are set so, it is the caller's responsability
  * to set them before using the channel.
+ *
+ * By default, every transmission is evaluated against every PHY attached
+ * to the channel.  Optionally (see the SpatialIndexCutoff attribute), the
+ * channel keeps a uniform grid of receiver positions so that only the PHYs
+ * located within a cutoff range of the sender are evaluated and scheduled.
+ * The cutoff range is either configured directly or derived from the
+ * propagation loss model as the distance beyond which the received power
+ * falls below a threshold.  Receivers beyond the cutoff do not see the
+ * frame at all (not even as interference), so the cutoff should be chosen
+ * well below the energy detection threshold of the PHYs.  The grid is kept
+ * up to date through the CourseChange trace of the mobility models; PHYs
+ * that are moving are kept outside of the grid and always evaluated.
+ *
+ * With the MultithreadedSimulatorImpl, the PHYs are sorted by partition
+ * at the start of the simulation, and the sender only evaluates the PHYs
+ * of its own partition.  Each other partition is sent a copy of the
+ * frame sharing nothing with the sender's (see Packet::DeepCopy), with
+ * the position of the sender, which reaches it after the MinimumDelay;
+ * the partition then evaluates its own PHYs and delays their receptions
+ * by the rest of the propagation delay.  The MinimumDelay, and thus the
+ * Lookahead of the simulator, is the propagation delay over the
+ * MinimumDistance, which the nodes must not come closer than.  The
+ * propagation loss model must only depend on the positions of the nodes,
+ * without a CachedPropagationLossModel or a MatrixPropagationLossModel,
+ * the delay model must be a ConstantSpeedPropagationDelayModel, and the
+ * channel number of a receiver is read when the copy reaches it, rather
+ * than at the start of the transmission.
  */
 class YansWifiChannel : public WifiChannel
 {
 public:
+  /**
+   * Receiver culling modes of the channel.
+   */
+  enum SpatialIndexCutoff
+  {
+    /** All PHYs are evaluated for every transmission */
+    CUTOFF_NONE,
+    /** PHYs farther than SpatialIndexRange are not evaluated */
+    CUTOFF_RANGE,
+    /** PHYs whose distance yields a received power below SpatialIndexMinRxPower are not evaluated */
+    CUTOFF_RX_POWER
+  };
+
   static TypeId GetTypeId (void);
 
   YansWifiChannel ();
@@ -98,7 +142,9 @@ public:
    * This method should not be invoked by normal users. It is
    * currently invoked only from WifiPhy::Send. YansWifiChannel
    * delivers packets only between PHYs with the same m_channelNumber,
-   * e.g. PHYs that are operating on the same channel.
+   * e.g. PHYs that are operating on the same channel. To this end, the
+   * PHYs are kept in per-channel-number buckets, which are updated
+   * through the ChannelChange trace source of the PHYs.
    */
   void Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double txPowerDbm,
              WifiTxVector txVector, WifiPreamble preamble, enum mpduType mpdutype, Time duration) const;
@@ -114,12 +160,139 @@ public:
    */
   int64_t AssignStreams (int64_t stream);
 
+  /**
+   * \param loss the first model of a chain of propagation loss models
+   * \return true if the chain is not deterministic (see
+   * PropagationLossModel::IsDeterministic), and cannot be used with
+   * SpatialIndexCutoff=RxPower
+   */
+  static bool IsStochastic (Ptr<PropagationLossModel> loss);
+
+  /**
+   * \return the propagation delay over MinimumDistance, or zero if the
+   * propagation delay model is not a ConstantSpeedPropagationDelayModel
+   */
+  Time GetMinimumDelay (void) const;
+
+protected:
+  virtual void DoDispose (void);
 
 private:
   /**
    * A vector of pointers to YansWifiPhy.
    */
   typedef std::vector<Ptr<YansWifiPhy> > PhyList;
+  /**
+   * Coordinates of a cell of the receiver grid.
+   */
+  typedef std::pair<int32_t, int32_t> CellId;
+  /**
+   * Indices (in the PHY list) of the static PHYs located in each cell.
+   */
+  typedef std::map<CellId, std::vector<uint32_t> > CellMap;
+  /**
+   * Indices (in the PHY list) of the PHYs sharing a mobility model.
+   */
+  typedef std::map<Ptr<MobilityModel>, std::vector<uint32_t> > MobilityPhyMap;
+  /**
+   * Indices (in the PHY list) of the PHYs operating on each channel number.
+   */
+  typedef std::map<uint16_t, std::vector<uint32_t> > ChannelBuckets;
+
+  /**
+   * What a partition of the MultithreadedSimulatorImpl needs to evaluate
+   * its PHYs for the transmission of another partition.
+   */
+  struct RemoteTransmission
+  {
+    uint32_t partition;      //!< Index of the receiving partition in m_partitionPhys
+    uint16_t channelNumber;  //!< Channel number of the sender
+    Vector senderPosition;   //!< Position of the sender at the start of the transmission
+    double txPowerDbm;       //!< Tx power of the transmission
+  };
+
+  /**
+   * Compute the received power at the given PHY, and schedule the
+   * reception of the packet by this PHY.
+   *
+   * \param i index of the receiving YansWifiPhy in the PHY list
+   * \param senderMobility the mobility model of the sender
+   * \param packet the frame being sent, shared by all the receivers
+   * \param txPowerDbm the tx power associated to the packet
+   * \param parameters the parameters of the transmission (rxPowerDbm is filled in)
+   * \param elapsed the time elapsed since the start of the transmission,
+   * taken off the propagation delay
+   */
+  void SendTo (uint32_t i, Ptr<MobilityModel> senderMobility, Ptr<const Packet> packet,
+               double txPowerDbm, struct Parameters parameters, Time elapsed) const;
+  /**
+   * Sort the PHYs by partition of the MultithreadedSimulatorImpl, if it is
+   * the simulator implementation.  Scheduled without context by Add, to
+   * run before the events of the partitions.
+   */
+  void Prepare (void);
+  /**
+   * Evaluate the PHYs of the partition of the calling thread for the
+   * transmission of another partition.
+   *
+   * \param packet the copy of the frame for this partition
+   * \param parameters the parameters of the transmission
+   * \param remote the sender and the receiving partition
+   */
+  void ReceiveRemote (Ptr<const Packet> packet, struct Parameters parameters,
+                      struct RemoteTransmission remote) const;
+  /**
+   * Callback connected to the ChannelChange trace source of the PHYs.
+   * Without effect once the PHYs are sorted by partition, since the
+   * buckets are then not used.
+   *
+   * \param channelNumber the new channel number of the PHY
+   * \param frequency the new center frequency of the PHY (MHz)
+   * \param channelWidth the new channel width of the PHY (MHz)
+   */
+  void NotifyChannelChange (uint16_t channelNumber, uint32_t frequency, uint32_t channelWidth);
+  /**
+   * Sort the PHYs into per-channel-number buckets.
+   */
+  void BuildChannelBuckets (void) const;
+  /**
+   * \param txPowerDbm the tx power of a transmission
+   * \return the distance beyond which receivers are culled for this tx power
+   *
+   * In CUTOFF_RX_POWER mode, the simulation is aborted if the propagation
+   * loss model is stochastic.
+   */
+  double GetCutoffRange (double txPowerDbm) const;
+  /**
+   * Place every PHY in the receiver grid, and start listening to the
+   * course changes of their mobility models.
+   *
+   * \param cellSize the side of a grid cell in meters
+   */
+  void BuildSpatialIndex (double cellSize) const;
+  /**
+   * Remove the given PHY from the grid (or from the mobile list),
+   * and insert it again according to the current state of its mobility model.
+   *
+   * \param i index of the YansWifiPhy in the PHY list
+   * \param mobility the mobility model of the PHY
+   */
+  void UpdateSpatialIndex (uint32_t i, Ptr<const MobilityModel> mobility) const;
+  /**
+   * Callback connected to the CourseChange trace of the mobility models.
+   *
+   * \param mobility the mobility model whose course changed
+   */
+  void NotifyCourseChange (Ptr<const MobilityModel> mobility) const;
+  /**
+   * Disconnect from the mobility models and drop the receiver grid.
+   */
+  void ClearSpatialIndex (void) const;
+  /**
+   * \param position a position
+   * \return the grid cell containing this position
+   */
+  CellId GetCellId (const Vector &position) const;
 
   /**
    * This method is scheduled by Send for each associated YansWifiPhy.
@@ -127,16 +300,42 @@ private:
    * bit of the packet has arrived.
    *
    * \param i index of the corresponding YansWifiPhy in the PHY list
-   * \param packet the packet being sent
+   * \param packet the frame being sent, shared by all the receivers
    * \param atts a vector containing the received power in dBm and the packet type
    * \param txVector the TXVECTOR of the packet
    * \param preamble the type of preamble being used to send the packet
    */
-  void Receive (uint32_t i, Ptr<Packet> packet, struct Parameters parameters) const;
+  void Receive (uint32_t i, Ptr<const Packet> packet, struct Parameters parameters) const;
 
   PhyList m_phyList;                   //!< List of YansWifiPhys connected to this YansWifiChannel
   Ptr<PropagationLossModel> m_loss;    //!< Propagation loss model
   Ptr<PropagationDelayModel> m_delay;  //!< Propagation delay model
+
+  mutable bool m_bucketsBuilt;             //!< Whether the channel number buckets are up to date
+  mutable ChannelBuckets m_channelBuckets; //!< PHYs per channel number
+
+  enum SpatialIndexCutoff m_cutoff;    //!< Receiver culling mode
+  double m_cutoffRange;                //!< Cutoff range (m) used in CUTOFF_RANGE mode
+  double m_cutoffRxPowerDbm;           //!< Cutoff received power (dBm) used in CUTOFF_RX_POWER mode
+
+  mutable bool m_indexBuilt;                     //!< Whether the receiver grid is up to date
+  mutable double m_cellSize;                     //!< Side of a grid cell (m)
+  mutable CellMap m_cells;                       //!< Static PHYs per grid cell
+  mutable std::vector<CellId> m_phyCells;        //!< Grid cell of each PHY
+  mutable std::vector<bool> m_phyMoving;         //!< Whether each PHY is kept outside of the grid
+  mutable std::vector<uint32_t> m_movingPhys;    //!< PHYs kept outside of the grid, always evaluated
+  mutable MobilityPhyMap m_mobilityPhys;         //!< PHYs attached to each tracked mobility model
+  mutable std::map<double, double> m_cutoffRanges; //!< Cutoff range per tx power in CUTOFF_RX_POWER mode
+  mutable std::vector<uint32_t> m_candidates;    //!< Scratch list of receivers for the current transmission
+  mutable std::mutex m_mutex;                    //!< Protects m_cutoffRanges from the threads of the partitions
+
+  double m_minimumDistance;            //!< Distance (m) the nodes never come closer than
+  bool m_preparePending;               //!< Whether Prepare is scheduled
+  bool m_partitioned;                  //!< Whether the PHYs are sorted by partition
+  Time m_minDelay;                     //!< Propagation delay over m_minimumDistance, while partitioned
+  std::vector<uint32_t> m_contexts;    //!< Context of each PHY, while partitioned
+  std::vector<std::vector<uint32_t> > m_partitionPhys; //!< PHYs of each partition, then of no partition
+  std::vector<Ptr<MobilityModel> > m_proxies; //!< Position of the remote sender in each partition
 };
 
 } //namespace ns3
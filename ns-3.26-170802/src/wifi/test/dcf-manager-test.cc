@@ -42,6 +42,7 @@ private:
   virtual void DoNotifyChannelSwitching (void);
   virtual void DoNotifySleep (void);
   virtual void DoNotifyWakeUp (void);
+  virtual bool DoGetToken (void);
 
   typedef std::pair<uint64_t,uint64_t> ExpectedGrant;
   typedef std::list<ExpectedGrant> ExpectedGrants;
@@ -76,6 +77,7 @@ private:
   void StartTest (uint64_t slotTime, uint64_t sifs, uint64_t eifsNoDifsNoSifs, uint32_t ackTimeoutValue = 20);
   void AddDcfState (uint32_t aifsn);
   void EndTest (void);
+  void ExpectAccessTimeouts (uint64_t scheduled, uint64_t cancelled, uint64_t fired);
   void ExpectInternalCollision (uint64_t time, uint32_t nSlots, uint32_t from);
   void ExpectCollision (uint64_t time, uint32_t nSlots, uint32_t from);
   void AddRxOkEvt (uint64_t at, uint64_t duration);
@@ -106,6 +108,10 @@ private:
   DcfManager *m_dcfManager;
   DcfStates m_dcfStates;
   uint32_t m_ackTimeoutValue;
+  bool m_checkAccessTimeouts;
+  uint64_t m_expectedScheduled;
+  uint64_t m_expectedCancelled;
+  uint64_t m_expectedFired;
 };
 
 DcfStateTest::DcfStateTest (DcfManagerTest *test, uint32_t i)
@@ -160,6 +166,12 @@ DcfStateTest::DoNotifyWakeUp (void)
 {
 }
 
+bool
+DcfStateTest::DoGetToken (void)
+{
+  return false;
+}
+
 DcfManagerTest::DcfManagerTest ()
   : TestCase ("DcfManager")
 {
@@ -256,6 +268,16 @@ DcfManagerTest::StartTest (uint64_t slotTime, uint64_t sifs, uint64_t eifsNoDifs
   m_dcfManager->SetSifs (MicroSeconds (sifs));
   m_dcfManager->SetEifsNoDifs (MicroSeconds (eifsNoDifsNoSifs + sifs));
   m_ackTimeoutValue = ackTimeoutValue;
+  m_checkAccessTimeouts = false;
+}
+
+void
+DcfManagerTest::ExpectAccessTimeouts (uint64_t scheduled, uint64_t cancelled, uint64_t fired)
+{
+  m_checkAccessTimeouts = true;
+  m_expectedScheduled = scheduled;
+  m_expectedCancelled = cancelled;
+  m_expectedFired = fired;
 }
 
 void
@@ -281,6 +303,12 @@ DcfManagerTest::EndTest (void)
       delete state;
     }
   m_dcfStates.clear ();
+  if (m_checkAccessTimeouts)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_dcfManager->GetAccessTimeoutsScheduled (), m_expectedScheduled, "Unexpected number of access timeouts scheduled");
+      NS_TEST_EXPECT_MSG_EQ (m_dcfManager->GetAccessTimeoutsCancelled (), m_expectedCancelled, "Unexpected number of access timeouts cancelled");
+      NS_TEST_EXPECT_MSG_EQ (m_dcfManager->GetAccessTimeoutsFired (), m_expectedFired, "Unexpected number of access timeouts fired");
+    }
   delete m_dcfManager;
 }
 
@@ -447,6 +475,10 @@ DcfManagerTest::DoRun (void)
   AddRxOkEvt (80, 20);
   AddAccessRequest (30, 2, 118, 0);
   ExpectCollision (30, 4, 0); //backoff: 4 slots
+  // No access timeout is armed during the receptions: the timeout armed
+  // at 60 for 86 is removed by the rx at 80 and the one armed at 100 is
+  // the only one which expires.
+  ExpectAccessTimeouts (2, 1, 1);
   EndTest ();
   // Test the case where the backoff slots is zero.
   //
@@ -0,0 +1,188 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/mr-wifi-helper.h"
+#include "ns3/mr-wifi-net-device.h"
+#include "ns3/mr-radio-statistics.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/yans-wifi-helper.h"
+#include "ns3/qos-wifi-mac-helper.h"
+#include "ns3/object-vector.h"
+#include "ns3/pointer.h"
+
+using namespace ns3;
+
+/**
+ * Check the per-radio statistics of a MrWifiNetDevice with more radios
+ * than the eight the statistics used to be limited to.
+ */
+class MrRadioStatisticsTest : public TestCase
+{
+public:
+  MrRadioStatisticsTest ();
+
+  virtual void DoRun (void);
+
+private:
+  /// AcksReceived trace sink; the context is the config path
+  void NotifyAcksReceived (std::string context, uint32_t oldValue, uint32_t newValue);
+  /// TxBytes trace sink
+  void NotifyTxBytes (uint64_t oldValue, uint64_t newValue);
+
+  uint32_t m_acksTraced;
+  uint64_t m_txBytesTraced;
+};
+
+MrRadioStatisticsTest::MrRadioStatisticsTest ()
+  : TestCase ("Per-radio statistics of MrWifiNetDevice"),
+    m_acksTraced (0),
+    m_txBytesTraced (0)
+{
+}
+
+void
+MrRadioStatisticsTest::NotifyAcksReceived (std::string context, uint32_t oldValue, uint32_t newValue)
+{
+  m_acksTraced = newValue;
+}
+
+void
+MrRadioStatisticsTest::NotifyTxBytes (uint64_t oldValue, uint64_t newValue)
+{
+  m_txBytesTraced = newValue;
+}
+
+void
+MrRadioStatisticsTest::DoRun (void)
+{
+  const uint32_t nRadios = 12;
+  NodeContainer nodes;
+  nodes.Create (2);
+  MobilityHelper mobility;
+  mobility.Install (nodes);
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (YansWifiChannelHelper::Default ().Create ());
+  QosWifiMacHelper mac = QosWifiMacHelper::Default ();
+  mac.SetType ("ns3::AdhocWifiMac");
+  MrWifiHelper wifi = MrWifiHelper::Default ();
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager");
+  wifi.SetNumRadios (nRadios);
+  wifi.SetSelectionPolicy ("ns3::MrRoundRobinSelectionPolicy");
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+  Ptr<MrWifiNetDevice> tx = DynamicCast<MrWifiNetDevice> (devices.Get (0));
+  Ptr<MrWifiNetDevice> rx = DynamicCast<MrWifiNetDevice> (devices.Get (1));
+  tx->SetProposed (false);
+  rx->SetProposed (false);
+  for (uint32_t i = 0; i < nRadios; i++)
+    {
+      // radio i of both devices on its own channel
+      uint16_t channel = i < 8 ? 36 + 4 * i : 100 + 4 * (i - 8);
+      tx->GetPhysicalNetDevice (i)->GetPhy ()->SetChannelNumber (channel);
+      rx->GetPhysicalNetDevice (i)->GetPhy ()->SetChannelNumber (channel);
+    }
+
+  // one statistics object per radio, each on its own cache line
+  ObjectVectorValue stats;
+  tx->GetAttribute ("RadioStatistics", stats);
+  NS_TEST_ASSERT_MSG_EQ (stats.GetN (), nRadios, "one statistics object per radio");
+  for (uint32_t i = 0; i < nRadios; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (reinterpret_cast<uintptr_t> (PeekPointer (tx->GetRadioStatistics (i)))
+                             % MrRadioStatistics::CACHE_LINE_SIZE, 0, "statistics should be cache aligned");
+    }
+
+  Config::Connect ("/NodeList/0/DeviceList/*/$ns3::MrWifiNetDevice/RadioStatistics/11/AcksReceived",
+                   MakeCallback (&MrRadioStatisticsTest::NotifyAcksReceived, this));
+  tx->GetRadioStatistics (11)->TraceConnectWithoutContext ("TxBytes", MakeCallback (&MrRadioStatisticsTest::NotifyTxBytes, this));
+
+  // the MAC reports the block ACKs only; report the ACKs of each radio
+  // from the device itself, once it is initialized
+  for (uint32_t i = 0; i < nRadios; i++)
+    {
+      Simulator::Schedule (MilliSeconds (1), &MrWifiNetDevice::GotAck, tx, i);
+      Simulator::Schedule (MilliSeconds (2), &MrWifiNetDevice::GotAck, tx, i);
+      Simulator::Schedule (MilliSeconds (3), &MrWifiNetDevice::MissedAck, tx, i);
+    }
+  // a burst of two packets per radio: the first one is sent at once and
+  // the second one waits in the queue
+  const uint32_t nPackets = 2 * nRadios;
+  for (uint32_t i = 0; i < nPackets; i++)
+    {
+      Simulator::Schedule (MilliSeconds (10), &MrWifiNetDevice::Send, tx,
+                           Create<Packet> (500), rx->GetAddress (), 0x0800);
+    }
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+
+  std::vector<MrRadioStatistics::Snapshot> snapshot = tx->GetStatisticsSnapshot ();
+  NS_TEST_ASSERT_MSG_EQ (snapshot.size (), nRadios, "one snapshot per radio");
+  for (uint32_t i = 0; i < nRadios; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (snapshot[i].acksReceived, 2, "unexpected number of ACKs received");
+      NS_TEST_EXPECT_MSG_EQ (tx->GetNumAcksReceived (i), 2, "GetNumAcksReceived should match the snapshot");
+      NS_TEST_EXPECT_MSG_EQ (snapshot[i].acksMissed, 1, "unexpected number of ACKs missed");
+      NS_TEST_EXPECT_MSG_EQ (tx->GetNumAcksMissed (i), 1, "GetNumAcksMissed should match the snapshot");
+      NS_TEST_EXPECT_MSG_EQ (snapshot[i].txBytes, 1000, "each radio should send 1000 bytes");
+      NS_TEST_EXPECT_MSG_EQ (snapshot[i].queueHighWater, 1, "one packet should wait in each queue");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_acksTraced, 2, "AcksReceived should be traced through the config path");
+  NS_TEST_EXPECT_MSG_EQ (m_txBytesTraced, 1000, "TxBytes should be traced");
+
+  MrRadioStatistics::Snapshot total = tx->GetAggregateStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (total.acksReceived, 2 * nRadios, "aggregate should add up the radios");
+  NS_TEST_EXPECT_MSG_EQ (total.acksMissed, nRadios, "aggregate should add up the radios");
+  NS_TEST_EXPECT_MSG_EQ (total.txBytes, nPackets * 500, "aggregate should add up the radios");
+  NS_TEST_EXPECT_MSG_EQ (total.queueHighWater, 1, "aggregate high-water mark should be the largest one");
+  NS_TEST_EXPECT_MSG_EQ (rx->GetAggregateStatistics ().rxBytes, nPackets * 500, "receiver should count the bytes received");
+
+  tx->ResetStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (tx->GetAggregateStatistics ().acksReceived, 0, "statistics should be reset");
+  NS_TEST_EXPECT_MSG_EQ (tx->GetAggregateStatistics ().txBytes, 0, "statistics should be reset");
+
+  // token hold time, counted while the radio holds the token
+  Ptr<MrRadioStatistics> radio = CreateObject<MrRadioStatistics> ();
+  radio->NotifyToken (true);
+  Simulator::Schedule (MilliSeconds (5), &MrRadioStatistics::NotifyToken, radio, false);
+  Simulator::Schedule (MilliSeconds (8), &MrRadioStatistics::NotifyToken, radio, true);
+  Simulator::Stop (MilliSeconds (10));
+  Time start = Simulator::Now ();
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now () - start, MilliSeconds (10), "unexpected stop time");
+  NS_TEST_EXPECT_MSG_EQ (radio->GetSnapshot ().tokenHoldTime, MilliSeconds (7),
+                         "token hold time should include the current holding period");
+
+  Simulator::Destroy ();
+}
+
+class MrRadioStatisticsTestSuite : public TestSuite
+{
+public:
+  MrRadioStatisticsTestSuite ();
+};
+
+MrRadioStatisticsTestSuite::MrRadioStatisticsTestSuite ()
+  : TestSuite ("wifi-mr-radio-statistics", UNIT)
+{
+  AddTestCase (new MrRadioStatisticsTest, TestCase::QUICK);
+}
+
+static MrRadioStatisticsTestSuite g_mrRadioStatisticsTestSuite;
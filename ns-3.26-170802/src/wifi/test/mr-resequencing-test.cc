@@ -0,0 +1,256 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/mr-wifi-helper.h"
+#include "ns3/mr-wifi-net-device.h"
+#include "ns3/mr-sequence-header.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/yans-wifi-helper.h"
+#include "ns3/nqos-wifi-mac-helper.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/nstime.h"
+
+using namespace ns3;
+
+/**
+ * Check that MrWifiNetDevice delivers the packets of a striped flow in
+ * order, that it bounds the time and the number of packets it holds, and
+ * that a flow striped over three radios arrives in order.
+ */
+class MrResequencingTest : public TestCase
+{
+public:
+  MrResequencingTest ();
+
+  virtual void DoRun (void);
+
+private:
+  /// Create a sender and a receiver with three radios each.
+  void Setup (void);
+  /**
+   * Hand a striped packet to the receiver as if a radio received it.
+   *
+   * \param flow the flow id
+   * \param sequence the sequence number
+   */
+  void Inject (uint32_t flow, uint32_t sequence);
+  /**
+   * Receive callback of the receiver; records the first payload byte.
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+  void NotifyReorderDepth (uint32_t depth);
+  void NotifyHoldTime (Time holdTime);
+
+  Ptr<MrWifiNetDevice> m_tx;
+  Ptr<MrWifiNetDevice> m_rx;
+  std::vector<uint32_t> m_received;
+  std::vector<uint32_t> m_depths;
+  std::vector<Time> m_holdTimes;
+};
+
+MrResequencingTest::MrResequencingTest ()
+  : TestCase ("Resequencing of flows striped over the radios of a MrWifiNetDevice")
+{
+}
+
+void
+MrResequencingTest::Setup (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  MobilityHelper mobility;
+  mobility.Install (nodes);
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (YansWifiChannelHelper::Default ().Create ());
+  NqosWifiMacHelper mac = NqosWifiMacHelper::Default ();
+  mac.SetType ("ns3::AdhocWifiMac");
+  MrWifiHelper wifi = MrWifiHelper::Default ();
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager");
+  wifi.SetNumRadios (3);
+  wifi.SetSelectionPolicy ("ns3::MrRoundRobinSelectionPolicy");
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+  m_tx = DynamicCast<MrWifiNetDevice> (devices.Get (0));
+  m_rx = DynamicCast<MrWifiNetDevice> (devices.Get (1));
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      // radio i of both devices on its own channel
+      m_tx->GetPhysicalNetDevice (i)->GetPhy ()->SetChannelNumber (36 + i * 4);
+      m_rx->GetPhysicalNetDevice (i)->GetPhy ()->SetChannelNumber (36 + i * 4);
+    }
+  m_tx->SetAttribute ("Striping", BooleanValue (true));
+  m_rx->SetReceiveCallback (MakeCallback (&MrResequencingTest::Receive, this));
+  m_rx->TraceConnectWithoutContext ("ReorderDepth", MakeCallback (&MrResequencingTest::NotifyReorderDepth, this));
+  m_rx->TraceConnectWithoutContext ("HoldTime", MakeCallback (&MrResequencingTest::NotifyHoldTime, this));
+  m_received.clear ();
+  m_depths.clear ();
+  m_holdTimes.clear ();
+}
+
+void
+MrResequencingTest::Inject (uint32_t flow, uint32_t sequence)
+{
+  uint8_t payload[100] = {0};
+  payload[0] = sequence;
+  Ptr<Packet> packet = Create<Packet> (payload, sizeof (payload));
+  MrSequenceHeader header;
+  header.SetProtocol (0x0800);
+  header.SetFlowId (flow);
+  header.SetSequence (sequence);
+  packet->AddHeader (header);
+  m_rx->ReceiveFromDevice (m_rx->GetPhysicalNetDevice (sequence % 3), packet,
+                           MrSequenceHeader::PROT_NUMBER, m_tx->GetAddress ());
+}
+
+bool
+MrResequencingTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  NS_TEST_EXPECT_MSG_EQ (protocol, 0x0800, "original protocol number should be restored");
+  uint8_t first;
+  packet->CopyData (&first, 1);
+  m_received.push_back (first);
+  return true;
+}
+
+void
+MrResequencingTest::NotifyReorderDepth (uint32_t depth)
+{
+  m_depths.push_back (depth);
+}
+
+void
+MrResequencingTest::NotifyHoldTime (Time holdTime)
+{
+  m_holdTimes.push_back (holdTime);
+}
+
+void
+MrResequencingTest::DoRun (void)
+{
+  // 0 2 3 1: 2 and 3 are held until 1 arrives
+  Setup ();
+  Simulator::Schedule (MilliSeconds (0), &MrResequencingTest::Inject, this, 1, 0);
+  Simulator::Schedule (MilliSeconds (1), &MrResequencingTest::Inject, this, 1, 2);
+  Simulator::Schedule (MilliSeconds (2), &MrResequencingTest::Inject, this, 1, 3);
+  Simulator::Schedule (MilliSeconds (3), &MrResequencingTest::Inject, this, 1, 1);
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_received.size (), 4, "all packets should be delivered");
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_received[i], i, "packets should be delivered in order");
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_depths.size (), 2, "two packets should be held");
+  NS_TEST_EXPECT_MSG_EQ (m_depths[1], 2, "unexpected reorder depth");
+  NS_TEST_ASSERT_MSG_EQ (m_holdTimes.size (), 2, "two held packets should be released");
+  NS_TEST_EXPECT_MSG_EQ (m_holdTimes[0], MilliSeconds (2), "unexpected hold time");
+  NS_TEST_EXPECT_MSG_EQ (m_holdTimes[1], MilliSeconds (1), "unexpected hold time");
+  Simulator::Destroy ();
+
+  // 0 2 ... 1: 2 is released by the timeout, 1 is delivered late; the
+  // other flow is not blocked by the gap
+  Setup ();
+  m_rx->SetAttribute ("ResequencingTimeout", TimeValue (MilliSeconds (10)));
+  Simulator::Schedule (MilliSeconds (0), &MrResequencingTest::Inject, this, 1, 0);
+  Simulator::Schedule (MilliSeconds (1), &MrResequencingTest::Inject, this, 1, 2);
+  Simulator::Schedule (MilliSeconds (2), &MrResequencingTest::Inject, this, 2, 5);
+  Simulator::Schedule (MilliSeconds (20), &MrResequencingTest::Inject, this, 1, 1);
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_received.size (), 4, "all packets should be delivered");
+  NS_TEST_EXPECT_MSG_EQ (m_received[0], 0, "unexpected delivery order");
+  NS_TEST_EXPECT_MSG_EQ (m_received[1], 5, "other flows should not wait");
+  NS_TEST_EXPECT_MSG_EQ (m_received[2], 2, "unexpected delivery order");
+  NS_TEST_EXPECT_MSG_EQ (m_received[3], 1, "late packet should be delivered");
+  NS_TEST_ASSERT_MSG_EQ (m_holdTimes.size (), 1, "one held packet should be released");
+  NS_TEST_EXPECT_MSG_EQ (m_holdTimes[0], MilliSeconds (10), "held packet should be released after the timeout");
+  Simulator::Destroy ();
+
+  // 1 2 3 4 5 without 0 and a buffer of 4 packets
+  Setup ();
+  m_rx->SetAttribute ("ResequencingBufferSize", UintegerValue (4));
+  Simulator::Schedule (MilliSeconds (0), &MrResequencingTest::Inject, this, 1, 0);
+  for (uint32_t i = 2; i < 7; i++)
+    {
+      Simulator::Schedule (MilliSeconds (i), &MrResequencingTest::Inject, this, 1, i);
+    }
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_received.size (), 6, "all packets should be delivered");
+  NS_TEST_EXPECT_MSG_EQ (m_received[1], 2, "full buffer should skip the missing packet");
+  NS_TEST_EXPECT_MSG_EQ (m_holdTimes.size (), 5, "all held packets should be released");
+  NS_TEST_EXPECT_MSG_EQ (m_holdTimes.back (), MilliSeconds (0), "full buffer should release immediately");
+  Simulator::Destroy ();
+
+  // a flow sent round robin over the three radios arrives in order
+  Setup ();
+  for (uint32_t i = 0; i < 30; i++)
+    {
+      uint8_t payload[100] = {0};
+      payload[0] = i;
+      Simulator::Schedule (Seconds (1), &MrWifiNetDevice::Send, m_tx, Create<Packet> (payload, sizeof (payload)),
+                           m_rx->GetAddress (), 0x0800);
+    }
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_received.size (), 30, "all packets should be delivered");
+  for (uint32_t i = 0; i < 30; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_received[i], i, "packets should be delivered in order");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_rx->GetNumAcksReceived (0), 0, "receiver should not get ACKs");
+  NS_TEST_EXPECT_MSG_EQ (m_tx->GetNSequencedFlows (), 1, "the sender should number the flow");
+  NS_TEST_EXPECT_MSG_EQ (m_rx->GetNResequencedFlows (), 1, "the receiver should keep the flow");
+  NS_TEST_EXPECT_MSG_EQ (m_tx->GetMtu () + MrSequenceHeader ().GetSerializedSize (), m_tx->GetPhysicalNetDevice (0)->GetMtu (),
+                         "the MTU should leave room for the sequence header");
+  Simulator::Destroy ();
+
+  // the state of an idle flow is dropped by the receiver after
+  // FlowIdleTimeout, and by the sender after twice that time
+  Setup ();
+  m_tx->SetAttribute ("FlowIdleTimeout", TimeValue (Seconds (1)));
+  m_rx->SetAttribute ("FlowIdleTimeout", TimeValue (Seconds (1)));
+  Simulator::Schedule (Seconds (1), &MrWifiNetDevice::Send, m_tx, Create<Packet> (100), m_rx->GetAddress (), 0x0800);
+  Simulator::Stop (Seconds (2.5));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_received.size (), 1, "the packet should be delivered");
+  NS_TEST_EXPECT_MSG_EQ (m_rx->GetNResequencedFlows (), 0, "the receiver should drop the idle flow");
+  NS_TEST_EXPECT_MSG_EQ (m_tx->GetNSequencedFlows (), 1, "the sender should keep the flow longer");
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_tx->GetNSequencedFlows (), 0, "the sender should drop the idle flow");
+  Simulator::Destroy ();
+
+  m_tx = 0;
+  m_rx = 0;
+}
+
+class MrResequencingTestSuite : public TestSuite
+{
+public:
+  MrResequencingTestSuite ();
+};
+
+MrResequencingTestSuite::MrResequencingTestSuite ()
+  : TestSuite ("wifi-mr-resequencing", UNIT)
+{
+  AddTestCase (new MrResequencingTest, TestCase::QUICK);
+}
+
+static MrResequencingTestSuite g_mrResequencingTestSuite;
@@ -0,0 +1,191 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/mr-wifi-helper.h"
+#include "ns3/mr-wifi-net-device.h"
+#include "ns3/mr-selection-policy.h"
+#include "ns3/yans-wifi-helper.h"
+#include "ns3/nqos-wifi-mac-helper.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
+#include <set>
+
+using namespace ns3;
+
+/**
+ * Check the radio picked by each MrSelectionPolicy on a three-radio
+ * MrWifiNetDevice with empty queues.
+ */
+class MrSelectionPolicyTest : public TestCase
+{
+public:
+  MrSelectionPolicyTest ();
+
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \param srcPort the UDP source port
+   * \param dstPort the UDP destination port
+   * \return a packet starting with an IPv4 and a UDP header
+   */
+  Ptr<Packet> CreateUdpPacket (uint16_t srcPort, uint16_t dstPort);
+  /**
+   * \param policy the policy to attach to the device
+   * \return the radio picked by the policy for a UDP packet to the peer
+   */
+  uint32_t Select (Ptr<MrSelectionPolicy> policy, Ptr<Packet> packet);
+
+  Ptr<MrWifiNetDevice> m_device;
+  Mac48Address m_peer;
+};
+
+MrSelectionPolicyTest::MrSelectionPolicyTest ()
+  : TestCase ("Radio selection policies of MrWifiNetDevice")
+{
+}
+
+Ptr<Packet>
+MrSelectionPolicyTest::CreateUdpPacket (uint16_t srcPort, uint16_t dstPort)
+{
+  uint8_t buffer[28 + 100] = {0};
+  buffer[0] = 0x45;   // IPv4, 20 byte header
+  buffer[9] = 17;     // UDP
+  buffer[12] = 10;    // 10.0.0.1 -> 10.0.0.2
+  buffer[15] = 1;
+  buffer[16] = 10;
+  buffer[19] = 2;
+  buffer[20] = srcPort >> 8;
+  buffer[21] = srcPort & 0xff;
+  buffer[22] = dstPort >> 8;
+  buffer[23] = dstPort & 0xff;
+  return Create<Packet> (buffer, sizeof (buffer));
+}
+
+uint32_t
+MrSelectionPolicyTest::Select (Ptr<MrSelectionPolicy> policy, Ptr<Packet> packet)
+{
+  m_device->SetSelectionPolicy (policy);
+  return m_device->SelectInterface (packet, m_peer, 0x0800);
+}
+
+void
+MrSelectionPolicyTest::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (YansWifiChannelHelper::Default ().Create ());
+  NqosWifiMacHelper mac = NqosWifiMacHelper::Default ();
+  mac.SetType ("ns3::AdhocWifiMac");
+  MrWifiHelper wifi = MrWifiHelper::Default ();
+  wifi.SetNumRadios (3);
+  NetDeviceContainer defaultDevices = wifi.Install (phy, mac, nodes.Get (0));
+  wifi.SetSelectionPolicy ("ns3::MrRoundRobinSelectionPolicy");
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+
+  // The helper gives each device its own policy; the default is the
+  // queue length policy.
+  Ptr<MrWifiNetDevice> defaultDevice = DynamicCast<MrWifiNetDevice> (defaultDevices.Get (0));
+  NS_TEST_ASSERT_MSG_NE (DynamicCast<MrQueueLengthSelectionPolicy> (defaultDevice->GetSelectionPolicy ()), 0,
+                         "default policy should be the queue length policy");
+  m_device = DynamicCast<MrWifiNetDevice> (devices.Get (0));
+  m_peer = Mac48Address::ConvertFrom (devices.Get (1)->GetAddress ());
+  Ptr<MrWifiNetDevice> other = DynamicCast<MrWifiNetDevice> (devices.Get (1));
+  NS_TEST_ASSERT_MSG_NE (DynamicCast<MrRoundRobinSelectionPolicy> (m_device->GetSelectionPolicy ()), 0,
+                         "helper should install a round robin policy");
+  NS_TEST_EXPECT_MSG_NE (m_device->GetSelectionPolicy (), other->GetSelectionPolicy (),
+                         "devices should not share a policy");
+  NS_TEST_EXPECT_MSG_EQ (m_device->GetNRadios (), 3, "unexpected number of radios");
+
+  Ptr<Packet> packet = CreateUdpPacket (1000, 9);
+
+  // round robin
+  Ptr<MrSelectionPolicy> policy = m_device->GetSelectionPolicy ();
+  for (uint32_t i = 0; i < 7; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (Select (policy, packet), i % 3, "round robin should use each radio in turn");
+    }
+
+  // queue length: with empty queues the preferred radio wins
+  policy = CreateObject<MrQueueLengthSelectionPolicy> ();
+  NS_TEST_EXPECT_MSG_EQ (Select (policy, packet), 0, "queue length should prefer radio 0");
+  policy->SetAttribute ("PreferredRadio", UintegerValue (2));
+  NS_TEST_EXPECT_MSG_EQ (Select (policy, packet), 2, "queue length should prefer radio 2");
+
+  // flow hash: a flow sticks to a radio, different flows are spread
+  Ptr<MrFlowHashSelectionPolicy> flowHash = CreateObject<MrFlowHashSelectionPolicy> ();
+  uint32_t radio = Select (flowHash, packet);
+  NS_TEST_EXPECT_MSG_EQ (Select (flowHash, CreateUdpPacket (1000, 9)), radio, "a flow should stay on its radio");
+  std::set<uint32_t> radios;
+  for (uint16_t port = 1000; port < 1064; port++)
+    {
+      radios.insert (Select (flowHash, CreateUdpPacket (port, 9)));
+    }
+  NS_TEST_EXPECT_MSG_EQ (radios.size (), 3, "flows should be spread over all the radios");
+  flowHash->SetAttribute ("HashIpFlow", BooleanValue (false));
+  radios.clear ();
+  for (uint16_t port = 1000; port < 1064; port++)
+    {
+      radios.insert (Select (flowHash, CreateUdpPacket (port, 9)));
+    }
+  NS_TEST_EXPECT_MSG_EQ (radios.size (), 1, "all the packets to a destination should use one radio");
+
+  // ACK ratio: radio 0 misses its ACKs, radio 1 gets them
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      m_device->MissedAck (0);
+      m_device->GotAck (1);
+    }
+  policy = CreateObject<MrAckRatioSelectionPolicy> ();
+  NS_TEST_EXPECT_MSG_EQ (Select (policy, packet), 1, "ACK ratio should prefer radio 1");
+
+  // expected transmission time: same rates, so the ACK ratio decides
+  Ptr<MrExpectedTxTimeSelectionPolicy> ett = CreateObject<MrExpectedTxTimeSelectionPolicy> ();
+  NS_TEST_EXPECT_MSG_EQ (Select (ett, packet), 1, "expected transmission time should prefer radio 1");
+  Time time0 = ett->GetExpectedTxTime (m_device, 0, packet->GetSize ());
+  Time time2 = ett->GetExpectedTxTime (m_device, 2, packet->GetSize ());
+  NS_TEST_EXPECT_MSG_GT (time0, time2, "missed ACKs should increase the expected transmission time");
+  NS_TEST_EXPECT_MSG_GT (time2, MicroSeconds (0), "expected transmission time should be positive");
+
+  // the policy can be replaced through the attribute system
+  m_device->SetAttribute ("SelectionPolicy", StringValue ("ns3::MrRoundRobinSelectionPolicy"));
+  NS_TEST_EXPECT_MSG_NE (DynamicCast<MrRoundRobinSelectionPolicy> (m_device->GetSelectionPolicy ()), 0,
+                         "SelectionPolicy attribute should set the policy");
+
+  m_device = 0;
+  Simulator::Destroy ();
+}
+
+class MrSelectionPolicyTestSuite : public TestSuite
+{
+public:
+  MrSelectionPolicyTestSuite ();
+};
+
+MrSelectionPolicyTestSuite::MrSelectionPolicyTestSuite ()
+  : TestSuite ("wifi-mr-selection-policy", UNIT)
+{
+  AddTestCase (new MrSelectionPolicyTest, TestCase::QUICK);
+}
+
+static MrSelectionPolicyTestSuite g_mrSelectionPolicyTestSuite;
@@ -23,6 +23,8 @@
 #include "ns3/dsss-error-rate-model.h"
 #include "ns3/yans-error-rate-model.h"
 #include "ns3/nist-error-rate-model.h"
+#include "ns3/tabulated-error-rate-model.h"
+#include "ns3/double.h"
 
 using namespace ns3;
 
@@ -279,6 +281,74 @@ WifiErrorRateModelsTestCaseNist::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (ps, 0.999, 0.001, "Not equal within tolerance");
 }
 
+class WifiErrorRateModelsTestCaseTabulated : public TestCase
+{
+public:
+  WifiErrorRateModelsTestCaseTabulated ();
+  virtual ~WifiErrorRateModelsTestCaseTabulated ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Compare a TabulatedErrorRateModel with the model it wraps.
+   *
+   * \param model the analytic model
+   * \param maxError the accuracy bound of the table
+   */
+  void Compare (Ptr<ErrorRateModel> model, double maxError);
+};
+
+WifiErrorRateModelsTestCaseTabulated::WifiErrorRateModelsTestCaseTabulated ()
+  : TestCase ("WifiErrorRateModel test case tabulated")
+{
+}
+
+WifiErrorRateModelsTestCaseTabulated::~WifiErrorRateModelsTestCaseTabulated ()
+{
+}
+
+void
+WifiErrorRateModelsTestCaseTabulated::Compare (Ptr<ErrorRateModel> model, double maxError)
+{
+  static const char *modes[] = {
+    "DsssRate1Mbps", "DsssRate2Mbps", "DsssRate5_5Mbps", "DsssRate11Mbps",
+    "OfdmRate6Mbps", "OfdmRate9Mbps", "OfdmRate12Mbps", "OfdmRate18Mbps",
+    "OfdmRate24Mbps", "OfdmRate36Mbps", "OfdmRate48Mbps", "OfdmRate54Mbps",
+    "HtMcs0", "HtMcs3", "HtMcs7", "VhtMcs8"
+  };
+  static const uint32_t sizes[] = { 1, 14 * 8, 1500 * 8, 65535 * 8 };
+  WifiTxVector txVector;
+  Ptr<TabulatedErrorRateModel> tabulated = CreateObject<TabulatedErrorRateModel> ();
+  tabulated->SetAttribute ("MaxError", DoubleValue (maxError));
+  tabulated->SetModel (model);
+
+  for (uint32_t m = 0; m < sizeof (modes) / sizeof (modes[0]); m++)
+    {
+      WifiMode mode (modes[m]);
+      double worst = 0;
+      for (double snrDb = -5.0; snrDb < 45.0; snrDb += 0.0371)
+        {
+          double snr = std::pow (10.0, snrDb / 10.0);
+          for (uint32_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++)
+            {
+              double exact = model->GetChunkSuccessRate (mode, txVector, snr, sizes[i]);
+              double approx = tabulated->GetChunkSuccessRate (mode, txVector, snr, sizes[i]);
+              worst = std::max (worst, std::abs (exact - approx));
+            }
+        }
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (worst, maxError, "table for " << mode << " exceeds the accuracy bound");
+    }
+  NS_TEST_EXPECT_MSG_GT (tabulated->GetTableLookups (), 10 * tabulated->GetModelLookups (), "too many calls forwarded to the analytic model");
+}
+
+void
+WifiErrorRateModelsTestCaseTabulated::DoRun (void)
+{
+  Compare (CreateObject<NistErrorRateModel> (), 1e-5);
+  Compare (CreateObject<YansErrorRateModel> (), 1e-5);
+  Compare (CreateObject<NistErrorRateModel> (), 1e-3);
+}
+
 class WifiErrorRateModelsTestSuite : public TestSuite
 {
 public:
@@ -290,6 +360,7 @@ WifiErrorRateModelsTestSuite::WifiErrorRateModelsTestSuite ()
 {
   AddTestCase (new WifiErrorRateModelsTestCaseDsss, TestCase::QUICK);
   AddTestCase (new WifiErrorRateModelsTestCaseNist, TestCase::QUICK);
+  AddTestCase (new WifiErrorRateModelsTestCaseTabulated, TestCase::QUICK);
 }
 
 static WifiErrorRateModelsTestSuite wifiErrorRateModelsTestSuite;
@@ -27,7 +27,10 @@
 #include "ns3/adhoc-wifi-mac.h"
 #include "ns3/propagation-delay-model.h"
 #include "ns3/propagation-loss-model.h"
+#include "ns3/cached-propagation-loss-model.h"
 #include "ns3/yans-error-rate-model.h"
+#include "ns3/nist-error-rate-model.h"
+#include "ns3/interference-helper.h"
 #include "ns3/constant-position-mobility-model.h"
 #include "ns3/test.h"
 #include "ns3/pointer.h"
@@ -35,10 +38,20 @@
 #include "ns3/config.h"
 #include "ns3/boolean.h"
 #include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
 #include "ns3/packet-socket-address.h"
 #include "ns3/packet-socket-server.h"
 #include "ns3/packet-socket-client.h"
 #include "ns3/packet-socket-helper.h"
+#include "ns3/constant-rate-wifi-manager.h"
+#include "ns3/wifi-mac-queue.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/uinteger.h"
+#include "../model/qos-blocked-destinations.h"
+#include <set>
+#include <cmath>
+#include <algorithm>
 
 using namespace ns3;
 
@@ -326,6 +339,226 @@ InterferenceHelperSequenceTest::DoRun (void)
 }
 
 
+//-----------------------------------------------------------------------------
+/**
+ * Make sure that InterferenceHelper computes the same SNR, PER and energy
+ * durations as before when many transmissions overlap a reception.  The
+ * reference values were recorded with the original sorted-vector
+ * implementation and are compared bit for bit.
+ */
+class InterferenceHelperAccumulationTest : public TestCase
+{
+public:
+  InterferenceHelperAccumulationTest ();
+
+  virtual void DoRun (void);
+
+private:
+  /// Start the reception of the frame whose SNR is computed
+  void StartRx (void);
+  /**
+   * Add an overlapping transmission
+   * \param k index of the transmission, used to derive its duration and power
+   */
+  void AddInterferer (uint32_t k);
+  /// Record the SNR and PER of the frame under reception
+  void EndRx (void);
+  /**
+   * Record the time until the medium drops below the given energy
+   * \param energyW the energy threshold in W
+   */
+  void RecordEnergyDuration (double energyW);
+
+  InterferenceHelper m_interference;       //!< the helper under test
+  Ptr<InterferenceHelper::Event> m_event;  //!< the frame under reception
+  std::vector<double> m_results;           //!< recorded values
+};
+
+InterferenceHelperAccumulationTest::InterferenceHelperAccumulationTest ()
+  : TestCase ("InterferenceHelper SNR and PER with many overlapping signals")
+{
+}
+
+void
+InterferenceHelperAccumulationTest::StartRx (void)
+{
+  WifiTxVector txVector (WifiPhy::GetOfdmRate24Mbps (), 0, 0, false, 1, 0, 20, false, false);
+  m_event = m_interference.Add (1500, txVector, WIFI_PREAMBLE_LONG, MicroSeconds (300), 1e-9);
+  m_interference.NotifyRxStart ();
+}
+
+void
+InterferenceHelperAccumulationTest::AddInterferer (uint32_t k)
+{
+  WifiTxVector txVector (WifiPhy::GetOfdmRate6Mbps (), 0, 0, false, 1, 0, 20, false, false);
+  Time duration = MicroSeconds ((13 * k) % 97 + 20);
+  double rxPowerW = 2e-13 * (1 + k % 5) + 6e-14 * k;
+  if (k % 7 == 0)
+    {
+      m_interference.AddForeignSignal (duration, rxPowerW);
+    }
+  else
+    {
+      m_interference.Add (100, txVector, WIFI_PREAMBLE_LONG, duration, rxPowerW);
+    }
+}
+
+void
+InterferenceHelperAccumulationTest::EndRx (void)
+{
+  InterferenceHelper::SnrPer header = m_interference.CalculatePlcpHeaderSnrPer (m_event);
+  InterferenceHelper::SnrPer payload = m_interference.CalculatePlcpPayloadSnrPer (m_event);
+  m_results.push_back (header.snr);
+  m_results.push_back (header.per);
+  m_results.push_back (payload.snr);
+  m_results.push_back (payload.per);
+  m_interference.NotifyRxEnd ();
+  m_event = 0;
+}
+
+void
+InterferenceHelperAccumulationTest::RecordEnergyDuration (double energyW)
+{
+  m_results.push_back (m_interference.GetEnergyDuration (energyW).GetSeconds ());
+}
+
+void
+InterferenceHelperAccumulationTest::DoRun (void)
+{
+  m_interference.SetNoiseFigure (std::pow (10.0, 7.0 / 10.0));
+  m_interference.SetErrorRateModel (CreateObject<NistErrorRateModel> ());
+
+  for (uint32_t round = 0; round < 3; round++)
+    {
+      Time base = MilliSeconds (1 + 10 * round) + MicroSeconds (3 * round);
+      Simulator::Schedule (base, &InterferenceHelperAccumulationTest::StartRx, this);
+      for (uint32_t k = 1; k <= 40; k++)
+        {
+          Simulator::Schedule (base + MicroSeconds (7 * k) - MicroSeconds (30 + round),
+                               &InterferenceHelperAccumulationTest::AddInterferer, this, k + round);
+        }
+      Simulator::Schedule (base + MicroSeconds (150),
+                           &InterferenceHelperAccumulationTest::RecordEnergyDuration, this, 1.001e-9);
+      Simulator::Schedule (base + MicroSeconds (300),
+                           &InterferenceHelperAccumulationTest::EndRx, this);
+      Simulator::Schedule (base + MicroSeconds (300),
+                           &InterferenceHelperAccumulationTest::RecordEnergyDuration, this, 2e-12);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  // energy duration at 150us, header SNR/PER, payload SNR/PER, energy duration at 300us
+  static const double expected[] = {
+    8.5999999999999976e-05, 263.07222537922013, 0, 263.07222537922013, 2.5417969681251762e-06, 4.1999999999999991e-05,
+    7.7999999999999999e-05, 260.33277250711018, 0, 260.33277250711018, 5.2766114911895201e-06, 3.3999999999999959e-05,
+    9.2999999999999984e-05, 257.6497851905246, 0, 257.6497851905246, 5.9496091281419083e-06, 2.8999999999999946e-05,
+  };
+  NS_TEST_ASSERT_MSG_EQ (m_results.size (), sizeof (expected) / sizeof (expected[0]), "unexpected number of results");
+  for (uint32_t i = 0; i < m_results.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_results[i], expected[i], "result " << i << " differs from the reference");
+    }
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Make sure that InterferenceHelper keeps the power of the changes it
+ * expires, also while a frame is received: a long signal starts first,
+ * then short transmissions come and go before and during a long
+ * reception, and expire, but the SNR and energy durations still account
+ * for the long signal.
+ */
+class InterferenceHelperExpiryTest : public TestCase
+{
+public:
+  InterferenceHelperExpiryTest ();
+
+  virtual void DoRun (void);
+
+private:
+  /// Start the reception of the frame whose SNR is computed
+  void StartRx (void);
+  /// Add a short transmission
+  void AddInterferer (void);
+  /// Record the SNR of the frame under reception
+  void EndRx (void);
+  /**
+   * Record the time until the medium drops below the given energy
+   * \param energyW the energy threshold in W
+   */
+  void RecordEnergyDuration (double energyW);
+
+  InterferenceHelper m_interference;       //!< the helper under test
+  Ptr<InterferenceHelper::Event> m_event;  //!< the frame under reception
+  std::vector<double> m_results;           //!< recorded values
+};
+
+InterferenceHelperExpiryTest::InterferenceHelperExpiryTest ()
+  : TestCase ("InterferenceHelper keeps the power of expired changes")
+{
+}
+
+void
+InterferenceHelperExpiryTest::StartRx (void)
+{
+  WifiTxVector txVector (WifiPhy::GetOfdmRate6Mbps (), 0, 0, false, 1, 0, 20, false, false);
+  m_event = m_interference.Add (1500, txVector, WIFI_PREAMBLE_LONG, MilliSeconds (10), 1e-9);
+  m_interference.NotifyRxStart ();
+}
+
+void
+InterferenceHelperExpiryTest::AddInterferer (void)
+{
+  WifiTxVector txVector (WifiPhy::GetOfdmRate6Mbps (), 0, 0, false, 1, 0, 20, false, false);
+  m_interference.Add (100, txVector, WIFI_PREAMBLE_LONG, MicroSeconds (10), 1e-13);
+}
+
+void
+InterferenceHelperExpiryTest::EndRx (void)
+{
+  m_results.push_back (m_interference.CalculatePlcpHeaderSnrPer (m_event).snr);
+  m_results.push_back (m_interference.CalculatePlcpPayloadSnrPer (m_event).snr);
+  m_interference.NotifyRxEnd ();
+  m_event = 0;
+}
+
+void
+InterferenceHelperExpiryTest::RecordEnergyDuration (double energyW)
+{
+  m_results.push_back (m_interference.GetEnergyDuration (energyW).GetSeconds ());
+}
+
+void
+InterferenceHelperExpiryTest::DoRun (void)
+{
+  m_interference.SetNoiseFigure (1);
+  m_interference.SetErrorRateModel (CreateObject<NistErrorRateModel> ());
+
+  // a long signal, then short transmissions every 20us from 1ms to 90ms,
+  // and a 10ms reception from 50ms: the short transmissions before the
+  // reception expire while it is received
+  Simulator::Schedule (Seconds (0), &InterferenceHelper::AddForeignSignal, &m_interference,
+                       Seconds (2), 1e-12);
+  for (uint32_t k = 0; k < 4450; k++)
+    {
+      Simulator::Schedule (MilliSeconds (1) + MicroSeconds (20 * k) + NanoSeconds (5),
+                           &InterferenceHelperExpiryTest::AddInterferer, this);
+    }
+  Simulator::Schedule (MilliSeconds (50), &InterferenceHelperExpiryTest::StartRx, this);
+  Simulator::Schedule (MilliSeconds (55), &InterferenceHelperExpiryTest::RecordEnergyDuration, this, 5e-13);
+  Simulator::Schedule (MilliSeconds (60), &InterferenceHelperExpiryTest::EndRx, this);
+  Simulator::Schedule (MilliSeconds (95), &InterferenceHelperExpiryTest::RecordEnergyDuration, this, 5e-13);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  double snr = 1e-9 / (1.3803e-23 * 290.0 * 20e6 + 1e-12);
+  NS_TEST_ASSERT_MSG_EQ (m_results.size (), 4, "unexpected number of results");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_results[0], 1.945, 1e-12, "energy duration while receiving");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_results[1], snr, snr * 1e-9, "header SNR");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_results[2], snr, snr * 1e-9, "payload SNR");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_results[3], 1.905, 1e-12, "energy duration after the reception");
+}
+
 //-----------------------------------------------------------------------------
 /**
  * Make sure that when multiple broadcast packets are queued on the same
@@ -1090,6 +1323,615 @@ Bug2222TestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_countInternalCollisions, 1, "unexpected number of internal collisions!");
 }
 
+//-----------------------------------------------------------------------------
+/**
+ * Loss model decreasing with distance, which counts the receivers it is
+ * evaluated for.  Used to check which receivers YansWifiChannel evaluates.
+ */
+
+class CountingPropagationLossModel : public PropagationLossModel
+{
+public:
+  uint32_t m_count; ///< number of evaluations for a receiver
+  std::set<Ptr<MobilityModel> > m_receivers; ///< mobility models of the receivers
+
+
+private:
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
+  virtual int64_t DoAssignStreams (int64_t stream);
+};
+
+double
+CountingPropagationLossModel::DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+{
+  if (m_receivers.find (b) != m_receivers.end ())
+    {
+      const_cast<CountingPropagationLossModel *> (this)->m_count++;
+    }
+  return txPowerDbm - 40 - 20 * std::log10 (std::max (a->GetDistanceFrom (b), 1.0));
+}
+
+int64_t
+CountingPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Make sure that the spatial index of YansWifiChannel only evaluates the
+ * receivers located within the cutoff range of the sender, and that it
+ * follows the course changes of the receivers.
+ */
+
+class YansWifiChannelSpatialIndexTest : public TestCase
+{
+public:
+  YansWifiChannelSpatialIndexTest ();
+
+  virtual void DoRun (void);
+
+
+private:
+  /**
+   * Send a frame from the given PHY and return the number of receivers
+   * evaluated by the channel.
+   */
+  uint32_t Send (Ptr<YansWifiPhy> sender);
+
+  Ptr<YansWifiChannel> m_channel;
+  Ptr<CountingPropagationLossModel> m_loss;
+};
+
+YansWifiChannelSpatialIndexTest::YansWifiChannelSpatialIndexTest ()
+  : TestCase ("Test case for the receiver culling of YansWifiChannel")
+{
+}
+
+uint32_t
+YansWifiChannelSpatialIndexTest::Send (Ptr<YansWifiPhy> sender)
+{
+  m_loss->m_count = 0;
+  m_channel->Send (sender, Create<Packet> (1000), 16.0, WifiTxVector (), WIFI_PREAMBLE_LONG, NORMAL_MPDU, MicroSeconds (100));
+  return m_loss->m_count;
+}
+
+void
+YansWifiChannelSpatialIndexTest::DoRun (void)
+{
+  m_channel = CreateObject<YansWifiChannel> ();
+  m_loss = CreateObject<CountingPropagationLossModel> ();
+  m_channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  m_channel->SetPropagationLossModel (m_loss);
+
+  double positions[] = {0.0, 10.0, 500.0, 2000.0};
+  std::vector<Ptr<YansWifiPhy> > phys;
+  std::vector<Ptr<ConstantPositionMobilityModel> > mobilities;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (positions[i], 0.0, 0.0));
+      Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+      phy->SetErrorRateModel (CreateObject<YansErrorRateModel> ());
+      phy->SetMobility (mobility);
+      phy->SetChannel (m_channel);
+      phy->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+      m_loss->m_receivers.insert (mobility);
+      phys.push_back (phy);
+      mobilities.push_back (mobility);
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (Send (phys[0]), 3, "all receivers should be evaluated without cutoff");
+
+  m_channel->SetAttribute ("SpatialIndexCutoff", EnumValue (YansWifiChannel::CUTOFF_RANGE));
+  m_channel->SetAttribute ("SpatialIndexRange", DoubleValue (1000.0));
+  NS_TEST_ASSERT_MSG_EQ (Send (phys[0]), 2, "the receiver at 2000m should be culled");
+  NS_TEST_ASSERT_MSG_EQ (Send (phys[3]), 0, "all receivers should be culled");
+
+  mobilities[3]->SetPosition (Vector (800.0, 0.0, 0.0));
+  NS_TEST_ASSERT_MSG_EQ (Send (phys[0]), 3, "the receiver moved within range should be evaluated");
+  mobilities[3]->SetPosition (Vector (5000.0, 0.0, 0.0));
+  NS_TEST_ASSERT_MSG_EQ (Send (phys[0]), 2, "the receiver moved out of range should be culled");
+  NS_TEST_ASSERT_MSG_EQ (Send (phys[3]), 0, "all receivers should be culled");
+  mobilities[3]->SetPosition (Vector (800.0, 0.0, 0.0));
+
+  //16 dBm - 40 - 20 log10 (d) >= -80 dBm is satisfied up to d = 631m
+  Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+  channel->SetAttribute ("SpatialIndexCutoff", EnumValue (YansWifiChannel::CUTOFF_RX_POWER));
+  channel->SetAttribute ("SpatialIndexMinRxPower", DoubleValue (-80.0));
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  channel->SetPropagationLossModel (m_loss);
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      phys[i]->SetChannel (channel);
+    }
+  m_channel = channel;
+  NS_TEST_ASSERT_MSG_EQ (Send (phys[0]), 2, "the receiver at 800m should be culled");
+
+  //The search of the cutoff range must not leave entries in a cache
+  Ptr<CachedPropagationLossModel> cached = CreateObject<CachedPropagationLossModel> ();
+  cached->SetModel (m_loss);
+  channel = CreateObject<YansWifiChannel> ();
+  channel->SetAttribute ("SpatialIndexCutoff", EnumValue (YansWifiChannel::CUTOFF_RX_POWER));
+  channel->SetAttribute ("SpatialIndexMinRxPower", DoubleValue (-80.0));
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  channel->SetPropagationLossModel (cached);
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      phys[i]->SetChannel (channel);
+    }
+  m_channel = channel;
+  NS_TEST_ASSERT_MSG_EQ (Send (phys[0]), 2, "the receiver at 800m should be culled");
+  NS_TEST_ASSERT_MSG_EQ (cached->GetSize (), 2, "only the receivers within range should be cached");
+
+  NS_TEST_ASSERT_MSG_EQ (YansWifiChannel::IsStochastic (cached), false, "the cached model is deterministic");
+  Ptr<NakagamiPropagationLossModel> nakagami = CreateObject<NakagamiPropagationLossModel> ();
+  cached->SetNext (nakagami);
+  NS_TEST_ASSERT_MSG_EQ (YansWifiChannel::IsStochastic (cached), true, "a chained Nakagami model is stochastic");
+  NS_TEST_ASSERT_MSG_EQ (YansWifiChannel::IsStochastic (nakagami), true, "a Nakagami model is stochastic");
+
+  Simulator::Destroy ();
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Make sure that YansWifiChannel only evaluates the receivers operating on
+ * the channel number of the sender, and that it follows the channel
+ * switches of the receivers.
+ */
+
+class YansWifiChannelBucketTest : public TestCase
+{
+public:
+  YansWifiChannelBucketTest ();
+
+  virtual void DoRun (void);
+
+
+private:
+  /**
+   * Send a frame from the given PHY and return the number of receivers
+   * evaluated by the channel.
+   */
+  uint32_t Send (Ptr<YansWifiPhy> sender);
+
+  Ptr<YansWifiChannel> m_channel;
+  Ptr<CountingPropagationLossModel> m_loss;
+};
+
+YansWifiChannelBucketTest::YansWifiChannelBucketTest ()
+  : TestCase ("Test case for the channel number buckets of YansWifiChannel")
+{
+}
+
+uint32_t
+YansWifiChannelBucketTest::Send (Ptr<YansWifiPhy> sender)
+{
+  m_loss->m_count = 0;
+  m_channel->Send (sender, Create<Packet> (1000), 16.0, WifiTxVector (), WIFI_PREAMBLE_LONG, NORMAL_MPDU, MicroSeconds (100));
+  return m_loss->m_count;
+}
+
+void
+YansWifiChannelBucketTest::DoRun (void)
+{
+  m_channel = CreateObject<YansWifiChannel> ();
+  m_loss = CreateObject<CountingPropagationLossModel> ();
+  m_channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  m_channel->SetPropagationLossModel (m_loss);
+
+  uint16_t channelNumbers[] = {36, 36, 40, 44};
+  std::vector<Ptr<YansWifiPhy> > phys;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (10.0 * i, 0.0, 0.0));
+      Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+      phy->SetErrorRateModel (CreateObject<YansErrorRateModel> ());
+      phy->SetMobility (mobility);
+      phy->SetChannel (m_channel);
+      phy->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+      phy->SetChannelNumber (channelNumbers[i]);
+      m_loss->m_receivers.insert (mobility);
+      phys.push_back (phy);
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (Send (phys[0]), 1, "only the receiver on channel 36 should be evaluated");
+  NS_TEST_ASSERT_MSG_EQ (Send (phys[2]), 0, "no other receiver is on channel 40");
+
+  phys[3]->SetChannelNumber (36);
+  NS_TEST_ASSERT_MSG_EQ (Send (phys[0]), 2, "the receiver switched to channel 36 should be evaluated");
+  phys[1]->SetChannelNumber (40);
+  NS_TEST_ASSERT_MSG_EQ (Send (phys[0]), 1, "the receiver switched to channel 40 should not be evaluated");
+  NS_TEST_ASSERT_MSG_EQ (Send (phys[2]), 1, "the receiver switched to channel 40 should be evaluated");
+
+  Simulator::Destroy ();
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Make sure that a YansWifiChannel run by the MultithreadedSimulatorImpl,
+ * with one thread and with several, delivers the broadcast frames of a
+ * few adhoc nodes at the same times as with the DefaultSimulatorImpl,
+ * and that the Lookahead is derived from its MinimumDistance.
+ */
+
+class YansWifiChannelMultithreadedTest : public TestCase
+{
+public:
+  YansWifiChannelMultithreadedTest ();
+
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+
+private:
+  /**
+   * Run the topology, and return the reception times of each node.
+   *
+   * \param simulatorType the simulator implementation
+   * \param threads the ThreadCount of the MultithreadedSimulatorImpl
+   * \param partitions the PartitionCount of the MultithreadedSimulatorImpl
+   */
+  std::vector<std::vector<Time> > RunTopology (std::string simulatorType, uint32_t threads, uint32_t partitions);
+  void SendOnePacket (Ptr<NetDevice> device);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  /** Reception times of each node, each only written by the thread of the node. */
+  std::vector<std::vector<Time> > m_received;
+  /** Id of the first node. */
+  uint32_t m_firstNode;
+};
+
+YansWifiChannelMultithreadedTest::YansWifiChannelMultithreadedTest ()
+  : TestCase ("Test case for YansWifiChannel with the MultithreadedSimulatorImpl")
+{
+}
+
+void
+YansWifiChannelMultithreadedTest::SendOnePacket (Ptr<NetDevice> device)
+{
+  device->Send (Create<Packet> (500), device->GetBroadcast (), 1);
+}
+
+bool
+YansWifiChannelMultithreadedTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                           uint16_t protocol, const Address &from)
+{
+  m_received[device->GetNode ()->GetId () - m_firstNode].push_back (Simulator::Now ());
+  return true;
+}
+
+std::vector<std::vector<Time> >
+YansWifiChannelMultithreadedTest::RunTopology (std::string simulatorType, uint32_t threads, uint32_t partitions)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (simulatorType));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (threads));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::PartitionCount", UintegerValue (partitions));
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+
+  double positions[] = {0.0, 10.0, 20.0, 35.0, 50.0, 60.0};
+  uint32_t n = sizeof (positions) / sizeof (positions[0]);
+  NodeContainer nodes;
+  nodes.Create (n);
+  m_firstNode = nodes.Get (0)->GetId ();
+  m_received.assign (n, std::vector<Time> ());
+
+  YansWifiChannelHelper channelHelper = YansWifiChannelHelper::Default ();
+  Ptr<YansWifiChannel> channel = channelHelper.Create ();
+  channel->SetAttribute ("MinimumDistance", DoubleValue (10.0));
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channel);
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211a);
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode", StringValue ("OfdmRate6Mbps"),
+                                "ControlMode", StringValue ("OfdmRate6Mbps"));
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+  wifi.AssignStreams (devices, 100);
+
+  MobilityHelper mobility;
+  Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator> ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      positionAlloc->Add (Vector (positions[i], 0.0, 0.0));
+    }
+  mobility.SetPositionAllocator (positionAlloc);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (nodes);
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      devices.Get (i)->SetReceiveCallback (MakeCallback (&YansWifiChannelMultithreadedTest::Receive, this));
+      for (uint32_t k = 0; k < 3; k++)
+        {
+          Simulator::ScheduleWithContext (nodes.Get (i)->GetId (), Seconds (1) + MicroSeconds (1700 * i + 20000 * k),
+                                          &YansWifiChannelMultithreadedTest::SendOnePacket, this, devices.Get (i));
+        }
+    }
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+
+  Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  if (impl != 0)
+    {
+      NS_TEST_EXPECT_MSG_EQ (impl->GetLookahead (), channel->GetMinimumDelay (), "lookahead not derived from the channel");
+      NS_TEST_EXPECT_MSG_GT (impl->GetLookahead (), Seconds (0), "lookahead not derived from the MinimumDistance");
+    }
+  Simulator::Destroy ();
+  return m_received;
+}
+
+void
+YansWifiChannelMultithreadedTest::DoRun (void)
+{
+  std::vector<std::vector<Time> > expected = RunTopology ("ns3::DefaultSimulatorImpl", 0, 0);
+  uint32_t total = 0;
+  for (uint32_t i = 0; i < expected.size (); i++)
+    {
+      total += expected[i].size ();
+    }
+  //Each of the 3 frames of each node is received by the 5 other nodes
+  NS_TEST_ASSERT_MSG_EQ (total, 3 * 6 * 5, "unexpected number of receptions");
+
+  uint32_t threads[] = {1, 4};
+  uint32_t partitions[] = {3, 4};
+  for (uint32_t t = 0; t < 2; t++)
+    {
+      std::vector<std::vector<Time> > received = RunTopology ("ns3::MultithreadedSimulatorImpl", threads[t], partitions[t]);
+      NS_TEST_ASSERT_MSG_EQ (received.size (), expected.size (), "unexpected number of nodes");
+      for (uint32_t i = 0; i < received.size (); i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (received[i].size (), expected[i].size (),
+                                 "unexpected number of receptions of node " << i << " with " << threads[t] << " threads");
+          for (uint32_t j = 0; j < received[i].size (); j++)
+            {
+              NS_TEST_EXPECT_MSG_EQ (received[i][j], expected[i][j],
+                                     "unexpected reception time of node " << i << " with " << threads[t] << " threads");
+            }
+        }
+    }
+}
+
+void
+YansWifiChannelMultithreadedTest::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (0));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::PartitionCount", UintegerValue (0));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Make sure that WifiRemoteStationManager keeps one state per address
+ * and one station per address and TID while its lookup index grows.
+ */
+class WifiRemoteStationManagerLookupTest : public TestCase
+{
+public:
+  WifiRemoteStationManagerLookupTest ();
+
+  virtual void DoRun (void);
+};
+
+WifiRemoteStationManagerLookupTest::WifiRemoteStationManagerLookupTest ()
+  : TestCase ("Test case for the station lookup of WifiRemoteStationManager")
+{
+}
+
+void
+WifiRemoteStationManagerLookupTest::DoRun (void)
+{
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+  Ptr<WifiRemoteStationManager> manager = CreateObject<ConstantRateWifiManager> ();
+  manager->SetupPhy (phy);
+  manager->SetMaxSlrc (2);
+
+  const uint32_t nStations = 500;
+  std::vector<Mac48Address> addresses;
+  Ptr<Packet> packet = Create<Packet> (100);
+  WifiMacHeader header;
+  header.SetType (WIFI_MAC_QOSDATA);
+  for (uint32_t i = 0; i < nStations; i++)
+    {
+      // unicast addresses differing only in their third or last byte
+      uint8_t buffer[6] = {0};
+      buffer[i % 2 ? 2 : 5] = i / 2;
+      buffer[1] = i % 2;
+      Mac48Address address;
+      address.CopyFrom (buffer);
+      addresses.push_back (address);
+      // station i associates, and exhausts the retries of its TID 1 if i is odd
+      if (i % 3 == 0)
+        {
+          manager->RecordGotAssocTxOk (address);
+        }
+      if (i % 2 == 1)
+        {
+          header.SetQosTid (1);
+          manager->ReportDataFailed (address, &header);
+          manager->ReportDataFailed (address, &header);
+        }
+      header.SetQosTid (0);
+      manager->ReportDataFailed (address, &header);
+    }
+
+  for (uint32_t i = 0; i < nStations; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (manager->IsAssociated (addresses[i]), (i % 3 == 0), "unexpected state of station " << i);
+      header.SetQosTid (1);
+      NS_TEST_EXPECT_MSG_EQ (manager->NeedDataRetransmission (addresses[i], &header, packet), (i % 2 == 0),
+                             "unexpected retries of TID 1 of station " << i);
+      header.SetQosTid (0);
+      NS_TEST_EXPECT_MSG_EQ (manager->NeedDataRetransmission (addresses[i], &header, packet), true,
+                             "unexpected retries of TID 0 of station " << i);
+    }
+
+  // Reset forgets the stations but keeps their states
+  manager->Reset ();
+  header.SetQosTid (1);
+  NS_TEST_EXPECT_MSG_EQ (manager->NeedDataRetransmission (addresses[1], &header, packet), true,
+                         "Reset should clear the retries");
+  NS_TEST_EXPECT_MSG_EQ (manager->IsAssociated (addresses[3]), true, "Reset should keep the states");
+
+  manager->Dispose ();
+  phy->Dispose ();
+  Simulator::Destroy ();
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Make sure that the per-(receiver, TID) FIFOs of WifiMacQueue follow the
+ * queue order and that the packets expire in arrival order.
+ */
+class WifiMacQueueFlowTest : public TestCase
+{
+public:
+  WifiMacQueueFlowTest ();
+
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Enqueue a QoS data packet.
+   *
+   * \param to the receiver
+   * \param tid the TID
+   * \param size the size of the packet, used to identify it
+   * \param front push the packet at the front of the queue
+   */
+  void Enqueue (Mac48Address to, uint8_t tid, uint32_t size, bool front);
+  /**
+   * \param to the receiver
+   * \param tid the TID
+   * \return the size of the first packet for the receiver and TID, or 0
+   */
+  uint32_t PeekSize (Mac48Address to, uint8_t tid);
+  /// Check the queue after the first packets have expired
+  void CheckExpiry (void);
+
+  Ptr<WifiMacQueue> m_queue;
+};
+
+WifiMacQueueFlowTest::WifiMacQueueFlowTest ()
+  : TestCase ("Test case for the per-receiver and TID FIFOs of WifiMacQueue")
+{
+}
+
+void
+WifiMacQueueFlowTest::Enqueue (Mac48Address to, uint8_t tid, uint32_t size, bool front)
+{
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_QOSDATA);
+  hdr.SetAddr1 (to);
+  hdr.SetQosTid (tid);
+  if (front)
+    {
+      m_queue->PushFront (Create<Packet> (size), hdr);
+    }
+  else
+    {
+      m_queue->Enqueue (Create<Packet> (size), hdr);
+    }
+}
+
+uint32_t
+WifiMacQueueFlowTest::PeekSize (Mac48Address to, uint8_t tid)
+{
+  WifiMacHeader hdr;
+  Time tstamp;
+  Ptr<const Packet> packet = m_queue->PeekByTidAndAddress (&hdr, tid, WifiMacHeader::ADDR1, to, &tstamp);
+  return packet != 0 ? packet->GetSize () : 0;
+}
+
+void
+WifiMacQueueFlowTest::CheckExpiry (void)
+{
+  // the packets enqueued at 0 s expired, the one pushed at the front at
+  // 5 ms did not
+  Mac48Address a ("00:00:00:00:00:01");
+  NS_TEST_EXPECT_MSG_EQ (m_queue->GetSize (), 1, "expired packets should be dropped");
+  NS_TEST_EXPECT_MSG_EQ (PeekSize (a, 0), 50, "pushed packet should not expire");
+  NS_TEST_EXPECT_MSG_EQ (m_queue->GetNPacketsByTidAndAddress (0, WifiMacHeader::ADDR1, a), 1,
+                         "expired packets should leave their FIFO");
+}
+
+void
+WifiMacQueueFlowTest::DoRun (void)
+{
+  m_queue = CreateObject<WifiMacQueue> ();
+  m_queue->SetMaxDelay (MilliSeconds (10));
+  Mac48Address a ("00:00:00:00:00:01");
+  Mac48Address b ("00:00:00:00:00:02");
+
+  Enqueue (a, 0, 10, false);
+  Enqueue (b, 0, 20, false);
+  Enqueue (a, 1, 30, false);
+  Enqueue (a, 0, 40, false);
+  NS_TEST_EXPECT_MSG_EQ (m_queue->GetSize (), 4, "unexpected queue size");
+  NS_TEST_EXPECT_MSG_EQ (m_queue->GetNPacketsByTidAndAddress (0, WifiMacHeader::ADDR1, a), 2, "unexpected FIFO size");
+  NS_TEST_EXPECT_MSG_EQ (m_queue->GetNPacketsByTidAndAddress (1, WifiMacHeader::ADDR1, b), 0, "unexpected FIFO size");
+  NS_TEST_EXPECT_MSG_EQ (PeekSize (a, 0), 10, "FIFO should follow the queue order");
+
+  // removing the peeked packet
+  WifiMacHeader hdr;
+  Time tstamp;
+  Ptr<const Packet> packet = m_queue->PeekByTidAndAddress (&hdr, 0, WifiMacHeader::ADDR1, a, &tstamp);
+  NS_TEST_EXPECT_MSG_EQ (m_queue->Remove (packet), true, "peeked packet should be removed");
+  NS_TEST_EXPECT_MSG_EQ (PeekSize (a, 0), 40, "next packet of the FIFO should be peeked");
+  packet = m_queue->DequeueByTidAndAddress (&hdr, 0, WifiMacHeader::ADDR1, a);
+  NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), 40, "first packet of the FIFO should be dequeued");
+  NS_TEST_EXPECT_MSG_EQ (PeekSize (a, 0), 0, "FIFO should be empty");
+  NS_TEST_EXPECT_MSG_EQ (m_queue->Dequeue (&hdr)->GetSize (), 20, "queue order should be kept");
+  NS_TEST_EXPECT_MSG_EQ (m_queue->GetSize (), 1, "unexpected queue size");
+  m_queue->Flush ();
+
+  // the first available packet follows the queue order across the FIFOs
+  // and the other packets, and skips the blocked FIFOs
+  QosBlockedDestinations blocked;
+  Enqueue (a, 0, 10, false);
+  Enqueue (b, 0, 20, false);
+  WifiMacHeader action;
+  action.SetType (WIFI_MAC_MGT_ACTION);
+  action.SetAddr1 (a);
+  m_queue->Enqueue (Create<Packet> (30), action);
+  Enqueue (b, 1, 40, false);
+  Enqueue (a, 1, 5, true);
+  NS_TEST_EXPECT_MSG_EQ (m_queue->PeekFirstAvailable (&hdr, tstamp, &blocked)->GetSize (), 5,
+                         "the packet pushed at the front should be first");
+  blocked.Block (a, 1);
+  NS_TEST_EXPECT_MSG_EQ (m_queue->PeekFirstAvailable (&hdr, tstamp, &blocked)->GetSize (), 10,
+                         "the blocked FIFO should be skipped");
+  blocked.Block (a, 0);
+  blocked.Block (b, 0);
+  NS_TEST_EXPECT_MSG_EQ (m_queue->DequeueFirstAvailable (&hdr, tstamp, &blocked)->GetSize (), 30,
+                         "packets other than QoS data should not be blocked");
+  NS_TEST_EXPECT_MSG_EQ (m_queue->DequeueFirstAvailable (&hdr, tstamp, &blocked)->GetSize (), 40,
+                         "the blocked FIFOs should be skipped");
+  blocked.Block (b, 1);
+  NS_TEST_EXPECT_MSG_EQ (m_queue->PeekFirstAvailable (&hdr, tstamp, &blocked), 0,
+                         "every FIFO left is blocked");
+  blocked.Unblock (a, 1);
+  NS_TEST_EXPECT_MSG_EQ (m_queue->DequeueFirstAvailable (&hdr, tstamp, &blocked)->GetSize (), 5,
+                         "the unblocked FIFO should be available");
+  NS_TEST_EXPECT_MSG_EQ (m_queue->GetSize (), 2, "unexpected queue size");
+  m_queue->Flush ();
+
+  // a packet pushed at the front leads its FIFO and the queue, but does
+  // not delay the expiry of the older packets behind it
+  Enqueue (a, 0, 10, false);
+  Enqueue (a, 0, 20, false);
+  Simulator::Schedule (MilliSeconds (5), &WifiMacQueueFlowTest::Enqueue, this, a, 0, 50, true);
+  Simulator::Schedule (MilliSeconds (12), &WifiMacQueueFlowTest::CheckExpiry, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+  m_queue = 0;
+}
+
 //-----------------------------------------------------------------------------
 
 class WifiTestSuite : public TestSuite
@@ -1104,10 +1946,17 @@ WifiTestSuite::WifiTestSuite ()
   AddTestCase (new WifiTest, TestCase::QUICK);
   AddTestCase (new QosUtilsIsOldPacketTest, TestCase::QUICK);
   AddTestCase (new InterferenceHelperSequenceTest, TestCase::QUICK); //Bug 991
+  AddTestCase (new InterferenceHelperAccumulationTest, TestCase::QUICK);
+  AddTestCase (new InterferenceHelperExpiryTest, TestCase::QUICK);
   AddTestCase (new DcfImmediateAccessBroadcastTestCase, TestCase::QUICK);
   AddTestCase (new Bug730TestCase, TestCase::QUICK); //Bug 730
   AddTestCase (new SetChannelFrequencyTest, TestCase::QUICK);
   AddTestCase (new Bug2222TestCase, TestCase::QUICK); //Bug 2222
+  AddTestCase (new YansWifiChannelSpatialIndexTest, TestCase::QUICK);
+  AddTestCase (new YansWifiChannelBucketTest, TestCase::QUICK);
+  AddTestCase (new YansWifiChannelMultithreadedTest, TestCase::QUICK);
+  AddTestCase (new WifiRemoteStationManagerLookupTest, TestCase::QUICK);
+  AddTestCase (new WifiMacQueueFlowTest, TestCase::QUICK);
 }
 
 static WifiTestSuite g_wifiTestSuite;